@@ -16,20 +16,31 @@
 //
 /////////////////////////////////////////////////////////////////////////////////////////
 
+#include <string.h>
+#include <algorithm>
+
 #include <dw/sensors/plugins/lidar/LidarDecoder.h>
 #include <dw/sensors/plugins/lidar/LidarPlugin.h>
 
 #include "HesaiLidar.h"
+#include "HesaiLidarPluginExt.h"
 #include "Version.h"
 
 using std::cout;
 using std::endl;
 
+// The public struct is the same memory as the one written by the parsers
+static_assert(sizeof(HesaiCompactPoint) == sizeof(CompactPoint) &&
+              offsetof(HesaiCompactPoint, laserId) == offsetof(CompactPoint, laserId),
+              "HesaiCompactPoint must match CompactPoint");
+
 // To store several lidar objects
-std::vector<std::unique_ptr<dw::plugins::lidar::HesaiLidar>> dw::plugins::lidar::HesaiLidar::g_sensorContext;
+std::vector<std::shared_ptr<dw::plugins::lidar::HesaiLidar>> dw::plugins::lidar::HesaiLidar::g_sensorContext;
+std::mutex dw::plugins::lidar::HesaiLidar::g_sensorContextMutex;
 
 static bool checkValid(dw::plugins::lidar::HesaiLidar* sensor)
 {
+    std::lock_guard<std::mutex> lock(dw::plugins::lidar::HesaiLidar::g_sensorContextMutex);
     for (auto& i : dw::plugins::lidar::HesaiLidar::g_sensorContext)
     {
         if (i.get() == sensor)
@@ -54,7 +65,10 @@ dwStatus _dwSensorPlugin_createHandle(dwSensorPluginSensorHandle_t* sensor, dwSe
 
     size_t slotSize = 10; // Size of memory pool to read raw data from the sensor
     std::unique_ptr<dw::plugins::lidar::HesaiLidar> sensorContext(new dw::plugins::lidar::HesaiLidar(ctx, DW_NULL_HANDLE, slotSize));
-    sensorContext->loadUserParams(params);
+    if (sensorContext->loadUserParams(params) != DW_SUCCESS) {
+        cout << "_dwSensorPlugin_createHandle: loadUserParams Error" << endl;
+        return DW_INVALID_ARGUMENT;
+    }
 
     std::string lidartype = sensorContext->getLidarType();
     if (sensorContext->createParser(lidartype) != DW_SUCCESS) {
@@ -62,6 +76,7 @@ dwStatus _dwSensorPlugin_createHandle(dwSensorPluginSensorHandle_t* sensor, dwSe
         return DW_CANNOT_CREATE_OBJECT;
     }
 
+    std::lock_guard<std::mutex> lock(dw::plugins::lidar::HesaiLidar::g_sensorContextMutex);
     dw::plugins::lidar::HesaiLidar::g_sensorContext.push_back(std::move(sensorContext));
     *sensor = dw::plugins::lidar::HesaiLidar::g_sensorContext.back().get();
 
@@ -83,26 +98,30 @@ dwStatus _dwSensorPlugin_start(dwSensorPluginSensorHandle_t sensor)
 dwStatus _dwSensorPlugin_release(dwSensorPluginSensorHandle_t sensor)
 {
     // std::cout << "_dwSensorPlugin_release: " << std::endl;
-    auto sensorContext = reinterpret_cast<dw::plugins::lidar::HesaiLidar*>(sensor);
-    if (!checkValid(sensorContext))
+    std::shared_ptr<dw::plugins::lidar::HesaiLidar> sensorContext;
     {
-        return DW_INVALID_HANDLE;
-    }
-
-    for (auto iter =
-             dw::plugins::lidar::HesaiLidar::g_sensorContext.begin();
-         iter != dw::plugins::lidar::HesaiLidar::g_sensorContext.end();
-         ++iter)
-    {
-        if ((*iter).get() == sensor)
+        std::lock_guard<std::mutex> lock(dw::plugins::lidar::HesaiLidar::g_sensorContextMutex);
+        for (auto iter =
+                 dw::plugins::lidar::HesaiLidar::g_sensorContext.begin();
+             iter != dw::plugins::lidar::HesaiLidar::g_sensorContext.end();
+             ++iter)
         {
-            sensorContext->stopSensor();
-            sensorContext->releaseSensor();
-            dw::plugins::lidar::HesaiLidar::g_sensorContext.erase(iter);
-            return DW_SUCCESS;
+            if ((*iter).get() == sensor)
+            {
+                sensorContext = *iter;
+                dw::plugins::lidar::HesaiLidar::g_sensorContext.erase(iter);
+                break;
+            }
         }
     }
-    return DW_FAILURE;
+    if (sensorContext == nullptr)
+    {
+        return DW_INVALID_HANDLE;
+    }
+    // out of the lock, the other sensors go on. An extension API still in a call keeps the object until it returns
+    sensorContext->stopSensor();
+    sensorContext->releaseSensor();
+    return DW_SUCCESS;
 }
 
 dwStatus _dwSensorPlugin_stop(dwSensorPluginSensorHandle_t sensor)
@@ -243,4 +262,361 @@ dwStatus dwSensorLidarPlugin_getFunctionTable(dwSensorLidarPluginFunctionTable*
     return DW_SUCCESS;
 }
 
-} // extern "C"
\ No newline at end of file
+////////////////////////////////Extension APIs, see HesaiLidarPluginExt.h////////////////////////////////
+
+// The reference keeps the sensor alive for the call, even if it is released meanwhile
+static std::shared_ptr<dw::plugins::lidar::HesaiLidar> getSensorByIndex(uint32_t sensorIndex)
+{
+    std::lock_guard<std::mutex> lock(dw::plugins::lidar::HesaiLidar::g_sensorContextMutex);
+    if (sensorIndex >= dw::plugins::lidar::HesaiLidar::g_sensorContext.size())
+    {
+        return nullptr;
+    }
+    return dw::plugins::lidar::HesaiLidar::g_sensorContext[sensorIndex];
+}
+
+uint32_t hesaiLidarPlugin_getSensorCount()
+{
+    std::lock_guard<std::mutex> lock(dw::plugins::lidar::HesaiLidar::g_sensorContextMutex);
+    return static_cast<uint32_t>(dw::plugins::lidar::HesaiLidar::g_sensorContext.size());
+}
+
+dwStatus hesaiLidarPlugin_setEgoMotion(uint32_t sensorIndex, const HesaiEgoMotion* motion)
+{
+    auto sensorContext = getSensorByIndex(sensorIndex);
+    if (sensorContext == nullptr)
+    {
+        return DW_INVALID_HANDLE;
+    }
+    if (motion == nullptr)
+    {
+        return DW_INVALID_ARGUMENT;
+    }
+
+    DeskewMotion deskewMotion;
+    for (int i = 0; i < 3; i++)
+    {
+        deskewMotion.linearVelocity[i]  = motion->linearVelocity[i];
+        deskewMotion.angularVelocity[i] = motion->angularVelocity[i];
+    }
+    deskewMotion.referenceTime = motion->referenceTime;
+    return sensorContext->setEgoMotion(deskewMotion);
+}
+
+dwStatus hesaiLidarPlugin_getPointTimestamps(uint32_t sensorIndex, const dwLidarPointXYZI* points,
+                                             const dwTime_t** timestamps)
+{
+    auto sensorContext = getSensorByIndex(sensorIndex);
+    if (sensorContext == nullptr)
+    {
+        return DW_INVALID_HANDLE;
+    }
+    return sensorContext->getPointTimestamps(points, timestamps);
+}
+
+dwStatus hesaiLidarPlugin_getRangeImage(uint32_t sensorIndex, HesaiRangeImage* image)
+{
+    auto sensorContext = getSensorByIndex(sensorIndex);
+    if (sensorContext == nullptr)
+    {
+        return DW_INVALID_HANDLE;
+    }
+    if (image == nullptr)
+    {
+        return DW_INVALID_ARGUMENT;
+    }
+
+    const RangeImage* rangeImage = nullptr;
+    dwStatus ret = sensorContext->getRangeImage(&rangeImage);
+    if (ret != DW_SUCCESS)
+    {
+        return ret;
+    }
+    // azimuth unit of the layout, e.g. 1/1000 degree
+    const float unitPerDeg = rangeImage->layout.unitsPerRev / 360.0f;
+    image->rows            = rangeImage->layout.rows;
+    image->cols            = rangeImage->layout.cols;
+    image->returns         = rangeImage->layout.returns;
+    image->azimuthStartDeg = rangeImage->layout.azimuthStart / unitPerDeg;
+    image->azimuthStepDeg  = rangeImage->layout.azimuthStep / unitPerDeg;
+    image->timestamp       = rangeImage->timestamp;
+    image->frameId         = rangeImage->frameId;
+    image->range           = rangeImage->range.data();
+    image->x               = rangeImage->x.data();
+    image->y               = rangeImage->y.data();
+    image->z               = rangeImage->z.data();
+    image->intensity       = rangeImage->intensity.data();
+    image->valid           = rangeImage->valid.data();
+    return DW_SUCCESS;
+}
+
+dwStatus hesaiLidarPlugin_getCompactPoints(uint32_t sensorIndex, const dwLidarPointXYZI* points,
+                                           const HesaiCompactPoint** compactPoints)
+{
+    auto sensorContext = getSensorByIndex(sensorIndex);
+    if (sensorContext == nullptr)
+    {
+        return DW_INVALID_HANDLE;
+    }
+    if (compactPoints == nullptr)
+    {
+        return DW_INVALID_ARGUMENT;
+    }
+
+    const CompactPoint* compact = nullptr;
+    dwStatus ret = sensorContext->getCompactPoints(points, &compact);
+    *compactPoints = reinterpret_cast<const HesaiCompactPoint*>(compact);
+    return ret;
+}
+
+void hesaiLidarPlugin_packCompactPoints(HesaiCompactPoint* compactPoints, const dwLidarPointXYZI* points,
+                                        const uint8_t* laserIds, size_t count)
+{
+    PackCompactPoints(reinterpret_cast<CompactPoint*>(compactPoints), points, laserIds, count);
+}
+
+void hesaiLidarPlugin_unpackCompactPoints(dwLidarPointXYZI* points, const HesaiCompactPoint* compactPoints,
+                                          size_t count)
+{
+    UnpackCompactPoints(points, reinterpret_cast<const CompactPoint*>(compactPoints), count);
+}
+
+dwStatus hesaiLidarPlugin_getOverloadStats(uint32_t sensorIndex, HesaiOverloadStats* stats)
+{
+    auto sensorContext = getSensorByIndex(sensorIndex);
+    if (sensorContext == nullptr)
+    {
+        return DW_INVALID_HANDLE;
+    }
+    if (stats == nullptr)
+    {
+        return DW_INVALID_ARGUMENT;
+    }
+
+    dw::plugins::lidar::OverloadStats overloadStats;
+    dwStatus ret = sensorContext->getOverloadStats(&overloadStats);
+    stats->deliveredPackets   = overloadStats.deliveredPackets;
+    stats->slotMisses         = overloadStats.slotMisses;
+    stats->droppedOldest      = overloadStats.droppedOldest;
+    stats->droppedQueueFull   = overloadStats.droppedQueueFull;
+    stats->packetRate         = overloadStats.packetRate;
+    stats->slotHoldMs         = overloadStats.slotHoldMs;
+    stats->slotCount          = overloadStats.slotCount;
+    stats->suggestedSlotCount = overloadStats.suggestedSlotCount;
+    return ret;
+}
+
+static void copyStageLatency(HesaiStageLatency* latency, const dw::plugins::lidar::LatencyHistogram::Summary& summary)
+{
+    latency->count  = summary.count;
+    latency->meanUs = summary.meanNs / 1e3f;
+    latency->p50Us  = summary.p50Ns / 1e3f;
+    latency->p90Us  = summary.p90Ns / 1e3f;
+    latency->p99Us  = summary.p99Ns / 1e3f;
+    latency->p999Us = summary.p999Ns / 1e3f;
+    latency->maxUs  = summary.maxNs / 1e3f;
+}
+
+dwStatus hesaiLidarPlugin_getStageStats(uint32_t sensorIndex, HesaiStageStats* stats)
+{
+    auto sensorContext = getSensorByIndex(sensorIndex);
+    if (sensorContext == nullptr)
+    {
+        return DW_INVALID_HANDLE;
+    }
+    if (stats == nullptr)
+    {
+        return DW_INVALID_ARGUMENT;
+    }
+
+    dw::plugins::lidar::StageStatsSnapshot snapshot;
+    dwStatus ret = sensorContext->getStageStats(&snapshot);
+    stats->receivedPackets  = snapshot.received;
+    stats->pushedPackets    = snapshot.pushed;
+    stats->parsedPackets    = snapshot.parsed;
+    stats->points           = snapshot.points;
+    stats->frames           = snapshot.frames;
+    stats->decodeErrors     = snapshot.decodeErrors;
+    stats->droppedSlotMiss  = snapshot.drops.slotMiss;
+    stats->droppedOldest    = snapshot.drops.dropOldest;
+    stats->droppedQueueFull = snapshot.drops.queueFull;
+    stats->droppedEarly     = snapshot.drops.early;
+    copyStageLatency(&stats->receiveToRead, snapshot.stage[dw::plugins::lidar::STAGE_RECEIVE_TO_READ]);
+    copyStageLatency(&stats->readToPush, snapshot.stage[dw::plugins::lidar::STAGE_READ_TO_PUSH]);
+    copyStageLatency(&stats->parsePacket, snapshot.stage[dw::plugins::lidar::STAGE_PARSE_PACKET]);
+    copyStageLatency(&stats->parseFrame, snapshot.stage[dw::plugins::lidar::STAGE_PARSE_FRAME]);
+    copyStageLatency(&stats->receiveToParsed, snapshot.stage[dw::plugins::lidar::STAGE_RECEIVE_TO_PARSED]);
+    return ret;
+}
+
+dwStatus hesaiLidarPlugin_getMemoryStats(uint32_t sensorIndex, HesaiMemoryStats* stats)
+{
+    auto sensorContext = getSensorByIndex(sensorIndex);
+    if (sensorContext == nullptr)
+    {
+        return DW_INVALID_HANDLE;
+    }
+    if (stats == nullptr)
+    {
+        return DW_INVALID_ARGUMENT;
+    }
+
+    dw::plugins::lidar::MemoryStats snapshot;
+    dwStatus ret = sensorContext->getMemoryStats(&snapshot);
+    const MemoryUsage& usage = snapshot.usage;
+    stats->staticBytes       = usage.StaticBytes();
+    stats->dynamicBytes      = usage.DynamicBytes();
+    stats->residentBytes     = usage.ResidentBytes();
+    stats->queuedPackets     = snapshot.queuedPackets;
+    stats->peakQueuedPackets = snapshot.peakQueuedPackets;
+    stats->componentNum      = std::min<uint32_t>(usage.componentNum, HESAI_MEMORY_COMPONENT_NUM);
+    for (uint32_t i = 0; i < stats->componentNum; i++)
+    {
+        HesaiMemoryComponent& component = stats->components[i];
+        memcpy(component.name, usage.components[i].name, sizeof(component.name));
+        component.staticBytes   = usage.components[i].staticBytes;
+        component.dynamicBytes  = usage.components[i].dynamicBytes;
+        component.residentBytes = usage.components[i].residentBytes;
+    }
+    return ret;
+}
+
+dwStatus hesaiLidarPlugin_getGpsStatus(uint32_t sensorIndex, HesaiGpsStatus* status)
+{
+    auto sensorContext = getSensorByIndex(sensorIndex);
+    if (sensorContext == nullptr)
+    {
+        return DW_INVALID_HANDLE;
+    }
+    if (status == nullptr)
+    {
+        return DW_INVALID_ARGUMENT;
+    }
+
+    dw::plugins::lidar::GpsStatus gpsStatus;
+    dwStatus ret = sensorContext->getGpsStatus(&gpsStatus);
+    status->packetNum  = gpsStatus.packetNum;
+    status->droppedNum = gpsStatus.droppedNum;
+    status->valid      = gpsStatus.valid;
+    status->positioned = gpsStatus.positioned;
+    status->ppsLocked  = gpsStatus.ppsLocked;
+    status->gpsTime    = gpsStatus.gpsTime;
+    status->hostTime   = gpsStatus.hostTime;
+    memcpy(status->nmea, gpsStatus.nmea, sizeof(status->nmea));
+    return ret;
+}
+
+dwStatus hesaiLidarPlugin_getHealth(uint32_t sensorIndex, HesaiHealth* health)
+{
+    auto sensorContext = getSensorByIndex(sensorIndex);
+    if (sensorContext == nullptr)
+    {
+        return DW_INVALID_HANDLE;
+    }
+    if (health == nullptr)
+    {
+        return DW_INVALID_ARGUMENT;
+    }
+
+    dw::plugins::lidar::HealthStatus status;
+    dwStatus ret = sensorContext->getHealth(&status);
+    health->faultMessageNum   = status.faultMessageNum;
+    health->droppedNum        = status.droppedNum;
+    health->faultNum          = status.faultNum;
+    health->valid             = status.valid;
+    health->operationState    = status.operationState;
+    health->faultState        = status.faultState;
+    health->faultCodeType     = status.faultCodeType;
+    health->totalFaultCodeNum = status.totalFaultCodeNum;
+    health->faultCodeId       = status.faultCodeId;
+    health->faultCode         = status.faultCode;
+    health->lidarTime         = status.lidarTime;
+    health->hostTime          = status.hostTime;
+    return ret;
+}
+
+dwStatus hesaiLidarPlugin_readLogReport(uint32_t sensorIndex, uint8_t* data, size_t capacity, size_t* size,
+                                        dwTime_t* hostTime)
+{
+    auto sensorContext = getSensorByIndex(sensorIndex);
+    if (sensorContext == nullptr)
+    {
+        return DW_INVALID_HANDLE;
+    }
+    if (data == nullptr || size == nullptr)
+    {
+        return DW_INVALID_ARGUMENT;
+    }
+
+    dw::plugins::lidar::SidePacket packet;
+    dwStatus ret = sensorContext->readLogReport(&packet);
+    if (ret != DW_SUCCESS)
+    {
+        return ret;
+    }
+    *size = std::min(capacity, static_cast<size_t>(packet.len));
+    memcpy(data, packet.data, *size);
+    if (hostTime != nullptr)
+    {
+        *hostTime = packet.hostTime;
+    }
+    return DW_SUCCESS;
+}
+
+dwStatus hesaiLidarPlugin_getLidarStatus(uint32_t sensorIndex, HesaiLidarStatus* status)
+{
+    auto sensorContext = getSensorByIndex(sensorIndex);
+    if (sensorContext == nullptr)
+    {
+        return DW_INVALID_HANDLE;
+    }
+    if (status == nullptr)
+    {
+        return DW_INVALID_ARGUMENT;
+    }
+
+    dw::plugins::lidar::LidarStatusSnapshot snapshot;
+    dwStatus ret = sensorContext->getLidarStatus(&snapshot);
+    if (ret != DW_SUCCESS)
+    {
+        return ret;
+    }
+    status->version           = snapshot.version;
+    status->hostTime          = snapshot.hostTime;
+    status->ptcValid          = snapshot.ptcValid;
+    status->uptimeS           = snapshot.uptimeS;
+    status->motorSpeedRpm     = snapshot.motorSpeedRpm;
+    memcpy(status->temperatureC, snapshot.temperatureC, sizeof(status->temperatureC));
+    status->gpsPpsLock        = snapshot.gpsPpsLock;
+    status->gpsGprmcStatus    = snapshot.gpsGprmcStatus;
+    status->ptpClockStatus    = snapshot.ptpClockStatus;
+    status->startupTimes      = snapshot.startupTimes;
+    status->totalOperationMin = snapshot.totalOperationMin;
+    status->tailValid         = snapshot.tailValid;
+    status->statusNum         = snapshot.tail.statusNum;
+    memcpy(status->statusId, snapshot.tail.statusId, sizeof(status->statusId));
+    memcpy(status->statusData, snapshot.tail.statusData, sizeof(status->statusData));
+    status->tailMotorSpeed    = snapshot.tail.motorSpeed;
+    status->returnMode        = snapshot.tail.returnMode;
+    status->shutdown          = snapshot.tail.shutdown;
+    status->hasFuncSafety     = snapshot.tail.hasFuncSafety;
+    status->lidarState        = snapshot.tail.lidarState;
+    status->currentFault      = snapshot.tail.currentFault;
+    status->historyFault      = snapshot.tail.historyFault;
+    status->faultNum          = snapshot.tail.faultNum;
+    status->faultId           = snapshot.tail.faultId;
+    status->faultCode         = snapshot.tail.faultCode;
+    return DW_SUCCESS;
+}
+
+dwStatus hesaiLidarPlugin_reloadCalibration(uint32_t sensorIndex)
+{
+    auto sensorContext = getSensorByIndex(sensorIndex);
+    if (sensorContext == nullptr)
+    {
+        return DW_INVALID_HANDLE;
+    }
+    return sensorContext->reloadCalibration();
+}
+
+} // extern "C"
@@ -0,0 +1,152 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: Lidar Sensor UDP Parser</b>
+ *
+ * @b Description: This file defines the 8 byte compact point and its pack/unpack helpers.
+ */
+
+#ifndef COMPACT_POINT_H_
+#define COMPACT_POINT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <cmath>
+
+#include <dw/sensors/plugins/lidar/LidarDecoder.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// xyz unit of the compact point is 1 cm, range +-327.67 m, saturated beyond
+#define COMPACT_POINT_SCALE (100.0f)
+
+// Half of a dwLidarPointXYZI, a quarter of xyzi plus rthi
+struct CompactPoint {
+  int16_t x;
+  int16_t y;
+  int16_t z;
+  uint8_t intensity;
+  uint8_t laserId;
+};
+static_assert(sizeof(CompactPoint) == 8, "CompactPoint must be 8 bytes");
+
+inline int16_t QuantizeCompactAxis(float value) {
+  float scaled = value * COMPACT_POINT_SCALE;
+  if (scaled >= 32767.0f) return 32767;
+  if (scaled <= -32768.0f) return -32768;
+  return static_cast<int16_t>(lrintf(scaled));
+}
+
+/**
+ * @brief Pack one point, used in the decode loop where the laser id is known
+ */
+inline void PackCompactPoint(CompactPoint& compact, const dwLidarPointXYZI& point, uint8_t laserId) {
+  compact.x = QuantizeCompactAxis(point.x);
+  compact.y = QuantizeCompactAxis(point.y);
+  compact.z = QuantizeCompactAxis(point.z);
+  compact.intensity = static_cast<uint8_t>(point.intensity);
+  compact.laserId = laserId;
+}
+
+inline void UnpackCompactPoint(dwLidarPointXYZI& point, const CompactPoint& compact) {
+  point.x = compact.x * (1.0f / COMPACT_POINT_SCALE);
+  point.y = compact.y * (1.0f / COMPACT_POINT_SCALE);
+  point.z = compact.z * (1.0f / COMPACT_POINT_SCALE);
+  point.intensity = compact.intensity;
+}
+
+/**
+ * @brief Pack n points with SSE2 or NEON if available.
+ * The last int16 lane of a point carries intensity and laser id, which is why the laser id
+ * is folded in as a signed value before the saturating narrow
+ *
+ * @param laserIds laser id of each point, nullptr to write 0
+ */
+inline void PackCompactPoints(CompactPoint* compact, const dwLidarPointXYZI* points, const uint8_t* laserIds,
+                              size_t n) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  static_assert(sizeof(dwLidarPointXYZI) == 16, "dwLidarPointXYZI must be 4 floats");
+  const __m128 scale = _mm_set_ps(1.0f, COMPACT_POINT_SCALE, COMPACT_POINT_SCALE, COMPACT_POINT_SCALE);
+  const __m128 maxValue = _mm_set1_ps(32767.0f);
+  const __m128 minValue = _mm_set1_ps(-32768.0f);
+  for (; i + 2 <= n; i += 2) {
+    float laser0 = laserIds != nullptr ? static_cast<int8_t>(laserIds[i]) * 256.0f : 0.0f;
+    float laser1 = laserIds != nullptr ? static_cast<int8_t>(laserIds[i + 1]) * 256.0f : 0.0f;
+    __m128 p0 = _mm_mul_ps(_mm_loadu_ps(&points[i].x), scale);
+    __m128 p1 = _mm_mul_ps(_mm_loadu_ps(&points[i + 1].x), scale);
+    p0 = _mm_add_ps(p0, _mm_set_ps(laser0, 0.0f, 0.0f, 0.0f));
+    p1 = _mm_add_ps(p1, _mm_set_ps(laser1, 0.0f, 0.0f, 0.0f));
+    // clamp first, cvtps returns INT_MIN for values beyond int32
+    p0 = _mm_max_ps(_mm_min_ps(p0, maxValue), minValue);
+    p1 = _mm_max_ps(_mm_min_ps(p1, maxValue), minValue);
+    __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(p0), _mm_cvtps_epi32(p1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&compact[i]), packed);
+  }
+#elif defined(__aarch64__)
+  const float32x4_t scale = {COMPACT_POINT_SCALE, COMPACT_POINT_SCALE, COMPACT_POINT_SCALE, 1.0f};
+  for (; i < n; i++) {
+    float laser = laserIds != nullptr ? static_cast<int8_t>(laserIds[i]) * 256.0f : 0.0f;
+    float32x4_t p = vmulq_f32(vld1q_f32(&points[i].x), scale);
+    p = vsetq_lane_f32(vgetq_lane_f32(p, 3) + laser, p, 3);
+    vst1_s16(reinterpret_cast<int16_t*>(&compact[i]), vqmovn_s32(vcvtnq_s32_f32(p)));
+  }
+#endif
+  for (; i < n; i++) {
+    PackCompactPoint(compact[i], points[i], laserIds != nullptr ? laserIds[i] : 0);
+  }
+}
+
+/**
+ * @brief Unpack n points back to float with SSE2 or NEON if available, the laser id is dropped
+ */
+inline void UnpackCompactPoints(dwLidarPointXYZI* points, const CompactPoint* compact, size_t n) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 scale = _mm_set_ps(1.0f, 1.0f / COMPACT_POINT_SCALE, 1.0f / COMPACT_POINT_SCALE,
+                                  1.0f / COMPACT_POINT_SCALE);
+  const __m128i mask = _mm_set_epi32(0xFF, -1, -1, -1);
+  for (; i + 2 <= n; i += 2) {
+    __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&compact[i]));
+    // sign extend int16 to int32, then keep only the intensity byte of the last lane
+    __m128i v0 = _mm_and_si128(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16), mask);
+    __m128i v1 = _mm_and_si128(_mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16), mask);
+    _mm_storeu_ps(&points[i].x, _mm_mul_ps(_mm_cvtepi32_ps(v0), scale));
+    _mm_storeu_ps(&points[i + 1].x, _mm_mul_ps(_mm_cvtepi32_ps(v1), scale));
+  }
+#elif defined(__aarch64__)
+  const float32x4_t scale = {1.0f / COMPACT_POINT_SCALE, 1.0f / COMPACT_POINT_SCALE, 1.0f / COMPACT_POINT_SCALE,
+                             1.0f};
+  const int32x4_t mask = {-1, -1, -1, 0xFF};
+  for (; i < n; i++) {
+    int32x4_t v = vandq_s32(vmovl_s16(vld1_s16(reinterpret_cast<const int16_t*>(&compact[i]))), mask);
+    vst1q_f32(&points[i].x, vmulq_f32(vcvtq_f32_s32(v), scale));
+  }
+#endif
+  for (; i < n; i++) {
+    UnpackCompactPoint(points[i], compact[i]);
+  }
+}
+
+#endif  // COMPACT_POINT_H_
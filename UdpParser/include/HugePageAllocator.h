@@ -0,0 +1,130 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: Lidar Sensor UDP Parser</b>
+ *
+ * @b Description: This file defines the huge page allocation of the big lookup tables and point buffers.
+ */
+
+#ifndef HUGE_PAGE_ALLOCATOR_H_
+#define HUGE_PAGE_ALLOCATOR_H_
+
+#include <stddef.h>
+#include <type_traits>
+#include <utility>
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/**
+ * @brief Map zeroed memory backed by 2 MB pages. Try MAP_HUGETLB first, which needs pages reserved in
+ * /proc/sys/vm/nr_hugepages, then fall back to normal pages with transparent huge page advice
+ *
+ * @param[in] size bytes to be mapped, rounded up to 2 MB
+ * @param[out] isHugeTlb return true if the memory comes from the reserved huge pages
+ * @return nullptr if the mapping failed
+ */
+void* HugePageAlloc(size_t size, bool* isHugeTlb);
+void HugePageFree(void* ptr, size_t size);
+
+/**
+ * @brief Let 'HugePageAlloc' use huge pages, the default. Disabled, it maps 4 KB pages that THP does not
+ * back, to measure what the huge pages bring. Only the mappings made after the call are changed
+ */
+void HugePageSetEnabled(bool enabled);
+
+/**
+ * @brief Touch every page so that no page fault happens in the decode loop
+ */
+void HugePagePrefault(void* ptr, size_t size);
+
+/**
+ * @brief Bind the memory to a NUMA node, pages already faulted are migrated
+ * @return 0 on success, -1 if the kernel has no NUMA support or the node is invalid
+ */
+int HugePageBindNode(void* ptr, size_t size, int node);
+
+/**
+ * @brief NUMA node of the cpu the calling thread runs on, 0 if unknown
+ */
+int HugePageCurrentNode();
+
+/**
+ * @brief Bytes of the range that are in RAM, by mincore. Works on any mapped memory, e.g. a vector
+ * @return 0 if the range is not mapped
+ */
+size_t HugePageResidentBytes(const void* ptr, size_t size);
+
+// Fixed size array of trivial elements in huge pages, zero initialized
+template <typename T>
+class HugePageArray {
+  static_assert(std::is_trivial<T>::value, "HugePageArray only holds trivial types");
+
+ public:
+  HugePageArray() = default;
+  explicit HugePageArray(size_t count) { Allocate(count); }
+  ~HugePageArray() { Release(); }
+
+  HugePageArray(const HugePageArray&) = delete;
+  HugePageArray& operator=(const HugePageArray&) = delete;
+  HugePageArray(HugePageArray&& other) noexcept { *this = std::move(other); }
+  HugePageArray& operator=(HugePageArray&& other) noexcept {
+    if (this != &other) {
+      Release();
+      std::swap(m_pData, other.m_pData);
+      std::swap(m_count, other.m_count);
+      std::swap(m_bHugeTlb, other.m_bHugeTlb);
+    }
+    return *this;
+  }
+
+  // Return false if no memory, the array is empty then
+  bool Allocate(size_t count) {
+    Release();
+    m_pData = static_cast<T*>(HugePageAlloc(count * sizeof(T), &m_bHugeTlb));
+    m_count = m_pData != nullptr ? count : 0;
+    return m_pData != nullptr;
+  }
+
+  void Release() {
+    if (m_pData != nullptr) HugePageFree(m_pData, bytes());
+    m_pData = nullptr;
+    m_count = 0;
+  }
+
+  void Prefault() { HugePagePrefault(m_pData, bytes()); }
+  int BindNode(int node) { return m_pData != nullptr ? HugePageBindNode(m_pData, bytes(), node) : 0; }
+  size_t ResidentBytes() const { return HugePageResidentBytes(m_pData, bytes()); }
+
+  inline T& operator[](size_t i) { return m_pData[i]; }
+  inline const T& operator[](size_t i) const { return m_pData[i]; }
+  inline T* data() { return m_pData; }
+  inline const T* data() const { return m_pData; }
+  inline size_t size() const { return m_count; }
+  inline bool empty() const { return m_count == 0; }
+  inline size_t bytes() const { return m_count * sizeof(T); }
+  inline bool IsHugeTlb() const { return m_bHugeTlb; }
+
+ private:
+  T* m_pData = nullptr;
+  size_t m_count = 0;
+  bool m_bHugeTlb = false;
+};
+
+#endif  // HUGE_PAGE_ALLOCATOR_H_
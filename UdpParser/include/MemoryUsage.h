@@ -0,0 +1,82 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: Lidar Sensor UDP Parser</b>
+ *
+ * @b Description: This file defines the memory accounting of a sensor by component.
+ */
+
+#ifndef MEMORY_USAGE_H_
+#define MEMORY_USAGE_H_
+
+#include <stddef.h>
+#include <string.h>
+
+// Bytes of one part of a sensor, e.g. the point buffers
+struct MemoryComponent {
+  char name[24] = {0};
+  // allocated once at start and kept, e.g. buffers and lookup tables
+  size_t staticBytes = 0;
+  // grows with the load or changes with the calibration, e.g. queues
+  size_t dynamicBytes = 0;
+  // part of the above in RAM, mapped pages only count once touched
+  size_t residentBytes = 0;
+};
+
+/**
+ * @brief Memory of a sensor by component, filled by the parser and the plugin. Fixed size, no allocation
+ */
+struct MemoryUsage {
+  static const int kMaxComponents = 16;
+  MemoryComponent components[kMaxComponents];
+  int componentNum = 0;
+
+  // Add to the component of this name, a new one if there is none yet. Dropped if all are in use
+  void Add(const char* name, size_t staticBytes, size_t dynamicBytes, size_t residentBytes) {
+    int i = 0;
+    while (i < componentNum && strncmp(components[i].name, name, sizeof(components[i].name) - 1) != 0) i++;
+    if (i == componentNum) {
+      if (componentNum == kMaxComponents) return;
+      strncpy(components[i].name, name, sizeof(components[i].name) - 1);
+      componentNum++;
+    }
+    components[i].staticBytes += staticBytes;
+    components[i].dynamicBytes += dynamicBytes;
+    components[i].residentBytes += residentBytes;
+  }
+
+  size_t StaticBytes() const {
+    size_t sum = 0;
+    for (int i = 0; i < componentNum; i++) sum += components[i].staticBytes;
+    return sum;
+  }
+  size_t DynamicBytes() const {
+    size_t sum = 0;
+    for (int i = 0; i < componentNum; i++) sum += components[i].dynamicBytes;
+    return sum;
+  }
+  size_t ResidentBytes() const {
+    size_t sum = 0;
+    for (int i = 0; i < componentNum; i++) sum += components[i].residentBytes;
+    return sum;
+  }
+};
+
+#endif  // MEMORY_USAGE_H_
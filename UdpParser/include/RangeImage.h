@@ -0,0 +1,128 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: Lidar Sensor UDP Parser</b>
+ *
+ * @b Description: This file defines the organized range image filled by the udp parsers.
+ */
+
+#ifndef RANGE_IMAGE_H_
+#define RANGE_IMAGE_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "HugePageAllocator.h"
+
+// Grid of one scan, row = laser id, column = azimuth bin, one layer per return
+struct RangeImageLayout {
+  uint32_t rows = 0;
+  uint32_t cols = 0;
+  uint32_t returns = 0;
+  // azimuth of the first column, in the azimuth unit of the parser
+  int32_t azimuthStart = 0;
+  // azimuth width of one column, native horizontal resolution of the lidar
+  int32_t azimuthStep = 1;
+  // azimuth units of one revolution, e.g. 360000
+  int32_t unitsPerRev = 1;
+};
+
+/**
+ * @brief Range image in structure-of-arrays form, each plane has returns * rows * cols cells
+ * and cell (ret, row, col) is at index (ret * rows + row) * cols + col.
+ * An empty cell has valid 0 and range 0, its x/y/z/intensity are not defined
+ */
+struct RangeImage {
+  RangeImageLayout layout;
+  std::vector<float> range;
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+  std::vector<uint8_t> intensity;
+  std::vector<uint8_t> valid;
+  // sensor time in us of the first packet of the scan
+  int64_t timestamp = 0;
+  // increase by one for each completed scan
+  uint64_t frameId = 0;
+
+  void Allocate(const RangeImageLayout& newLayout) {
+    layout = newLayout;
+    size_t size = static_cast<size_t>(layout.returns) * layout.rows * layout.cols;
+    range.assign(size, 0);
+    x.assign(size, 0);
+    y.assign(size, 0);
+    z.assign(size, 0);
+    intensity.assign(size, 0);
+    valid.assign(size, 0);
+    timestamp = 0;
+  }
+
+  // Bytes of the planes and the ones of them in RAM
+  size_t Bytes() const {
+    return (range.capacity() + x.capacity() + y.capacity() + z.capacity()) * sizeof(float) + intensity.capacity() +
+           valid.capacity();
+  }
+  size_t ResidentBytes() const {
+    return HugePageResidentBytes(range.data(), range.capacity() * sizeof(float)) +
+           HugePageResidentBytes(x.data(), x.capacity() * sizeof(float)) +
+           HugePageResidentBytes(y.data(), y.capacity() * sizeof(float)) +
+           HugePageResidentBytes(z.data(), z.capacity() * sizeof(float)) +
+           HugePageResidentBytes(intensity.data(), intensity.capacity()) +
+           HugePageResidentBytes(valid.data(), valid.capacity());
+  }
+
+  // Mark all the cells empty for the next scan, the xyz planes are left as they are
+  void Clear() {
+    if (valid.empty()) return;
+    memset(valid.data(), 0, valid.size());
+    memset(range.data(), 0, range.size() * sizeof(float));
+    timestamp = 0;
+  }
+
+  /**
+   * @brief Column of the azimuth, the nearest bin. Return -1 if outside the horizontal FOV of the grid
+   */
+  inline int32_t Column(int32_t azimuth) const {
+    int32_t offset = azimuth - layout.azimuthStart + layout.azimuthStep / 2;
+    offset = (offset % layout.unitsPerRev + layout.unitsPerRev) % layout.unitsPerRev;
+    int32_t col = offset / layout.azimuthStep;
+    return col < static_cast<int32_t>(layout.cols) ? col : -1;
+  }
+
+  /**
+   * @brief Write one return to its cell, a later return of the same cell overwrites the former one
+   */
+  inline void Write(uint32_t row, int32_t azimuth, uint32_t returnIndex, float distance, uint8_t pointIntensity,
+                    float pointX, float pointY, float pointZ) {
+    if (distance <= 0 || row >= layout.rows || returnIndex >= layout.returns) return;
+    int32_t col = Column(azimuth);
+    if (col < 0) return;
+    size_t index = (static_cast<size_t>(returnIndex) * layout.rows + row) * layout.cols + col;
+    range[index] = distance;
+    x[index] = pointX;
+    y[index] = pointY;
+    z[index] = pointZ;
+    intensity[index] = pointIntensity;
+    valid[index] = 1;
+  }
+};
+
+#endif  // RANGE_IMAGE_H_
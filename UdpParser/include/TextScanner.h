@@ -0,0 +1,187 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: Lidar Sensor UDP Parser</b>
+ *
+ * @b Description: This file defines the single pass scanner of the csv correction, firetimes and channel config files.
+ */
+
+#ifndef TEXT_SCANNER_H_
+#define TEXT_SCANNER_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <charconv>
+#include <cmath>
+
+// Part of a text buffer, not zero terminated
+struct TextSpan {
+  const char* begin = nullptr;
+  const char* end = nullptr;
+
+  size_t size() const { return end - begin; }
+  bool empty() const { return begin == end; }
+
+  // Case insensitive compare, e.g. the "EEFF" delimiter
+  bool EqualsNoCase(const char* text) const {
+    size_t length = strlen(text);
+    return length == size() && strncasecmp(begin, text, length) == 0;
+  }
+
+  // Without the spaces around
+  TextSpan Trimmed() const {
+    TextSpan span = *this;
+    while (span.begin < span.end && (*span.begin == ' ' || *span.begin == '\t')) span.begin++;
+    while (span.end > span.begin && (span.end[-1] == ' ' || span.end[-1] == '\t')) span.end--;
+    return span;
+  }
+};
+
+/**
+ * @brief Walk the lines of a buffer of explicit length, '\n' or "\r\n" ended. The buffer is not copied
+ */
+class TextScanner {
+ public:
+  TextScanner(const char* data, size_t size) : m_pCur(data), m_pEnd(data + size) {}
+
+  bool NextLine(TextSpan& line) {
+    if (m_pCur >= m_pEnd) return false;
+    const char* newline = static_cast<const char*>(memchr(m_pCur, '\n', m_pEnd - m_pCur));
+    line.begin = m_pCur;
+    line.end = newline != nullptr ? newline : m_pEnd;
+    m_pCur = newline != nullptr ? newline + 1 : m_pEnd;
+    if (line.end > line.begin && line.end[-1] == '\r') line.end--;
+    return true;
+  }
+
+ private:
+  const char* m_pCur;
+  const char* m_pEnd;
+};
+
+/**
+ * @brief Split one line into fields by the separator, trimmed, without allocation
+ */
+class FieldScanner {
+ public:
+  explicit FieldScanner(TextSpan line, char separator = ',') : m_line(line), m_pCur(line.begin), m_cSep(separator) {}
+
+  bool Next(TextSpan& field) {
+    if (m_pCur == nullptr) return false;
+    // never negative, but gcc can not tell and warns about the memchr bound
+    size_t remaining = m_line.end > m_pCur ? m_line.end - m_pCur : 0;
+    const char* sep = static_cast<const char*>(memchr(m_pCur, m_cSep, remaining));
+    field.begin = m_pCur;
+    field.end = sep != nullptr ? sep : m_line.end;
+    m_pCur = sep != nullptr ? sep + 1 : nullptr;
+    field = field.Trimmed();
+    return true;
+  }
+
+  // Number of fields of the line, "a,b" has 2 and "" has 1 like 'HSSplit'
+  size_t Count() const {
+    size_t count = 1;
+    for (const char* p = m_line.begin; p < m_line.end; p++) count += *p == m_cSep;
+    return count;
+  }
+
+ private:
+  TextSpan m_line;
+  const char* m_pCur;
+  char m_cSep;
+};
+
+template <typename T>
+inline bool ParseInt(TextSpan field, T& value) {
+  const char* begin = field.begin;
+  // from_chars rejects the plus sign
+  if (begin < field.end && *begin == '+') begin++;
+  std::from_chars_result result = std::from_chars(begin, field.end, value);
+  return result.ec == std::errc() && result.ptr == field.end;
+}
+
+/**
+ * @brief Parse a decimal float like "-1.042" or "3e-2". std::from_chars is used if the standard library has
+ * the floating point overloads, older toolchains only have the integer ones
+ */
+inline bool ParseFloat(TextSpan field, float& value) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  const char* begin = field.begin;
+  if (begin < field.end && *begin == '+') begin++;
+  std::from_chars_result result = std::from_chars(begin, field.end, value);
+  return result.ec == std::errc() && result.ptr == field.end;
+#else
+  const char* p = field.begin;
+  bool negative = false;
+  if (p < field.end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+  TextSpan special{p, field.end};
+  if (special.EqualsNoCase("nan")) {
+    value = NAN;
+    return true;
+  }
+  if (special.EqualsNoCase("inf") || special.EqualsNoCase("infinity")) {
+    value = negative ? -INFINITY : INFINITY;
+    return true;
+  }
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int scale = 0;
+  bool any = false;
+  for (; p < field.end && *p >= '0' && *p <= '9'; p++, any = true) {
+    if (digits < 18) {
+      mantissa = mantissa * 10 + (*p - '0');
+      if (mantissa != 0) digits++;
+    } else {
+      scale++;
+    }
+  }
+  if (p < field.end && *p == '.') {
+    for (p++; p < field.end && *p >= '0' && *p <= '9'; p++, any = true) {
+      if (digits < 18) {
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa != 0) digits++;
+        scale--;
+      }
+    }
+  }
+  if (!any) return false;
+  if (p < field.end && (*p == 'e' || *p == 'E')) {
+    int exponent = 0;
+    if (!ParseInt(TextSpan{p + 1, field.end}, exponent)) return false;
+    scale += exponent;
+    p = field.end;
+  }
+  if (p != field.end) return false;
+  static const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  // an integer below 2^53 divided or multiplied by an exact power of ten is rounded once
+  double result = static_cast<double>(mantissa);
+  if (scale < 0) {
+    result = -scale <= 22 ? result / kPow10[-scale] : result * std::pow(10.0, scale);
+  } else if (scale > 0) {
+    result = scale <= 22 ? result * kPow10[scale] : result * std::pow(10.0, scale);
+  }
+  value = static_cast<float>(negative ? -result : result);
+  return true;
+#endif
+}
+
+#endif  // TEXT_SCANNER_H_
@@ -29,11 +29,37 @@
 // Unit of azimuth in UDP packet 1/100
 #define HS_LIDAR_P128_AZIMUTH_UNIT_UDP (100)
 #define HS_LIDAR_P128_LASER_NUM (128)
+// Columns of firetime_correction_Pandar128.csv, distance >= A1 and < A1 for each operation mode and angle state
+#define HS_LIDAR_P128_FIRETIME_COLUMN_NUM (16)
 
+#include <memory>
 #include "GeneralParser.h"
 #include "HsLidarMeV4.h"
 
 // For Pandar128
+// Azimuth correction caused by the firetime at one spin speed, unit 1/1000 degree. Immutable once built
+struct P128FiretimeAziCorr {
+  uint16_t speed = 0;
+  int32_t corr[HS_LIDAR_P128_FIRETIME_COLUMN_NUM][HS_LIDAR_P128_LASER_NUM];
+};
+
+// firetime_correction_Pandar128.csv. Immutable once published
+struct P128Firetimes {
+  // operation mode and angle state of each column
+  uint8_t mode[HS_LIDAR_P128_FIRETIME_COLUMN_NUM] = {0};
+  uint8_t state[HS_LIDAR_P128_FIRETIME_COLUMN_NUM] = {0};
+  // firing time in us
+  float firetime[HS_LIDAR_P128_FIRETIME_COLUMN_NUM][HS_LIDAR_P128_LASER_NUM] = {{0}};
+};
+
+// All the tables a packet is decoded with, taken at once by the decoders. Immutable once published
+struct P128Calibration {
+  std::shared_ptr<const LaserCorrection> correction;
+  std::shared_ptr<const P128Firetimes> firetimes;
+  // azimuth correction of the firetimes for the last spin speed
+  std::shared_ptr<const P128FiretimeAziCorr> firetimeCorr;
+};
+
 class Udp1_4_Parser : public GeneralParser {
  public:
   Udp1_4_Parser();
@@ -41,11 +67,28 @@ class Udp1_4_Parser : public GeneralParser {
 
   dwStatus GetDecoderConstants(_dwSensorLidarDecoder_constants* constants) override;
   
-  virtual dwStatus ParserOnePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length, \
-                                   dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI) override;
+  virtual dwStatus DecodePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length,
+                                dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI, PointExtraOutput* extra,
+                                const DeskewMotion* motion, PacketDecodeInfo& info) override;
+
+  bool ParseTailStatus(const uint8_t *buffer, size_t length, TailStatus& status) override;
+
+  bool ParsePacketId(const uint8_t *buffer, size_t length, uint32_t& sequence, uint16_t& azimuth) override;
+
+  bool ScanPacket(const uint8_t *buffer, size_t length, PacketDecodeInfo& info, int64_t& sensorTime) override;
+
+  void SequencePacket(dwLidarDecodedPacket *output, const PacketDecodeInfo& info) override;
 
   int16_t GetVecticalAngle(int channel) override;
 
+  void GetMemoryUsage(MemoryUsage& usage) const override;
+
+  /**
+   * @brief Decode firetime_correction_Pandar128.csv, the firing time of each laser in us
+   * for each operation mode and angle state. Can be called while decoding, used from the next packet
+   */
+  virtual int LoadFiretimesString(const char *firetimes) override;
+
  private:
   // to be updated by the UDP packet
   int m_nLaserNum = HS_LIDAR_P128_LASER_NUM;
@@ -55,6 +98,30 @@ class Udp1_4_Parser : public GeneralParser {
   const int m_nAziUnitUDP = HS_LIDAR_P128_AZIMUTH_UNIT_UDP;
 
   unsigned long GetDataBodySize(const HS_LIDAR_HEADER_ME_V4 *pHeader);
+
+  /**
+   * @brief Column of the firetime table for the operation mode and angle state, -1 if not listed.
+   * The A1 distance threshold is not part of the file, so the column of distance >= A1 is used
+   */
+  static int GetFiretimeColumn(const P128Firetimes& firetimes, uint8_t operationMode, uint8_t angleState);
+
+  /**
+   * @brief Publish a new calibration with the firetimes given, nullptr keeps them. The azimuth correction of the
+   * firetimes is built for the speed, -1 keeps the speed of the one in use. Called by the decoders when the
+   * spin speed changes
+   * @return the calibration in use, unchanged if it already has the firetimes and the speed
+   */
+  std::shared_ptr<const P128Calibration> UpdateCalibration(std::shared_ptr<const P128Firetimes> firetimes, int speed);
+
+  void OnCorrectionPublished() override;
+
+  // Azimuth correction of the firetimes at the speed
+  std::shared_ptr<const P128FiretimeAziCorr> BuildFiretimesAziCorr(const P128Firetimes& firetimes, uint16_t speed) const;
+
+  // Replaced with 'UpdateCalibration', the decoders take it once per packet
+  std::shared_ptr<const P128Calibration> m_pCalibration;
+  // serializes 'UpdateCalibration'
+  std::mutex m_calibrationMutex;
 };
 
 #endif  // UDP1_4_PARSER_H_
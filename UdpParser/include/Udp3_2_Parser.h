@@ -34,20 +34,42 @@
 #define HS_LIDAR_QT128_COORDINATE_CORRECTION_ODOG (0.0354)
 #define HS_LIDAR_QT128_COORDINATE_CORRECTION_OGOT (-0.0072)
 
+#include <array>
+#include <memory>
 #include "GeneralParser.h"
 #include "HsLidarQTV2.h"
 
-// Default channel config is the common use of QT128, using all 128 channels
+// Default channel config is the common use of QT128, using all 128 channels. Immutable once published
 struct PandarQTChannelConfig {
  public:
-  uint16_t m_u16Sob;
-  uint8_t m_u8MajorVersion;
-  uint8_t m_u8MinVersion;
-  uint8_t m_u8LaserNum;
-  uint8_t m_u8BlockNum;
+  uint16_t m_u16Sob = 0;
+  uint8_t m_u8MajorVersion = 0;
+  uint8_t m_u8MinVersion = 0;
+  uint8_t m_u8LaserNum = 0;
+  uint8_t m_u8BlockNum = 0;
   std::vector<std::vector<int>> m_vChannelConfigTable;
   std::string m_sHashValue;
-  bool m_bIsChannelConfigObtained;
+  bool m_bIsChannelConfigObtained = false;
+};
+
+// Azimuth correction caused by the firetime at one spin speed, unit 1/1000 degree. Immutable once built
+struct QT128FiretimeAziCorr {
+  uint16_t speed = 0;
+  std::array<std::array<int32_t, HS_LIDAR_QT128_LASER_NUM>, HS_LIDAR_QT128_LOOP_NUM> corr;
+};
+
+// Firing time of each laser for every loop in us. Immutable once published
+struct QT128Firetimes {
+  std::array<std::array<float, HS_LIDAR_QT128_LASER_NUM>, HS_LIDAR_QT128_LOOP_NUM> firetime;
+};
+
+// All the tables a packet is decoded with, taken at once by the decoders. Immutable once published
+struct QT128Calibration {
+  std::shared_ptr<const LaserCorrection> correction;
+  std::shared_ptr<const QT128Firetimes> firetimes;
+  std::shared_ptr<const PandarQTChannelConfig> channelConfig;
+  // azimuth correction of the firetimes for the last spin speed
+  std::shared_ptr<const QT128FiretimeAziCorr> firetimeCorr;
 };
 
 class Udp3_2_Parser : public GeneralParser {
@@ -57,8 +79,19 @@ class Udp3_2_Parser : public GeneralParser {
 
   dwStatus GetDecoderConstants(_dwSensorLidarDecoder_constants* constants) override;
 
-  virtual dwStatus ParserOnePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length, \
-                                   dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI) override;     
+  virtual dwStatus DecodePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length,
+                                dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI, PointExtraOutput* extra,
+                                const DeskewMotion* motion, PacketDecodeInfo& info) override;
+
+  bool ParseTailStatus(const uint8_t *buffer, size_t length, TailStatus& status) override;
+
+  bool ParsePacketId(const uint8_t *buffer, size_t length, uint32_t& sequence, uint16_t& azimuth) override;
+
+  bool ScanPacket(const uint8_t *buffer, size_t length, PacketDecodeInfo& info, int64_t& sensorTime) override;
+
+  RangeImageLayout GetRangeImageLayout() const override;
+
+  void GetMemoryUsage(MemoryUsage& usage) const override;
 
   /**
    * @brief Get vertical angle of each laser channel
@@ -68,25 +101,38 @@ class Udp3_2_Parser : public GeneralParser {
    */
   int16_t GetVecticalAngle(int channel) override;
 
+  /**
+   * @brief Decode the firetime of each laser for every loop, only the first HS_LIDAR_QT128_LOOP_NUM loops are used.
+   * Can be called while decoding, the new firetimes are used from the next packet
+   */
   virtual int LoadFiretimesString(const char *firetimes) override;
-  virtual void LoadFiretimesFile(std::string firetimes_path) override;
   
   /**
-   * @brief Initialize the m_PandarQTChannelConfig, specialized for QT
+   * @brief Initialize the channel config, specialized for QT. Can be called while decoding
    */
   virtual int LoadChannelConfigString(const char *channelconfig) override;
   virtual void LoadChannelConfigFile(std::string channel_config_path) override;
 
  private:
-  virtual double GetFiretimesCorrection(int laserId, double speed, int loopIndex);
+  /**
+   * @brief Publish a new calibration with the tables given, the others are kept. The azimuth correction of the
+   * firetimes is built for the speed, -1 keeps the speed of the one in use. Called by the decoders when the
+   * spin speed changes
+   * @return the calibration in use, unchanged if it already has the tables and the speed
+   */
+  std::shared_ptr<const QT128Calibration> UpdateCalibration(std::shared_ptr<const QT128Firetimes> firetimes,
+                                                            std::shared_ptr<const PandarQTChannelConfig> channelConfig,
+                                                            int speed);
 
-  // To be initialized by func 'LoadFiretimesString'
-  std::array<std::array<float, HS_LIDAR_QT128_LASER_NUM>, HS_LIDAR_QT128_LOOP_NUM> m_vQT128Firetime;
-  // To be initialized by func 'LoadChannelConfigString'
-  PandarQTChannelConfig m_PandarQTChannelConfig;
-  
-  // Only for QT128 and etc，not for AT128
-  std::vector<double> m_vFiretimeCorrection;
+  void OnCorrectionPublished() override;
+
+  // Azimuth correction of each laser and loop caused by the firetime at the speed
+  static std::shared_ptr<const QT128FiretimeAziCorr> BuildFiretimesAziCorr(const QT128Firetimes& firetimes, uint16_t speed);
+
+  // Replaced with 'UpdateCalibration', the decoders take it once per packet
+  std::shared_ptr<const QT128Calibration> m_pCalibration;
+  // serializes 'UpdateCalibration'
+  std::mutex m_calibrationMutex;
 };
 
 #endif  // UDP3_2_PARSER_H_
@@ -37,6 +37,7 @@
 #define PANDAR_AT128_EDGE_AZIMUTH_SIZE (1600)
 
 #include <array>
+#include <memory>
 #include "GeneralParser.h"
 
 struct PandarATCorrectionsHeader {
@@ -55,10 +56,9 @@ struct PandarATFrameInfo {
   uint32_t end_frame[8];
   int32_t azimuth[AT128_LASER_NUM];
   int32_t elevation[AT128_LASER_NUM];
-  std::array<float, MAX_AZI_LEN> sin_map;
-  std::array<float, MAX_AZI_LEN> cos_map;
 };
 
+// Immutable once published
 struct PandarATCorrections {
  public:
   PandarATCorrectionsHeader header;
@@ -70,14 +70,6 @@ struct PandarATCorrections {
   int8_t elevation_offset[CIRCLE_ANGLE];
   uint8_t SHA256[32];
   PandarATFrameInfo l;  // V1.5
-  std::array<float, MAX_AZI_LEN> sin_map;
-  std::array<float, MAX_AZI_LEN> cos_map;
-  PandarATCorrections() {
-    for (int i = 0; i < MAX_AZI_LEN; ++i) {
-      sin_map[i] = std::sin(2 * i * M_PI / MAX_AZI_LEN);
-      cos_map[i] = std::cos(2 * i * M_PI / MAX_AZI_LEN);
-    }
-  }
   static const int STEP = CORRECTION_AZIMUTH_STEP;
   int8_t getAzimuthAdjust(uint8_t ch, uint16_t azi) const {
     unsigned int i = std::floor(1.f * azi / STEP);
@@ -117,16 +109,32 @@ class Udp4_3_Parser : public GeneralParser {
 
   virtual dwStatus GetDecoderConstants(_dwSensorLidarDecoder_constants* constants) override;
   
-  virtual dwStatus ParserOnePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length, \
-                                   dwLidarPointXYZI* data, dwLidarPointRTHI* pointRTHI) override;     
+  virtual dwStatus DecodePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length,
+                                dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI, PointExtraOutput* extra,
+                                const DeskewMotion* motion, PacketDecodeInfo& info) override;
+
+  bool ParseTailStatus(const uint8_t *buffer, size_t length, TailStatus& status) override;
+
+  bool ParsePacketId(const uint8_t *buffer, size_t length, uint32_t& sequence, uint16_t& azimuth) override;
+
+  bool ScanPacket(const uint8_t *buffer, size_t length, PacketDecodeInfo& info, int64_t& sensorTime) override;
+
+  RangeImageLayout GetRangeImageLayout() const override;
+
+  int BindNumaNode(int node) override;
+
+  void GetMemoryUsage(MemoryUsage& usage) const override;
   
   // Get vectical angle of each channel from PandarATCorrections
   int16_t GetVecticalAngle(int channel) override;
 
 private:
   int ParseCorrectionString(char *correction_string) override;
-  // Save correction file of azimuth and elevation
-  PandarATCorrections m_PandarAT_corrections;
+  // Save correction file of azimuth and elevation, replaced with 'PublishCalibration'
+  std::shared_ptr<const PandarATCorrections> m_pCorrections;
+  // 36 MB each, in huge pages as they are looked up randomly. They do not depend on the correction
+  HugePageArray<float> m_fSinMap;
+  HugePageArray<float> m_fCosMap;
 };
 
 #endif  // UDP4_3_PARSER_H_
@@ -16,12 +16,13 @@
 //
 /////////////////////////////////////////////////////////////////////////////////////////
 
-#include <sstream>
 #include "GeneralParser.h"
+#include "TextScanner.h"
 
 const std::string GeneralParser::kLidarIPAddr("192.168.1.201");
 
-GeneralParser::GeneralParser() {
+GeneralParser::GeneralParser()
+    : m_fCosAllAngle(CIRCLE), m_fSinAllAngle(CIRCLE) {
   for(int i = 0; i < CIRCLE; ++i) {
       m_fSinAllAngle[i] = std::sin(2 * M_PI * i / CIRCLE);
       m_fCosAllAngle[i] = std::cos(2 * M_PI * i / CIRCLE);
@@ -34,21 +35,13 @@ GeneralParser::~GeneralParser() {
 
 int GeneralParser::LoadCorrectionFile(std::string correction_path) {
   // printf("GeneralParser: load correction file, path=%s \n", correction_path.c_str());
-  std::ifstream fin(correction_path);
-  if (fin.is_open() == false) {
+  std::vector<char> buffer;
+  if (!ReadTextFile(correction_path, buffer)) {
     printf("Open correction file Error, path=%s\n", correction_path.c_str());
     return -1;
   }
-  int length = 0;
-  fin.seekg(0, std::ios::end);
-  length = fin.tellg();
-  fin.seekg(0, std::ios::beg);
-  char *buffer = new char[length];
-  fin.read(buffer, length);
-  fin.close();
 
-  int ret = ParseCorrectionString(buffer);
-  delete[] buffer;
+  int ret = ParseCorrectionString(buffer.data());
   if (ret != 0) {
     printf("Parse local correction file Error\n");
   } 
@@ -56,62 +49,81 @@ int GeneralParser::LoadCorrectionFile(std::string correction_path) {
   return ret;
 }
 
+bool GeneralParser::ReadTextFile(const std::string& path, std::vector<char>& buffer) {
+  FILE* fp = fopen(path.c_str(), "rb");
+  if (fp == nullptr) {
+    return false;
+  }
+  bool ok = fseek(fp, 0, SEEK_END) == 0;
+  long length = ok ? ftell(fp) : -1;
+  ok = length >= 0 && fseek(fp, 0, SEEK_SET) == 0;
+  if (ok) {
+    buffer.resize(length + 1);
+    ok = fread(buffer.data(), 1, length, fp) == static_cast<size_t>(length);
+    // the parsers take zero terminated strings
+    buffer[length] = '\0';
+  }
+  fclose(fp);
+  return ok;
+}
+
 int GeneralParser::ParseCorrectionString(char* correction_content) {
   // printf("ParseCorrectionString: parsing calibration content\n %s \n", correction_content);
-  std::string correction_content_str = correction_content;
-	std::istringstream ifs(correction_content_str);
-	std::string line;
-
-	// skip first line "Laser id,Elevation,Azimuth" or "eeff"
-  std::getline(ifs, line);
-
-	float elevationList[MAX_LASER_NUM], azimuthList[MAX_LASER_NUM];
-	std::vector<std::string>  vfirstLine;
-  HSSplit(vfirstLine, line, ',');
-	if(vfirstLine[0] == "EEFF" || vfirstLine[0] == "eeff"){
-		// skip second line
-    std::getline(ifs, line);
-	}
-    
+  return ParseCorrectionCsv(correction_content, strlen(correction_content));
+}
+
+int GeneralParser::ParseCorrectionCsv(const char* data, size_t size) {
+  TextScanner scanner(data, size);
+  TextSpan line;
+  TextSpan field;
+
+  // skip first line "Laser id,Elevation,Azimuth" or "eeff"
+  if (!scanner.NextLine(line)) {
+    printf("ParseCorrectionString: empty correction Error\n");
+    return -1;
+  }
+  FieldScanner firstLine(line);
+  firstLine.Next(field);
+  if (field.EqualsNoCase("eeff")) {
+    // skip second line
+    scanner.NextLine(line);
+  }
+
+  int32_t elevationList[MAX_LASER_NUM], azimuthList[MAX_LASER_NUM];
   int lineCount = 0;
-  while (std::getline(ifs, line)) {
-    std::vector<std::string>  vLineSplit;
-    HSSplit(vLineSplit, line, ',');
-    if (vLineSplit.size() < 3) { // skip error line or hash value line 
-        continue;
-    } else {
-        lineCount++;
+  while (scanner.NextLine(line)) {
+    FieldScanner fields(line);
+    if (fields.Count() < 3) { // skip error line or hash value line 
+      continue;
     }
-    float elevation, azimuth;
+    lineCount++;
     int laserId = 0;
-
-    std::stringstream ss(line);
-    std::string subline;
-    std::getline(ss, subline, ',');
-    std::stringstream(subline) >> laserId;
-    std::getline(ss, subline, ',');
-    std::stringstream(subline) >> elevation;
-    std::getline(ss, subline, ',');
-    std::stringstream(subline) >> azimuth;
-
+    float elevation = 0, azimuth = 0;
+    fields.Next(field);
+    ParseInt(field, laserId);
     if (laserId != lineCount || laserId >= MAX_LASER_NUM) {
-        printf("ParseCorrectionString: laser id Error. laser Id=%d, line=%d", laserId, lineCount);
-        return -1;
+      printf("ParseCorrectionString: laser id Error. laser Id=%d, line=%d\n", laserId, lineCount);
+      return -1;
+    }
+    fields.Next(field);
+    bool ok = ParseFloat(field, elevation);
+    fields.Next(field);
+    ok = ParseFloat(field, azimuth) && ok;
+    if (!ok) {
+      printf("ParseCorrectionString: angle Error. laser Id=%d\n", laserId);
+      return -1;
     }
-    elevationList[laserId - 1] = elevation;
-    azimuthList[laserId - 1] = azimuth;
+    elevationList[laserId - 1] = static_cast<int32_t> (round(elevation * m_iAziCorrUnit));
+    azimuthList[laserId - 1] = static_cast<int32_t> (round(azimuth * m_iAziCorrUnit));
   }
-  m_vEleCorrection.resize(lineCount);
-  m_vAziCorrection.resize(lineCount);
-
-	for (int i = 0; i < lineCount; ++i) {
-		m_vEleCorrection[i] = static_cast<int32_t> (round(elevationList[i] * m_iAziCorrUnit));
-		m_vAziCorrection[i] = static_cast<int32_t> (round(azimuthList[i] * m_iAziCorrUnit));
-    // printf("m_vEleCorrection, %d  m_vAziCorrection, %d \n", m_vEleCorrection[i], m_vAziCorrection[i]);
-	}
+  auto correction = std::make_shared<LaserCorrection>();
+  correction->elevation.assign(elevationList, elevationList + lineCount);
+  correction->azimuth.assign(azimuthList, azimuthList + lineCount);
+  PublishCalibration(m_pLaserCorrection, std::shared_ptr<const LaserCorrection>(correction));
+  OnCorrectionPublished();
 
   m_bGetCorrectionFile = true;
-	return 0;
+  return 0;
 }
 
 int GeneralParser::LoadFiretimesString(const char *firetimes) {
@@ -122,10 +134,136 @@ int GeneralParser::LoadFiretimesString(const char *firetimes) {
 }
 
 void GeneralParser::LoadFiretimesFile(std::string firetimes_path) {
-  printf("GeneralParser::LoadFiretimesFile, no load\n");
-  (void) firetimes_path;
+  std::vector<char> buffer;
+  if (!ReadTextFile(firetimes_path, buffer)) {
+    printf("LoadFiretimesFile: Open firetimes file Error, path=%s\n", firetimes_path.c_str());
+    return;
+  }
 
-  return;
+  int ret = LoadFiretimesString(buffer.data());
+  if (ret != 0) {
+    printf("LoadFiretimesFile: Parse local firetimes file Error\n");
+  }
+}
+
+void GeneralParser::SetDeskewMotion(const DeskewMotion& motion) {
+  std::lock_guard<std::mutex> lock(m_deskewMutex);
+  m_deskewMotion = motion;
+  m_bDeskew = true;
+}
+
+void GeneralParser::DisableDeskew() {
+  std::lock_guard<std::mutex> lock(m_deskewMutex);
+  m_bDeskew = false;
+}
+
+bool GeneralParser::GetDeskewMotion(DeskewMotion& motion) {
+  std::lock_guard<std::mutex> lock(m_deskewMutex);
+  if (!m_bDeskew) return false;
+  motion = m_deskewMotion;
+  if (motion.referenceTime == 0) {
+    motion.referenceTime = m_i64ScanStartTime;
+  }
+  return true;
+}
+
+dwStatus GeneralParser::ParserOnePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length,
+                                        dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI,
+                                        PointExtraOutput* extra) {
+  // single thread, the deskew is fused in the decode loop
+  DeskewMotion motion;
+  PacketDecodeInfo info;
+  dwStatus ret = DecodePacket(output, buffer, length, pointXYZI, pointRTHI, extra,
+                              GetDeskewMotion(motion) ? &motion : nullptr, info);
+  if (ret != DW_SUCCESS) info.splitAzimuthNum = 0;
+  SequencePacket(output, info);
+  return ret;
+}
+
+void GeneralParser::SequencePacket(dwLidarDecodedPacket *output, const PacketDecodeInfo& info) {
+  if (info.hasTail) {
+    m_u16SpinSpeed = info.spinSpeed;
+    m_bIsDualReturn = info.isDualReturn;
+  }
+  if (info.splitAzimuthNum == 0) return;
+
+  if (m_i64ScanStartTime == 0) {
+    m_i64ScanStartTime = output->sensorTimestamp;
+  }
+  for (int i = 0; i < info.splitAzimuthNum; i++) {
+    if (IsNeedFrameSplit(info.splitAzimuth[i])) {
+      output->scanComplete = true;
+    }
+    m_u16LastAzimuth = info.splitAzimuth[i];
+  }
+  // the next packet starts a new scan
+  if (output->scanComplete) m_i64ScanStartTime = 0;
+}
+
+void GeneralParser::DeskewPoints(dwLidarPointXYZI* pointXYZI, const dwTime_t* pointTimestamp, uint32_t pointNum,
+                                 int64_t packetTime, CompactPoint* compactPoint) {
+  DeskewMotion motion;
+  if (pointTimestamp == nullptr || !GetDeskewMotion(motion)) return;
+  if (motion.referenceTime == 0) motion.referenceTime = packetTime;
+  for (uint32_t i = 0; i < pointNum; i++) {
+    FinishPoint(pointXYZI[i], nullptr, pointTimestamp[i], &motion);
+    if (compactPoint != nullptr) {
+      PackCompactPoint(compactPoint[i], pointXYZI[i], compactPoint[i].laserId);
+    }
+  }
+}
+
+int GeneralParser::BindNumaNode(int node) {
+  int ret = m_fCosAllAngle.BindNode(node);
+  ret |= m_fSinAllAngle.BindNode(node);
+  return ret;
+}
+
+void GeneralParser::GetMemoryUsage(MemoryUsage& usage) const {
+  usage.Add("parser tables", m_fCosAllAngle.bytes() + m_fSinAllAngle.bytes(), 0,
+            m_fCosAllAngle.ResidentBytes() + m_fSinAllAngle.ResidentBytes());
+  std::shared_ptr<const LaserCorrection> correction = std::atomic_load(&m_pLaserCorrection);
+  if (correction != nullptr) {
+    size_t bytes = sizeof(LaserCorrection) + (correction->elevation.capacity() + correction->azimuth.capacity()) * sizeof(int32_t);
+    usage.Add("calibration", 0, bytes, bytes);
+  }
+}
+
+bool GeneralParser::ParseTailStatus(const uint8_t *buffer, size_t length, TailStatus& status) {
+  (void) buffer;
+  (void) length;
+  (void) status;
+
+  return false;
+}
+
+bool GeneralParser::ParsePacketId(const uint8_t *buffer, size_t length, uint32_t& sequence, uint16_t& azimuth) {
+  (void) buffer;
+  (void) length;
+  (void) sequence;
+  (void) azimuth;
+
+  return false;
+}
+
+bool GeneralParser::ScanPacket(const uint8_t *buffer, size_t length, PacketDecodeInfo& info, int64_t& sensorTime) {
+  (void) buffer;
+  (void) length;
+  (void) info;
+  (void) sensorTime;
+
+  return false;
+}
+
+RangeImageLayout GeneralParser::GetRangeImageLayout() const {
+  RangeImageLayout layout;
+  layout.rows = 128;
+  layout.cols = 3600;
+  layout.returns = 2;
+  layout.azimuthStart = 0;
+  layout.azimuthStep = 100;
+  layout.unitsPerRev = CIRCLE;
+  return layout;
 }
 
 int GeneralParser::LoadChannelConfigString(const char *channelconfig) {
@@ -143,7 +281,11 @@ void GeneralParser::LoadChannelConfigFile(std::string channel_config_path) {
 }
 
 int16_t GeneralParser::GetVecticalAngle(int channel) {
-  return m_vEleCorrection[channel];
+  std::shared_ptr<const LaserCorrection> correction = GetLaserCorrection();
+  if (correction == nullptr || channel < 0 || static_cast<size_t>(channel) >= correction->elevation.size()) {
+    return -1;
+  }
+  return correction->elevation[channel];
 }
 
 bool GeneralParser::IsNeedFrameSplit(uint16_t azimuth) {
@@ -161,7 +303,7 @@ int64_t GeneralParser::GetMicroLidarTimeU64(const uint8_t* utc, int size, uint32
   }
 
   if (utc[0] != 0) {
-    struct tm t = {0};
+    struct tm t = {};
     t.tm_year = utc[0];
     if (t.tm_year >= 200) {
       t.tm_year -= 100;
@@ -201,9 +343,9 @@ dwStatus GeneralParser::ComputeDwPoint(dwLidarPointXYZI& pointXYZI, dwLidarPoint
   return DW_SUCCESS;
 }
 
-int32_t GeneralParser::CalibrateAzimuth(int32_t azimuth, unsigned int laserID) {
+int32_t GeneralParser::CalibrateAzimuth(int32_t azimuth, unsigned int laserID, const LaserCorrection& correction) {
   // azimuth from UDP packet has unit 100, but correction file is 1000
-  int32_t result = azimuth * 10 + this->m_vAziCorrection[laserID];
+  int32_t result = azimuth * 10 + correction.azimuth[laserID];
   result = (CIRCLE + result) % CIRCLE;
   // printf("azimuth=%d \n", result);
   
@@ -0,0 +1,131 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include "HugePageAllocator.h"
+
+static size_t RoundUpHugePage(size_t size) {
+  return (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+static std::atomic<bool> g_bHugePageEnabled{true};
+
+void HugePageSetEnabled(bool enabled) {
+  g_bHugePageEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void* HugePageAlloc(size_t size, bool* isHugeTlb) {
+  if (isHugeTlb != nullptr) *isHugeTlb = false;
+  if (size == 0) return nullptr;
+  size_t length = RoundUpHugePage(size);
+
+  if (!g_bHugePageEnabled.load(std::memory_order_relaxed)) {
+    // same length as the huge page mapping, so HugePageFree is the same
+    void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+      printf("HugePageAlloc: mmap Error, size=%zu\n", size);
+      return nullptr;
+    }
+#ifdef MADV_NOHUGEPAGE
+    madvise(ptr, length, MADV_NOHUGEPAGE);
+#endif
+    return ptr;
+  }
+
+#ifdef MAP_HUGETLB
+  void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (ptr != MAP_FAILED) {
+    if (isHugeTlb != nullptr) *isHugeTlb = true;
+    return ptr;
+  }
+#endif
+
+  // no reserved huge pages, over-map to align to 2 MB so that THP can back every page
+  size_t mapLength = length + HUGE_PAGE_SIZE;
+  uint8_t* base = static_cast<uint8_t*>(
+      mmap(nullptr, mapLength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (base == MAP_FAILED) {
+    printf("HugePageAlloc: mmap Error, size=%zu\n", size);
+    return nullptr;
+  }
+  uintptr_t aligned = (reinterpret_cast<uintptr_t>(base) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  size_t head = aligned - reinterpret_cast<uintptr_t>(base);
+  if (head > 0) munmap(base, head);
+  if (HUGE_PAGE_SIZE - head > 0) munmap(reinterpret_cast<uint8_t*>(aligned) + length, HUGE_PAGE_SIZE - head);
+#ifdef MADV_HUGEPAGE
+  madvise(reinterpret_cast<void*>(aligned), length, MADV_HUGEPAGE);
+#endif
+  return reinterpret_cast<void*>(aligned);
+}
+
+void HugePageFree(void* ptr, size_t size) {
+  if (ptr == nullptr || size == 0) return;
+  munmap(ptr, RoundUpHugePage(size));
+}
+
+void HugePagePrefault(void* ptr, size_t size) {
+  if (ptr == nullptr) return;
+  // one write per 4 KB page, pages already there are not changed
+  volatile uint8_t* p = static_cast<volatile uint8_t*>(ptr);
+  for (size_t offset = 0; offset < size; offset += 4096) {
+    p[offset] = p[offset];
+  }
+}
+
+int HugePageBindNode(void* ptr, size_t size, int node) {
+  if (ptr == nullptr || node < 0 || node >= 64) return -1;
+  unsigned long nodeMask = 1UL << node;
+  long ret = syscall(SYS_mbind, ptr, RoundUpHugePage(size), MPOL_BIND, &nodeMask, 64, MPOL_MF_MOVE);
+  if (ret != 0) {
+    printf("HugePageBindNode: mbind Error, node=%d\n", node);
+    return -1;
+  }
+  return 0;
+}
+
+int HugePageCurrentNode() {
+  unsigned int cpu = 0;
+  unsigned int node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return 0;
+  return static_cast<int>(node);
+}
+
+size_t HugePageResidentBytes(const void* ptr, size_t size) {
+  if (ptr == nullptr || size == 0) return 0;
+  const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t begin = reinterpret_cast<uintptr_t>(ptr) / pageSize * pageSize;
+  uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + size + pageSize - 1) / pageSize * pageSize;
+  // a fixed vector per call, a 36000*256 float table is checked in a few chunks
+  unsigned char vec[4096];
+  size_t resident = 0;
+  for (uintptr_t chunk = begin; chunk < end; chunk += sizeof(vec) * pageSize) {
+    size_t length = end - chunk < sizeof(vec) * pageSize ? end - chunk : sizeof(vec) * pageSize;
+    if (mincore(reinterpret_cast<void*>(chunk), length, vec) != 0) return 0;
+    for (size_t i = 0; i < length / pageSize; i++) {
+      if (vec[i] & 1) resident += pageSize;
+    }
+  }
+  // the first and last pages may be shared with other data
+  return resident < size ? resident : size;
+}
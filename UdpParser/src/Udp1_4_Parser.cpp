@@ -18,6 +18,7 @@
 
 #include <iostream>
 #include "Udp1_4_Parser.h"
+#include "TextScanner.h"
 
 Udp1_4_Parser::Udp1_4_Parser() {}
 
@@ -52,9 +53,10 @@ dwStatus Udp1_4_Parser::GetDecoderConstants(_dwSensorLidarDecoder_constants* con
     // From Pandar128 manual or correction file to take the first and last value
     constants->properties.verticalFOVStart = deg2Rad(-14);
     constants->properties.verticalFOVEnd = deg2Rad(26);
+    std::shared_ptr<const LaserCorrection> correction = GetLaserCorrection();
     for (int i = 0; i < m_nLaserNum; i++) {
-        if(m_bGetCorrectionFile == true && m_vEleCorrection.empty() == false) {
-            constants->properties.verticalAngles[i] = deg2Rad(m_vEleCorrection[i] / m_iAziCorrUnit);
+        if(correction != nullptr && static_cast<size_t>(i) < correction->elevation.size()) {
+            constants->properties.verticalAngles[i] = deg2Rad(correction->elevation[i] / m_iAziCorrUnit);
             // printf("verticalAngles: %f \n", constants->properties.verticalAngles[i]);
         }
     }
@@ -63,9 +65,95 @@ dwStatus Udp1_4_Parser::GetDecoderConstants(_dwSensorLidarDecoder_constants* con
     return DW_SUCCESS;
 }
 
-dwStatus Udp1_4_Parser::ParserOnePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length, \
-                                  dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI) {
-  if (buffer[0] != 0xEE || buffer[1] != 0xFF || length < 0) {
+bool Udp1_4_Parser::ParseTailStatus(const uint8_t *buffer, size_t length, TailStatus& status) {
+  if (length < sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_ME_V4) || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+    return false;
+  }
+  const HS_LIDAR_HEADER_ME_V4 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_ME_V4 *>(&(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  size_t bodyEnd = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_ME_V4) + GetDataBodySize(pHeader) +
+                   sizeof(HS_LIDAR_BODY_CRC_ME_V4);
+  size_t tailOffset = bodyEnd + (pHeader->HasFuncSafety() ? sizeof(HS_LIDAR_FUNC_SAFETY_ME_V4) : 0);
+  if (tailOffset + sizeof(HS_LIDAR_TAIL_ME_V4) > length) {
+    return false;
+  }
+  const auto *pTail = reinterpret_cast<const HS_LIDAR_TAIL_ME_V4 *>(buffer + tailOffset);
+  status.statusNum = 3;
+  status.statusId[0] = pTail->GetStsID0();
+  status.statusData[0] = pTail->GetData0();
+  status.statusId[1] = pTail->GetStsID1();
+  status.statusData[1] = pTail->GetData1();
+  status.statusId[2] = pTail->GetStsID2();
+  status.statusData[2] = pTail->GetData2();
+  status.motorSpeed = pTail->GetMotorSpeed();
+  status.returnMode = pTail->GetReturnMode();
+  status.shutdown = pTail->HasShutdown();
+  status.hasFuncSafety = pHeader->HasFuncSafety();
+  if (status.hasFuncSafety) {
+    const auto *pSafety = reinterpret_cast<const HS_LIDAR_FUNC_SAFETY_ME_V4 *>(buffer + bodyEnd);
+    status.lidarState = pSafety->GetLidarState();
+    status.currentFault = pSafety->IsCurrentFault();
+    status.historyFault = pSafety->IsHistoryFault();
+    status.faultNum = pSafety->GetFaultNum();
+    status.faultId = pSafety->GetFaultID();
+    status.faultCode = pSafety->GetFaultCode();
+  }
+  return true;
+}
+
+bool Udp1_4_Parser::ParsePacketId(const uint8_t *buffer, size_t length, uint32_t& sequence, uint16_t& azimuth) {
+  size_t bodyOffset = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_ME_V4);
+  if (length < bodyOffset + sizeof(HS_LIDAR_BODY_AZIMUTH_ME_V4) || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+    return false;
+  }
+  const HS_LIDAR_HEADER_ME_V4 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_ME_V4 *>(&(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  azimuth = reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_ME_V4 *>(buffer + bodyOffset)->GetAzimuth();
+  // the sequence number follows the tail
+  size_t seqOffset = bodyOffset + GetDataBodySize(pHeader) + sizeof(HS_LIDAR_BODY_CRC_ME_V4) +
+                     (pHeader->HasFuncSafety() ? sizeof(HS_LIDAR_FUNC_SAFETY_ME_V4) : 0) + sizeof(HS_LIDAR_TAIL_ME_V4);
+  sequence = 0;
+  if (pHeader->HasSeqNum() && seqOffset + sizeof(HS_LIDAR_TAIL_SEQ_NUM_ME_V4) <= length) {
+    sequence = reinterpret_cast<const HS_LIDAR_TAIL_SEQ_NUM_ME_V4 *>(buffer + seqOffset)->GetSeqNum();
+  }
+  return true;
+}
+
+bool Udp1_4_Parser::ScanPacket(const uint8_t *buffer, size_t length, PacketDecodeInfo& info, int64_t& sensorTime) {
+  size_t bodyOffset = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_ME_V4);
+  if (length < bodyOffset || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+    return false;
+  }
+  const HS_LIDAR_HEADER_ME_V4 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_ME_V4 *>(&(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  size_t tailOffset = bodyOffset + GetDataBodySize(pHeader) + sizeof(HS_LIDAR_BODY_CRC_ME_V4) +
+                      (pHeader->HasFuncSafety() ? sizeof(HS_LIDAR_FUNC_SAFETY_ME_V4) : 0);
+  if (tailOffset + sizeof(HS_LIDAR_TAIL_ME_V4) > length) {
+    return false;
+  }
+  const auto *pTail = reinterpret_cast<const HS_LIDAR_TAIL_ME_V4 *>(buffer + tailOffset);
+  info.hasTail = true;
+  info.spinSpeed = pTail->m_u16MotorSpeed;
+  info.isDualReturn = pTail->IsDualReturn();
+  info.laserNum = pHeader->GetLaserNum();
+  info.blockNum = pHeader->GetBlockNum();
+  sensorTime = this->GetMicroLidarTimeU64(pTail->m_u8UTC, 6, pTail->GetTimestamp());
+  // the blocks with confidence are not decoded, so not checked for the split either
+  if (pHeader->HasConfidenceLevel()) {
+    return true;
+  }
+  const size_t blockSize = sizeof(HS_LIDAR_BODY_AZIMUTH_ME_V4) + sizeof(HS_LIDAR_BODY_CHN_UNIT_NO_CONF_ME_V4) * info.laserNum;
+  for (int blockID = 0; blockID < info.blockNum; blockID++) {
+    info.AddSplitAzimuth(
+        reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_ME_V4 *>(buffer + bodyOffset + blockSize * blockID)->GetAzimuth());
+  }
+  return true;
+}
+
+dwStatus Udp1_4_Parser::DecodePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length,
+                                     dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI, PointExtraOutput* extra,
+                                     const DeskewMotion* motion, PacketDecodeInfo& info) {
+  if (length < 2 || buffer[0] != 0xEE || buffer[1] != 0xFF) {
     printf("Udp1_4_Parser: ParserOnePacket, invalid packet %x %x\n", buffer[0], buffer[1]);
     return DW_FAILURE;
   }
@@ -78,8 +166,9 @@ dwStatus Udp1_4_Parser::ParserOnePacket(dwLidarDecodedPacket *output, const uint
       reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_ME_V4 *>(
           (const unsigned char *)pHeader + sizeof(HS_LIDAR_HEADER_ME_V4));
   int32_t azimuth = pAzimuth->GetAzimuth();
-  m_nBlockNum = pHeader->GetBlockNum();
-  m_nLaserNum = pHeader->GetLaserNum();
+  // packets may differ from the member defaults, which are only updated in 'SequencePacket'
+  const int blockNum = pHeader->GetBlockNum();
+  const int laserNum = pHeader->GetLaserNum();
   // pAzimuth->Print();
   
   const auto *pTail = reinterpret_cast<const HS_LIDAR_TAIL_ME_V4 *>(
@@ -87,27 +176,50 @@ dwStatus Udp1_4_Parser::ParserOnePacket(dwLidarDecodedPacket *output, const uint
       GetDataBodySize(pHeader) + sizeof(HS_LIDAR_BODY_CRC_ME_V4) + 
       (pHeader->HasFuncSafety() ? sizeof(HS_LIDAR_FUNC_SAFETY_ME_V4) : 0));
   // pTail->Print();
-  m_u16SpinSpeed = pTail->m_u16MotorSpeed;
-  m_bIsDualReturn = pTail->IsDualReturn();
+  info.hasTail = true;
+  info.spinSpeed = pTail->m_u16MotorSpeed;
+  info.isDualReturn = pTail->IsDualReturn();
+  info.laserNum = laserNum;
+  info.blockNum = blockNum;
   output->duration =  pTail->GetMicroLidarTimeU64() - 100000;
   output->hostTimestamp = 0;
-  output->maxPoints = m_nBlockNum * m_nLaserNum;
-  if (m_vEleCorrection.empty() == true) {
+  output->maxPoints = blockNum * laserNum;
+  // the calibration of the whole packet is taken once, a reload is used from the next packet
+  std::shared_ptr<const P128Calibration> calibration = std::atomic_load(&m_pCalibration);
+  if (calibration != nullptr && calibration->firetimes != nullptr && (calibration->firetimeCorr == nullptr ||
+      calibration->firetimeCorr->speed != pTail->GetMotorSpeed())) {
+    calibration = UpdateCalibration(nullptr, pTail->GetMotorSpeed());
+  }
+  const LaserCorrection* pCorrection = calibration != nullptr ? calibration->correction.get() : nullptr;
+  if (pCorrection == nullptr || pCorrection->elevation.size() < static_cast<size_t>(laserNum)) {
     // printf("Udp1_4_Parser: ParserOnePacket, no calibration string loaded Error \n");
     return DW_FAILURE;
   }
-  output->maxVerticalAngleRad = m_vEleCorrection[m_nLaserNum - 1] / 1000 / 180 * M_PI;
-  output->minVerticalAngleRad = m_vEleCorrection[0] / 1000 / 180 * M_PI;
-  output->nPoints = m_nBlockNum * m_nLaserNum;
+  const P128Firetimes* pFiretimes = calibration->firetimes.get();
+  const P128FiretimeAziCorr* pFiretimeCorr = calibration->firetimeCorr.get();
+  output->maxVerticalAngleRad = pCorrection->elevation[laserNum - 1] / 1000 / 180 * M_PI;
+  output->minVerticalAngleRad = pCorrection->elevation[0] / 1000 / 180 * M_PI;
+  output->nPoints = blockNum * laserNum;
   // scanComplete must be filled or it cracks
   output->scanComplete = false;
   // output->sensorTimestamp = GetMicroLidarTimeU64(pTail->m_u8UTC, 6, pTail->GetTimestamp());
   output->sensorTimestamp = this->GetMicroLidarTimeU64(pTail->m_u8UTC, 6, pTail->GetTimestamp());
 
+  // the tail timestamp belongs to the first block, the others follow the spin
+  const int32_t firstAzimuth = azimuth;
+  const float revPerUs = pTail->GetMotorSpeed() / 60e6f;
+  dwTime_t* pointTimestamp = extra != nullptr ? extra->pointTimestamp : nullptr;
+  DeskewMotion packetMotion;
+  const DeskewMotion* pMotion = ResolveDeskewMotion(motion, packetMotion, output->sensorTimestamp);
+  const bool bPointTime = pointTimestamp != nullptr || pMotion != nullptr;
+  RangeImage* pImage = extra != nullptr ? extra->rangeImage : nullptr;
+  if (pImage != nullptr && pImage->timestamp == 0) pImage->timestamp = output->sensorTimestamp;
+  CompactPoint* pCompact = extra != nullptr ? extra->compactPoint : nullptr;
+
   int index = 0;
   float minAzimuth = -361;
   float maxAzimuth = 361;
-  for (int blockID = 0; blockID < m_nBlockNum; blockID++) {
+  for (int blockID = 0; blockID < blockNum; blockID++) {
     // point to channel unit addr
     if (pHeader->HasConfidenceLevel()) {
       printf("Not supported! HasConfidenceLevel");
@@ -121,25 +233,44 @@ dwStatus Udp1_4_Parser::ParserOnePacket(dwLidarDecodedPacket *output, const uint
       pAzimuth = reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_ME_V4 *>(
           (const unsigned char *)pAzimuth +
           sizeof(HS_LIDAR_BODY_AZIMUTH_ME_V4) +
-          sizeof(HS_LIDAR_BODY_CHN_UNIT_NO_CONF_ME_V4) * m_nLaserNum);
-      for (int laserID = 0; laserID < m_nLaserNum; laserID++) {
-        int32_t elevation = this->m_vEleCorrection[laserID];
+          sizeof(HS_LIDAR_BODY_CHN_UNIT_NO_CONF_ME_V4) * laserNum);
+      const int64_t blockTime = output->sensorTimestamp +
+          static_cast<int64_t>(AzimuthDeltaToUs(azimuth - firstAzimuth, 36000, revPerUs));
+      int firetimeColumn = pFiretimeCorr != nullptr ?
+          GetFiretimeColumn(*pFiretimes, pTail->GetOperationMode(), pTail->GetAngleState(blockID)) : -1;
+      const float* pFiretime = firetimeColumn >= 0 ? pFiretimes->firetime[firetimeColumn] : m_fNoFiretime;
+      // dual return means two blocks of the same azimuth
+      const uint32_t returnIndex = info.isDualReturn ? blockID % 2 : 0;
+      for (int laserID = 0; laserID < laserNum; laserID++) {
+        int32_t elevation = pCorrection->elevation[laserID];
         elevation = (360000 + elevation) % 360000;  //TODO No need
-        int32_t aziCorr = this->CalibrateAzimuth(azimuth, laserID);
+        int32_t aziCorr = this->CalibrateAzimuth(azimuth, laserID, *pCorrection);
+        if (firetimeColumn >= 0 && laserID < HS_LIDAR_P128_LASER_NUM) {
+          aziCorr = (aziCorr + pFiretimeCorr->corr[firetimeColumn][laserID] + CIRCLE) % CIRCLE;
+        }
 
         double distance = static_cast<double>(pChnUnitNoConf->GetDistance()) * pHeader->GetDistUnit();
         uint8_t intensity = pChnUnitNoConf->GetReflectivity();
         this->ComputeDwPoint(pointXYZI[index], pointRTHI[index], distance, elevation, aziCorr, intensity);
+        if (bPointTime) {
+          FinishPoint(pointXYZI[index], pointTimestamp != nullptr ? &pointTimestamp[index] : nullptr,
+                      blockTime + static_cast<int64_t>(laserID < HS_LIDAR_P128_LASER_NUM ? pFiretime[laserID] : 0),
+                      pMotion);
+        }
+        if (pImage != nullptr) {
+          pImage->Write(laserID, aziCorr, returnIndex, distance, intensity,
+                        pointXYZI[index].x, pointXYZI[index].y, pointXYZI[index].z);
+        }
+        if (pCompact != nullptr) {
+          PackCompactPoint(pCompact[index], pointXYZI[index], static_cast<uint8_t>(laserID));
+        }
         // PrintDwPoint(&pointXYZI[index]);
         ++ index;
         pChnUnitNoConf = pChnUnitNoConf + 1;
         // pChnUnitNoConf->Print();
       }  // iterate laserId
 
-      if (IsNeedFrameSplit(azimuth)) {
-        output->scanComplete = true;
-      }
-      this->m_u16LastAzimuth = azimuth;
+      info.AddSplitAzimuth(azimuth);
       if (blockID == 0) minAzimuth = azimuth;
       else maxAzimuth = azimuth;
 
@@ -160,7 +291,140 @@ int16_t Udp1_4_Parser::GetVecticalAngle(int channel) {
     printf("GetVecticalAngle: channel id not in range 0-%d \n", HS_LIDAR_P128_LASER_NUM-1);
     return -1;
   }
-  return m_vEleCorrection[channel];
+  return GeneralParser::GetVecticalAngle(channel);
+}
+
+void Udp1_4_Parser::GetMemoryUsage(MemoryUsage& usage) const {
+  GeneralParser::GetMemoryUsage(usage);
+  std::shared_ptr<const P128Calibration> calibration = std::atomic_load(&m_pCalibration);
+  if (calibration != nullptr) {
+    size_t bytes = sizeof(P128Calibration);
+    if (calibration->firetimes != nullptr) bytes += sizeof(P128Firetimes);
+    if (calibration->firetimeCorr != nullptr) bytes += sizeof(P128FiretimeAziCorr);
+    usage.Add("calibration", 0, bytes, bytes);
+  }
+}
+
+int Udp1_4_Parser::LoadFiretimesString(const char *firetimes) {
+  TextScanner scanner(firetimes, strlen(firetimes));
+  TextSpan line;
+  TextSpan field;
+  // first line describes the distance of each column
+  if (!scanner.NextLine(line)) {
+    printf("LoadFiretimesString: empty firetimes Error\n");
+    return -1;
+  }
+  // built aside, the decoders keep the former firetimes until it is published
+  auto table = std::make_shared<P128Firetimes>();
+  // operation mode and angle state of each column
+  uint8_t* rowTable[2] = {table->mode, table->state};
+  for (int row = 0; row < 2; row++) {
+    if (!scanner.NextLine(line)) line = TextSpan();
+    FieldScanner fields(line);
+    if (fields.Count() < HS_LIDAR_P128_FIRETIME_COLUMN_NUM + 1) {
+      printf("LoadFiretimesString: mode or angle state line Error\n");
+      return -1;
+    }
+    // the first field is the name of the row
+    fields.Next(field);
+    for (int col = 0; col < HS_LIDAR_P128_FIRETIME_COLUMN_NUM; col++) {
+      fields.Next(field);
+      rowTable[row][col] = 0;
+      ParseInt(field, rowTable[row][col]);
+    }
+  }
+
+  auto& firetimeTable = table->firetime;
+  int lineCount = 0;
+  while (scanner.NextLine(line)) {
+    FieldScanner fields(line);
+    if (fields.Count() < HS_LIDAR_P128_FIRETIME_COLUMN_NUM + 1) continue;
+    int laserId = 0;
+    fields.Next(field);
+    ParseInt(field, laserId);
+    laserId -= 1;
+    if (laserId < 0 || laserId >= HS_LIDAR_P128_LASER_NUM) {
+      printf("LoadFiretimesString: laser id Error, laserId=%d\n", laserId + 1);
+      return -1;
+    }
+    for (int col = 0; col < HS_LIDAR_P128_FIRETIME_COLUMN_NUM; col++) {
+      fields.Next(field);
+      if (!ParseFloat(field, firetimeTable[col][laserId])) {
+        printf("LoadFiretimesString: firetime Error, laserId=%d\n", laserId + 1);
+        return -1;
+      }
+    }
+    lineCount++;
+  }
+  if (lineCount != HS_LIDAR_P128_LASER_NUM) {
+    printf("LoadFiretimesString: %d laser lines found, expected %d\n", lineCount, HS_LIDAR_P128_LASER_NUM);
+    return -1;
+  }
+  // the azimuth correction at the current speed is built here, not by the first packet after the swap
+  UpdateCalibration(table, -1);
+  m_bGetFiretimes = true;
+  return 0;
+}
+
+int Udp1_4_Parser::GetFiretimeColumn(const P128Firetimes& firetimes, uint8_t operationMode, uint8_t angleState) {
+  // even columns are distance >= A1
+  for (int col = 0; col < HS_LIDAR_P128_FIRETIME_COLUMN_NUM; col += 2) {
+    if (firetimes.mode[col] == operationMode && firetimes.state[col] == angleState) {
+      return col;
+    }
+  }
+  return -1;
+}
+
+std::shared_ptr<const P128Calibration> Udp1_4_Parser::UpdateCalibration(std::shared_ptr<const P128Firetimes> firetimes,
+                                                                        int speed) {
+  std::lock_guard<std::mutex> lock(m_calibrationMutex);
+  std::shared_ptr<const P128Calibration> current = std::atomic_load(&m_pCalibration);
+  // several decode threads may see the same speed change, the first one builds it
+  if (firetimes == nullptr && speed >= 0 && current != nullptr &&
+      current->firetimeCorr != nullptr && current->firetimeCorr->speed == speed) {
+    return current;
+  }
+  auto next = current != nullptr ? std::make_shared<P128Calibration>(*current) : std::make_shared<P128Calibration>();
+  next->correction = GetLaserCorrection();
+  if (firetimes != nullptr) next->firetimes = firetimes;
+  if (speed < 0 && next->firetimeCorr != nullptr) speed = next->firetimeCorr->speed;
+  if (next->firetimes != nullptr && speed >= 0) {
+    if (firetimes != nullptr || next->firetimeCorr == nullptr || next->firetimeCorr->speed != speed) {
+      next->firetimeCorr = BuildFiretimesAziCorr(*next->firetimes, static_cast<uint16_t>(speed));
+    }
+  } else {
+    next->firetimeCorr = nullptr;
+  }
+  std::shared_ptr<const P128Calibration> published(next);
+  PublishCalibration(m_pCalibration, published);
+  return published;
+}
+
+void Udp1_4_Parser::OnCorrectionPublished() {
+  UpdateCalibration(nullptr, -1);
+}
+
+std::shared_ptr<const P128FiretimeAziCorr> Udp1_4_Parser::BuildFiretimesAziCorr(const P128Firetimes& firetimes,
+                                                                             uint16_t speed) const {
+  // us * rpm * 6e-6 is degree, then to the unit of correction file 1/1000
+  auto table = std::make_shared<P128FiretimeAziCorr>();
+  table->speed = speed;
+  for (int col = 0; col < HS_LIDAR_P128_FIRETIME_COLUMN_NUM; col++) {
+    for (int laserId = 0; laserId < HS_LIDAR_P128_LASER_NUM; laserId++) {
+      table->corr[col][laserId] = static_cast<int32_t>(
+          round(firetimes.firetime[col][laserId] * speed * 6E-6 * m_iAziCorrUnit));
+    }
+  }
+  return table;
+}
+
+void Udp1_4_Parser::SequencePacket(dwLidarDecodedPacket *output, const PacketDecodeInfo& info) {
+  if (info.hasTail) {
+    m_nLaserNum = info.laserNum;
+    m_nBlockNum = info.blockNum;
+  }
+  GeneralParser::SequencePacket(output, info);
 }
 
 unsigned long Udp1_4_Parser::GetDataBodySize(const HS_LIDAR_HEADER_ME_V4 *pHeader) {
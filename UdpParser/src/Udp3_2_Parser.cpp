@@ -16,8 +16,8 @@
 //
 /////////////////////////////////////////////////////////////////////////////////////////
 
-#include <sstream>
 #include "Udp3_2_Parser.h"
+#include "TextScanner.h"
 
 Udp3_2_Parser::Udp3_2_Parser() {}
 
@@ -25,12 +25,85 @@ Udp3_2_Parser::~Udp3_2_Parser() {
   // printf("release Udp3_2_Parser\n"); 
 }
 
-dwStatus Udp3_2_Parser::ParserOnePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length, \
-                                        dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI)
+bool Udp3_2_Parser::ParseTailStatus(const uint8_t *buffer, size_t length, TailStatus& status) {
+  if (length < sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_QT_V2) || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+    return false;
+  }
+  const HS_LIDAR_HEADER_QT_V2 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_QT_V2 *>(&(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  size_t tailOffset = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_QT_V2) +
+                      (sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2) + sizeof(HS_LIDAR_BODY_CHN_UNIT_QT_V2) * pHeader->GetLaserNum()) *
+                      pHeader->GetBlockNum() + sizeof(HS_LIDAR_BODY_CRC_QT_V2) +
+                      (pHeader->HasFunctionSafety() ? sizeof(HS_LIDAR_FUNCTION_SAFETY) : 0);
+  if (tailOffset + sizeof(HS_LIDAR_TAIL_QT_V2) > length) {
+    return false;
+  }
+  const HS_LIDAR_TAIL_QT_V2 *pTail = reinterpret_cast<const HS_LIDAR_TAIL_QT_V2 *>(buffer + tailOffset);
+  status.statusNum = 2;
+  status.statusId[0] = pTail->GetStsID1();
+  status.statusData[0] = pTail->GetData1();
+  status.statusId[1] = pTail->GetStsID3();
+  status.statusData[1] = pTail->GetData3();
+  status.motorSpeed = pTail->GetMotorSpeed();
+  status.returnMode = pTail->GetReturnMode();
+  status.shutdown = pTail->m_u8WorkingMode & HS_LIDAR_TAIL_QT_V2::kShutdown;
+  return true;
+}
+
+bool Udp3_2_Parser::ParsePacketId(const uint8_t *buffer, size_t length, uint32_t& sequence, uint16_t& azimuth) {
+  size_t bodyOffset = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_QT_V2);
+  if (length < bodyOffset + sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2) || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+    return false;
+  }
+  const HS_LIDAR_HEADER_QT_V2 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_QT_V2 *>(&(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  azimuth = reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_QT_V2 *>(buffer + bodyOffset)->GetAzimuth();
+  // the sequence number follows the tail
+  size_t seqOffset = bodyOffset +
+                     (sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2) + sizeof(HS_LIDAR_BODY_CHN_UNIT_QT_V2) * pHeader->GetLaserNum()) *
+                     pHeader->GetBlockNum() + sizeof(HS_LIDAR_BODY_CRC_QT_V2) +
+                     (pHeader->HasFunctionSafety() ? sizeof(HS_LIDAR_FUNCTION_SAFETY) : 0) + sizeof(HS_LIDAR_TAIL_QT_V2);
+  sequence = 0;
+  if (pHeader->HasSeqNum() && seqOffset + sizeof(HS_LIDAR_TAIL_SEQ_NUM_QT_V2) <= length) {
+    sequence = reinterpret_cast<const HS_LIDAR_TAIL_SEQ_NUM_QT_V2 *>(buffer + seqOffset)->GetSeqNum();
+  }
+  return true;
+}
+
+bool Udp3_2_Parser::ScanPacket(const uint8_t *buffer, size_t length, PacketDecodeInfo& info, int64_t& sensorTime) {
+  size_t bodyOffset = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_QT_V2);
+  if (length < bodyOffset || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+    return false;
+  }
+  const HS_LIDAR_HEADER_QT_V2 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_QT_V2 *>(&(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  const size_t blockSize = sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2) + sizeof(HS_LIDAR_BODY_CHN_UNIT_QT_V2) * pHeader->GetLaserNum();
+  size_t tailOffset = bodyOffset + blockSize * pHeader->GetBlockNum() + sizeof(HS_LIDAR_BODY_CRC_QT_V2) +
+                      (pHeader->HasFunctionSafety() ? sizeof(HS_LIDAR_FUNCTION_SAFETY) : 0);
+  if (tailOffset + sizeof(HS_LIDAR_TAIL_QT_V2) > length) {
+    return false;
+  }
+  const HS_LIDAR_TAIL_QT_V2 *pTail = reinterpret_cast<const HS_LIDAR_TAIL_QT_V2 *>(buffer + tailOffset);
+  info.hasTail = true;
+  info.spinSpeed = pTail->m_u16MotorSpeed;
+  info.isDualReturn = pTail->IsDualReturn();
+  info.laserNum = pHeader->GetLaserNum();
+  info.blockNum = pHeader->GetBlockNum();
+  sensorTime = this->GetMicroLidarTimeU64(pTail->m_u8UTC, 6, pTail->GetTimestamp());
+  for (int blockID = 0; blockID < info.blockNum; blockID++) {
+    info.AddSplitAzimuth(
+        reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_QT_V2 *>(buffer + bodyOffset + blockSize * blockID)->GetAzimuth());
+  }
+  return true;
+}
+
+dwStatus Udp3_2_Parser::DecodePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length,
+                                     dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI, PointExtraOutput* extra,
+                                     const DeskewMotion* motion, PacketDecodeInfo& info)
 {
   // printf("Udp3_2_Parser:ParserOnePacket, lens=%lu \n", length);
   // printf(" %x yes %x \n", buffer[0], buffer[1]);
-  if (length < 0 || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+  if (length < 2 || buffer[0] != 0xEE || buffer[1] != 0xFF) {
     printf("Udp3_2_Parser: ParserOnePacket, invalid packet %x %x\n", buffer[0], buffer[1]);
     return DW_FAILURE;
   }
@@ -43,20 +116,35 @@ dwStatus Udp3_2_Parser::ParserOnePacket(dwLidarDecodedPacket *output, const uint
                           pHeader->GetBlockNum() + sizeof(HS_LIDAR_BODY_CRC_QT_V2) +
                           (pHeader->HasFunctionSafety() ? sizeof(HS_LIDAR_FUNCTION_SAFETY) : 0));
   // pTail->Print();
-  m_u16SpinSpeed = pTail->m_u16MotorSpeed;
+  info.hasTail = true;
+  info.spinSpeed = pTail->m_u16MotorSpeed;
   // dual return won't affect decoding, just the azimuth of two blocks are the same, more points
-  m_bIsDualReturn = pTail->IsDualReturn();
+  info.isDualReturn = pTail->IsDualReturn();
+  info.laserNum = pHeader->GetLaserNum();
+  info.blockNum = pHeader->GetBlockNum();
   output->duration = pTail->GetTimestamp() - 100000;
   // from outside this func
   output->hostTimestamp = 0; 
   output->maxPoints = pHeader->GetBlockNum() * pHeader->GetLaserNum();
-  // !Attention m_vEleCorrection and m_vAziCorrection must be initialized by func LoadCorrectionString
-  if (m_vEleCorrection.empty() == true) {
+  // !Attention the correction must be initialized by func LoadCorrectionString
+  // the calibration of the whole packet is taken once, a reload is used from the next packet
+  std::shared_ptr<const QT128Calibration> calibration = std::atomic_load(&m_pCalibration);
+  if (calibration != nullptr && calibration->firetimes != nullptr && (calibration->firetimeCorr == nullptr ||
+      calibration->firetimeCorr->speed != pTail->GetMotorSpeed())) {
+    calibration = UpdateCalibration(nullptr, nullptr, pTail->GetMotorSpeed());
+  }
+  const LaserCorrection* pCorrection = calibration != nullptr ? calibration->correction.get() : nullptr;
+  if (pCorrection == nullptr || pCorrection->elevation.size() < pHeader->GetLaserNum()) {
     // printf("Udp3_2_Parser: ParserOnePacket, no calibration string loaded Error \n");
     return DW_FAILURE;
   }
-  output->maxVerticalAngleRad = m_vEleCorrection[pHeader->GetLaserNum() - 1] / 1000 / 180 * M_PI;
-  output->minVerticalAngleRad = m_vEleCorrection[0] / 1000 / 180 * M_PI;
+  const std::vector<int32_t>& eleCorrection = pCorrection->elevation;
+  const std::vector<int32_t>& aziCorrection = pCorrection->azimuth;
+  const QT128Firetimes* pFiretimes = calibration->firetimes.get();
+  const PandarQTChannelConfig* pChannelConfig = pHeader->HasSelfDefine() ? calibration->channelConfig.get() : nullptr;
+  const QT128FiretimeAziCorr* pFiretimeCorr = calibration->firetimeCorr.get();
+  output->maxVerticalAngleRad = eleCorrection[pHeader->GetLaserNum() - 1] / 1000 / 180 * M_PI;
+  output->minVerticalAngleRad = eleCorrection[0] / 1000 / 180 * M_PI;
   // vital parameter to assign memory
   output->nPoints = pHeader->GetBlockNum() * pHeader->GetLaserNum();
   // scanComplete must set false, then true when one scan is completed
@@ -68,6 +156,16 @@ dwStatus Udp3_2_Parser::ParserOnePacket(dwLidarDecodedPacket *output, const uint
   const HS_LIDAR_BODY_AZIMUTH_QT_V2 *pAzimuth = reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_QT_V2 *>(
           (const unsigned char *)pHeader + sizeof(HS_LIDAR_HEADER_QT_V2));
   // pAzimuth->Print();
+  // the tail timestamp belongs to the first block, the others follow the spin
+  const uint32_t firstAzimuth = pAzimuth->GetAzimuth();
+  const float revPerUs = pTail->GetMotorSpeed() / 60e6f;
+  dwTime_t* pointTimestamp = extra != nullptr ? extra->pointTimestamp : nullptr;
+  DeskewMotion packetMotion;
+  const DeskewMotion* pMotion = ResolveDeskewMotion(motion, packetMotion, output->sensorTimestamp);
+  const bool bPointTime = pointTimestamp != nullptr || pMotion != nullptr;
+  RangeImage* pImage = extra != nullptr ? extra->rangeImage : nullptr;
+  if (pImage != nullptr && pImage->timestamp == 0) pImage->timestamp = output->sensorTimestamp;
+  CompactPoint* pCompact = extra != nullptr ? extra->compactPoint : nullptr;
   const HS_LIDAR_BODY_CHN_UNIT_QT_V2 *pChnUnit = reinterpret_cast<const HS_LIDAR_BODY_CHN_UNIT_QT_V2 *>(
           (const unsigned char *)pAzimuth + sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2));
   // pChnUnit->Print();
@@ -88,6 +186,14 @@ dwStatus Udp3_2_Parser::ParserOnePacket(dwLidarDecodedPacket *output, const uint
         sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2) +
         sizeof(HS_LIDAR_BODY_CHN_UNIT_QT_V2) * pHeader->GetLaserNum());
     int loopIndex = (pTail->GetModeFlag() + (i / ((pTail->GetReturnMode() < 0x39) ? 1 : 2)) + 1) % 2;
+    const int64_t blockTime = output->sensorTimestamp +
+        static_cast<int64_t>(AzimuthDeltaToUs(azimuth - firstAzimuth, 36000, revPerUs));
+    const float* pFiretime = pFiretimes != nullptr ? pFiretimes->firetime[loopIndex].data() : m_fNoFiretime;
+    const std::vector<int>* pChannelTable =
+        pChannelConfig != nullptr && static_cast<size_t>(loopIndex) < pChannelConfig->m_vChannelConfigTable.size() ?
+        &pChannelConfig->m_vChannelConfigTable[loopIndex] : nullptr;
+    // two blocks of the same loop are the two returns
+    const uint32_t returnIndex = (pTail->GetReturnMode() < 0x39) ? 0 : i % 2;
 
     for (unsigned int j = 0; j < pHeader->GetLaserNum(); j++) {
       uint16_t u16Distance = pChnUnit->GetDistance();
@@ -97,34 +203,48 @@ dwStatus Udp3_2_Parser::ParserOnePacket(dwLidarDecodedPacket *output, const uint
       uint32_t azimuthCorr = 0;
       uint32_t elevationCorr = 0;
       pChnUnit = pChnUnit + 1;
+      int laserId = j;
 
-      if (m_vEleCorrection.size() >= j && m_vAziCorrection.size() >= j) {
-        int laserId = j;
-        if (pHeader->HasSelfDefine() && m_PandarQTChannelConfig.m_bIsChannelConfigObtained 
-            && i < m_PandarQTChannelConfig.m_vChannelConfigTable[loopIndex].size()) {
-            laserId = m_PandarQTChannelConfig.m_vChannelConfigTable[loopIndex][j] - 1;
-        }
-        elevationCorr = m_vEleCorrection[laserId];
+      if (pChannelTable != nullptr && j < pChannelTable->size()) {
+        laserId = (*pChannelTable)[j] - 1;
+      }
+      // a channel config entry out of the lasers, or a header with more lasers, gives a zero point, its
+      // extras are not written
+      if (laserId < 0 || laserId >= HS_LIDAR_QT128_LASER_NUM) {
+        this->ComputeDwPoint(pointXYZI[index], pointRTHI[index], 0, 0, 0, 0);
+        ++ index;
+        continue;
+      }
+      if (static_cast<size_t>(laserId) < eleCorrection.size()) {
+        elevationCorr = eleCorrection[laserId];
         // azimuth unit from UDP packet is 100, e.g. 1.23 = 123.
         // however, azimuth unit from correction file is 1000, e.g. 1.234 = 1234
-        azimuthCorr = azimuth * 10 + m_vAziCorrection[laserId];
-        // if (m_bEnableFireTimeCorrection) { ////!! TODO
-        //     azimuthCorr += GetFiretimesCorrection(laserId, pTail->GetMotorSpeed(), loopIndex);
-        // }
+        azimuthCorr = azimuth * 10 + aziCorrection[laserId];
+        if (pFiretimeCorr != nullptr) {
+          azimuthCorr += pFiretimeCorr->corr[loopIndex][laserId];
+        }
       }
       elevationCorr = (HS_LIDAR_QT128_AZIMUTH_SIZE + elevationCorr) % HS_LIDAR_QT128_AZIMUTH_SIZE;
       azimuthCorr = (HS_LIDAR_QT128_AZIMUTH_SIZE + azimuthCorr) % HS_LIDAR_QT128_AZIMUTH_SIZE;
       // printf("azimuthCorr: %d, elevationCorr: %d \n", azimuthCorr, elevationCorr);
       this->ComputeDwPoint(pointXYZI[index], pointRTHI[index], distance, elevationCorr, azimuthCorr, u8Intensity);
+      if (bPointTime) {
+        FinishPoint(pointXYZI[index], pointTimestamp != nullptr ? &pointTimestamp[index] : nullptr,
+                    blockTime + static_cast<int64_t>(pFiretime[laserId]), pMotion);
+      }
+      if (pImage != nullptr) {
+        pImage->Write(laserId, azimuthCorr, returnIndex, distance, u8Intensity,
+                      pointXYZI[index].x, pointXYZI[index].y, pointXYZI[index].z);
+      }
+      if (pCompact != nullptr) {
+        PackCompactPoint(pCompact[index], pointXYZI[index], static_cast<uint8_t>(laserId));
+      }
       ++ index;
       // PrintDwPoint(&pointRTHI[index]);
       // PrintDwPoint(&pointXYZI[index]);
     } // cycle laser channel
     
-    if (IsNeedFrameSplit(azimuth)) {
-      output->scanComplete = true;
-    }
-    m_u16LastAzimuth = azimuth;
+    info.AddSplitAzimuth(azimuth);
     // As only two block exist, the primary one is minimum
     if (i == 0) minAzimuth = azimuth;
     else maxAzimuth = azimuth;
@@ -141,6 +261,37 @@ dwStatus Udp3_2_Parser::ParserOnePacket(dwLidarDecodedPacket *output, const uint
   return DW_SUCCESS;
 }
 
+RangeImageLayout Udp3_2_Parser::GetRangeImageLayout() const {
+  // 0.4 degree at 10Hz, 900 columns
+  RangeImageLayout layout;
+  layout.rows = HS_LIDAR_QT128_LASER_NUM;
+  layout.cols = 900;
+  layout.returns = 2;
+  layout.azimuthStart = 0;
+  layout.azimuthStep = 400;
+  layout.unitsPerRev = HS_LIDAR_QT128_AZIMUTH_SIZE;
+  return layout;
+}
+
+void Udp3_2_Parser::GetMemoryUsage(MemoryUsage& usage) const {
+  GeneralParser::GetMemoryUsage(usage);
+  std::shared_ptr<const QT128Calibration> calibration = std::atomic_load(&m_pCalibration);
+  if (calibration == nullptr) {
+    return;
+  }
+  size_t bytes = sizeof(QT128Calibration);
+  if (calibration->firetimes != nullptr) bytes += sizeof(QT128Firetimes);
+  if (calibration->firetimeCorr != nullptr) bytes += sizeof(QT128FiretimeAziCorr);
+  const PandarQTChannelConfig* channelConfig = calibration->channelConfig.get();
+  if (channelConfig != nullptr) {
+    bytes += sizeof(PandarQTChannelConfig) + channelConfig->m_sHashValue.capacity();
+    for (const std::vector<int>& row : channelConfig->m_vChannelConfigTable) {
+      bytes += sizeof(row) + row.capacity() * sizeof(int);
+    }
+  }
+  usage.Add("calibration", 0, bytes, bytes);
+}
+
 dwStatus Udp3_2_Parser::GetDecoderConstants(_dwSensorLidarDecoder_constants* constants) {
   // printf("GetDecoderConstants: \n");
   // Each packet contains 1127 bytes for QT128, use 1500
@@ -164,9 +315,10 @@ dwStatus Udp3_2_Parser::GetDecoderConstants(_dwSensorLidarDecoder_constants* con
   // From the correction file, the first and last
   constants->properties.verticalFOVStart = deg2Rad(-52.6);
   constants->properties.verticalFOVEnd = deg2Rad(52.6);
+  std::shared_ptr<const LaserCorrection> correction = GetLaserCorrection();
   for (int i = 0; i < 128; i++) {
-      if(m_bGetCorrectionFile == true && m_vEleCorrection.empty() == false) {
-          constants->properties.verticalAngles[i] = deg2Rad(m_vEleCorrection[i] / HS_LIDAR_QT128_AZIMUTH_UNIT);
+      if(correction != nullptr && static_cast<size_t>(i) < correction->elevation.size()) {
+          constants->properties.verticalAngles[i] = deg2Rad(correction->elevation[i] / HS_LIDAR_QT128_AZIMUTH_UNIT);
           // printf("verticalAngles: %f \n", constants->properties.verticalAngles[i]);
       }
   }
@@ -181,165 +333,185 @@ int16_t Udp3_2_Parser::GetVecticalAngle(int channel) {
     return -1;
   }
 
-  return m_vEleCorrection[channel];
+  return GeneralParser::GetVecticalAngle(channel);
 }
 
 int Udp3_2_Parser::LoadFiretimesString(const char *firetimes) {
   // printf("LoadFiretimesString: %s\n",firetimes);
-  std::string firetimes_content_str = firetimes;
-  std::istringstream fin(firetimes_content_str);
-  std::string line;
-  if (std::getline(fin, line)) {  // first line sequence,chn id,firetime/us
-    // printf("Parse Lidar firetime now...\n");
+  TextScanner scanner(firetimes, strlen(firetimes));
+  TextSpan line;
+  TextSpan field;
+  scanner.NextLine(line);
+  FieldScanner firstLine(line);
+  firstLine.Next(field);
+  if (!field.EqualsNoCase("eeff")) {
+    printf("firetime file delimiter is wrong\n");
+    return -1;
   }
-  std::vector<std::string> firstLine;
-  HSSplit(firstLine, line, ',');
-  if (firstLine[0] == "EEFF" || firstLine[0] == "eeff") {
-    std::array<std::array<float, HS_LIDAR_QT128_LASER_NUM>,
-               HS_LIDAR_QT128_LOOP_NUM>
-        firetimes;
-    firetimes[0].fill(0);
-    firetimes[1].fill(0);
-    firetimes[2].fill(0);
-    firetimes[3].fill(0);
-    std::getline(fin, line);
-    std::vector<std::string> loopNumLine;
-    HSSplit(loopNumLine, line, ',');
-    unsigned int loopNum = atoi(loopNumLine[3].c_str());
-    std::getline(fin, line);
-    for (int i = 0; i < HS_LIDAR_QT128_LASER_NUM; i++) {
-      std::getline(fin, line);
-      std::vector<std::string> ChannelLine;
-      HSSplit(ChannelLine, line, ',');
-      for (unsigned int j = 0; j < loopNum; j++) {
-        if (ChannelLine.size() == loopNum * 2) {
-          int laserId = atoi(ChannelLine[j * 2].c_str()) - 1;
-          firetimes[j][laserId] = std::stof(ChannelLine[j * 2 + 1].c_str());
-          // printf("loop num=%d, laserId =%d, firetime = %f\n", j, laserId, firetimes[j][laserId]);
-        } else {
-          printf("loop num is not equal to the first channel line\n");
-          return -1;
-        }
+  // built aside, the decoders keep the former firetimes until it is published
+  auto table = std::make_shared<QT128Firetimes>();
+  auto& firetimeTable = table->firetime;
+  for (auto& loop : firetimeTable) loop.fill(0);
+  // the loop number is the 4th field of the second line
+  unsigned int loopNum = 0;
+  scanner.NextLine(line);
+  FieldScanner loopNumLine(line);
+  for (int i = 0; i < 4 && loopNumLine.Next(field); i++) {}
+  ParseInt(field, loopNum);
+  // header of the channel lines
+  scanner.NextLine(line);
+  for (int i = 0; i < HS_LIDAR_QT128_LASER_NUM; i++) {
+    if (!scanner.NextLine(line)) line = TextSpan();
+    FieldScanner channelLine(line);
+    if (loopNum > 0 && channelLine.Count() != loopNum * 2) {
+      printf("loop num is not equal to the first channel line\n");
+      return -1;
+    }
+    // files may describe more loops than the lidar fires, only the first loops are used
+    for (unsigned int j = 0; j < loopNum && j < HS_LIDAR_QT128_LOOP_NUM; j++) {
+      int laserId = 0;
+      float firetime = 0;
+      channelLine.Next(field);
+      ParseInt(field, laserId);
+      laserId -= 1;
+      if (laserId < 0 || laserId >= HS_LIDAR_QT128_LASER_NUM) {
+        printf("LoadFiretimesString: laser id Error, laserId=%d\n", laserId);
+        return -1;
+      }
+      channelLine.Next(field);
+      if (!ParseFloat(field, firetime)) {
+        printf("LoadFiretimesString: firetime Error, laserId=%d\n", laserId);
+        return -1;
       }
+      firetimeTable[j][laserId] = std::isfinite(firetime) ? firetime : 0;
+      // printf("loop num=%d, laserId =%d, firetime = %f\n", j, laserId, firetimeTable[j][laserId]);
     }
-    m_vQT128Firetime = firetimes;
-  } else {
-    printf("firetime file delimiter is wrong\n");
-    return -1;
   }
+  // the azimuth correction at the current speed is built here, not by the first packet after the swap
+  UpdateCalibration(table, nullptr, -1);
+  m_bGetFiretimes = true;
   return 0;
 }
 
-void Udp3_2_Parser::LoadFiretimesFile(std::string firetimes_path) {
-  std::ifstream fin(firetimes_path);
-  if (fin.is_open() == false) {
-    printf("LoadFiretimesFile: Open firetimes file Error, path=%s\n", firetimes_path.c_str());
-    return;
-  }
-  int length = 0;
-  fin.seekg(0, std::ios::end);
-  length = fin.tellg();
-  fin.seekg(0, std::ios::beg);
-  char *buffer = new char[length];
-  fin.read(buffer, length);
-  fin.close();
-  
-  int ret =  LoadFiretimesString(buffer);
-  if (ret != 0) {
-    printf("LoadFiretimesString: Parse local firetimes file Error");
-  }
-  delete[] buffer;
-
-}
-
 int Udp3_2_Parser::LoadChannelConfigString(const char *channelconfig) {
   // printf("LoadChannelConfigString: \n");
   // printf("%s\n",channelconfig);
-  std::string channel_config_content_str = channelconfig;
-  m_PandarQTChannelConfig.m_bIsChannelConfigObtained = false;
-  std::istringstream ifs(channel_config_content_str);
-  std::string line;
+  // built aside, the decoders keep the former config until it is published
+  auto config = std::make_shared<PandarQTChannelConfig>();
+  TextScanner scanner(channelconfig, strlen(channelconfig));
+  TextSpan line;
+  TextSpan field;
 
-  std::getline(ifs, line);
-  std::vector<std::string> versionLine;
-  HSSplit(versionLine, line, ',');
-  if (versionLine[0] == "EEFF" || versionLine[0] == "eeff") {
-    m_PandarQTChannelConfig.m_u8MajorVersion =
-        std::stoi(versionLine[1].c_str());
-    m_PandarQTChannelConfig.m_u8MinVersion = std::stoi(versionLine[2].c_str());
-  } else {
+  scanner.NextLine(line);
+  FieldScanner versionLine(line);
+  versionLine.Next(field);
+  if (!field.EqualsNoCase("eeff")) {
     printf("channel config file delimiter is wrong\n");
     return -1;
   }
-  std::getline(ifs, line);
-  std::vector<std::string> channelNumLine;
-  HSSplit(channelNumLine, line, ',');
-  m_PandarQTChannelConfig.m_u8LaserNum = std::stoi(channelNumLine[1].c_str());
-  m_PandarQTChannelConfig.m_u8BlockNum = std::stoi(channelNumLine[3].c_str());
-  if (m_PandarQTChannelConfig.m_u8LaserNum <= 0 ||
-      m_PandarQTChannelConfig.m_u8BlockNum <= 0) {
-    printf("LaserNum:%d, BlockNum:%d", m_PandarQTChannelConfig.m_u8LaserNum, m_PandarQTChannelConfig.m_u8BlockNum);
+  versionLine.Next(field);
+  bool ok = ParseInt(field, config->m_u8MajorVersion);
+  versionLine.Next(field);
+  ok = ParseInt(field, config->m_u8MinVersion) && ok;
+  // laser num is the 2nd field and block num the 4th
+  scanner.NextLine(line);
+  FieldScanner channelNumLine(line);
+  channelNumLine.Next(field);
+  channelNumLine.Next(field);
+  ok = ParseInt(field, config->m_u8LaserNum) && ok;
+  channelNumLine.Next(field);
+  channelNumLine.Next(field);
+  ok = ParseInt(field, config->m_u8BlockNum) && ok;
+  if (!ok || config->m_u8LaserNum <= 0 ||
+      config->m_u8BlockNum <= 0) {
+    printf("LaserNum:%d, BlockNum:%d\n", config->m_u8LaserNum, config->m_u8BlockNum);
     return -1;
   }
-  std::getline(ifs, line);
-  std::vector<std::string> firstChannelLine;
-  HSSplit(firstChannelLine, line, ',');
-  unsigned int loop_num = firstChannelLine.size();
-  m_PandarQTChannelConfig.m_vChannelConfigTable.resize(loop_num);
+  scanner.NextLine(line);
+  unsigned int loop_num = FieldScanner(line).Count();
+  config->m_vChannelConfigTable.resize(loop_num);
 
   for (unsigned int i = 0; i < loop_num; i++) {
-    m_PandarQTChannelConfig.m_vChannelConfigTable[i].resize(
-        m_PandarQTChannelConfig.m_u8LaserNum);
+    config->m_vChannelConfigTable[i].resize(
+        config->m_u8LaserNum);
   }
-  for (int i = 0; i < m_PandarQTChannelConfig.m_u8LaserNum; i++) {
-    std::getline(ifs, line);
-    std::vector<std::string> ChannelLine;
-    HSSplit(ChannelLine, line, ',');
+  for (int i = 0; i < config->m_u8LaserNum; i++) {
+    if (!scanner.NextLine(line)) line = TextSpan();
+    FieldScanner channelLine(line);
+    if (channelLine.Count() != loop_num) {
+      printf("loop num is not equal to the first channel line\n");
+      return -1;
+    }
     for (unsigned int j = 0; j < loop_num; j++) {
-      if (ChannelLine.size() == loop_num) {
-        m_PandarQTChannelConfig.m_vChannelConfigTable[j][i] =
-            std::stoi(ChannelLine[j].c_str());
-      } else {
-        printf("loop num is not equal to the first channel line\n");
+      channelLine.Next(field);
+      if (!ParseInt(field, config->m_vChannelConfigTable[j][i])) {
+        printf("LoadChannelConfigString: channel Error, line=%d\n", i);
         return -1;
       }
     }
   }
-  std::getline(ifs, line);
-  m_PandarQTChannelConfig.m_sHashValue = line;
-  m_PandarQTChannelConfig.m_bIsChannelConfigObtained = true;
+  if (!scanner.NextLine(line)) line = TextSpan();
+  config->m_sHashValue.assign(line.begin, line.size());
+  config->m_bIsChannelConfigObtained = true;
+  UpdateCalibration(nullptr, config, -1);
 
   return 0;
 }
 
 void Udp3_2_Parser::LoadChannelConfigFile(std::string channel_config_path) {
-  int ret = 0;
-  std::ifstream fin(channel_config_path);
-  if (fin.is_open()) {
-    int length = 0;
-    fin.seekg(0, std::ios::end);
-    length = fin.tellg();
-    fin.seekg(0, std::ios::beg);
-    char *buffer = new char[length];
-    fin.read(buffer, length);
-    fin.close();
-    ret = LoadChannelConfigString(buffer);
-    if (ret != 0) {
-      printf("Parse local channel congfig file Error\n");
-    }
-    delete[] buffer;
-  } else {
+  std::vector<char> buffer;
+  if (!ReadTextFile(channel_config_path, buffer)) {
     printf("Open channel congfig file failed\n");
     return;
   }
+  int ret = LoadChannelConfigString(buffer.data());
+  if (ret != 0) {
+    printf("Parse local channel congfig file Error\n");
+  }
 }
 
-double Udp3_2_Parser::GetFiretimesCorrection(int laserId, double speed,
-                                             int loopIndex) {
-  if (m_vQT128Firetime.empty() == true) {
-    printf("GetFiretimesCorrection: m_vQT128Firetime is empty, Error\n");
-    return -1;
+std::shared_ptr<const QT128Calibration> Udp3_2_Parser::UpdateCalibration(
+    std::shared_ptr<const QT128Firetimes> firetimes, std::shared_ptr<const PandarQTChannelConfig> channelConfig,
+    int speed) {
+  std::lock_guard<std::mutex> lock(m_calibrationMutex);
+  std::shared_ptr<const QT128Calibration> current = std::atomic_load(&m_pCalibration);
+  // several decode threads may see the same speed change, the first one builds it
+  if (firetimes == nullptr && channelConfig == nullptr && speed >= 0 && current != nullptr &&
+      current->firetimeCorr != nullptr && current->firetimeCorr->speed == speed) {
+    return current;
+  }
+  auto next = current != nullptr ? std::make_shared<QT128Calibration>(*current) : std::make_shared<QT128Calibration>();
+  next->correction = GetLaserCorrection();
+  if (firetimes != nullptr) next->firetimes = firetimes;
+  if (channelConfig != nullptr) next->channelConfig = channelConfig;
+  if (speed < 0 && next->firetimeCorr != nullptr) speed = next->firetimeCorr->speed;
+  if (next->firetimes != nullptr && speed >= 0) {
+    if (firetimes != nullptr || next->firetimeCorr == nullptr || next->firetimeCorr->speed != speed) {
+      next->firetimeCorr = BuildFiretimesAziCorr(*next->firetimes, static_cast<uint16_t>(speed));
+    }
+  } else {
+    next->firetimeCorr = nullptr;
+  }
+  std::shared_ptr<const QT128Calibration> published(next);
+  PublishCalibration(m_pCalibration, published);
+  return published;
+}
+
+void Udp3_2_Parser::OnCorrectionPublished() {
+  UpdateCalibration(nullptr, nullptr, -1);
+}
+
+std::shared_ptr<const QT128FiretimeAziCorr> Udp3_2_Parser::BuildFiretimesAziCorr(const QT128Firetimes& firetimes,
+                                                                               uint16_t speed) {
+  // degree to the unit of correction file 1/1000
+  auto table = std::make_shared<QT128FiretimeAziCorr>();
+  table->speed = speed;
+  for (int loop = 0; loop < HS_LIDAR_QT128_LOOP_NUM; loop++) {
+    for (int laserId = 0; laserId < HS_LIDAR_QT128_LASER_NUM; laserId++) {
+      // us * rpm * 6e-6 is degree
+      table->corr[loop][laserId] = static_cast<int32_t>(
+          round(firetimes.firetime[loop][laserId] * speed * 6E-6 * HS_LIDAR_QT128_AZIMUTH_UNIT));
+    }
   }
-  //需要一个int值， 6e-6， round一下这个结果， 0.1度修正， 100， 0.001
-  return m_vQT128Firetime[loopIndex][laserId] * speed * 6E-6;
+  return table;
 }
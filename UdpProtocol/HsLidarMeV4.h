@@ -195,6 +195,11 @@ struct HS_LIDAR_TAIL_ME_V4 {
   uint16_t GetData2() const { return m_monitorInfo.GetData(); }
 
   uint8_t HasShutdown() const { return m_u8RunningMode == kShutdown; }
+  uint8_t GetOperationMode() const { return m_u8RunningMode & 0x0f; }
+  // two bits of angle state for each block, the first block in the highest bits
+  uint8_t GetAngleState(int blockIndex) const {
+    return (little_to_native(m_u16AzimuthFlag) >> (2 * (7 - blockIndex))) & 0x03;
+  }
   uint8_t GetReturnMode() const { return m_u8ReturnMode; }
   uint16_t GetMotorSpeed() const { return little_to_native(m_u16MotorSpeed); }
   uint32_t GetTimestamp() const { return little_to_native(m_u32Timestamp); }
@@ -214,7 +219,7 @@ struct HS_LIDAR_TAIL_ME_V4 {
   }
   int64_t GetMicroLidarTimeU64() const {
     if (m_u8UTC[0] != 0) {
-			struct tm t = {0};
+			struct tm t = {};
 			t.tm_year = m_u8UTC[0] + 100;
 			if (t.tm_year >= 200) {
 				t.tm_year -= 100;
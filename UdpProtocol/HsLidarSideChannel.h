@@ -0,0 +1,116 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd] 
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: Lidar Sensor UDP Protocol</b>
+ *
+ * @b Description: This file defines the GPS packet and the leading fields of the fault message packet, sent
+ * beside the point cloud packets by Pandar128, QT128 and AT128.
+ */
+
+#ifndef HS_LIDAR_SIDE_CHANNEL_H
+#define HS_LIDAR_SIDE_CHANNEL_H
+
+#include <LidarProtocolHeader.h>
+
+#ifdef _MSC_VER
+#define PACKED
+#pragma pack(push, 1)
+#else
+#define PACKED __attribute__((packed))
+#endif
+
+// 512 byte GPS packet, date and time in ASCII with the low digit first
+struct HS_LIDAR_GPS_PACKET {
+  static const uint16_t kDelimiter = 0xffee;
+  static const uint8_t kLocked = '1';
+
+  uint16_t m_u16Delimiter;
+  uint8_t m_u8Year[2];
+  uint8_t m_u8Month[2];
+  uint8_t m_u8Day[2];
+  uint8_t m_u8Second[2];
+  uint8_t m_u8Minute[2];
+  uint8_t m_u8Hour[2];
+  // us within the second
+  uint32_t m_u32FineTime;
+  // GPRMC or GPGGA sentence
+  char m_cNmea[77];
+  uint8_t m_u8Reserved[411];
+  uint8_t m_u8PositioningStatus;
+  uint8_t m_u8PpsLockStatus;
+  uint8_t m_u8Reserved2[4];
+
+  static int GetAscii(const uint8_t digits[2]) {
+    return (digits[0] - '0') + (digits[1] - '0') * 10;
+  }
+
+  bool IsValid() const { return little_to_native(m_u16Delimiter) == kDelimiter; }
+  int GetYear() const { return 2000 + GetAscii(m_u8Year); }
+  int GetMonth() const { return GetAscii(m_u8Month); }
+  int GetDay() const { return GetAscii(m_u8Day); }
+  int GetHour() const { return GetAscii(m_u8Hour); }
+  int GetMinute() const { return GetAscii(m_u8Minute); }
+  int GetSecond() const { return GetAscii(m_u8Second); }
+  uint32_t GetFineTime() const { return little_to_native(m_u32FineTime); }
+  bool IsPositioned() const { return m_u8PositioningStatus == 'A' || m_u8PositioningStatus == kLocked; }
+  bool IsPpsLocked() const { return m_u8PpsLockStatus == kLocked; }
+
+  void Print() const {
+    printf("HS_LIDAR_GPS_PACKET: %04d-%02d-%02d %02d:%02d:%02d.%06u, positioned:%u, ppsLocked:%u\n",
+           GetYear(), GetMonth(), GetDay(), GetHour(), GetMinute(), GetSecond(), GetFineTime(),
+           IsPositioned(), IsPpsLocked());
+  }
+} PACKED;
+
+// Leading fields of the 99 byte fault message packet, the rest is kept raw
+struct HS_LIDAR_FAULT_MESSAGE_HEADER {
+  static const uint16_t kDelimiter = 0xcddc;
+
+  uint16_t m_u16Delimiter;
+  uint8_t m_u8VersionMajor;
+  uint8_t m_u8VersionMinor;
+  // year - 1900, month 1 to 12
+  uint8_t m_u8UTC[6];
+  uint32_t m_u32Timestamp;
+  uint8_t m_u8OperationState;
+  uint8_t m_u8FaultState;
+  uint8_t m_u8FaultCodeType;
+  uint8_t m_u8RollingCounter;
+  uint8_t m_u8TotalFaultCodeNum;
+  uint8_t m_u8FaultCodeId;
+  uint32_t m_u32FaultCode;
+
+  // the delimiter is sent big endian
+  bool IsValid() const {
+    return reinterpret_cast<const uint8_t *>(&m_u16Delimiter)[0] == 0xcd &&
+           reinterpret_cast<const uint8_t *>(&m_u16Delimiter)[1] == 0xdc;
+  }
+  uint32_t GetTimestamp() const { return little_to_native(m_u32Timestamp); }
+  uint32_t GetFaultCode() const { return little_to_native(m_u32FaultCode); }
+
+  void Print() const {
+    printf("HS_LIDAR_FAULT_MESSAGE_HEADER: ver:%u.%u, operationState:%u, faultState:%u, codeType:%u, "
+           "rollingCnt:%u, totalFaultNum:%u, faultID:%u, faultCode:0x%08x\n",
+           m_u8VersionMajor, m_u8VersionMinor, m_u8OperationState, m_u8FaultState, m_u8FaultCodeType,
+           m_u8RollingCounter, m_u8TotalFaultCodeNum, m_u8FaultCodeId, GetFaultCode());
+  }
+} PACKED;
+
+#endif
@@ -140,7 +140,7 @@ struct HS_LIDAR_TAIL_ST_V3 {
 
   int64_t GetMicroLidarTimeU64() const {
     if (m_u8UTC[0] != 0) {
-			struct tm t = {0};
+			struct tm t = {};
 			t.tm_year = m_u8UTC[0];
 			if (t.tm_year >= 200) {
 				t.tm_year -= 100;
@@ -73,38 +73,48 @@ public:
 
     void clear();
 
+    // Number of whole messages in the queue
+    size_t size() const;
+
+    // Bytes reserved, the vector keeps its peak size once grown
+    size_t capacityBytes() const { return m_deque.capacity(); }
+    const uint8_t* storage() const { return m_deque.data(); }
+
 private:
     std::vector<uint8_t> m_deque;
+    // offset of the first message, the front is erased once half of the bytes are dequeued
+    size_t m_head = 0;
     size_t m_sizeOfMessage;
 };
 
 inline void ByteQueue::enqueue(const uint8_t* data, size_t length)
 {
-    for (size_t i = 0; i < length; i++)
-    {
-        m_deque.push_back(*data);
-        ++data;
-    }
+    m_deque.insert(m_deque.end(), data, data + length);
 }
 
 inline bool ByteQueue::peek(const uint8_t** address)
 {
-    if (m_deque.size() < m_sizeOfMessage)
+    if (m_deque.size() - m_head < m_sizeOfMessage)
     {
         return false;
     }
     else
-        *address = &m_deque.front();
+        *address = &m_deque[m_head];
 
     return true;
 }
 
 inline bool ByteQueue::dequeue()
 {
-    if (m_deque.size() < m_sizeOfMessage)
+    if (m_deque.size() - m_head < m_sizeOfMessage)
         return false;
-    else
-        m_deque.erase(m_deque.begin(), m_deque.begin() + m_sizeOfMessage);
+    m_head += m_sizeOfMessage;
+    // erasing one message at a time moves the whole backlog for every message
+    if (m_head * 2 >= m_deque.size())
+    {
+        m_deque.erase(m_deque.begin(), m_deque.begin() + m_head);
+        m_head = 0;
+    }
 
     return true;
 }
@@ -112,6 +122,12 @@ inline bool ByteQueue::dequeue()
 inline void ByteQueue::clear()
 {
     m_deque.clear();
+    m_head = 0;
+}
+
+inline size_t ByteQueue::size() const
+{
+    return (m_deque.size() - m_head) / m_sizeOfMessage;
 }
 
 } // namespace common
@@ -0,0 +1,98 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CALIBRATION_CACHE_H
+#define CALIBRATION_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+
+// One cached file mapped in memory, unmapped when destroyed
+class CalibrationBlob
+{
+public:
+    CalibrationBlob() = default;
+    ~CalibrationBlob();
+    CalibrationBlob(const CalibrationBlob&) = delete;
+    CalibrationBlob& operator=(const CalibrationBlob&) = delete;
+
+    // Content as given to 'Store', followed by a zero. The mapping is private, the parsers may write to it
+    char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    uint64_t hash() const { return m_hash; }
+
+private:
+    friend class CalibrationCache;
+    void* m_map     = nullptr;
+    size_t m_mapLen = 0;
+    char* m_data    = nullptr;
+    size_t m_size   = 0;
+    uint64_t m_hash = 0;
+};
+
+/**
+ * @brief Calibration files of one sensor kept on disk, e.g. the correction file from PTC.
+ * An entry is <dir>/<key>_<name>.cache, a small header with the content hash then the content as it came
+ * from the lidar, so loading it is one mmap and the usual parse
+ */
+class CalibrationCache
+{
+public:
+    /**
+     * @param dir folder of the cache, created if missing
+     * @param key identity of the sensor, e.g. lidar type and ip address
+     */
+    CalibrationCache(const std::string& dir, const std::string& key);
+
+    /**
+     * @brief Map an entry, the hash is checked
+     *
+     * @return false if the entry is missing or corrupted
+     */
+    bool Load(const std::string& name, CalibrationBlob& blob);
+
+    /**
+     * @brief Write an entry, replaced atomically by a rename
+     *
+     * @return false on any file error
+     */
+    bool Store(const std::string& name, const char* data, size_t size);
+
+    // 64 bit FNV-1a of the content
+    static uint64_t Hash(const void* data, size_t size);
+
+private:
+    std::string path(const std::string& name) const;
+
+    std::string m_dir;
+    std::string m_key;
+};
+
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // CALIBRATION_CACHE_H
@@ -0,0 +1,117 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef DECODE_POOL_H
+#define DECODE_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "GeneralParser.h"
+#include "InputSocket.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+
+// One packet in flight, decoded by any worker and handed back in the order it was submitted
+struct DecodeJob
+{
+    UdpPacket packet;
+    // where the worker writes the points, the slot of the packet in the point buffers
+    dwLidarPointXYZI* pointXYZI = nullptr;
+    dwLidarPointRTHI* pointRTHI = nullptr;
+    PointExtraOutput extra;
+    // used as 'extra.pointTimestamp' if the caller has no time buffer, deskew needs the time of each point
+    std::vector<dwTime_t> localTimestamp;
+    dwLidarDecodedPacket output;
+    PacketDecodeInfo info;
+    dwStatus status = DW_FAILURE;
+    bool done       = false;
+};
+
+/**
+ * @brief Decode packets on several threads with the stateless 'GeneralParser::DecodePacket'.
+ * Jobs are kept in a ring, so 'collect' always returns the oldest one and the caller applies the
+ * stream state (frame split, deskew) in packet order
+ */
+class DecodePool
+{
+public:
+    /**
+     * @param parser parser shared by all the workers, only 'DecodePacket' is called by them
+     * @param threadNum number of worker threads
+     * @param queueSize max number of jobs in flight
+     * @param maxPoints max points of one packet, size of the local time buffer of a job
+     */
+    DecodePool(GeneralParser* parser, uint32_t threadNum, uint32_t queueSize, size_t maxPoints);
+    ~DecodePool();
+
+    /**
+     * @brief Copy the packet into a free job and wake up a worker
+     *
+     * @return false if all the jobs are in flight, collect one first
+     */
+    bool submit(const UdpPacket& packet, dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI,
+                const PointExtraOutput& extra);
+
+    /**
+     * @brief Wait for the oldest job to be decoded. The job stays valid until 'release'
+     *
+     * @return nullptr if no job is in flight
+     */
+    DecodeJob* collect();
+
+    // Give the job returned by 'collect' back to the ring
+    void release();
+
+    // Wait for the jobs in flight and drop them
+    void clear();
+
+    size_t pending();
+
+    // Bytes of the jobs and their time buffers, all allocated at construction
+    size_t memoryBytes() const;
+    size_t residentBytes() const;
+
+private:
+    void workerLoop();
+
+    GeneralParser* m_parser;
+    std::vector<DecodeJob> m_jobs;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_workCond;
+    std::condition_variable m_doneCond;
+    // ever increasing job counters, the job index is counter % m_jobs.size()
+    uint64_t m_submitted  = 0;
+    uint64_t m_dispatched = 0;
+    uint64_t m_collected  = 0;
+    bool m_stop           = false;
+};
+
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // DECODE_POOL_H
@@ -22,6 +22,12 @@
 #include <iostream>
 #include <unordered_map>
 #include <fstream>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 #include <BufferPool.hpp>
 #include <ByteQueue.hpp>
@@ -29,6 +35,12 @@
 #include "TcpCommandClient.h"
 #include "GeneralParser.h"
 #include "InputSocket.h"
+#include "DecodePool.h"
+#include "CalibrationCache.h"
+#include "SideChannel.h"
+#include "StatusPoller.h"
+#include "StageStats.h"
+#include "TraceProbes.h"
 
 namespace dw
 {
@@ -43,6 +55,14 @@ const std::string LIDAR_TYPE_P128 = "Pandar128E3X";
 
 const size_t SAMPLE_BUFFER_POOL_SIZE = 5;
 
+// Decoded points are kept in a ring of packets, as dw reads them after 'parseData' returns
+const size_t POINT_BUFFER_PACKETS = 21000;
+const size_t MAX_POINTS_PER_PACKET = 256;
+// Packets decoded ahead by the worker threads, see param 'decode_threads'
+const uint32_t DECODE_QUEUE_SIZE = 64;
+// Packets kept while the calibration is loaded, decoded once it is ready, about 1 s of a 128 line lidar
+const size_t EARLY_PACKET_LIMIT = 10000;
+
 const uint32_t PACKET_OFFSET   = sizeof(uint32_t) + sizeof(dwTime_t);
 const uint32_t RAW_PACKET_SIZE = sizeof(UdpPacket) + PACKET_OFFSET;
 
@@ -51,6 +71,45 @@ typedef struct
     uint8_t rawData[RAW_PACKET_SIZE];
 } rawPacket;
 
+// What 'readRawData' does when driveworks holds all the raw packet slots, param 'overload_policy'
+enum class OverloadPolicy
+{
+    // wait for a slot up to 'slot_deadline_ms', the packets stay queued
+    BLOCK,
+    // return at once, the queued packets are kept and new ones are dropped once the queue is full
+    DROP_NEWEST,
+    // return at once and discard the queued packets, the next free slot gets a fresh packet
+    DROP_OLDEST,
+};
+
+// Memory of one sensor, see 'getMemoryStats'
+struct MemoryStats
+{
+    MemoryUsage usage;
+    // raw packets pushed and not parsed yet, and the most since start
+    uint64_t queuedPackets;
+    uint64_t peakQueuedPackets;
+};
+
+// Counters of the raw packet slots, see 'getOverloadStats'
+struct OverloadStats
+{
+    uint64_t deliveredPackets;
+    // 'readRawData' calls that found no free slot
+    uint64_t slotMisses;
+    // queued packets discarded by drop_oldest
+    uint64_t droppedOldest;
+    // packets dropped as the receive queue was full, counted with the io reactor only
+    uint64_t droppedQueueFull;
+    // measured over the last second
+    float packetRate;
+    // average time from 'readRawData' to 'returnRawData'
+    float slotHoldMs;
+    uint32_t slotCount;
+    // packet rate * hold time with 2x headroom for bursts
+    uint32_t suggestedSlotCount;
+};
+
 class HesaiLidar
 {
 public:
@@ -64,6 +123,8 @@ public:
     {
         resetSlot();
         count = 0;
+        m_pointXYZI.Allocate(POINT_BUFFER_PACKETS * MAX_POINTS_PER_PACKET);
+        m_pointRTHI.Allocate(POINT_BUFFER_PACKETS * MAX_POINTS_PER_PACKET);
     }
 
     virtual ~HesaiLidar();
@@ -91,6 +152,8 @@ public:
      * Attention! the point cloud won't be displayed correct if no correction file is found. It will cause point cloud shaking.
      * Virtual sensor: from a local default folder
      * Live sensor: from a live sensor by PTC command. Also from a local folder if PTC command failed. PTC is the TCP protocal defined by Hesai
+     * The udp socket is opened first and the live sensor loads the files on a thread, so several sensors start
+     * in parallel. Packets are buffered until the calibration is installed, see 'EARLY_PACKET_LIMIT'
      */
     dwStatus startSensor();
 
@@ -138,6 +201,7 @@ public:
      * @brief Deocde essential user params from the terminal, and initialize the auguments of the class
      * 
      * @param params user params from the terminal
+     * @return DW_INVALID_ARGUMENT if the params can not be used together
      */
     dwStatus loadUserParams(const char* params);
     
@@ -152,6 +216,89 @@ public:
     dwStatus loadChannelConfig();
     dwStatus loadFiretimes();
 
+    /**
+     * @brief Update the ego motion used to deskew the points, thread safe.
+     * Deskew is enabled by the first call if it is not enabled by params
+     *
+     * @param motion linear velocity in m/s and angular velocity in rad/s in the lidar frame
+     */
+    dwStatus setEgoMotion(const DeskewMotion& motion);
+
+    /**
+     * @brief Get the per-point timestamps of one decoded packet, enabled by param 'point_time=1'
+     *
+     * @param[in] points 'pointsXYZI' of the decoded packet
+     * @param[out] timestamps return the time in us of each point, same order as 'points'
+     */
+    dwStatus getPointTimestamps(const dwLidarPointXYZI* points, const dwTime_t** timestamps);
+
+    /**
+     * @brief Get the range image of the last completed scan, enabled by param 'output_mode=range_image'
+     * The image is filled in the decode loop and stays valid until the next scan completes
+     *
+     * @param[out] image return the last completed range image, nullptr if no scan is completed yet
+     */
+    dwStatus getRangeImage(const RangeImage** image);
+
+    /**
+     * @brief Get the compact points of one decoded packet, enabled by param 'compact_point=1'
+     *
+     * @param[in] points 'pointsXYZI' of the decoded packet
+     * @param[out] compactPoints return the 8 byte points, same order as 'points'
+     */
+    dwStatus getCompactPoints(const dwLidarPointXYZI* points, const CompactPoint** compactPoints);
+
+    /**
+     * @brief Load the calibration and firetimes again, from PTC with the local files as fallback.
+     * The tables are parsed on the calling thread and swapped in between two packets, the decode is not stopped
+     * and a table that fails to parse keeps the former one
+     *
+     * @return DW_NOT_READY if the sensor is not started yet
+     */
+    dwStatus reloadCalibration();
+
+    /**
+     * @brief Get the counters of the raw packet slots, e.g. to size 'slot_count' from the measured packet rate
+     */
+    dwStatus getOverloadStats(OverloadStats* stats);
+
+    /**
+     * @brief Get the latest GPS packet of a live sensor, e.g. to check the PPS lock or the host clock offset.
+     * The GPS packets are queued by 'readRawData' and parsed by this call
+     */
+    dwStatus getGpsStatus(GpsStatus* status);
+
+    /**
+     * @brief Get the latest fault message of a live sensor, parsed by this call like 'getGpsStatus'
+     */
+    dwStatus getHealth(HealthStatus* status);
+
+    /**
+     * @brief Take the oldest log report packet of a live sensor
+     *
+     * @return DW_NOT_AVAILABLE if none is queued
+     */
+    dwStatus readLogReport(SidePacket* packet);
+
+    /**
+     * @brief Get the last status polled by the thread of param 'status_interval_ms', without locks
+     *
+     * @return DW_NOT_AVAILABLE if the poller is not enabled
+     */
+    dwStatus getLidarStatus(LidarStatusSnapshot* status);
+
+    /**
+     * @brief Get the packet counters and the latency of each stage, see 'PacketStage'. Always on, read while
+     * the sensor runs. The stages of 'readRawData' are only measured for a live sensor
+     */
+    dwStatus getStageStats(StageStatsSnapshot* stats);
+
+    /**
+     * @brief Get the bytes of each component, e.g. the point buffers, the parser tables and the packet queues,
+     * split in static and dynamic bytes with the part in RAM. Read while the sensor runs
+     */
+    dwStatus getMemoryStats(MemoryStats* stats);
+
     /**
      * @brief Get lidar constants
      * 
@@ -160,12 +307,35 @@ public:
      */
     virtual dwStatus getDecoderConstants(_dwSensorLidarDecoder_constants* constants);
 
-    static std::vector<std::unique_ptr<dw::plugins::lidar::HesaiLidar>> g_sensorContext;
+    // Shared with the extension APIs, which keep a reference for their call when the sensor is released meanwhile
+    static std::vector<std::shared_ptr<dw::plugins::lidar::HesaiLidar>> g_sensorContext;
+    // Guards g_sensorContext, the lookups of the plugin APIs and 'createHandle' and 'release'
+    static std::mutex g_sensorContextMutex;
+    // Sensors created in the process so far, gives the id of the trace probes
+    static std::atomic<uint32_t> g_sensorNum;
 
     std::string getLidarType();
 
 protected:
     void resetSlot();
+    // Take a free slot following 'm_overloadPolicy', false if there is none
+    bool acquireSlot(rawPacket*& result);
+    // Print the slot counters, at most once per second
+    void reportOverload(dwTime_t now);
+    // Print the stage stats every 'm_statsIntervalS' if set, 'now' from 'StageClockNs'
+    void reportStageStats(uint64_t now);
+    // Print the memory of each component, once the calibration is ready
+    void printMemoryStats();
+    // Record the depth of 'm_buffer' for 'getMemoryStats', called by the thread that owns it
+    inline void noteQueueDepth()
+    {
+        uint64_t depth = m_buffer.size();
+        m_queueDepth.store(depth, std::memory_order_relaxed);
+        m_queueBytes.store(m_buffer.capacityBytes(), std::memory_order_relaxed);
+        if (depth > m_queuePeak.load(std::memory_order_relaxed)) {
+            m_queuePeak.store(depth, std::memory_order_relaxed);
+        }
+    }
 
     inline bool isVirtualSensor()
     {
@@ -184,6 +354,34 @@ protected:
 
     std::string getSearchString(std::string params, const std::string search);
 
+    // Index of the points from 'parseData' in the point buffer, -1 if they are not from it
+    ptrdiff_t getPointOffset(const dwLidarPointXYZI* points);
+
+    // Load calibration and firetimes, then switch the decode on
+    void bringUp();
+    // Load from PTC with the local files as fallback
+    void loadCalibration();
+    // Wait for the bring up thread if it is running
+    void waitBringUp();
+    // Wait until the calibration is installed if the bring up thread is running
+    void waitCalibrationReady();
+
+    // Parse the calibration and firetimes of the cache, false if any of them is missing
+    bool loadCachedCalibration();
+    // Fetch the calibration from the lidar and publish it to the decoders if its hash differs from the installed one
+    void revalidateCalibration();
+
+    // Send the PTC gets of the start up in one round trip, see 'ptcGet'
+    void prefetchPtc(const std::vector<PTC_COMMAND>& commands);
+    // Same as TcpCommandGet, served from the prefetched replies first
+    PTC_ErrCode ptcGet(PTC_COMMAND command, unsigned char** buffer, unsigned int* len);
+
+    // Hand the buffered packets to the decode pool until it is full
+    void submitPackets();
+
+    // Bind the point buffers and parser tables to a NUMA node, then fault them in
+    void prepareMemory(int numaNode);
+
     void printLidarProperty(dwLidarProperties* property);
 
     // Refer to other nvidia plugins, e.g. radar, camera
@@ -192,17 +390,53 @@ protected:
     dwSensorHandle_t m_lidarSensor = nullptr;
     // Virtual sensor, namely playing a local bin file
     bool m_virtualSensorFlag;
+    // Creation order in the process, the sensor of the trace probes
+    uint32_t m_sensorId = g_sensorNum++;
 
     // Store UDP data in a local buffer
     dw::plugin::common::ByteQueue m_buffer;
+    // depth and reserved bytes of above queue, it is only read by the thread of 'pushData'
+    std::atomic<uint64_t> m_queueDepth{0};
+    std::atomic<uint64_t> m_queuePeak{0};
+    std::atomic<uint64_t> m_queueBytes{0};
     std::unique_ptr<dw::plugins::common::BufferPool<rawPacket>> m_slot;
     std::unordered_map<uint8_t*, rawPacket*> m_map;
     size_t m_slotSize;
+    OverloadPolicy m_overloadPolicy = OverloadPolicy::BLOCK;
+    // 0 waits without limit
+    int m_slotDeadlineMs = 0;
+    std::atomic<uint64_t> m_deliveredNum{0};
+    std::atomic<uint64_t> m_slotMissNum{0};
+    std::atomic<uint64_t> m_droppedOldestNum{0};
+    // 'returnRawData' may run on another thread
+    std::atomic<uint64_t> m_slotHoldUs{0};
+    std::atomic<uint64_t> m_slotHoldNum{0};
+    std::atomic<float> m_packetRate{0};
+    dwTime_t m_rateWindowStart = 0;
+    uint64_t m_rateWindowNum = 0;
+    dwTime_t m_overloadReported = 0;
+    // GPS, fault message and log report packets taken out of the point packet stream by 'readRawData'
+    SideChannels m_sideChannels;
+    // PTC and packet tail status of a live sensor, polled every 'm_statusIntervalMs' if set
+    std::unique_ptr<StatusPoller> m_statusPoller;
+    int m_statusIntervalMs = 0;
+    // Counters and latency histograms of the packet stages, printed every 'm_statsIntervalS' if set
+    StageStats m_stageStats;
+    int m_statsIntervalS = 0;
+    uint64_t m_statsReported = 0;
 
     // PTC/TCP client to acuqure the correction file
-    void *m_pTcpCommandClient;
+    void *m_pTcpCommandClient = nullptr;
+    // Replies fetched in one round trip at start, taken by 'ptcGet'
+    std::vector<TcpCommandReply> m_ptcPrefetch;
     // Socket client to acquire the UDP packet
     InputSocket m_inputSocket;
+    // Sockets are received by the epoll thread shared by all the sensors, or polled by 'readRawData' if false
+    bool m_ioReactorFlag = true;
+    // Capture read in place of the sockets by param 'source=pcap:<file>', no PTC then, the local files are used
+    std::string m_pcapPath;
+    double m_pcapSpeed = 1;
+    bool m_pcapLoop = false;
 
     std::string m_ipAddress;
     std::string m_hostIpAddress;
@@ -214,15 +448,56 @@ protected:
     // To be updated by user through terminal input
     std::string m_correctionFilePath = "./correction_at128.dat";
     std::string m_firetimesPath = "./firetimes_qt128.dat";
+    // Only for Pandar128 whose firetimes can't be acquired by PTC
+    bool m_firetimesFileFlag = false;
     std::string m_channelConfigPath = "./channelconfig_qt128.dat";
 
     unsigned short m_udpPort;
     unsigned short m_ptcPort;
 
     // Base class pointer to be initialized as typical parser
-    GeneralParser* m_Parser;
-    dwLidarPointXYZI m_pointXYZI[21000][256];
-    dwLidarPointRTHI m_pointRTHI[21000][256];
+    GeneralParser* m_Parser = nullptr;
+    // 86 MB each, in huge pages to save the TLB misses, see README param 'numa_node'
+    HugePageArray<dwLidarPointXYZI> m_pointXYZI;
+    HugePageArray<dwLidarPointRTHI> m_pointRTHI;
+    // Time of each point in above buffer, empty unless param 'point_time=1'
+    HugePageArray<dwTime_t> m_pointTimestamp;
+    // Quantized copy of the points in above buffer, empty unless param 'compact_point=1'
+    HugePageArray<CompactPoint> m_compactPoint;
+    // NUMA node of the buffers and tables, -1 not bound, -2 the node of the decode thread once it runs
+    int m_numaNode = -1;
+    // Range image written by the parser and the last completed one, swapped when a scan completes
+    bool m_rangeImageFlag = false;
+    RangeImage m_rangeImage[2];
+    int m_rangeImageWrite = 0;
+    std::atomic<int> m_rangeImageReady{-1};
+    // Deskew from params, handed to the parser once it is created
+    bool m_deskewFlag = false;
+    DeskewMotion m_deskewMotion = {};
+    // Set once the calibration is installed, packets are only buffered before
+    std::atomic<bool> m_calibrationReady{false};
+    // Load the calibration on a thread for live sensors, disabled by param 'async_start=0'
+    bool m_asyncStartFlag = true;
+    std::thread m_bringUpThread;
+    std::mutex m_bringUpMutex;
+    std::atomic<bool> m_bringUpStarted{false};
+    std::mutex m_readyMutex;
+    std::condition_variable m_readyCond;
+    // Calibration cache of param 'calib_cache', null if not set
+    std::unique_ptr<CalibrationCache> m_calibCache;
+    std::string m_calibCacheDir;
+    // content hash of the installed files from PTC
+    uint64_t m_correctionHash = 0;
+    uint64_t m_firetimesHash = 0;
+    // serializes 'reloadCalibration' calls, the decoders do not take it
+    std::mutex m_reloadMutex;
+    // Packets received before the calibration is ready, buffered or dropped above the limit
+    std::atomic<uint64_t> m_earlyPacketNum{0};
+    std::atomic<uint64_t> m_earlyDroppedNum{0};
+    bool m_earlyReported = false;
+    // Packets are decoded by a pool of threads if more than one, then sequenced by 'parseData'
+    uint32_t m_decodeThreads = 1;
+    std::unique_ptr<DecodePool> m_decodePool;
     // record how many points in above buffer
     int count = 0;
 
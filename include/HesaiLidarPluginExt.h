@@ -0,0 +1,341 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd] 
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef HESAI_LIDAR_PLUGIN_EXT_H
+#define HESAI_LIDAR_PLUGIN_EXT_H
+
+// Extra APIs of the hesai plugin beyond the driveworks function table.
+// The application gets them by dlsym on the plugin library, e.g. dlsym(handle, "hesaiLidarPlugin_getSensorCount")
+// Sensors are addressed by index in the order they are created by driveworks
+
+#include <stdint.h>
+#include <stddef.h>
+#include <dw/sensors/plugins/lidar/LidarPlugin.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Constant-velocity ego motion of the lidar, in the lidar frame
+typedef struct
+{
+    // m/s
+    float linearVelocity[3];
+    // rad/s
+    float angularVelocity[3];
+    // sensor time (us) the points are compensated to, 0 means the start of each scan
+    int64_t referenceTime;
+} HesaiEgoMotion;
+
+// Organized range image of one scan: row = laser id, column = azimuth bin, one layer per return.
+// Each plane has returns * rows * cols cells, cell (ret, row, col) is at (ret * rows + row) * cols + col
+typedef struct
+{
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t returns;
+    // azimuth of the first column and the width of a column in degree
+    float azimuthStartDeg;
+    float azimuthStepDeg;
+    // sensor time in us of the first packet of the scan
+    int64_t timestamp;
+    // increase by one for each completed scan
+    uint64_t frameId;
+    // range in m, 0 for an empty cell
+    const float* range;
+    const float* x;
+    const float* y;
+    const float* z;
+    const uint8_t* intensity;
+    // 1 if the cell has a return, 0 for an empty cell whose x/y/z/intensity are not defined
+    const uint8_t* valid;
+} HesaiRangeImage;
+
+// 8 byte quantized point, xyz in cm saturated at +-327.67 m
+typedef struct
+{
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    uint8_t intensity;
+    uint8_t laserId;
+} HesaiCompactPoint;
+
+// Counters of the raw packet slots handed to driveworks by readRawData
+typedef struct
+{
+    uint64_t deliveredPackets;
+    // readRawData calls that found all the slots held
+    uint64_t slotMisses;
+    // queued packets discarded by 'overload_policy=drop_oldest'
+    uint64_t droppedOldest;
+    // packets dropped as the receive queue was full, counted with 'io_reactor' only
+    uint64_t droppedQueueFull;
+    // packets per second over the last second
+    float packetRate;
+    // average time driveworks holds a slot
+    float slotHoldMs;
+    uint32_t slotCount;
+    // packet rate * hold time with 2x headroom, a value for 'slot_count'
+    uint32_t suggestedSlotCount;
+} HesaiOverloadStats;
+
+// Latest GPS packet of the lidar
+typedef struct
+{
+    // packets received, 'droppedNum' more were lost as nobody read them
+    uint64_t packetNum;
+    uint64_t droppedNum;
+    // 0 until a GPS packet is parsed
+    uint8_t valid;
+    uint8_t positioned;
+    uint8_t ppsLocked;
+    // UTC in us since the epoch
+    int64_t gpsTime;
+    // host time the packet was received, the clock of the point timestamps
+    dwTime_t hostTime;
+    // GPRMC or GPGGA sentence, zero terminated
+    char nmea[78];
+} HesaiGpsStatus;
+
+// Latest fault message of the lidar
+typedef struct
+{
+    // messages received, 'droppedNum' more were lost as nobody read them
+    uint64_t faultMessageNum;
+    uint64_t droppedNum;
+    // messages reporting a current or history fault
+    uint64_t faultNum;
+    // 0 until a fault message is parsed
+    uint8_t valid;
+    uint8_t operationState;
+    uint8_t faultState;
+    uint8_t faultCodeType;
+    uint8_t totalFaultCodeNum;
+    uint8_t faultCodeId;
+    uint32_t faultCode;
+    // lidar time of the message in us since the epoch
+    int64_t lidarTime;
+    dwTime_t hostTime;
+} HesaiHealth;
+
+// Lidar status polled in the background, see param 'status_interval_ms'
+typedef struct
+{
+    // increased by each poll, compare it to see if the status is new
+    uint64_t version;
+    dwTime_t hostTime;
+
+    // PTC status, 0 if the last get failed
+    uint8_t ptcValid;
+    uint32_t uptimeS;
+    uint16_t motorSpeedRpm;
+    // bottom board 1 and 2, laser board 1 and 2, receiver board 1 and 2, top board 1 and 2
+    float temperatureC[8];
+    uint8_t gpsPpsLock;
+    uint8_t gpsGprmcStatus;
+    uint8_t ptpClockStatus;
+    uint32_t startupTimes;
+    uint32_t totalOperationMin;
+
+    // status in the tail of a point packet sampled once per poll, 0 if no packet came
+    uint8_t tailValid;
+    uint8_t statusNum;
+    uint8_t statusId[3];
+    uint16_t statusData[3];
+    uint16_t tailMotorSpeed;
+    uint8_t returnMode;
+    uint8_t shutdown;
+    // functional safety of Pandar128
+    uint8_t hasFuncSafety;
+    uint8_t lidarState;
+    uint8_t currentFault;
+    uint8_t historyFault;
+    uint8_t faultNum;
+    uint8_t faultId;
+    uint16_t faultCode;
+} HesaiLidarStatus;
+
+// Latency of one packet stage, the percentiles are within 3%
+typedef struct
+{
+    uint64_t count;
+    float meanUs;
+    float p50Us;
+    float p90Us;
+    float p99Us;
+    float p999Us;
+    float maxUs;
+} HesaiStageLatency;
+
+// Packet counters and stage latencies of a sensor, see 'hesaiLidarPlugin_getStageStats'
+typedef struct
+{
+    // point packets handed out by readRawData, live sensor only
+    uint64_t receivedPackets;
+    uint64_t pushedPackets;
+    uint64_t parsedPackets;
+    uint64_t points;
+    uint64_t frames;
+    // packets the parser rejected, e.g. of an unknown format
+    uint64_t decodeErrors;
+    // readRawData calls that found all the slots held
+    uint64_t droppedSlotMiss;
+    uint64_t droppedOldest;
+    uint64_t droppedQueueFull;
+    // packets above the limit buffered before the calibration was installed
+    uint64_t droppedEarly;
+    // socket receive to readRawData, live sensor only
+    HesaiStageLatency receiveToRead;
+    // readRawData to pushData, live sensor only
+    HesaiStageLatency readToPush;
+    // one parseData call
+    HesaiStageLatency parsePacket;
+    // parseData time summed over the packets of a frame
+    HesaiStageLatency parseFrame;
+    // socket receive to parseData returning the points, live sensor only
+    HesaiStageLatency receiveToParsed;
+} HesaiStageStats;
+
+#define HESAI_MEMORY_COMPONENT_NUM 16
+
+// Bytes of one part of a sensor, e.g. "point buffers" or "parser tables"
+typedef struct
+{
+    char name[24];
+    // allocated at start and kept
+    uint64_t staticBytes;
+    // grows with the load or changes with the calibration, e.g. the raw packet queue
+    uint64_t dynamicBytes;
+    // part of the above in RAM, mapped pages only count once they are touched
+    uint64_t residentBytes;
+} HesaiMemoryComponent;
+
+// Memory of a sensor, see 'hesaiLidarPlugin_getMemoryStats'
+typedef struct
+{
+    uint64_t staticBytes;
+    uint64_t dynamicBytes;
+    uint64_t residentBytes;
+    // raw packets pushed and not parsed yet, and the most since start
+    uint64_t queuedPackets;
+    uint64_t peakQueuedPackets;
+    uint32_t componentNum;
+    HesaiMemoryComponent components[HESAI_MEMORY_COMPONENT_NUM];
+} HesaiMemoryStats;
+
+/**
+ * @brief Number of hesai lidars created in this process
+ */
+uint32_t hesaiLidarPlugin_getSensorCount();
+
+/**
+ * @brief Update the ego motion to deskew the following points, e.g. from the odometry.
+ * The points are compensated in the decode loop, no second pass is needed
+ */
+dwStatus hesaiLidarPlugin_setEgoMotion(uint32_t sensorIndex, const HesaiEgoMotion* motion);
+
+/**
+ * @brief Get the sensor time in us of each point in a decoded packet, enabled by param 'point_time=1'
+ *
+ * @param[in] points 'pointsXYZI' of the dwLidarDecodedPacket
+ * @param[out] timestamps return 'nPoints' timestamps in the same order, valid as long as the points
+ */
+dwStatus hesaiLidarPlugin_getPointTimestamps(uint32_t sensorIndex, const dwLidarPointXYZI* points,
+                                             const dwTime_t** timestamps);
+
+/**
+ * @brief Get the range image of the last completed scan, enabled by param 'output_mode=range_image'.
+ * The planes are filled in the decode loop and stay valid until the next scan completes,
+ * check 'frameId' after the use if the processing may take longer than one scan
+ */
+dwStatus hesaiLidarPlugin_getRangeImage(uint32_t sensorIndex, HesaiRangeImage* image);
+
+/**
+ * @brief Get the compact points of a decoded packet, enabled by param 'compact_point=1'.
+ * They are quantized in the decode loop, 'nPoints' points in the same order as 'points'
+ */
+dwStatus hesaiLidarPlugin_getCompactPoints(uint32_t sensorIndex, const dwLidarPointXYZI* points,
+                                           const HesaiCompactPoint** compactPoints);
+
+/**
+ * @brief Pack and unpack compact points with SSE2/NEON, e.g. for recorded or received points.
+ * The laser id is dropped by unpack, 'laserIds' can be NULL for pack
+ */
+void hesaiLidarPlugin_packCompactPoints(HesaiCompactPoint* compactPoints, const dwLidarPointXYZI* points,
+                                        const uint8_t* laserIds, size_t count);
+void hesaiLidarPlugin_unpackCompactPoints(dwLidarPointXYZI* points, const HesaiCompactPoint* compactPoints,
+                                          size_t count);
+
+/**
+ * @brief Get the counters of the raw packet slots, see params 'slot_count' and 'overload_policy'
+ */
+dwStatus hesaiLidarPlugin_getOverloadStats(uint32_t sensorIndex, HesaiOverloadStats* stats);
+
+/**
+ * @brief Get the latest GPS packet, e.g. the PPS lock and 'hostTime - gpsTime' to synchronize the host clock.
+ * The GPS packets are set aside by readRawData and parsed by this call, read it about once per second
+ */
+dwStatus hesaiLidarPlugin_getGpsStatus(uint32_t sensorIndex, HesaiGpsStatus* status);
+
+/**
+ * @brief Get the latest fault message of the lidar, parsed by this call like the GPS packets
+ */
+dwStatus hesaiLidarPlugin_getHealth(uint32_t sensorIndex, HesaiHealth* health);
+
+/**
+ * @brief Take the oldest log report packet, raw
+ *
+ * @param[out] data buffer of 'capacity' bytes
+ * @param[out] size return the size of the packet, it is cut to 'capacity'
+ * @return DW_NOT_AVAILABLE if none is queued
+ */
+dwStatus hesaiLidarPlugin_readLogReport(uint32_t sensorIndex, uint8_t* data, size_t capacity, size_t* size,
+                                        dwTime_t* hostTime);
+
+/**
+ * @brief Get the last status polled by the background thread, without locks and without a PTC round trip.
+ * Enabled by param 'status_interval_ms'
+ *
+ * @return DW_NOT_AVAILABLE if the polling is not enabled
+ */
+dwStatus hesaiLidarPlugin_getLidarStatus(uint32_t sensorIndex, HesaiLidarStatus* status);
+
+/**
+ * @brief Get the packet counters and the latency histograms of the packet stages, always on and without locks.
+ * Printed every 'stats_interval_s' if the param is set
+ */
+dwStatus hesaiLidarPlugin_getStageStats(uint32_t sensorIndex, HesaiStageStats* stats);
+
+/**
+ * @brief Get the memory of a sensor by component, static and dynamic bytes and the resident part of them.
+ * Also printed once at start, when the calibration is ready
+ */
+dwStatus hesaiLidarPlugin_getMemoryStats(uint32_t sensorIndex, HesaiMemoryStats* stats);
+
+/**
+ * @brief Load the calibration of a started sensor again, e.g. after it is changed on the lidar.
+ * It blocks for the PTC round trips, the packets are decoded with the former calibration until the new one is parsed
+ */
+dwStatus hesaiLidarPlugin_reloadCalibration(uint32_t sensorIndex);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // HESAI_LIDAR_PLUGIN_EXT_H
@@ -24,6 +24,7 @@
 #include <netinet/in.h>
 #include <string>
 #include <map>
+#include <memory>
 #include "util.h"
 
 #define FAULT_MESSAGE_PCAKET_SIZE (99)
@@ -51,7 +52,7 @@ static uint16_t GPS_PORT_NUMBER = 10110;     // default gps port
 class InputSocket
 {
 public:
-	InputSocket() {};
+	InputSocket() : m_iSockfd(-1), m_iSockGpsfd(-1), m_iSocktNumber(0) {};
     ~InputSocket() { CloseSocket(); };
 	
 	/** @brief Initialize two socket object, UDP and GPS
@@ -64,6 +65,23 @@ public:
 
 	void CloseSocket();
 
+	/**
+	 * @brief Hand the sockets to the shared UdpReactor, 'GetPacket' then reads the packets it received
+	 * instead of polling the sockets
+	 *
+	 * @return false if the reactor is not available, 'GetPacket' keeps polling
+	 */
+	bool AttachReactor();
+
+	/**
+	 * @brief Read the packets of a capture instead of the sockets, see 'PcapSource'. 'GetPacket' returns
+	 * PCAP_END_PACKET at its end
+	 *
+	 * @param speed 1 for the timing of the capture, 0 as fast as read
+	 * @return false if the file can not be read
+	 */
+	bool OpenPcap(std::string path, uint16_t lidarport, double speed, bool loop, uint16_t gpsport = GPS_PORT_NUMBER);
+
 	/**
 	 * @brief Get a single packet via UDP socket
 	 * 
@@ -73,6 +91,23 @@ public:
 	 */
 	PacketType GetPacket(UdpPacket *&pkt, int timeout);
 
+	/**
+	 * @brief Discard the packets received and not read yet, without waiting
+	 *
+	 * @return number of packets discarded
+	 */
+	size_t DiscardPackets();
+
+	// Packets dropped as the queue of the reactor was full, 0 if not attached as the kernel does not count them per socket
+	uint64_t GetDroppedNum() const;
+
+	// Bytes of the reactor queue and the ones in RAM, 0 if not attached
+	size_t GetBufferBytes() const;
+	size_t GetBufferResidentBytes() const;
+
+	// Time the last packet of 'GetPacket' was received, see 'StageClockNs'
+	uint64_t GetRecvTime() const { return m_u64RecvTime; }
+
 protected:
 	uint16_t m_u16LidarPort;
 	std::string m_sDeviceIpAddr;
@@ -88,5 +123,10 @@ protected:
 	int m_iSockGpsfd;
 	int m_iSocktNumber;
 	uint32_t m_u32Sequencenum;
+	uint64_t m_u64RecvTime = 0;
+	// Packets of both sockets received by the reactor, null if not attached
+	std::shared_ptr<class UdpChannel> m_pChannel;
+	// Packets of a capture, null if reading the sockets
+	std::shared_ptr<class PcapSource> m_pPcap;
 };
 #endif // __PANDAR_INPUT_H
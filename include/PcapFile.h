@@ -0,0 +1,134 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef PCAP_FILE_H
+#define PCAP_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+
+// One udp datagram of a capture, the payload points into the mapping
+struct UdpDatagram
+{
+    // capture time, ns since 1970
+    int64_t timestamp = 0;
+    // ipv4 addresses and ports in host byte order
+    uint32_t srcAddr = 0;
+    uint32_t dstAddr = 0;
+    uint16_t srcPort = 0;
+    uint16_t dstPort = 0;
+    const uint8_t* payload = nullptr;
+    size_t length = 0;
+    // file offset of its record or block, see 'PcapFile::seek'
+    uint64_t offset = 0;
+};
+
+/**
+ * @brief A pcap or pcapng file mapped read only. Ethernet (with vlan tags), Linux cooked and raw ip captures
+ * are read, ipv4 udp datagrams are returned and the rest is skipped, e.g. arp or ip fragments.
+ * Of a pcapng file the packets of all the interfaces and sections are returned in file order
+ */
+class PcapFile
+{
+public:
+    PcapFile() = default;
+    ~PcapFile();
+    PcapFile(const PcapFile&) = delete;
+    PcapFile& operator=(const PcapFile&) = delete;
+
+    /**
+     * @brief Map a file and check its header
+     *
+     * @return false if it can not be read or it is not a pcap or pcapng file, the error is printed
+     */
+    bool open(const std::string& path);
+
+    void close();
+
+    /**
+     * @brief Next udp datagram, records are read in file order
+     *
+     * @return false at the end of the file or at a truncated record
+     */
+    bool next(UdpDatagram& datagram);
+
+    // Back to the first record
+    void rewind();
+
+    /**
+     * @brief Continue at the record of a datagram returned before, by its 'offset'. A pcap file is positioned
+     * directly, a pcapng file walks the block headers from the start to restore the byte order and the interfaces
+     * of the section, the packets are not read
+     *
+     * @return false if the offset is not the start of a record, the position is then unchanged
+     */
+    bool seek(uint64_t offset);
+
+    bool isPcapng() const { return m_pcapng; }
+
+    // Start of the mapping, the payloads point into it
+    const uint8_t* data() const { return m_data; }
+
+private:
+    // Interface of a pcapng section, from its description block
+    struct Interface
+    {
+        uint32_t linkType = 0;
+        // time stamp units per second, 1000000 unless 'if_tsresol' is given
+        uint64_t tsRate = 1000000;
+    };
+
+    bool openPcap(const std::string& path);
+    bool openPcapng(const std::string& path);
+    bool nextPcapng(UdpDatagram& datagram);
+    // Read the interface description block of a pcapng section
+    void addInterface(const uint8_t* body, size_t length);
+
+    // Strip the link layer, ip and udp headers of a frame
+    static bool decodeFrame(uint32_t linkType, const uint8_t* frame, size_t length, UdpDatagram& datagram);
+    static bool isLinkTypeSupported(uint32_t linkType);
+
+    const uint8_t* m_data = nullptr;
+    size_t m_size         = 0;
+    size_t m_offset       = 0;
+    size_t m_firstOffset  = 0;
+    uint32_t m_linkType   = 0;
+    // the file is of the other byte order, of the current section for pcapng
+    bool m_swapped = false;
+    // the fraction of the record time is in ns instead of us
+    bool m_nanosecond = false;
+    bool m_pcapng     = false;
+    std::vector<Interface> m_interfaces;
+    // time of the last packet, the simple packet block has none
+    int64_t m_lastTimestamp = 0;
+};
+
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // PCAP_FILE_H
@@ -0,0 +1,87 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef PCAP_SOURCE_H
+#define PCAP_SOURCE_H
+
+#include <stdint.h>
+#include <string>
+
+#include "InputSocket.h"
+#include "PcapFile.h"
+
+/**
+ * @brief Packets of a pcap or pcapng capture served in place of the sockets, param 'source=pcap:<file>'.
+ * The file is mapped and each packet is copied once, from the mapping into the slot given by the caller,
+ * at the time it had in the capture or as fast as it is read. Runs the live path of 'readRawData' without a network
+ */
+class PcapSource {
+public:
+    PcapSource() = default;
+
+    /**
+     * @brief Map the file, the first packet is due at once
+     *
+     * @param lidarPort destination port of the point cloud, fault message and log report packets
+     * @param gpsPort destination port of the GPS packets, the other ports are skipped
+     * @param speed 1 for the timing of the capture, 2 twice as fast, 0 as fast as they are read
+     * @param loop start again at the end of the file, the time goes on
+     * @return false if the file can not be read
+     */
+    bool Open(const std::string &path, uint16_t lidarPort, uint16_t gpsPort, double speed, bool loop);
+
+    /**
+     * @brief Copy the next packet into pkt once it is due
+     *
+     * @param timeout in ms, wait for the next packet up to it
+     * @param[out] recvTime return the time it was handed out, see 'StageClockNs'
+     * @return PCAP_END_PACKET at the end of the file, TIMEOUT if the next packet is not due within the timeout
+     */
+    PacketType GetPacket(UdpPacket *pkt, int timeout, uint64_t *recvTime);
+
+    // Skip the packets already due, as the socket queue is drained
+    size_t DiscardPackets();
+
+    uint64_t GetPacketNum() const { return m_u64PacketNum; }
+
+private:
+    // read the next datagram of the ports into m_next, rewound at the end if looping
+    bool Fetch();
+    // StageClockNs of m_next
+    uint64_t DueTime() const;
+
+    dw::plugins::lidar::PcapFile m_file;
+    dw::plugins::lidar::UdpDatagram m_next;
+    bool m_bHasNext = false;
+    uint16_t m_u16LidarPort = 0;
+    uint16_t m_u16GpsPort = 0;
+    double m_dSpeed = 1;
+    bool m_bLoop = false;
+    // capture time of the first packet and the clock when it was due
+    int64_t m_i64FirstCapture = 0;
+    uint64_t m_u64StartNs = 0;
+    // capture time added to the packets of each loop, so the time goes on at the rewind
+    int64_t m_i64LoopOffset = 0;
+    // first and last capture time of the current loop and its packet count
+    int64_t m_i64PassFirst = 0;
+    int64_t m_i64LastCapture = 0;
+    uint64_t m_u64PassNum = 0;
+    uint64_t m_u64PacketNum = 0;
+};
+
+#endif // PCAP_SOURCE_H
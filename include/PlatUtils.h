@@ -26,6 +26,7 @@
 #include <string.h>
 #include <time.h>
 #include <map>
+#include <string>
 #include <utility>
 
 #define SHED_FIFO_PRIORITY_HIGH 99
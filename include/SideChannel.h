@@ -0,0 +1,154 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SIDE_CHANNEL_H
+#define SIDE_CHANNEL_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <dw/sensors/plugins/lidar/LidarPlugin.h>
+
+#include "HugePageAllocator.h"
+#include "InputSocket.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+
+// Largest side packet, the GPS packet
+const size_t SIDE_PACKET_SIZE = 512;
+
+struct SidePacket
+{
+    // host time it was received, same clock as the point packets
+    dwTime_t hostTime;
+    uint16_t len;
+    uint8_t data[SIDE_PACKET_SIZE];
+};
+
+/**
+ * @brief Lock-free queue of one packet type, written by 'readRawData' and read by the API caller.
+ * Single producer and single consumer, a full queue drops the new packet so the producer never waits
+ */
+class SideQueue
+{
+public:
+    explicit SideQueue(size_t capacity)
+        : m_packets(capacity) {}
+
+    bool push(const uint8_t* data, size_t len, dwTime_t hostTime);
+    bool pop(SidePacket& packet);
+
+    uint64_t pushedNum() const { return m_tail.load(std::memory_order_relaxed); }
+    uint64_t droppedNum() const { return m_dropped.load(std::memory_order_relaxed); }
+    size_t memoryBytes() const { return m_packets.capacity() * sizeof(SidePacket); }
+    size_t residentBytes() const { return HugePageResidentBytes(m_packets.data(), memoryBytes()); }
+
+private:
+    std::vector<SidePacket> m_packets;
+    // on their own cache lines, written by different threads
+    alignas(64) std::atomic<uint64_t> m_head{0};
+    alignas(64) std::atomic<uint64_t> m_tail{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+// Latest GPS packet and the host time it was received, their difference is the offset of the host clock
+struct GpsStatus
+{
+    // packets queued, 'droppedNum' more are lost as the queue was full
+    uint64_t packetNum;
+    uint64_t droppedNum;
+    bool valid;
+    bool positioned;
+    bool ppsLocked;
+    // UTC in us since the epoch
+    int64_t gpsTime;
+    dwTime_t hostTime;
+    // GPRMC or GPGGA sentence, zero terminated
+    char nmea[78];
+};
+
+// Latest fault message of the lidar
+struct HealthStatus
+{
+    // fault messages queued, 'droppedNum' more are lost as the queue was full
+    uint64_t faultMessageNum;
+    uint64_t droppedNum;
+    // fault messages with a current or history fault
+    uint64_t faultNum;
+    bool valid;
+    uint8_t operationState;
+    uint8_t faultState;
+    uint8_t faultCodeType;
+    uint8_t totalFaultCodeNum;
+    uint8_t faultCodeId;
+    uint32_t faultCode;
+    // lidar time of the message in us since the epoch
+    int64_t lidarTime;
+    dwTime_t hostTime;
+};
+
+/**
+ * @brief GPS, fault message and log report packets of one sensor. 'readRawData' only copies them into a
+ * bounded queue per type, they are parsed by the API caller, so a flood of them costs the point
+ * packets one copy each and fills its own queue only
+ */
+class SideChannels
+{
+public:
+    SideChannels();
+
+    /**
+     * @brief Queue a packet that is not a point cloud packet, producer side. The type is judged by the size,
+     * so it gives the length
+     *
+     * @return false if the type has no side channel
+     */
+    bool route(PacketType type, const uint8_t* data, dwTime_t hostTime);
+
+    // Parse the queued GPS packets and return the latest
+    void getGpsStatus(GpsStatus* status);
+    // Parse the queued fault messages and return the latest
+    void getHealth(HealthStatus* status);
+    // Take the oldest log report packet, raw
+    bool popLogReport(SidePacket& packet);
+
+    // Bytes of the three queues, allocated at construction
+    size_t memoryBytes() const;
+    size_t residentBytes() const;
+
+private:
+    SideQueue m_gpsQueue;
+    SideQueue m_faultQueue;
+    SideQueue m_logQueue;
+    // the consumer side, the API may be called from several threads
+    std::mutex m_mutex;
+    GpsStatus m_gpsStatus   = {};
+    HealthStatus m_health   = {};
+};
+
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // SIDE_CHANNEL_H
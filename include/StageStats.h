@@ -0,0 +1,242 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STAGE_STATS_H
+#define STAGE_STATS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+
+#include "InputSocket.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+
+// Monotonic time of the stage stamps in ns, not slewed by NTP or PTP. A vDSO call, about 20 ns
+inline uint64_t StageClockNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+// Add to a counter with one writer thread, a plain add without the lock prefix of fetch_add
+inline void AddRelaxed(std::atomic<uint64_t>& counter, uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Latency histogram with HDR style log-linear buckets: 32 buckets per power of two, so any value up to
+ * 2^40 ns (18 minutes) is kept within 3%. Recorded by one thread without locks or allocation, read by any
+ */
+class LatencyHistogram
+{
+public:
+    static const uint32_t SUB_BITS     = 5;
+    static const uint32_t SUB_COUNT    = 1u << SUB_BITS;
+    static const uint32_t MAX_EXPONENT = 40;
+    static const uint32_t BUCKET_NUM   = (MAX_EXPONENT - SUB_BITS + 1) * SUB_COUNT;
+
+    inline void record(uint64_t ns)
+    {
+        AddRelaxed(m_buckets[bucketIndex(ns)], 1);
+        AddRelaxed(m_sumNs, ns);
+        if (ns > m_maxNs.load(std::memory_order_relaxed)) {
+            m_maxNs.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    void reset();
+
+    // Count, mean, max and percentiles of what is recorded so far, read while it is being recorded
+    struct Summary
+    {
+        uint64_t count;
+        uint64_t meanNs;
+        uint64_t maxNs;
+        uint64_t p50Ns;
+        uint64_t p90Ns;
+        uint64_t p99Ns;
+        uint64_t p999Ns;
+    };
+    Summary summarize() const;
+
+    static inline uint32_t bucketIndex(uint64_t ns)
+    {
+        if (ns < SUB_COUNT) {
+            return static_cast<uint32_t>(ns);
+        }
+        uint32_t exponent = 63 - __builtin_clzll(ns);
+        if (exponent >= MAX_EXPONENT) {
+            return BUCKET_NUM - 1;
+        }
+        uint32_t mantissa = static_cast<uint32_t>(ns >> (exponent - SUB_BITS)) - SUB_COUNT;
+        return (exponent - SUB_BITS + 1) * SUB_COUNT + mantissa;
+    }
+
+    // Largest value of a bucket, what the percentiles report
+    static uint64_t bucketUpperNs(uint32_t index);
+
+private:
+    std::atomic<uint64_t> m_buckets[BUCKET_NUM] = {};
+    std::atomic<uint64_t> m_sumNs{0};
+    std::atomic<uint64_t> m_maxNs{0};
+};
+
+// Stages of a point cloud packet through the plugin
+enum PacketStage
+{
+    // socket receive to 'readRawData' handing it out, live sensor
+    STAGE_RECEIVE_TO_READ = 0,
+    // 'readRawData' to 'pushData', live sensor
+    STAGE_READ_TO_PUSH,
+    // duration of 'parseDataBuffer' for one packet
+    STAGE_PARSE_PACKET,
+    // 'parseDataBuffer' time summed over the packets of a frame
+    STAGE_PARSE_FRAME,
+    // socket receive to 'parseDataBuffer' returning the packet, live sensor
+    STAGE_RECEIVE_TO_PARSED,
+    STAGE_NUM
+};
+
+// Packets dropped or lost on the way, by reason
+struct StageDrops
+{
+    // 'readRawData' found no free raw packet slot, the packet waited in the socket
+    uint64_t slotMiss;
+    // queued packets discarded by overload_policy=drop_oldest
+    uint64_t dropOldest;
+    // the receive queue of the io reactor was full
+    uint64_t queueFull;
+    // pushed before the calibration was installed once 'EARLY_PACKET_LIMIT' was reached
+    uint64_t early;
+};
+
+struct StageStatsSnapshot
+{
+    uint64_t received;
+    uint64_t pushed;
+    uint64_t parsed;
+    uint64_t points;
+    uint64_t frames;
+    // packets the parser rejected, e.g. of an unknown format
+    uint64_t decodeErrors;
+    StageDrops drops;
+    LatencyHistogram::Summary stage[STAGE_NUM];
+};
+
+/**
+ * @brief Always-on counters and latency histograms of one sensor. The receive and read times travel with the
+ * packet in the unused end of its buffer, see 'StampPacket', so each stage reads them from the packet it has.
+ * Each stage and counter is written by one thread, e.g. 'readRawData' or 'parseData', and read by any
+ */
+class StageStats
+{
+public:
+    // Bytes of the stamp at the end of 'UdpPacket::m_u8Buf', packets longer than the offset are not stamped
+    static const size_t STAMP_SIZE   = 3 * sizeof(uint64_t);
+    static const size_t STAMP_OFFSET = sizeof(UdpPacket().m_u8Buf) - STAMP_SIZE;
+
+    // Write the receive and read times into the end of the packet buffer
+    static inline void StampPacket(UdpPacket& packet, uint64_t receiveNs, uint64_t readNs)
+    {
+        if (packet.m_i16Len < 0 || static_cast<size_t>(packet.m_i16Len) > STAMP_OFFSET) {
+            return;
+        }
+        uint64_t stamp[3] = {receiveNs, readNs, receiveNs ^ readNs ^ STAMP_CHECK};
+        memcpy(&packet.m_u8Buf[STAMP_OFFSET], stamp, sizeof(stamp));
+    }
+
+    // Read the times back, false if the packet was not stamped by 'readRawData'
+    static inline bool ReadStamp(const UdpPacket& packet, uint64_t& receiveNs, uint64_t& readNs)
+    {
+        if (packet.m_i16Len < 0 || static_cast<size_t>(packet.m_i16Len) > STAMP_OFFSET) {
+            return false;
+        }
+        uint64_t stamp[3];
+        memcpy(stamp, &packet.m_u8Buf[STAMP_OFFSET], sizeof(stamp));
+        receiveNs = stamp[0];
+        readNs    = stamp[1];
+        return (stamp[0] ^ stamp[1] ^ STAMP_CHECK) == stamp[2] && stamp[0] != 0 && stamp[0] <= stamp[1];
+    }
+
+    inline void recordStage(PacketStage stage, uint64_t fromNs, uint64_t toNs)
+    {
+        if (toNs >= fromNs) m_stage[stage].record(toNs - fromNs);
+    }
+
+    // One packet through 'parseDataBuffer', the frame time is recorded once the frame completes
+    inline void recordParse(uint64_t parseNs, uint32_t points, bool scanComplete)
+    {
+        AddRelaxed(m_parsed, 1);
+        AddRelaxed(m_points, points);
+        m_stage[STAGE_PARSE_PACKET].record(parseNs);
+        m_frameParseNs += parseNs;
+        if (scanComplete) {
+            AddRelaxed(m_frames, 1);
+            m_stage[STAGE_PARSE_FRAME].record(m_frameParseNs);
+            m_frameParseNs = 0;
+        }
+    }
+
+    inline void countReceived() { AddRelaxed(m_received, 1); }
+    inline void countPushed() { AddRelaxed(m_pushed, 1); }
+    inline void countDecodeError() { AddRelaxed(m_decodeError, 1); }
+    uint64_t frameNum() const { return m_frames.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Copy the counters and summarize the histograms, while they are recorded
+     *
+     * @param drops the drop counters kept by the plugin, copied into the snapshot
+     */
+    void snapshot(StageStatsSnapshot& out, const StageDrops& drops) const;
+
+    // Zero everything, e.g. at reset. Not synchronized with the recording threads
+    void reset();
+
+    // Print a snapshot on one line per stage
+    static void print(const char* name, const StageStatsSnapshot& snapshot);
+
+    static const char* StageName(PacketStage stage);
+
+private:
+    static const uint64_t STAMP_CHECK = 0x48534c5354414d50ULL;
+
+    std::atomic<uint64_t> m_received{0};
+    std::atomic<uint64_t> m_pushed{0};
+    std::atomic<uint64_t> m_parsed{0};
+    std::atomic<uint64_t> m_points{0};
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_decodeError{0};
+    // parse time of the current frame, only touched by the thread of 'parseDataBuffer'
+    uint64_t m_frameParseNs = 0;
+    LatencyHistogram m_stage[STAGE_NUM];
+};
+
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // STAGE_STATS_H
@@ -0,0 +1,169 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STATUS_POLLER_H
+#define STATUS_POLLER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "GeneralParser.h"
+#include "InputSocket.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+
+/**
+ * @brief Single writer value read without locks. The reader copies the value and retries if the
+ * sequence changed meanwhile, so it never blocks the writer and never sees a torn value
+ */
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+
+public:
+    void store(const T& value)
+    {
+        uint64_t words[WORD_NUM] = {0};
+        memcpy(words, &value, sizeof(T));
+        uint64_t seq = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORD_NUM; i++) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    T load() const
+    {
+        uint64_t words[WORD_NUM];
+        while (true) {
+            uint64_t seq = m_seq.load(std::memory_order_acquire);
+            if (seq & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t i = 0; i < WORD_NUM; i++) {
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_seq.load(std::memory_order_relaxed) == seq) {
+                break;
+            }
+        }
+        T value;
+        memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static const size_t WORD_NUM = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    std::atomic<uint64_t> m_seq{0};
+    std::atomic<uint64_t> m_words[WORD_NUM] = {};
+};
+
+// Status of the lidar from PTC and from the tail of a sampled point packet
+struct LidarStatusSnapshot
+{
+    // increased by each poll, 0 until the first one
+    uint64_t version;
+    // host time of the poll
+    dwTime_t hostTime;
+
+    // PTC_COMMAND_GET_LIDAR_STATUS, false if the last get failed
+    bool ptcValid;
+    uint32_t uptimeS;
+    uint16_t motorSpeedRpm;
+    // bottom board 1 and 2, laser board 1 and 2, receiver board 1 and 2, top board 1 and 2
+    float temperatureC[8];
+    uint8_t gpsPpsLock;
+    uint8_t gpsGprmcStatus;
+    uint8_t ptpClockStatus;
+    uint32_t startupTimes;
+    uint32_t totalOperationMin;
+
+    // false if no point packet came during the last interval
+    bool tailValid;
+    TailStatus tail;
+};
+
+/**
+ * @brief Poll the status of one lidar on a low priority thread, see param 'status_interval_ms'.
+ * The receive path hands over one point packet per interval, only when asked for, and the thread
+ * merges its tail status with the PTC status into a snapshot read without locks
+ */
+class StatusPoller
+{
+public:
+    StatusPoller(void* ptcClient, GeneralParser* parser, dwContextHandle_t ctx, int intervalMs);
+    ~StatusPoller();
+
+    // Receive side, copies the packet only if the thread asked for a sample
+    void offerPacket(const uint8_t* data, size_t len)
+    {
+        if (!m_sampleWanted.load(std::memory_order_acquire)) {
+            return;
+        }
+        m_sampleLen = std::min(len, sizeof(m_sample.m_u8Buf));
+        memcpy(m_sample.m_u8Buf, data, m_sampleLen);
+        m_sampleWanted.store(false, std::memory_order_relaxed);
+        m_sampleReady.store(true, std::memory_order_release);
+    }
+
+    LidarStatusSnapshot snapshot() const { return m_snapshot.load(); }
+
+private:
+    void run();
+    void poll(LidarStatusSnapshot& snapshot);
+
+    void* m_ptcClient;
+    GeneralParser* m_parser;
+    dwContextHandle_t m_ctx;
+    int m_intervalMs;
+
+    // packet handed over by 'offerPacket', owned by the receive side while 'm_sampleWanted' is set
+    UdpPacket m_sample;
+    size_t m_sampleLen = 0;
+    std::atomic<bool> m_sampleWanted{true};
+    std::atomic<bool> m_sampleReady{false};
+
+    SeqLock<LidarStatusSnapshot> m_snapshot;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_stop = false;
+    std::thread m_thread;
+};
+
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // STATUS_POLLER_H
@@ -69,8 +69,23 @@ typedef struct TC_Command_s {
   unsigned int ret_size;
 } TC_Command;
 
+// One reply of a pipelined get, the payload is read straight into 'buffer'
+typedef struct TcpCommandReply_s {
+  // in: command to send
+  unsigned char cmd;
+  // in: caller buffer of 'capacity' bytes, or NULL to malloc one of len + 1 bytes, freed by the caller
+  unsigned char* buffer;
+  unsigned int capacity;
+  // out: payload size, zero terminated if the buffer has room for it
+  unsigned int len;
+  unsigned char ret_code;
+  // out: PTC_ERROR_NO_MEMORY if the payload is larger than the caller buffer
+  PTC_ErrCode status;
+} TcpCommandReply;
+
 /**
- * @brief Create a new Tcp client
+ * @brief Create a new Tcp client. The connection is opened by the first command and kept,
+ * it is opened again once if a command fails on it
  * 
  * @param ip lidar tcp ip address
  * @param port lidar tcp port
@@ -106,6 +121,27 @@ PTC_ErrCode TcpCommandSetLidarReturnMode(const void* handle, uint8_t mode);
 PTC_ErrCode TcpCommandSetLidarSpinRate(const void* handle, uint16_t spinRate);
 PTC_ErrCode TcpCommandSet(const void* handle, PTC_COMMAND cmd, unsigned char* data, uint32_t len);
 PTC_ErrCode TcpCommandGet(const void* handle, PTC_COMMAND cmd, unsigned char** buffer, unsigned int* len);
+/**
+ * @brief Send several get commands back to back on the connection, then read the replies in order.
+ * Only one round trip for e.g. calibration, firetimes and config info at start up
+ *
+ * @param handle Tcp client, namely TcpCommandClient
+ * @param[in,out] replies command of each reply in, payload out
+ * @param num number of replies
+ * @return 0: all the replies are read, see the status of each one
+ */
+PTC_ErrCode TcpCommandGetPipelined(const void* handle, TcpCommandReply* replies, int num);
+
+/**
+ * @brief Get a reply into the caller buffer, no allocation
+ *
+ * @param[out] len payload size, larger than capacity with PTC_ERROR_NO_MEMORY
+ * @param[out] retCode return code of the lidar, may be NULL
+ */
+PTC_ErrCode TcpCommandGetInto(const void* handle, PTC_COMMAND cmd, unsigned char* buffer,
+                              unsigned int capacity, unsigned int* len, unsigned char* retCode);
+
+// Close the connection and free the client
 void TcpCommandClientDestroy(const void* handle);
 
 #ifdef __cplusplus
@@ -0,0 +1,59 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TRACE_PROBES_H
+#define TRACE_PROBES_H
+
+/**
+ * Static probes of provider 'hesai_lidar', compiled in by the cmake option HESAI_TRACE_PROBES. A probe is a
+ * nop and a note in the binary, so perf, bpftrace and systemtap attach to it on a production unit without a
+ * rebuild. Without the option the macros are empty and their arguments are not evaluated
+ *
+ *   read_raw_data   sensor, sequence, azimuth, bytes        packet handed out by 'readRawData'
+ *   return_raw_data sensor, sequence, azimuth, bytes        slot given back by driveworks
+ *   push_data       sensor, sequence, azimuth, bytes        packet queued by 'pushData'
+ *   parse_begin     sensor, sequence, azimuth, bytes        'parseData' takes the packet
+ *   parse_end       sensor, sequence, azimuth, points
+ *   frame_split     sensor, sequence, azimuth, frames       the packet completes a scan
+ *   calib_begin     sensor, reason                          0 start, 1 reload
+ *   calib_end       sensor, reason, source                  0 PTC or file, 1 cache
+ *
+ * Sensor is the creation order of the sensor in the process, azimuth the first block in 0.01 degree
+ */
+
+#ifdef HESAI_TRACE_PROBES
+#include <sys/sdt.h>
+
+#define HESAI_TRACE_ENABLED 1
+#define HESAI_TRACE2(name, a1, a2) DTRACE_PROBE2(hesai_lidar, name, a1, a2)
+#define HESAI_TRACE3(name, a1, a2, a3) DTRACE_PROBE3(hesai_lidar, name, a1, a2, a3)
+#define HESAI_TRACE4(name, a1, a2, a3, a4) DTRACE_PROBE4(hesai_lidar, name, a1, a2, a3, a4)
+#else
+#define HESAI_TRACE_ENABLED 0
+#define HESAI_TRACE2(name, a1, a2) do {} while (0)
+#define HESAI_TRACE3(name, a1, a2, a3) do {} while (0)
+#define HESAI_TRACE4(name, a1, a2, a3, a4) do {} while (0)
+#endif
+
+enum TraceCalibReason
+{
+    TRACE_CALIB_START  = 0,
+    TRACE_CALIB_RELOAD = 1,
+};
+
+#endif // TRACE_PROBES_H
@@ -0,0 +1,130 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef UDP_REACTOR_H
+#define UDP_REACTOR_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "InputSocket.h"
+
+// Packets received by the reactor for one sensor and not read yet, about 100 ms of a 128 line lidar
+#define UDP_CHANNEL_PACKET_NUM (2048)
+// Max packets of one recvmmsg call, the reactor moves to the next socket after it
+#define UDP_REACTOR_BATCH_NUM (32)
+
+/**
+ * @brief Packet queue of one sensor, filled by the reactor thread and read by the sensor thread.
+ * Single producer and single consumer, the consumer is only woken up when it waits
+ */
+class UdpChannel {
+public:
+    explicit UdpChannel(size_t capacity);
+
+    /**
+     * @brief Take the oldest packet
+     *
+     * The packet is copied once more, from the ring into the slot of 'readRawData'. The slots belong to
+     * driveworks until 'returnRawData', so the reactor can't receive into them ahead of the reads. The copy
+     * is the 'UdpChannel::Pop' case of parser_bench, below 100 ns a packet or under 1% of its decode
+     * @param[out] pkt copy of the packet, m_i16Len is the received size
+     * @param[in] timeout in ms, wait for a packet up to it
+     * @param[out] recvTime return the time the reactor received it, see 'StageClockNs', can be null
+     * @return false on timeout
+     */
+    bool Pop(UdpPacket *pkt, int timeout, uint64_t *recvTime = nullptr);
+
+    // Packets dropped as the queue was full
+    uint64_t GetDroppedNum() const { return m_u64Dropped.load(std::memory_order_relaxed); }
+
+    // Bytes of the ring, allocated at construction
+    size_t MemoryBytes() const { return m_vPackets.capacity() * sizeof(UdpPacket) + m_vRecvTimes.capacity() * sizeof(uint64_t); }
+    size_t ResidentBytes() const;
+
+private:
+    friend class UdpReactor;
+
+    // reactor side, free slots in ring order starting at the tail
+    size_t FreeNum() const;
+    size_t SlotIndex(size_t offset) const { return (m_u64Tail.load(std::memory_order_relaxed) + offset) % m_vPackets.size(); }
+    UdpPacket *Slot(size_t offset) { return &m_vPackets[SlotIndex(offset)]; }
+    void Commit(size_t num);
+
+    std::vector<UdpPacket> m_vPackets;
+    // receive time of each packet, one clock read per recvmmsg batch
+    std::vector<uint64_t> m_vRecvTimes;
+    std::atomic<uint64_t> m_u64Head{0};
+    std::atomic<uint64_t> m_u64Tail{0};
+    std::atomic<uint64_t> m_u64Dropped{0};
+    std::atomic<bool> m_bWaiting{false};
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+};
+
+/**
+ * @brief One epoll thread receiving the udp sockets of all the sensors in the process.
+ * Each ready socket is drained with recvmmsg straight into the queue of its sensor, so the
+ * cost grows with the packet rate and not with the number of sensors
+ */
+class UdpReactor {
+public:
+    static UdpReactor &Instance();
+
+    /**
+     * @brief Add a socket, its packets go to the channel. The thread starts with the first socket
+     *
+     * @return 0 on success
+     */
+    int Register(int fd, std::shared_ptr<UdpChannel> channel);
+
+    // Remove a socket, the channel is not written any more once it returns. The thread stops with the last one
+    void Unregister(int fd);
+
+private:
+    UdpReactor() = default;
+    ~UdpReactor();
+    UdpReactor(const UdpReactor &) = delete;
+    UdpReactor &operator=(const UdpReactor &) = delete;
+
+    void Start();
+    void Stop();
+    void Run();
+    void Receive(int fd, UdpChannel *channel);
+
+    // serializes Register and Unregister, so the thread is not started while it stops
+    std::mutex m_lifeMutex;
+    // guards the channels, held by the thread while it receives
+    std::mutex m_mutex;
+    std::map<int, std::shared_ptr<UdpChannel>> m_mapChannels;
+    std::thread m_thread;
+    int m_iEpollfd = -1;
+    // written to wake up the thread when it stops
+    int m_iEventfd = -1;
+    std::atomic<bool> m_bRunning{false};
+    // used when the channel is full, the socket is drained anyway
+    std::vector<UdpPacket> m_vDiscard;
+};
+
+#endif // UDP_REACTOR_H
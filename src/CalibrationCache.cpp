@@ -0,0 +1,153 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CalibrationCache.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+
+namespace
+{
+const char CACHE_MAGIC[4]    = {'H', 'S', 'C', 'C'};
+const uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t hash;
+    uint64_t size;
+};
+} // namespace
+
+CalibrationBlob::~CalibrationBlob()
+{
+    if (m_map != nullptr) {
+        munmap(m_map, m_mapLen);
+    }
+}
+
+CalibrationCache::CalibrationCache(const std::string& dir, const std::string& key)
+    : m_dir(dir)
+{
+    // the key ends up in a file name
+    for (char c : key) {
+        m_key += (isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '-') ? c : '_';
+    }
+    if (mkdir(m_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        printf("CalibrationCache: create folder %s Error, %s\n", m_dir.c_str(), strerror(errno));
+    }
+}
+
+bool CalibrationCache::Load(const std::string& name, CalibrationBlob& blob)
+{
+    std::string file = path(name);
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) <= sizeof(CacheHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t mapLen = st.st_size;
+    void* map = mmap(nullptr, mapLen, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    const CacheHeader* header = static_cast<const CacheHeader*>(map);
+    char* data = static_cast<char*>(map) + sizeof(CacheHeader);
+    bool valid = memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 && header->version == CACHE_VERSION &&
+                 header->size + 1 == mapLen - sizeof(CacheHeader) && data[header->size] == '\0' &&
+                 Hash(data, header->size) == header->hash;
+    if (!valid) {
+        printf("CalibrationCache: %s is corrupted, ignored\n", file.c_str());
+        munmap(map, mapLen);
+        return false;
+    }
+    if (blob.m_map != nullptr) {
+        munmap(blob.m_map, blob.m_mapLen);
+    }
+    blob.m_map    = map;
+    blob.m_mapLen = mapLen;
+    blob.m_data   = data;
+    blob.m_size   = header->size;
+    blob.m_hash   = header->hash;
+    return true;
+}
+
+bool CalibrationCache::Store(const std::string& name, const char* data, size_t size)
+{
+    std::string file = path(name);
+    std::string temp = file + ".tmp";
+    FILE* fp = fopen(temp.c_str(), "wb");
+    if (fp == nullptr) {
+        printf("CalibrationCache: write %s Error, %s\n", temp.c_str(), strerror(errno));
+        return false;
+    }
+    CacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.hash    = Hash(data, size);
+    header.size    = size;
+    const char end = '\0';
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 && fwrite(data, 1, size, fp) == size &&
+              fwrite(&end, 1, 1, fp) == 1;
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(temp.c_str(), file.c_str()) != 0) {
+        printf("CalibrationCache: write %s Error\n", file.c_str());
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+uint64_t CalibrationCache::Hash(const void* data, size_t size)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string CalibrationCache::path(const std::string& name) const
+{
+    return m_dir + "/" + m_key + "_" + name + ".cache";
+}
+
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
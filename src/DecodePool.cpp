@@ -0,0 +1,161 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include "DecodePool.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+
+DecodePool::DecodePool(GeneralParser* parser, uint32_t threadNum, uint32_t queueSize, size_t maxPoints)
+    : m_parser(parser)
+    , m_jobs(queueSize)
+{
+    for (DecodeJob& job : m_jobs) {
+        job.localTimestamp.resize(maxPoints);
+    }
+    for (uint32_t i = 0; i < threadNum; i++) {
+        m_threads.emplace_back(&DecodePool::workerLoop, this);
+    }
+}
+
+size_t DecodePool::memoryBytes() const
+{
+    size_t bytes = m_jobs.capacity() * sizeof(DecodeJob);
+    for (const DecodeJob& job : m_jobs) {
+        bytes += job.localTimestamp.capacity() * sizeof(dwTime_t);
+    }
+    return bytes;
+}
+
+size_t DecodePool::residentBytes() const
+{
+    size_t bytes = HugePageResidentBytes(m_jobs.data(), m_jobs.capacity() * sizeof(DecodeJob));
+    for (const DecodeJob& job : m_jobs) {
+        bytes += HugePageResidentBytes(job.localTimestamp.data(), job.localTimestamp.capacity() * sizeof(dwTime_t));
+    }
+    return bytes;
+}
+
+DecodePool::~DecodePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_workCond.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+bool DecodePool::submit(const UdpPacket& packet, dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI,
+                        const PointExtraOutput& extra)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_submitted - m_collected >= m_jobs.size()) {
+            return false;
+        }
+        // the job is free, no worker touches it until m_submitted is increased
+        DecodeJob& job = m_jobs[m_submitted % m_jobs.size()];
+        job.packet = packet;
+        job.pointXYZI = pointXYZI;
+        job.pointRTHI = pointRTHI;
+        job.extra = extra;
+        if (job.extra.pointTimestamp == nullptr) {
+            job.extra.pointTimestamp = job.localTimestamp.data();
+        }
+        job.done = false;
+        m_submitted++;
+    }
+    m_workCond.notify_one();
+    return true;
+}
+
+DecodeJob* DecodePool::collect()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_collected == m_submitted) {
+        return nullptr;
+    }
+    DecodeJob& job = m_jobs[m_collected % m_jobs.size()];
+    m_doneCond.wait(lock, [&job] { return job.done; });
+    return &job;
+}
+
+void DecodePool::release()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_collected < m_submitted) {
+        m_collected++;
+    }
+}
+
+void DecodePool::clear()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // the workers write into the jobs until they are done
+    m_doneCond.wait(lock, [this] {
+        for (uint64_t i = m_collected; i < m_submitted; i++) {
+            if (!m_jobs[i % m_jobs.size()].done) return false;
+        }
+        return true;
+    });
+    m_collected = m_submitted;
+}
+
+size_t DecodePool::pending()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_submitted - m_collected;
+}
+
+void DecodePool::workerLoop()
+{
+    while (true) {
+        DecodeJob* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workCond.wait(lock, [this] { return m_stop || m_dispatched < m_submitted; });
+            if (m_stop) {
+                return;
+            }
+            job = &m_jobs[m_dispatched % m_jobs.size()];
+            m_dispatched++;
+        }
+        job->info = PacketDecodeInfo();
+        job->status = m_parser->DecodePacket(&job->output, job->packet.m_u8Buf, job->packet.m_i16Len,
+                                             job->pointXYZI, job->pointRTHI, &job->extra, nullptr, job->info);
+        if (job->status != DW_SUCCESS) {
+            job->info.splitAzimuthNum = 0;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            job->done = true;
+        }
+        m_doneCond.notify_all();
+    }
+}
+
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
@@ -18,6 +18,8 @@
 
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <cmath>
 #include "HesaiLidar.h"
 #include "Udp4_3_Parser.h"
 #include "Udp3_2_Parser.h"
@@ -30,7 +32,31 @@ namespace plugins
 namespace lidar
 {
 
+#if HESAI_TRACE_ENABLED
+// Probe of one UdpPacket, its sequence number and azimuth are only read when the probes are compiled in
+#define TRACE_PACKET_VALUE(name, packet, value)                                                                \
+    do {                                                                                                       \
+        const UdpPacket* tracePacket = (packet);                                                               \
+        uint32_t traceSequence = 0;                                                                            \
+        uint16_t traceAzimuth = 0;                                                                             \
+        if (m_Parser != nullptr && tracePacket->m_i16Len > 0) {                                                \
+            m_Parser->ParsePacketId(tracePacket->m_u8Buf, tracePacket->m_i16Len, traceSequence, traceAzimuth); \
+        }                                                                                                      \
+        HESAI_TRACE4(name, m_sensorId, traceSequence, traceAzimuth, value);                                    \
+    } while (0)
+#else
+#define TRACE_PACKET_VALUE(name, packet, value) do {} while (0)
+#endif
+// Probe of one UdpPacket with its byte count
+#define TRACE_PACKET(name, packet) TRACE_PACKET_VALUE(name, packet, (packet)->m_i16Len)
+
+std::atomic<uint32_t> HesaiLidar::g_sensorNum{0};
+
 HesaiLidar::~HesaiLidar() {
+    waitBringUp();
+    m_statusPoller.reset();
+    // the workers use the parser
+    m_decodePool.reset();
     if (m_Parser != nullptr) {
         delete m_Parser;
         m_Parser = nullptr;
@@ -49,6 +75,13 @@ dwStatus HesaiLidar::createParser(std::string lidartype) {
         std::cout << "createParser, create specific parser Error, lidartype=" << lidartype << std::endl;
         return DW_CANNOT_CREATE_OBJECT;
     }
+    if (m_deskewFlag) {
+        m_Parser->SetDeskewMotion(m_deskewMotion);
+    }
+    if (m_rangeImageFlag) {
+        m_rangeImage[0].Allocate(m_Parser->GetRangeImageLayout());
+        m_rangeImage[1].Allocate(m_Parser->GetRangeImageLayout());
+    }
 
     return DW_SUCCESS;
 }
@@ -58,26 +91,116 @@ dwStatus HesaiLidar::createSensor(dwSALHandle_t sal, const char* params)
     m_sal               = sal;
     m_virtualSensorFlag = false;
     (void) params;
-    m_pTcpCommandClient = TcpCommandClientNew(m_ipAddress.c_str(), m_ptcPort);  
+    if (m_pcapPath.empty()) {
+        m_pTcpCommandClient = TcpCommandClientNew(m_ipAddress.c_str(), m_ptcPort);  
+    }
              
     return DW_SUCCESS;
 }
 
 dwStatus HesaiLidar::releaseSensor()
 {
+    // the bring up and status threads use the PTC client
+    waitBringUp();
+    m_statusPoller.reset();
     if (!isVirtualSensor()) {
         m_inputSocket.CloseSocket();
     }
+    if (m_pTcpCommandClient != nullptr) {
+        TcpCommandClientDestroy(m_pTcpCommandClient);
+        m_pTcpCommandClient = nullptr;
+    }
     return DW_SUCCESS;
 }
 
 dwStatus HesaiLidar::startSensor()
 {
+    // fault the buffers in now, not in the decode loop of the first frame
+    prepareMemory(m_numaNode);
+
     // std::cout << "HesaiLidar::startSensor, loading correction files" << std::endl;
     if (!isVirtualSensor()) {
-        m_inputSocket.InitSocket(m_ipAddress, m_hostIpAddress, m_multcastIpAddress, m_udpPort); 
+        // packets are buffered from now on, while the calibration is loaded
+        if (!m_pcapPath.empty()) {
+            if (!m_inputSocket.OpenPcap(m_pcapPath, m_udpPort, m_pcapSpeed, m_pcapLoop)) {
+                return DW_FILE_NOT_FOUND;
+            }
+        } else {
+            m_inputSocket.InitSocket(m_ipAddress, m_hostIpAddress, m_multcastIpAddress, m_udpPort); 
+            if (m_ioReactorFlag) {
+                m_inputSocket.AttachReactor();
+            }
+        }
+        if (m_statusIntervalMs > 0 && m_statusPoller == nullptr && m_pTcpCommandClient != nullptr) {
+            m_statusPoller.reset(new StatusPoller(m_pTcpCommandClient, m_Parser, m_ctx, m_statusIntervalMs));
+        }
     }
-    
+    if (m_calibrationReady.load()) {
+        // started again, the calibration is kept
+        return DW_SUCCESS;
+    }
+
+    std::lock_guard<std::mutex> lock(m_bringUpMutex);
+    if (m_bringUpThread.joinable()) {
+        return DW_SUCCESS;
+    }
+    if (!isVirtualSensor() && m_asyncStartFlag) {
+        m_bringUpStarted.store(true);
+        m_bringUpThread = std::thread(&HesaiLidar::bringUp, this);
+    } else {
+        bringUp();
+    }
+
+    return DW_SUCCESS;
+}
+
+void HesaiLidar::bringUp()
+{
+    auto start = std::chrono::steady_clock::now();
+    HESAI_TRACE2(calib_begin, m_sensorId, TRACE_CALIB_START);
+    bool cached = !isVirtualSensor() && loadCachedCalibration();
+    if (!cached) {
+        loadCalibration();
+    } else if (m_lidarType == LIDAR_TYPE_QT128 && loadChannelConfig() != DW_SUCCESS) {
+        // the channel config is not cached
+        std::cout << "startSensor: QT128 loadChannelConfig Error, try local file" << std::endl;
+        m_Parser->LoadChannelConfigFile(m_channelConfigPath);
+    }
+    HESAI_TRACE3(calib_end, m_sensorId, TRACE_CALIB_START, cached ? 1 : 0);
+
+    // the tables are loaded, the workers only read them from now on
+    if (m_decodeThreads > 1 && m_decodePool == nullptr) {
+        m_decodePool.reset(new DecodePool(m_Parser, m_decodeThreads, DECODE_QUEUE_SIZE, MAX_POINTS_PER_PACKET));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_readyMutex);
+        m_calibrationReady.store(true, std::memory_order_release);
+    }
+    m_readyCond.notify_all();
+    if (!isVirtualSensor()) {
+        printf("startSensor: calibration ready after %lld ms%s\n", static_cast<long long>(
+               std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()),
+               cached ? ", from the cache" : "");
+        printMemoryStats();
+    }
+    if (cached) {
+        // decode with the cached one meanwhile
+        revalidateCalibration();
+    }
+}
+
+void HesaiLidar::loadCalibration()
+{
+    if (!isVirtualSensor() && m_pTcpCommandClient != nullptr) {
+        std::vector<PTC_COMMAND> commands = {PTC_COMMAND_GET_LIDAR_CALIBRATION};
+        if (m_lidarType == LIDAR_TYPE_QT128) {
+            commands.push_back(PTC_COMMAND_GET_LIDAR_FIRETIMES);
+            commands.push_back(PTC_COMMAND_GET_LIDAR_CHANNEL_CONFIG);
+        }
+        prefetchPtc(commands);
+    }
+
     if (loadLidarCorrection() != DW_SUCCESS) {
         std::cout << "startSensor: first loading calibration Error, try local file" << std::endl;
         if (m_Parser->LoadCorrectionFile(m_correctionFilePath) != 0) {
@@ -86,17 +209,122 @@ dwStatus HesaiLidar::startSensor()
     }
 
     if (m_lidarType == LIDAR_TYPE_QT128) {
-        // TODO support channel config or firetime config
-        // if(loadChannelConfig() != DW_SUCCESS) {
-        //     std::cout << "startSensor: QT128 loadChannelConfig Error" << std::endl;
-        //     // return DW_FAILURE;
-        // }
-        // if(loadFiretimes() != DW_SUCCESS) {
-        //     std::cout << "startSensor: QT128 loadFiretimes Error" << std::endl;
-        //     // return DW_FAILURE;
-        // }
+        if (loadChannelConfig() != DW_SUCCESS) {
+            std::cout << "startSensor: QT128 loadChannelConfig Error, try local file" << std::endl;
+            m_Parser->LoadChannelConfigFile(m_channelConfigPath);
+        }
+        if (loadFiretimes() != DW_SUCCESS && !isVirtualSensor()) {
+            std::cout << "startSensor: QT128 loadFiretimes Error, try local file" << std::endl;
+            m_Parser->LoadFiretimesFile(m_firetimesPath);
+        }
+    } else if (m_lidarType == LIDAR_TYPE_P128 && m_firetimesFileFlag) {
+        m_Parser->LoadFiretimesFile(m_firetimesPath);
+        if (!m_Parser->m_bGetFiretimes) {
+            std::cout << "startSensor: Pandar128 firetimes file Error, points are timed by block" << std::endl;
+        }
+    }
+    // replies not asked for, e.g. firetimes of a lidar without them
+    prefetchPtc({});
+}
+
+void HesaiLidar::waitBringUp()
+{
+    std::lock_guard<std::mutex> lock(m_bringUpMutex);
+    if (m_bringUpThread.joinable()) {
+        m_bringUpThread.join();
+    }
+}
+
+void HesaiLidar::waitCalibrationReady()
+{
+    std::unique_lock<std::mutex> lock(m_readyMutex);
+    m_readyCond.wait(lock, [this] { return m_calibrationReady.load() || !m_bringUpStarted.load(); });
+}
+
+bool HesaiLidar::loadCachedCalibration()
+{
+    if (m_calibCache == nullptr) {
+        return false;
+    }
+    CalibrationBlob correction;
+    CalibrationBlob firetimes;
+    bool needFiretimes = m_lidarType == LIDAR_TYPE_QT128;
+    if (!m_calibCache->Load("correction", correction) ||
+        (needFiretimes && !m_calibCache->Load("firetimes", firetimes))) {
+        return false;
+    }
+    if (m_Parser->ParseCorrectionString(correction.data()) != 0) {
+        printf("loadCachedCalibration: cached correction parsing Error\n");
+        return false;
+    }
+    m_correctionHash = correction.hash();
+    if (needFiretimes) {
+        if (m_Parser->LoadFiretimesString(firetimes.data()) != 0) {
+            printf("loadCachedCalibration: cached firetimes parsing Error\n");
+            return false;
+        }
+        m_firetimesHash = firetimes.hash();
+    } else if (m_lidarType == LIDAR_TYPE_P128 && m_firetimesFileFlag) {
+        m_Parser->LoadFiretimesFile(m_firetimesPath);
+    }
+    return true;
+}
+
+void HesaiLidar::revalidateCalibration()
+{
+    if (m_pTcpCommandClient == nullptr) {
+        return;
+    }
+    bool needFiretimes = m_lidarType == LIDAR_TYPE_QT128;
+    std::vector<PTC_COMMAND> commands = {PTC_COMMAND_GET_LIDAR_CALIBRATION};
+    if (needFiretimes) {
+        commands.push_back(PTC_COMMAND_GET_LIDAR_FIRETIMES);
+    }
+    prefetchPtc(commands);
+
+    std::string correction;
+    std::string firetimes;
+    for (PTC_COMMAND command : commands) {
+        unsigned char* buffer = NULL;
+        unsigned int len = 0;
+        if (ptcGet(command, &buffer, &len) == PTC_ERROR_NO_ERROR && buffer != NULL && len > 1) {
+            // len counts the terminating zero
+            uint64_t hash = CalibrationCache::Hash(buffer, len - 1);
+            bool isCorrection = command == PTC_COMMAND_GET_LIDAR_CALIBRATION;
+            if (hash != (isCorrection ? m_correctionHash : m_firetimesHash)) {
+                const char* name = isCorrection ? "correction" : "firetimes";
+                m_calibCache->Store(name, reinterpret_cast<char*>(buffer), len - 1);
+                (isCorrection ? correction : firetimes).assign(reinterpret_cast<char*>(buffer), len - 1);
+                (isCorrection ? m_correctionHash : m_firetimesHash) = hash;
+                printf("revalidateCalibration: %s changed on the lidar, cache updated\n", name);
+            }
+        } else {
+            printf("revalidateCalibration: PTC get Error, keep the cached calibration\n");
+        }
+        free(buffer);
     }
+    prefetchPtc({});
 
+    // the decoders switch to the new tables at their next packet
+    if (!correction.empty() && m_Parser->ParseCorrectionString(&correction[0]) != 0) {
+        printf("revalidateCalibration: correction parsing Error\n");
+    }
+    if (!firetimes.empty() && m_Parser->LoadFiretimesString(firetimes.c_str()) != 0) {
+        printf("revalidateCalibration: firetimes parsing Error\n");
+    }
+}
+
+dwStatus HesaiLidar::reloadCalibration()
+{
+    if (!m_calibrationReady.load(std::memory_order_acquire)) {
+        return DW_NOT_READY;
+    }
+    // the bring up thread may still revalidate the cached calibration
+    waitBringUp();
+    std::lock_guard<std::mutex> lock(m_reloadMutex);
+    HESAI_TRACE2(calib_begin, m_sensorId, TRACE_CALIB_RELOAD);
+    loadCalibration();
+    HESAI_TRACE3(calib_end, m_sensorId, TRACE_CALIB_RELOAD, 0);
     return DW_SUCCESS;
 }
 
@@ -110,7 +338,11 @@ dwStatus HesaiLidar::stopSensor()
 
 dwStatus HesaiLidar::resetSensor()
 {
+    if (m_calibrationReady.load() && m_decodePool != nullptr) {
+        m_decodePool->clear();
+    }
     m_buffer.clear();
+    noteQueueDepth();
     resetSlot();
 
     return DW_SUCCESS;
@@ -120,27 +352,57 @@ dwStatus HesaiLidar::readRawData(const uint8_t** data, size_t* size, dwTime_t* t
 {
     if (!isVirtualSensor()) {
         rawPacket* result = nullptr;
-        bool ok           = m_slot->get(result);
-        if (!ok)
+        if (!acquireSlot(result))
         {
-            std::cerr << "readRawData: Read raw data, slot not empty\n";
-            return DW_BUFFER_FULL;
+            return DW_TIME_OUT;
         }
         UdpPacket* packet = reinterpret_cast<UdpPacket*>(&(result->rawData[PACKET_OFFSET]));
         while (1)
         {
             PacketType type = m_inputSocket.GetPacket(packet, timeout_us / 1000);
             if (type ==  POINTCLOUD_PACKET) break;
-            if (type ==  TIMEOUT) return DW_TIME_OUT;
-            usleep(10);
+            if (type ==  TIMEOUT) {
+                // not handed out, the slot is free again
+                m_slot->put(result);
+                return DW_TIME_OUT;
+            }
+            if (type == PCAP_END_PACKET) {
+                m_slot->put(result);
+                return DW_END_OF_STREAM;
+            }
+            dwTime_t now = 0;
+            dwContext_getCurrentTime(&now, m_ctx);
+            // copied aside and the slot is filled again at once
+            if (!m_sideChannels.route(type, packet->m_u8Buf, now)) {
+                usleep(10);
+            }
+        }
+        if (m_statusPoller != nullptr && packet->m_i16Len > 0) {
+            // the bytes past the length are left from a former packet of the slot
+            m_statusPoller->offerPacket(packet->m_u8Buf, static_cast<size_t>(packet->m_i16Len));
         }
+        uint64_t readNs = StageClockNs();
+        m_stageStats.countReceived();
+        m_stageStats.recordStage(STAGE_RECEIVE_TO_READ, m_inputSocket.GetRecvTime(), readNs);
+        // carried to 'pushData' and 'parseData' by the packet, driveworks copies the whole slot
+        StageStats::StampPacket(*packet, m_inputSocket.GetRecvTime(), readNs);
         dwContext_getCurrentTime(timestamp, m_ctx);
+        m_deliveredNum++;
+        m_rateWindowNum++;
+        if (*timestamp - m_rateWindowStart >= 1000000) {
+            if (m_rateWindowStart != 0) {
+                m_packetRate.store(m_rateWindowNum * 1e6f / (*timestamp - m_rateWindowStart));
+            }
+            m_rateWindowStart = *timestamp;
+            m_rateWindowNum = 0;
+        }
         uint32_t rawDataSize = sizeof(UdpPacket);
         memcpy(&result->rawData[0], &rawDataSize, sizeof(uint32_t));
         memcpy(&result->rawData[sizeof(uint32_t)], timestamp, sizeof(dwTime_t));
 
         *data = &(result->rawData[0]);
         *size = RAW_PACKET_SIZE - 12;
+        TRACE_PACKET(read_raw_data, packet);
         return DW_SUCCESS;
     }
 
@@ -154,6 +416,9 @@ dwStatus HesaiLidar::returnRawData(const uint8_t* data)
         return DW_INVALID_HANDLE;
     }
 
+    TRACE_PACKET(return_raw_data, reinterpret_cast<const UdpPacket*>(data + PACKET_OFFSET));
+    dwTime_t handedOut = 0;
+    memcpy(&handedOut, data + sizeof(uint32_t), sizeof(dwTime_t));
     bool ok = m_slot->put(const_cast<rawPacket*>(m_map[const_cast<uint8_t*>(data)]));
     if (!ok)
     {
@@ -161,6 +426,11 @@ dwStatus HesaiLidar::returnRawData(const uint8_t* data)
                   << std::endl;
         return DW_INVALID_ARGUMENT;
     }
+    dwTime_t now = 0;
+    if (!isVirtualSensor() && dwContext_getCurrentTime(&now, m_ctx) == DW_SUCCESS && now >= handedOut) {
+        m_slotHoldUs += now - handedOut;
+        m_slotHoldNum++;
+    }
 
     data = nullptr;
 
@@ -173,14 +443,99 @@ dwStatus HesaiLidar::pushData(const uint8_t* data, const size_t size, size_t* le
     {
         return DW_INVALID_HANDLE;
     }
+    if (!m_calibrationReady.load(std::memory_order_acquire)) {
+        m_earlyPacketNum++;
+        if (m_buffer.size() >= EARLY_PACKET_LIMIT) {
+            // keep the oldest ones, they are decoded first once the calibration is ready
+            m_earlyDroppedNum++;
+            *lenPushed = size;
+            return DW_SUCCESS;
+        }
+    }
+    if (size >= sizeof(UdpPacket)) {
+        TRACE_PACKET(push_data, reinterpret_cast<const UdpPacket*>(data));
+    }
     m_buffer.enqueue(data, size);
+    noteQueueDepth();
     *lenPushed = size;
+    m_stageStats.countPushed();
+    uint64_t receiveNs = 0;
+    uint64_t readNs = 0;
+    if (!isVirtualSensor() && size >= sizeof(UdpPacket) &&
+        StageStats::ReadStamp(*reinterpret_cast<const UdpPacket*>(data), receiveNs, readNs)) {
+        m_stageStats.recordStage(STAGE_READ_TO_PUSH, readNs, StageClockNs());
+    }
+    if (m_decodePool != nullptr && m_calibrationReady.load(std::memory_order_acquire)) {
+        submitPackets();
+    }
 
     return DW_SUCCESS;
 }
 
 dwStatus HesaiLidar::parseData(dwLidarDecodedPacket* output, const uint64_t hostTimeStamp)
 {
+    if (!m_calibrationReady.load(std::memory_order_acquire)) {
+        // the packets stay in the buffer until the calibration is installed
+        return DW_FAILURE;
+    }
+    if (!m_earlyReported) {
+        m_earlyReported = true;
+        if (m_earlyPacketNum.load() > 0) {
+            printf("parseData: %llu packets received before the calibration, %llu of them dropped\n",
+                   static_cast<unsigned long long>(m_earlyPacketNum.load()),
+                   static_cast<unsigned long long>(m_earlyDroppedNum.load()));
+        }
+    }
+    uint64_t parseStart = StageClockNs();
+    uint64_t receiveNs = 0;
+    uint64_t readNs = 0;
+    if (m_decodePool != nullptr) {
+        if (output == nullptr)
+        {
+            return DW_INVALID_HANDLE;
+        }
+        if (m_numaNode == -2) {
+            // the workers write the points, bind them to the node of the thread handing them out
+            prepareMemory(HugePageCurrentNode());
+        }
+        DecodeJob* job = m_decodePool->collect();
+        if (job == nullptr) {
+            // the pool was full when the packets were pushed
+            submitPackets();
+            job = m_decodePool->collect();
+        }
+        if (job == nullptr) {
+            return DW_FAILURE;
+        }
+        TRACE_PACKET(parse_begin, &job->packet);
+        *output = job->output;
+        if (job->status == DW_SUCCESS) {
+            // points are decoded without motion, deskew them in packet order as the reference is the scan start.
+            // without point_time=1 the job has timed the points in its own buffer, see DecodePool::submit
+            m_Parser->DeskewPoints(job->pointXYZI, job->extra.pointTimestamp, output->nPoints,
+                                   output->sensorTimestamp, job->extra.compactPoint);
+        }
+        m_Parser->SequencePacket(output, job->info);
+        if (job->status != DW_SUCCESS) {
+            m_stageStats.countDecodeError();
+        }
+        TRACE_PACKET_VALUE(parse_end, &job->packet, output->nPoints);
+        if (output->scanComplete) {
+            TRACE_PACKET_VALUE(frame_split, &job->packet, m_stageStats.frameNum() + 1);
+        }
+        bool stamped = !isVirtualSensor() && StageStats::ReadStamp(job->packet, receiveNs, readNs);
+        m_decodePool->release();
+        submitPackets();
+        output->hostTimestamp = hostTimeStamp;
+        uint64_t parseEnd = StageClockNs();
+        m_stageStats.recordParse(parseEnd - parseStart, output->nPoints, output->scanComplete);
+        if (stamped) {
+            m_stageStats.recordStage(STAGE_RECEIVE_TO_PARSED, receiveNs, parseEnd);
+        }
+        reportStageStats(parseEnd);
+        return DW_SUCCESS;
+    }
+
     const UdpPacket* msg;
     // Peek the first packet from the buffer queue
     if (!m_buffer.peek(reinterpret_cast<const uint8_t**>(&msg)))
@@ -192,13 +547,53 @@ dwStatus HesaiLidar::parseData(dwLidarDecodedPacket* output, const uint64_t host
     {
         return DW_INVALID_HANDLE;
     }
+    if (m_numaNode == -2) {
+        // now the decode thread is known
+        prepareMemory(HugePageCurrentNode());
+    }
+    TRACE_PACKET(parse_begin, msg);
     count++;
-    m_Parser->ParserOnePacket(output, msg->m_u8Buf, msg->m_i16Len, m_pointXYZI[count], m_pointRTHI[count]);
+    PointExtraOutput extra;
+    if (!m_pointTimestamp.empty()) {
+        extra.pointTimestamp = &m_pointTimestamp[count * MAX_POINTS_PER_PACKET];
+    }
+    if (m_rangeImageFlag) {
+        extra.rangeImage = &m_rangeImage[m_rangeImageWrite];
+    }
+    if (!m_compactPoint.empty()) {
+        extra.compactPoint = &m_compactPoint[count * MAX_POINTS_PER_PACKET];
+    }
+    dwStatus status = m_Parser->ParserOnePacket(output, msg->m_u8Buf, msg->m_i16Len,
+                                                &m_pointXYZI[count * MAX_POINTS_PER_PACKET],
+                                                &m_pointRTHI[count * MAX_POINTS_PER_PACKET], &extra);
+    if (status != DW_SUCCESS) {
+        m_stageStats.countDecodeError();
+    }
+    TRACE_PACKET_VALUE(parse_end, msg, output->nPoints);
+    if (output->scanComplete) {
+        TRACE_PACKET_VALUE(frame_split, msg, m_stageStats.frameNum() + 1);
+    }
+    if (m_rangeImageFlag && output->scanComplete) {
+        // publish the completed scan, then reuse the former one for the next scan
+        m_rangeImage[m_rangeImageWrite].frameId++;
+        m_rangeImageReady.store(m_rangeImageWrite);
+        m_rangeImageWrite = 1 - m_rangeImageWrite;
+        m_rangeImage[m_rangeImageWrite].frameId = m_rangeImage[1 - m_rangeImageWrite].frameId;
+        m_rangeImage[m_rangeImageWrite].Clear();
+    }
     dwContext_getCurrentTime(&output->hostTimestamp, m_ctx);
+    bool stamped = !isVirtualSensor() && StageStats::ReadStamp(*msg, receiveNs, readNs);
     m_buffer.dequeue();
+    noteQueueDepth();
     
     output->hostTimestamp = hostTimeStamp;
     if (count > 20000) count = 0;
+    uint64_t parseEnd = StageClockNs();
+    m_stageStats.recordParse(parseEnd - parseStart, output->nPoints, output->scanComplete);
+    if (stamped) {
+        m_stageStats.recordStage(STAGE_RECEIVE_TO_PARSED, receiveNs, parseEnd);
+    }
+    reportStageStats(parseEnd);
     // m_Parser->PrintDwPoint(&output->pointsXYZI[0]);
 
     return DW_SUCCESS;
@@ -217,13 +612,18 @@ dwStatus HesaiLidar::loadLidarCorrection()
         }
         unsigned char *buffer = NULL;
         unsigned int len = 0;
-        PTC_ErrCode status = TcpCommandGetLidarCalibration(m_pTcpCommandClient, &buffer, &len);
+        PTC_ErrCode status = ptcGet(PTC_COMMAND_GET_LIDAR_CALIBRATION, &buffer, &len);
         if (status != PTC_ERROR_NO_ERROR || buffer == NULL) {
+            free(buffer);
             printf("loadLidarCorrection: Get calibration file Error,check ptc connection\n");
             return DW_SAL_CANNOT_INITIALIZE;
         }
         
         int ret = m_Parser->ParseCorrectionString((char*)buffer);
+        if (ret == 0 && m_calibCache != nullptr && len > 1) {
+            m_correctionHash = CalibrationCache::Hash(buffer, len - 1);
+            m_calibCache->Store("correction", (char*)buffer, len - 1);
+        }
         free(buffer);
         if(ret != 0) {
             printf("loadLidarCorrection: correction file from PTC parsing Error \n");
@@ -238,15 +638,22 @@ dwStatus HesaiLidar::loadChannelConfig() {
     if (isVirtualSensor() == true) {
         m_Parser->LoadChannelConfigFile(m_channelConfigPath);
     } else {
+        if (m_pTcpCommandClient == NULL) {
+            printf("loadChannelConfig: m_pTcpCommandClient is Null\n");
+            return DW_CANNOT_CREATE_OBJECT;
+        }
         unsigned char* buffer = NULL;
         unsigned int len = 0;
-        PTC_ErrCode status = TcpCommandGet(m_pTcpCommandClient, PTC_COMMAND_GET_LIDAR_CHANNEL_CONFIG, &buffer, &len);
+        PTC_ErrCode status = ptcGet(PTC_COMMAND_GET_LIDAR_CHANNEL_CONFIG, &buffer, &len);
         if (status != PTC_ERROR_NO_ERROR) {
-            printf("loadChannelConfig: Parse Lidar Correction Error,check ptc connection\n");
+            printf("loadChannelConfig: Get channel config Error,check ptc connection\n");
+            free(buffer);
             return DW_CANNOT_CREATE_OBJECT;
         } else {
-            if (m_Parser->LoadChannelConfigString((char*) buffer) != 0) {
-                printf("loadChannelConfig: Parse channel config Error,check ptc connection\n");
+            int ret = m_Parser->LoadChannelConfigString((char*) buffer);
+            free(buffer);
+            if (ret != 0) {
+                printf("loadChannelConfig: Parse channel config Error\n");
                 return DW_CANNOT_CREATE_OBJECT;
             }
         }
@@ -261,12 +668,19 @@ dwStatus HesaiLidar::loadFiretimes() {
     } else {
         unsigned char* buffer = NULL;
         unsigned int len = 0;
-        PTC_ErrCode status = TcpCommandGet(m_pTcpCommandClient, PTC_COMMAND_GET_LIDAR_FIRETIMES, &buffer, &len);
+        PTC_ErrCode status = ptcGet(PTC_COMMAND_GET_LIDAR_FIRETIMES, &buffer, &len);
         if (status != PTC_ERROR_NO_ERROR) {
             printf("loadFiretimes: Load FireTimes from lidar Error,check ptc connection\n");
+            free(buffer);
             return DW_CANNOT_CREATE_OBJECT;
         } else {
-            if (m_Parser->LoadFiretimesString((char*) buffer) != 0) {
+            int ret = m_Parser->LoadFiretimesString((char*) buffer);
+            if (ret == 0 && m_calibCache != nullptr && len > 1) {
+                m_firetimesHash = CalibrationCache::Hash(buffer, len - 1);
+                m_calibCache->Store("firetimes", (char*)buffer, len - 1);
+            }
+            free(buffer);
+            if (ret != 0) {
                 printf("loadFiretimes: Parse firetimes file Error\n");
                 return DW_CANNOT_CREATE_OBJECT;
             }
@@ -276,7 +690,188 @@ dwStatus HesaiLidar::loadFiretimes() {
     return DW_SUCCESS;
 }
 
+dwStatus HesaiLidar::setEgoMotion(const DeskewMotion& motion) {
+    m_Parser->SetDeskewMotion(motion);
+    return DW_SUCCESS;
+}
+
+dwStatus HesaiLidar::getOverloadStats(OverloadStats* stats) {
+    if (stats == nullptr) {
+        return DW_INVALID_ARGUMENT;
+    }
+    uint64_t holdNum = m_slotHoldNum.load();
+    stats->deliveredPackets = m_deliveredNum.load();
+    stats->slotMisses = m_slotMissNum.load();
+    stats->droppedOldest = m_droppedOldestNum.load();
+    stats->droppedQueueFull = m_inputSocket.GetDroppedNum();
+    stats->packetRate = m_packetRate.load();
+    stats->slotHoldMs = holdNum > 0 ? m_slotHoldUs.load() / 1000.0f / holdNum : 0;
+    stats->slotCount = static_cast<uint32_t>(m_slotSize);
+    // Little's law, slots in use = packet rate * hold time
+    stats->suggestedSlotCount = std::max(static_cast<uint32_t>(std::ceil(
+        2 * stats->packetRate * stats->slotHoldMs / 1000)), 2u);
+    return DW_SUCCESS;
+}
+
+dwStatus HesaiLidar::getStageStats(StageStatsSnapshot* stats) {
+    if (stats == nullptr) {
+        return DW_INVALID_ARGUMENT;
+    }
+    StageDrops drops;
+    drops.slotMiss = m_slotMissNum.load();
+    drops.dropOldest = m_droppedOldestNum.load();
+    drops.queueFull = m_inputSocket.GetDroppedNum();
+    drops.early = m_earlyDroppedNum.load();
+    m_stageStats.snapshot(*stats, drops);
+    return DW_SUCCESS;
+}
+
+dwStatus HesaiLidar::getMemoryStats(MemoryStats* stats) {
+    if (stats == nullptr) {
+        return DW_INVALID_ARGUMENT;
+    }
+    MemoryUsage& usage = stats->usage;
+    usage = MemoryUsage();
+    usage.Add("sensor object", sizeof(HesaiLidar), 0, sizeof(HesaiLidar));
+    usage.Add("point buffers",
+              m_pointXYZI.bytes() + m_pointRTHI.bytes() + m_pointTimestamp.bytes() + m_compactPoint.bytes(), 0,
+              m_pointXYZI.ResidentBytes() + m_pointRTHI.ResidentBytes() + m_pointTimestamp.ResidentBytes() +
+                  m_compactPoint.ResidentBytes());
+    if (m_rangeImageFlag) {
+        usage.Add("range image", m_rangeImage[0].Bytes() + m_rangeImage[1].Bytes(), 0,
+                  m_rangeImage[0].ResidentBytes() + m_rangeImage[1].ResidentBytes());
+    }
+    // the slots are zeroed when created, the map holds one node per slot
+    size_t slotBytes = m_slotSize * (sizeof(rawPacket) + 2 * sizeof(rawPacket*));
+    size_t mapBytes = m_slotSize * (sizeof(std::pair<uint8_t* const, rawPacket*>) + 2 * sizeof(void*));
+    usage.Add("raw slots", slotBytes + mapBytes, 0, slotBytes + mapBytes);
+    // the queue keeps its peak size, the pages of the peak depth have been written
+    size_t queueBytes = m_queueBytes.load(std::memory_order_relaxed);
+    uint64_t queuePeak = m_queuePeak.load(std::memory_order_relaxed);
+    usage.Add("raw queue", 0, queueBytes, std::min<size_t>(queueBytes, queuePeak * sizeof(UdpPacket)));
+    if (!isVirtualSensor()) {
+        usage.Add("udp receive", 0, m_inputSocket.GetBufferBytes(), m_inputSocket.GetBufferResidentBytes());
+    }
+    usage.Add("side channels", m_sideChannels.memoryBytes(), 0, m_sideChannels.residentBytes());
+    if (m_statusPoller != nullptr) {
+        usage.Add("status poller", sizeof(StatusPoller), 0, sizeof(StatusPoller));
+    }
+    // created by the bring up, before the calibration is ready
+    if (m_calibrationReady.load(std::memory_order_acquire)) {
+        if (m_decodePool != nullptr) {
+            usage.Add("decode pool", m_decodePool->memoryBytes(), 0, m_decodePool->residentBytes());
+        }
+        if (m_Parser != nullptr) {
+            m_Parser->GetMemoryUsage(usage);
+        }
+    }
+    stats->queuedPackets = m_queueDepth.load(std::memory_order_relaxed);
+    stats->peakQueuedPackets = queuePeak;
+    return DW_SUCCESS;
+}
+
+void HesaiLidar::printMemoryStats() {
+    MemoryStats stats;
+    getMemoryStats(&stats);
+    const MemoryUsage& usage = stats.usage;
+    printf("startSensor: memory of %s %s, static %.1f MB, dynamic %.1f MB, resident %.1f MB\n", m_lidarType.c_str(),
+           isVirtualSensor() ? "virtual" : m_ipAddress.c_str(), usage.StaticBytes() / 1048576.0,
+           usage.DynamicBytes() / 1048576.0, usage.ResidentBytes() / 1048576.0);
+    for (int i = 0; i < usage.componentNum; i++) {
+        const MemoryComponent& component = usage.components[i];
+        printf("  %-16s static %10zu dynamic %10zu resident %10zu\n", component.name, component.staticBytes,
+               component.dynamicBytes, component.residentBytes);
+    }
+    printf("  raw queue depth %llu, peak %llu\n", static_cast<unsigned long long>(stats.queuedPackets),
+           static_cast<unsigned long long>(stats.peakQueuedPackets));
+}
+
+dwStatus HesaiLidar::getGpsStatus(GpsStatus* status) {
+    if (status == nullptr) {
+        return DW_INVALID_ARGUMENT;
+    }
+    m_sideChannels.getGpsStatus(status);
+    return DW_SUCCESS;
+}
+
+dwStatus HesaiLidar::getHealth(HealthStatus* status) {
+    if (status == nullptr) {
+        return DW_INVALID_ARGUMENT;
+    }
+    m_sideChannels.getHealth(status);
+    return DW_SUCCESS;
+}
+
+dwStatus HesaiLidar::readLogReport(SidePacket* packet) {
+    if (packet == nullptr) {
+        return DW_INVALID_ARGUMENT;
+    }
+    return m_sideChannels.popLogReport(*packet) ? DW_SUCCESS : DW_NOT_AVAILABLE;
+}
+
+dwStatus HesaiLidar::getLidarStatus(LidarStatusSnapshot* status) {
+    if (status == nullptr) {
+        return DW_INVALID_ARGUMENT;
+    }
+    if (m_statusPoller == nullptr) {
+        return DW_NOT_AVAILABLE;
+    }
+    *status = m_statusPoller->snapshot();
+    return DW_SUCCESS;
+}
+
+dwStatus HesaiLidar::getPointTimestamps(const dwLidarPointXYZI* points, const dwTime_t** timestamps) {
+    if (points == nullptr || timestamps == nullptr) {
+        return DW_INVALID_ARGUMENT;
+    }
+    if (m_pointTimestamp.empty()) {
+        printf("getPointTimestamps: per-point time is disabled, set param point_time=1\n");
+        return DW_NOT_AVAILABLE;
+    }
+    ptrdiff_t offset = getPointOffset(points);
+    if (offset < 0) {
+        return DW_INVALID_ARGUMENT;
+    }
+    *timestamps = &m_pointTimestamp[offset];
+    return DW_SUCCESS;
+}
+
+dwStatus HesaiLidar::getCompactPoints(const dwLidarPointXYZI* points, const CompactPoint** compactPoints) {
+    if (points == nullptr || compactPoints == nullptr) {
+        return DW_INVALID_ARGUMENT;
+    }
+    if (m_compactPoint.empty()) {
+        printf("getCompactPoints: compact point is disabled, set param compact_point=1\n");
+        return DW_NOT_AVAILABLE;
+    }
+    ptrdiff_t offset = getPointOffset(points);
+    if (offset < 0) {
+        return DW_INVALID_ARGUMENT;
+    }
+    *compactPoints = &m_compactPoint[offset];
+    return DW_SUCCESS;
+}
+
+dwStatus HesaiLidar::getRangeImage(const RangeImage** image) {
+    if (image == nullptr) {
+        return DW_INVALID_ARGUMENT;
+    }
+    if (!m_rangeImageFlag) {
+        printf("getRangeImage: range image is disabled, set param output_mode=range_image\n");
+        return DW_NOT_AVAILABLE;
+    }
+    int ready = m_rangeImageReady.load();
+    if (ready < 0) {
+        *image = nullptr;
+        return DW_NOT_READY;
+    }
+    *image = &m_rangeImage[ready];
+    return DW_SUCCESS;
+}
+
 dwStatus HesaiLidar::getDecoderConstants(_dwSensorLidarDecoder_constants* constants) {
+    // the vertical angles come from the calibration
+    waitCalibrationReady();
     // ! Must assign deviceString to be CUSTOM_EX, or A black screen Error might occur
     memcpy(&constants->properties.deviceString, m_deviceStr.c_str(), 256);
     m_Parser->GetDecoderConstants(constants);
@@ -297,7 +892,7 @@ void HesaiLidar::resetSlot()
 
     std::vector<rawPacket*> vectorOfRawPacketPtr;
     std::vector<uint8_t*> vectorOfRawDataPtr;
-    for (uint8_t i = 0; i < m_slotSize; ++i)
+    for (size_t i = 0; i < m_slotSize; ++i)
     {
         rawPacket* rawPacketPtr = nullptr;
         bool ok                 = m_slot->get(rawPacketPtr);
@@ -311,7 +906,7 @@ void HesaiLidar::resetSlot()
         vectorOfRawDataPtr.push_back(rawDataPtr);
     }
 
-    for (uint8_t i = 0; i < m_slotSize; ++i)
+    for (size_t i = 0; i < m_slotSize; ++i)
     {
         rawPacket* rawPacketPtr = vectorOfRawPacketPtr[i];
         uint8_t* rawDataPtr     = vectorOfRawDataPtr[i];
@@ -324,6 +919,133 @@ void HesaiLidar::resetSlot()
     }
 }
 
+bool HesaiLidar::acquireSlot(rawPacket*& result)
+{
+    // BufferPool waits without limit for 0
+    int timeout_us = m_overloadPolicy == OverloadPolicy::BLOCK ? m_slotDeadlineMs * 1000 : 1;
+    if (m_slot->get(result, timeout_us)) {
+        return true;
+    }
+    m_slotMissNum++;
+    if (m_overloadPolicy == OverloadPolicy::DROP_OLDEST) {
+        m_droppedOldestNum += m_inputSocket.DiscardPackets();
+    }
+    dwTime_t now = 0;
+    dwContext_getCurrentTime(&now, m_ctx);
+    reportOverload(now);
+    return false;
+}
+
+void HesaiLidar::reportOverload(dwTime_t now)
+{
+    if (now - m_overloadReported < 1000000) {
+        return;
+    }
+    m_overloadReported = now;
+    OverloadStats stats;
+    getOverloadStats(&stats);
+    printf("readRawData: all %u slots held, %llu misses, %llu oldest and %llu queue full drops, "
+           "%.0f packets/s held %.2f ms, slot_count=%u suggested\n",
+           stats.slotCount, static_cast<unsigned long long>(stats.slotMisses),
+           static_cast<unsigned long long>(stats.droppedOldest),
+           static_cast<unsigned long long>(stats.droppedQueueFull), stats.packetRate, stats.slotHoldMs,
+           stats.suggestedSlotCount);
+}
+
+void HesaiLidar::reportStageStats(uint64_t now)
+{
+    if (m_statsIntervalS <= 0) {
+        return;
+    }
+    if (m_statsReported == 0) {
+        m_statsReported = now;
+        return;
+    }
+    if (now - m_statsReported < m_statsIntervalS * 1000000000ULL) {
+        return;
+    }
+    m_statsReported = now;
+    StageStatsSnapshot stats;
+    getStageStats(&stats);
+    std::string name = m_lidarType + " " + (isVirtualSensor() ? std::string("virtual") : m_ipAddress);
+    StageStats::print(name.c_str(), stats);
+}
+
+ptrdiff_t HesaiLidar::getPointOffset(const dwLidarPointXYZI* points) {
+    // the points must be handed out by 'parseData', it knows their slot in the buffer
+    const dwLidarPointXYZI* first = m_pointXYZI.data();
+    if (points < first || points >= first + m_pointXYZI.size()) {
+        return -1;
+    }
+    return points - first;
+}
+
+void HesaiLidar::prefetchPtc(const std::vector<PTC_COMMAND>& commands) {
+    for (TcpCommandReply& reply : m_ptcPrefetch) {
+        free(reply.buffer);
+    }
+    m_ptcPrefetch.clear();
+    if (commands.empty()) {
+        return;
+    }
+    m_ptcPrefetch.resize(commands.size());
+    for (size_t i = 0; i < commands.size(); i++) {
+        memset(&m_ptcPrefetch[i], 0, sizeof(TcpCommandReply));
+        m_ptcPrefetch[i].cmd = commands[i];
+    }
+    if (TcpCommandGetPipelined(m_pTcpCommandClient, m_ptcPrefetch.data(), m_ptcPrefetch.size()) != PTC_ERROR_NO_ERROR) {
+        printf("prefetchPtc: PTC gets failed, check ptc connection\n");
+    }
+}
+
+PTC_ErrCode HesaiLidar::ptcGet(PTC_COMMAND command, unsigned char** buffer, unsigned int* len) {
+    for (TcpCommandReply& reply : m_ptcPrefetch) {
+        if (reply.cmd == command && reply.buffer != nullptr && reply.status == PTC_ERROR_NO_ERROR) {
+            *buffer = reply.buffer;
+            *len = reply.len + 1;
+            reply.buffer = nullptr;
+            return static_cast<PTC_ErrCode>(reply.ret_code);
+        }
+    }
+    return TcpCommandGet(m_pTcpCommandClient, command, buffer, len);
+}
+
+void HesaiLidar::submitPackets() {
+    const UdpPacket* msg;
+    while (m_buffer.peek(reinterpret_cast<const uint8_t**>(&msg))) {
+        size_t slot = (count + 1) * MAX_POINTS_PER_PACKET;
+        PointExtraOutput extra;
+        if (!m_pointTimestamp.empty()) {
+            extra.pointTimestamp = &m_pointTimestamp[slot];
+        }
+        if (!m_compactPoint.empty()) {
+            extra.compactPoint = &m_compactPoint[slot];
+        }
+        if (!m_decodePool->submit(*msg, &m_pointXYZI[slot], &m_pointRTHI[slot], extra)) {
+            break;
+        }
+        m_buffer.dequeue();
+        count++;
+        if (count > 20000) count = 0;
+    }
+    noteQueueDepth();
+}
+
+void HesaiLidar::prepareMemory(int numaNode) {
+    if (numaNode >= 0) {
+        m_Parser->BindNumaNode(numaNode);
+        m_pointXYZI.BindNode(numaNode);
+        m_pointRTHI.BindNode(numaNode);
+        m_pointTimestamp.BindNode(numaNode);
+        m_compactPoint.BindNode(numaNode);
+        m_numaNode = numaNode;
+    }
+    m_pointXYZI.Prefault();
+    m_pointRTHI.Prefault();
+    m_pointTimestamp.Prefault();
+    m_compactPoint.Prefault();
+}
+
 std::string HesaiLidar::getSearchString(std::string params, const std::string search) {
     std::string result = "";
     size_t pos = params.find(search);
@@ -375,6 +1097,146 @@ dwStatus HesaiLidar::loadUserParams(const char* params) {
         }
     }
     
+    retStr = getSearchString(paramsString, "firetimes_file=");
+    if (retStr != "") {
+        m_firetimesPath = retStr;
+        m_firetimesFileFlag = true;
+    }
+
+    retStr = getSearchString(paramsString, "numa_node=");
+    if (retStr == "auto") {
+        m_numaNode = -2;
+    } else if (retStr != "") {
+        try{
+            m_numaNode = std::stoi(retStr);
+        }
+        catch(const std::exception& e){
+            std::cerr << "wrong param numa_node" << e.what() << '\n';
+        }
+    }
+
+    if (getSearchString(paramsString, "compact_point=") == "1") {
+        m_compactPoint.Allocate(POINT_BUFFER_PACKETS * MAX_POINTS_PER_PACKET);
+    }
+    if (getSearchString(paramsString, "output_mode=") == "range_image") {
+        m_rangeImageFlag = true;
+    }
+
+    retStr = getSearchString(paramsString, "status_interval_ms=");
+    if (retStr != "") {
+        try{
+            m_statusIntervalMs = std::max(std::stoi(retStr), 0);
+        }
+        catch(const std::exception& e){
+            std::cerr << "wrong param status_interval_ms" << e.what() << '\n';
+        }
+    }
+
+    retStr = getSearchString(paramsString, "stats_interval_s=");
+    if (retStr != "") {
+        try{
+            m_statsIntervalS = std::max(std::stoi(retStr), 0);
+        }
+        catch(const std::exception& e){
+            std::cerr << "wrong param stats_interval_s" << e.what() << '\n';
+        }
+    }
+
+    retStr = getSearchString(paramsString, "slot_count=");
+    if (retStr != "") {
+        try{
+            m_slotSize = std::max(std::stoi(retStr), 1);
+            resetSlot();
+        }
+        catch(const std::exception& e){
+            std::cerr << "wrong param slot_count" << e.what() << '\n';
+        }
+    }
+    retStr = getSearchString(paramsString, "overload_policy=");
+    if (retStr == "drop_newest") {
+        m_overloadPolicy = OverloadPolicy::DROP_NEWEST;
+    } else if (retStr == "drop_oldest") {
+        m_overloadPolicy = OverloadPolicy::DROP_OLDEST;
+    } else if (retStr != "" && retStr != "block") {
+        std::cerr << "wrong param overload_policy, expect block, drop_newest or drop_oldest" << '\n';
+    }
+    retStr = getSearchString(paramsString, "slot_deadline_ms=");
+    if (retStr != "") {
+        try{
+            m_slotDeadlineMs = std::max(std::stoi(retStr), 0);
+        }
+        catch(const std::exception& e){
+            std::cerr << "wrong param slot_deadline_ms" << e.what() << '\n';
+        }
+    }
+
+    m_calibCacheDir = getSearchString(paramsString, "calib_cache=");
+    if (m_calibCacheDir != "") {
+        m_calibCache.reset(new CalibrationCache(m_calibCacheDir, m_lidarType + "_" + m_ipAddress));
+    }
+    if (getSearchString(paramsString, "async_start=") == "0") {
+        m_asyncStartFlag = false;
+    }
+    if (getSearchString(paramsString, "io_reactor=") == "0") {
+        m_ioReactorFlag = false;
+    }
+    retStr = getSearchString(paramsString, "source=");
+    if (retStr.compare(0, 5, "pcap:") == 0) {
+        m_pcapPath = retStr.substr(5);
+    } else if (retStr != "" && retStr != "socket") {
+        std::cerr << "wrong param source " << retStr << '\n';
+    }
+    retStr = getSearchString(paramsString, "pcap_speed=");
+    if (retStr == "max") {
+        m_pcapSpeed = 0;
+    } else if (retStr != "") {
+        try{
+            m_pcapSpeed = std::max(std::stod(retStr), 0.0);
+        }
+        catch(const std::exception& e){
+            std::cerr << "wrong param pcap_speed" << e.what() << '\n';
+        }
+    }
+    if (getSearchString(paramsString, "pcap_loop=") == "1") {
+        m_pcapLoop = true;
+    }
+
+    retStr = getSearchString(paramsString, "decode_threads=");
+    if (retStr != "") {
+        try{
+            m_decodeThreads = std::max(std::stoi(retStr), 1);
+        }
+        catch(const std::exception& e){
+            std::cerr << "wrong param decode_threads" << e.what() << '\n';
+        }
+    }
+    if (m_decodeThreads > 1 && m_rangeImageFlag) {
+        // the cells of a scan are written in packet order, not supported by the workers
+        std::cerr << "wrong param output_mode=range_image, needs decode_threads=1" << '\n';
+        return DW_INVALID_ARGUMENT;
+    }
+
+    // per-point time and deskew, see README for the params
+    if (getSearchString(paramsString, "point_time=") == "1") {
+        m_pointTimestamp.Allocate(POINT_BUFFER_PACKETS * MAX_POINTS_PER_PACKET);
+    }
+    retStr = getSearchString(paramsString, "deskew=");
+    if (retStr == "1") {
+        DeskewMotion motion = {};
+        std::string velocity = getSearchString(paramsString, "ego_velocity=");
+        std::string angularVelocity = getSearchString(paramsString, "ego_angular_velocity=");
+        if (velocity != "" && sscanf(velocity.c_str(), "%f:%f:%f", &motion.linearVelocity[0],
+                &motion.linearVelocity[1], &motion.linearVelocity[2]) != 3) {
+            std::cerr << "wrong param ego_velocity, expect vx:vy:vz" << '\n';
+        }
+        if (angularVelocity != "" && sscanf(angularVelocity.c_str(), "%f:%f:%f", &motion.angularVelocity[0],
+                &motion.angularVelocity[1], &motion.angularVelocity[2]) != 3) {
+            std::cerr << "wrong param ego_angular_velocity, expect wx:wy:wz" << '\n';
+        }
+        m_deskewMotion = motion;
+        m_deskewFlag = true;
+    }
+
     // std::cout << "ip=" << m_ipAddress << ",udp_port=" << m_udpPort << ",ptc_port=" << m_ptcPort
     //           << ",multcast_ip=" << m_multcastIpAddress << std::endl;
 
@@ -27,6 +27,9 @@
 #include <sstream>
 
 #include "InputSocket.h"
+#include "UdpReactor.h"
+#include "PcapSource.h"
+#include "StageStats.h"
 #include "platUtil.h"
 
 static const size_t packet_size = sizeof(UdpPacket().m_u8Buf);
@@ -127,12 +130,85 @@ void InputSocket::InitSocket(std::string deviceipaddr, std::string hostIpAddr, s
 }
 
 void InputSocket::CloseSocket() { 
+	m_pPcap.reset();
+	if (m_pChannel != nullptr) {
+		// the reactor must not read the fds once they are closed
+		if(m_iSockGpsfd >0) UdpReactor::Instance().Unregister(m_iSockGpsfd);
+		if(m_iSockfd >0) UdpReactor::Instance().Unregister(m_iSockfd);
+		m_pChannel.reset();
+	}
 	if(m_iSockGpsfd >0) close(m_iSockGpsfd);
 	if(m_iSockfd >0) close(m_iSockfd); 
+	m_iSockGpsfd = -1;
+	m_iSockfd = -1;
+}
+
+bool InputSocket::AttachReactor() {
+	if (m_iSockfd < 0) return false;
+	std::shared_ptr<UdpChannel> channel = std::make_shared<UdpChannel>(UDP_CHANNEL_PACKET_NUM);
+	if (UdpReactor::Instance().Register(m_iSockfd, channel) != 0) {
+		printf("InputSocket: AttachReactor failed, polling the socket\n");
+		return false;
+	}
+	// the gps port is bound by the first sensor of the process only
+	if (m_iSocktNumber == 2 && UdpReactor::Instance().Register(m_iSockGpsfd, channel) != 0) {
+		printf("InputSocket: AttachReactor gps socket failed, gps packets are dropped\n");
+	}
+	m_pChannel = channel;
+	return true;
+}
+
+bool InputSocket::OpenPcap(std::string path, uint16_t lidarport, double speed, bool loop, uint16_t gpsport) {
+	std::shared_ptr<PcapSource> source = std::make_shared<PcapSource>();
+	if (!source->Open(path, lidarport, gpsport, speed, loop)) {
+		printf("InputSocket: OpenPcap %s failed\n", path.c_str());
+		return false;
+	}
+	m_pPcap = source;
+	return true;
+}
+
+size_t InputSocket::DiscardPackets() {
+	size_t num = 0;
+	if (m_pPcap != nullptr) {
+		return m_pPcap->DiscardPackets();
+	}
+	if (m_pChannel != nullptr) {
+		UdpPacket packet;
+		while (m_pChannel->Pop(&packet, 0)) num++;
+		return num;
+	}
+	uint8_t buffer[sizeof(UdpPacket::m_u8Buf)];
+	while (m_iSockfd >= 0 && recv(m_iSockfd, buffer, sizeof(buffer), MSG_DONTWAIT) >= 0) num++;
+	return num;
+}
+
+uint64_t InputSocket::GetDroppedNum() const {
+	return m_pChannel != nullptr ? m_pChannel->GetDroppedNum() : 0;
+}
+
+size_t InputSocket::GetBufferBytes() const {
+	return m_pChannel != nullptr ? m_pChannel->MemoryBytes() : 0;
+}
+
+size_t InputSocket::GetBufferResidentBytes() const {
+	return m_pChannel != nullptr ? m_pChannel->ResidentBytes() : 0;
 }
 
 PacketType InputSocket::GetPacket(UdpPacket *&pkt, int timeout) {
 	// printf("InputSocket: GetPacket, starting\n");
+	if (m_pPcap != nullptr) {
+		return m_pPcap->GetPacket(pkt, timeout, &m_u64RecvTime);
+	}
+	if (m_pChannel != nullptr) {
+		if (!m_pChannel->Pop(pkt, timeout, &m_u64RecvTime)) {
+			return TIMEOUT;
+		}
+		if (pkt->m_i16Len == 512) return GPS_PACKET;
+		if (pkt->m_i16Len == FAULT_MESSAGE_PCAKET_SIZE) return FAULT_MESSAGE_PACKET;
+		if (pkt->m_i16Len == LOG_REPORT_PCAKET_SIZE) return LOG_REPORT_PACKET;
+		return POINTCLOUD_PACKET;
+	}
 	timespec time;
 	memset(&time, 0, sizeof(time));
 
@@ -167,8 +243,9 @@ PacketType InputSocket::GetPacket(UdpPacket *&pkt, int timeout) {
 	ssize_t nbytes = 0;
   	for (int i = 0; i != m_iSocktNumber; ++i) {
     	if (fds[i].revents & POLLIN) {
-      		nbytes = recvfrom(fds[i].fd, &pkt->m_u8Buf[0], 10000, 0, (sockaddr *)&sender_address, &sender_address_len);
-			// pkt->m_i16Len = nbytes;
+      		nbytes = recvfrom(fds[i].fd, &pkt->m_u8Buf[0], sizeof(pkt->m_u8Buf), 0, (sockaddr *)&sender_address, &sender_address_len);
+			m_u64RecvTime = dw::plugins::lidar::StageClockNs();
+			pkt->m_i16Len = nbytes > 0 ? static_cast<int16_t>(nbytes) : 0;
 			// printf("fds[%d] size: %d\n",i, nbytes);
       		break;
     	}
@@ -0,0 +1,407 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "PcapFile.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+
+namespace
+{
+const uint32_t PCAP_MAGIC_US  = 0xa1b2c3d4;
+const uint32_t PCAP_MAGIC_NS  = 0xa1b23c4d;
+const size_t PCAP_HEADER_SIZE = 24;
+const size_t PCAP_RECORD_SIZE = 16;
+
+// pcapng block types and the byte order magic of the section header
+const uint32_t PCAPNG_SECTION_HEADER   = 0x0a0d0d0a;
+const uint32_t PCAPNG_INTERFACE        = 0x00000001;
+const uint32_t PCAPNG_PACKET_OBSOLETE  = 0x00000002;
+const uint32_t PCAPNG_SIMPLE_PACKET    = 0x00000003;
+const uint32_t PCAPNG_ENHANCED_PACKET  = 0x00000006;
+const uint32_t PCAPNG_BYTE_ORDER_MAGIC = 0x1a2b3c4d;
+const uint16_t PCAPNG_OPTION_END       = 0;
+const uint16_t PCAPNG_OPTION_TSRESOL   = 9;
+
+const uint32_t LINKTYPE_ETHERNET  = 1;
+const uint32_t LINKTYPE_RAW       = 101;
+const uint32_t LINKTYPE_LINUX_SLL = 113;
+
+const uint16_t ETHERTYPE_IPV4 = 0x0800;
+const uint16_t ETHERTYPE_VLAN = 0x8100;
+const uint16_t ETHERTYPE_QINQ = 0x88a8;
+const uint8_t IPPROTO_UDP_    = 17;
+
+inline uint16_t readBe16(const uint8_t* p)
+{
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+inline uint32_t readBe32(const uint8_t* p)
+{
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+           static_cast<uint32_t>(p[2]) << 8 | p[3];
+}
+
+inline uint32_t readU32(const uint8_t* p, bool swapped)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return swapped ? __builtin_bswap32(value) : value;
+}
+
+inline uint16_t readU16(const uint8_t* p, bool swapped)
+{
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return swapped ? __builtin_bswap16(value) : value;
+}
+
+inline size_t align4(size_t size)
+{
+    return (size + 3) & ~static_cast<size_t>(3);
+}
+} // namespace
+
+PcapFile::~PcapFile()
+{
+    close();
+}
+
+bool PcapFile::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        printf("PcapFile: open %s Error, %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < PCAP_HEADER_SIZE) {
+        printf("PcapFile: %s is too short\n", path.c_str());
+        ::close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        printf("PcapFile: mmap %s Error, %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    // read in file order
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    m_data = static_cast<const uint8_t*>(map);
+    m_size = st.st_size;
+    if (readU32(m_data, false) == PCAPNG_SECTION_HEADER) {
+        return openPcapng(path);
+    }
+    return openPcap(path);
+}
+
+bool PcapFile::openPcap(const std::string& path)
+{
+    uint32_t magic = readU32(m_data, false);
+    if (magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS) {
+        m_swapped = false;
+    } else if (__builtin_bswap32(magic) == PCAP_MAGIC_US || __builtin_bswap32(magic) == PCAP_MAGIC_NS) {
+        m_swapped = true;
+        magic     = __builtin_bswap32(magic);
+    } else {
+        printf("PcapFile: %s is not a pcap file, magic 0x%08x\n", path.c_str(), magic);
+        close();
+        return false;
+    }
+    m_pcapng     = false;
+    m_nanosecond = magic == PCAP_MAGIC_NS;
+    m_linkType   = readU32(m_data + 20, m_swapped) & 0x0fffffff;
+    if (!isLinkTypeSupported(m_linkType)) {
+        printf("PcapFile: %s link type %u not supported\n", path.c_str(), m_linkType);
+        close();
+        return false;
+    }
+    m_offset      = PCAP_HEADER_SIZE;
+    m_firstOffset = m_offset;
+    return true;
+}
+
+bool PcapFile::openPcapng(const std::string& path)
+{
+    // the byte order of the first section, checked again at each section header
+    uint32_t magic = readU32(m_data + 8, false);
+    if (magic != PCAPNG_BYTE_ORDER_MAGIC && __builtin_bswap32(magic) != PCAPNG_BYTE_ORDER_MAGIC) {
+        printf("PcapFile: %s is not a pcapng file, byte order magic 0x%08x\n", path.c_str(), magic);
+        close();
+        return false;
+    }
+    m_pcapng      = true;
+    m_offset      = 0;
+    m_firstOffset = 0;
+    m_interfaces.clear();
+    m_lastTimestamp = 0;
+    return true;
+}
+
+void PcapFile::close()
+{
+    if (m_data != nullptr) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+    m_data   = nullptr;
+    m_size   = 0;
+    m_offset = 0;
+    m_interfaces.clear();
+}
+
+void PcapFile::rewind()
+{
+    m_offset = m_firstOffset;
+    m_interfaces.clear();
+    m_lastTimestamp = 0;
+}
+
+bool PcapFile::seek(uint64_t offset)
+{
+    if (m_data == nullptr || offset < m_firstOffset || offset >= m_size) {
+        return false;
+    }
+    if (!m_pcapng) {
+        m_offset = offset;
+        return true;
+    }
+    // the interfaces are kept if the block is ahead in the same walk
+    size_t current = m_offset;
+    if (offset < current) {
+        rewind();
+    }
+    while (m_offset < offset && m_offset + 12 <= m_size) {
+        const uint8_t* block = m_data + m_offset;
+        uint32_t type        = readU32(block, m_swapped);
+        if (type == PCAPNG_SECTION_HEADER) {
+            m_swapped = readU32(block + 8, false) != PCAPNG_BYTE_ORDER_MAGIC;
+            m_interfaces.clear();
+        }
+        uint32_t length = readU32(block + 4, m_swapped);
+        if (length < 12 || length % 4 != 0 || m_offset + length > m_size) {
+            break;
+        }
+        if (type == PCAPNG_INTERFACE) {
+            addInterface(block + 8, length - 12);
+        }
+        m_offset += length;
+    }
+    if (m_offset != offset) {
+        // not a block start, back to where it was
+        rewind();
+        return current == m_firstOffset || seek(current);
+    }
+    return true;
+}
+
+bool PcapFile::next(UdpDatagram& datagram)
+{
+    if (m_pcapng) {
+        return nextPcapng(datagram);
+    }
+    while (m_data != nullptr && m_offset + PCAP_RECORD_SIZE <= m_size) {
+        const uint8_t* record = m_data + m_offset;
+        uint32_t second       = readU32(record, m_swapped);
+        uint32_t fraction     = readU32(record + 4, m_swapped);
+        uint32_t capLen       = readU32(record + 8, m_swapped);
+        if (m_offset + PCAP_RECORD_SIZE + capLen > m_size) {
+            // truncated by the capture tool, the rest is lost
+            return false;
+        }
+        datagram.offset = m_offset;
+        m_offset += PCAP_RECORD_SIZE + capLen;
+        if (decodeFrame(m_linkType, record + PCAP_RECORD_SIZE, capLen, datagram)) {
+            datagram.timestamp = static_cast<int64_t>(second) * 1000000000 +
+                                 (m_nanosecond ? fraction : static_cast<int64_t>(fraction) * 1000);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PcapFile::nextPcapng(UdpDatagram& datagram)
+{
+    while (m_data != nullptr && m_offset + 12 <= m_size) {
+        const uint8_t* block = m_data + m_offset;
+        uint32_t type        = readU32(block, m_swapped);
+        if (type == PCAPNG_SECTION_HEADER) {
+            // a new section may be of the other byte order and has its own interfaces
+            m_swapped = readU32(block + 8, false) != PCAPNG_BYTE_ORDER_MAGIC;
+            m_interfaces.clear();
+        }
+        uint32_t length = readU32(block + 4, m_swapped);
+        if (length < 12 || length % 4 != 0 || m_offset + length > m_size) {
+            // truncated by the capture tool, the rest is lost
+            return false;
+        }
+        datagram.offset = m_offset;
+        m_offset += length;
+        const uint8_t* body = block + 8;
+        size_t bodyLength   = length - 12;
+
+        uint32_t interfaceId = 0;
+        uint64_t time        = 0;
+        const uint8_t* frame = nullptr;
+        size_t capLen        = 0;
+        bool timed           = true;
+        if (type == PCAPNG_INTERFACE) {
+            addInterface(body, bodyLength);
+            continue;
+        } else if (type == PCAPNG_ENHANCED_PACKET && bodyLength >= 20) {
+            interfaceId = readU32(body, m_swapped);
+            time        = static_cast<uint64_t>(readU32(body + 4, m_swapped)) << 32 | readU32(body + 8, m_swapped);
+            capLen      = readU32(body + 12, m_swapped);
+            frame       = body + 20;
+            if (20 + capLen > bodyLength) continue;
+        } else if (type == PCAPNG_PACKET_OBSOLETE && bodyLength >= 20) {
+            interfaceId = readU16(body, m_swapped);
+            time        = static_cast<uint64_t>(readU32(body + 4, m_swapped)) << 32 | readU32(body + 8, m_swapped);
+            capLen      = readU32(body + 12, m_swapped);
+            frame       = body + 20;
+            if (20 + capLen > bodyLength) continue;
+        } else if (type == PCAPNG_SIMPLE_PACKET && bodyLength >= 4) {
+            // of the first interface, without time stamp and captured length
+            capLen = readU32(body, m_swapped);
+            if (capLen > bodyLength - 4) capLen = bodyLength - 4;
+            frame = body + 4;
+            timed = false;
+        } else {
+            // statistics, name resolution, custom blocks and so on
+            continue;
+        }
+        if (interfaceId >= m_interfaces.size()) {
+            continue;
+        }
+        const Interface& interface = m_interfaces[interfaceId];
+        if (!decodeFrame(interface.linkType, frame, capLen, datagram)) {
+            continue;
+        }
+        if (timed) {
+            uint64_t second = time / interface.tsRate;
+            uint64_t units  = time % interface.tsRate;
+            // 128 bit, the units of a fine resolution times 1e9 overflow
+            uint64_t ns     = static_cast<uint64_t>(static_cast<unsigned __int128>(units) * 1000000000 / interface.tsRate);
+            m_lastTimestamp = static_cast<int64_t>(second * 1000000000 + ns);
+        }
+        datagram.timestamp = m_lastTimestamp;
+        return true;
+    }
+    return false;
+}
+
+void PcapFile::addInterface(const uint8_t* body, size_t length)
+{
+    Interface interface;
+    if (length >= 8) {
+        interface.linkType = readU16(body, m_swapped);
+    }
+    // options, code and length then the value padded to 4 bytes
+    size_t offset = 8;
+    while (offset + 4 <= length) {
+        uint16_t code         = readU16(body + offset, m_swapped);
+        uint16_t optionLength = readU16(body + offset + 2, m_swapped);
+        if (code == PCAPNG_OPTION_END || offset + 4 + optionLength > length) {
+            break;
+        }
+        if (code == PCAPNG_OPTION_TSRESOL && optionLength >= 1) {
+            uint8_t resolution = body[offset + 4];
+            uint64_t rate      = 1;
+            // a power of 10, or of 2 with the high bit set
+            for (uint32_t i = 0; i < (resolution & 0x7fu) && rate < 1000000000000000000ULL; i++) {
+                rate *= (resolution & 0x80) != 0 ? 2 : 10;
+            }
+            interface.tsRate = rate;
+        }
+        offset += 4 + align4(optionLength);
+    }
+    // the packets of an interface of another link type are skipped
+    if (!isLinkTypeSupported(interface.linkType)) {
+        interface.linkType = 0;
+    }
+    m_interfaces.push_back(interface);
+}
+
+bool PcapFile::isLinkTypeSupported(uint32_t linkType)
+{
+    return linkType == LINKTYPE_ETHERNET || linkType == LINKTYPE_RAW || linkType == LINKTYPE_LINUX_SLL;
+}
+
+bool PcapFile::decodeFrame(uint32_t linkType, const uint8_t* frame, size_t length, UdpDatagram& datagram)
+{
+    if (!isLinkTypeSupported(linkType)) {
+        return false;
+    }
+    const uint8_t* end = frame + length;
+    const uint8_t* p   = frame;
+    uint16_t etherType = ETHERTYPE_IPV4;
+    if (linkType == LINKTYPE_ETHERNET) {
+        if (length < 14) return false;
+        etherType = readBe16(p + 12);
+        p += 14;
+        while ((etherType == ETHERTYPE_VLAN || etherType == ETHERTYPE_QINQ) && p + 4 <= end) {
+            etherType = readBe16(p + 2);
+            p += 4;
+        }
+    } else if (linkType == LINKTYPE_LINUX_SLL) {
+        if (length < 16) return false;
+        etherType = readBe16(p + 14);
+        p += 16;
+    }
+    if (etherType != ETHERTYPE_IPV4 || p + 20 > end || (p[0] >> 4) != 4) {
+        return false;
+    }
+    size_t ipHeader = (p[0] & 0x0f) * 4;
+    size_t ipLength = readBe16(p + 2);
+    // fragments are not put together again, the lidar packets fit in one frame
+    uint16_t fragment = readBe16(p + 6);
+    if (p[9] != IPPROTO_UDP_ || ipHeader < 20 || (fragment & 0x3fff) != 0 || p + ipLength > end ||
+        ipLength < ipHeader + 8) {
+        return false;
+    }
+    const uint8_t* udp = p + ipHeader;
+    size_t udpLength   = readBe16(udp + 4);
+    if (udpLength < 8 || udp + udpLength > p + ipLength) {
+        return false;
+    }
+    datagram.srcAddr = readBe32(p + 12);
+    datagram.dstAddr = readBe32(p + 16);
+    datagram.srcPort = readBe16(udp);
+    datagram.dstPort = readBe16(udp + 2);
+    datagram.payload = udp + 8;
+    datagram.length  = udpLength - 8;
+    return true;
+}
+
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
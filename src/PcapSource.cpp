@@ -0,0 +1,112 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#include "PcapSource.h"
+#include "StageStats.h"
+
+bool PcapSource::Open(const std::string &path, uint16_t lidarPort, uint16_t gpsPort, double speed, bool loop) {
+    if (!m_file.open(path)) {
+        return false;
+    }
+    m_u16LidarPort = lidarPort;
+    m_u16GpsPort = gpsPort;
+    m_dSpeed = speed > 0 ? speed : 0;
+    m_bLoop = loop;
+    m_i64LoopOffset = 0;
+    m_u64PassNum = 0;
+    m_u64PacketNum = 0;
+    m_bHasNext = Fetch();
+    if (!m_bHasNext) {
+        printf("PcapSource: no udp packet to port %u in %s\n", lidarPort, path.c_str());
+        return false;
+    }
+    m_i64FirstCapture = m_next.timestamp;
+    m_u64StartNs = dw::plugins::lidar::StageClockNs();
+    if (m_dSpeed > 0) {
+        printf("PcapSource: replay %s at x%.2f%s\n", path.c_str(), m_dSpeed, m_bLoop ? ", loop" : "");
+    } else {
+        printf("PcapSource: replay %s at max speed%s\n", path.c_str(), m_bLoop ? ", loop" : "");
+    }
+    return true;
+}
+
+bool PcapSource::Fetch() {
+    for (int pass = 0; pass < 2; pass++) {
+        while (m_file.next(m_next)) {
+            if (m_next.dstPort != m_u16LidarPort && m_next.dstPort != m_u16GpsPort) continue;
+            if (m_next.length > sizeof(UdpPacket::m_u8Buf)) continue;
+            m_next.timestamp += m_i64LoopOffset;
+            if (m_u64PassNum == 0) m_i64PassFirst = m_next.timestamp;
+            m_i64LastCapture = m_next.timestamp;
+            m_u64PassNum++;
+            return true;
+        }
+        // an empty pass would loop for ever
+        if (!m_bLoop || m_u64PassNum == 0) return false;
+        // the next pass starts one mean packet interval after the last packet
+        int64_t span = m_i64LastCapture - m_i64PassFirst;
+        m_i64LoopOffset += span + (m_u64PassNum > 1 ? span / static_cast<int64_t>(m_u64PassNum - 1) : 0);
+        m_u64PassNum = 0;
+        m_file.rewind();
+    }
+    return false;
+}
+
+uint64_t PcapSource::DueTime() const {
+    if (m_dSpeed <= 0) return 0;
+    return m_u64StartNs + static_cast<uint64_t>((m_next.timestamp - m_i64FirstCapture) / m_dSpeed);
+}
+
+PacketType PcapSource::GetPacket(UdpPacket *pkt, int timeout, uint64_t *recvTime) {
+    if (!m_bHasNext) return PCAP_END_PACKET;
+    uint64_t due = DueTime();
+    uint64_t now = dw::plugins::lidar::StageClockNs();
+    if (due > now) {
+        uint64_t wait = due - now;
+        if (wait > static_cast<uint64_t>(timeout) * 1000000) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+            return TIMEOUT;
+        }
+        std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+    }
+    memcpy(pkt->m_u8Buf, m_next.payload, m_next.length);
+    pkt->m_i16Len = static_cast<int16_t>(m_next.length);
+    *recvTime = dw::plugins::lidar::StageClockNs();
+    m_u64PacketNum++;
+    m_bHasNext = Fetch();
+    // judged by the size as the packets of the sockets
+    if (pkt->m_i16Len == 512) return GPS_PACKET;
+    if (pkt->m_i16Len == FAULT_MESSAGE_PCAKET_SIZE) return FAULT_MESSAGE_PACKET;
+    if (pkt->m_i16Len == LOG_REPORT_PCAKET_SIZE) return LOG_REPORT_PACKET;
+    return POINTCLOUD_PACKET;
+}
+
+size_t PcapSource::DiscardPackets() {
+    size_t num = 0;
+    uint64_t now = dw::plugins::lidar::StageClockNs();
+    while (m_bHasNext && m_dSpeed > 0 && DueTime() <= now) {
+        m_bHasNext = Fetch();
+        num++;
+    }
+    return num;
+}
@@ -0,0 +1,178 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+#include "SideChannel.h"
+#include "HsLidarSideChannel.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+
+static_assert(sizeof(HS_LIDAR_GPS_PACKET) == SIDE_PACKET_SIZE, "HS_LIDAR_GPS_PACKET must be 512 bytes");
+
+namespace
+{
+// about 16 s of GPS and fault messages at their usual 1 Hz
+const size_t GPS_QUEUE_SIZE   = 16;
+const size_t FAULT_QUEUE_SIZE = 16;
+const size_t LOG_QUEUE_SIZE   = 16;
+
+int64_t toEpochUs(int year, int month, int day, int hour, int minute, int second, uint32_t us)
+{
+    struct tm t;
+    memset(&t, 0, sizeof(t));
+    t.tm_year = year - 1900;
+    t.tm_mon  = month - 1;
+    t.tm_mday = day;
+    t.tm_hour = hour;
+    t.tm_min  = minute;
+    t.tm_sec  = second;
+    return static_cast<int64_t>(timegm(&t)) * 1000000 + us;
+}
+} // namespace
+
+bool SideQueue::push(const uint8_t* data, size_t len, dwTime_t hostTime)
+{
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) >= m_packets.size()) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    SidePacket& packet = m_packets[tail % m_packets.size()];
+    packet.hostTime    = hostTime;
+    packet.len         = static_cast<uint16_t>(std::min(len, sizeof(packet.data)));
+    memcpy(packet.data, data, packet.len);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool SideQueue::pop(SidePacket& packet)
+{
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    packet = m_packets[head % m_packets.size()];
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+SideChannels::SideChannels()
+    : m_gpsQueue(GPS_QUEUE_SIZE)
+    , m_faultQueue(FAULT_QUEUE_SIZE)
+    , m_logQueue(LOG_QUEUE_SIZE)
+{
+}
+
+size_t SideChannels::memoryBytes() const
+{
+    return m_gpsQueue.memoryBytes() + m_faultQueue.memoryBytes() + m_logQueue.memoryBytes();
+}
+
+size_t SideChannels::residentBytes() const
+{
+    return m_gpsQueue.residentBytes() + m_faultQueue.residentBytes() + m_logQueue.residentBytes();
+}
+
+bool SideChannels::route(PacketType type, const uint8_t* data, dwTime_t hostTime)
+{
+    switch (type) {
+    case GPS_PACKET:
+        m_gpsQueue.push(data, SIDE_PACKET_SIZE, hostTime);
+        return true;
+    case FAULT_MESSAGE_PACKET:
+        m_faultQueue.push(data, FAULT_MESSAGE_PCAKET_SIZE, hostTime);
+        return true;
+    case LOG_REPORT_PACKET:
+        m_logQueue.push(data, LOG_REPORT_PCAKET_SIZE, hostTime);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void SideChannels::getGpsStatus(GpsStatus* status)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SidePacket packet;
+    while (m_gpsQueue.pop(packet)) {
+        const HS_LIDAR_GPS_PACKET* gps = reinterpret_cast<const HS_LIDAR_GPS_PACKET*>(packet.data);
+        if (packet.len < sizeof(HS_LIDAR_GPS_PACKET) || !gps->IsValid()) {
+            continue;
+        }
+        m_gpsStatus.valid      = true;
+        m_gpsStatus.positioned = gps->IsPositioned();
+        m_gpsStatus.ppsLocked  = gps->IsPpsLocked();
+        m_gpsStatus.gpsTime    = toEpochUs(gps->GetYear(), gps->GetMonth(), gps->GetDay(), gps->GetHour(),
+                                           gps->GetMinute(), gps->GetSecond(), gps->GetFineTime());
+        m_gpsStatus.hostTime   = packet.hostTime;
+        size_t nmeaLen = strnlen(gps->m_cNmea, sizeof(gps->m_cNmea));
+        memcpy(m_gpsStatus.nmea, gps->m_cNmea, nmeaLen);
+        m_gpsStatus.nmea[nmeaLen] = '\0';
+    }
+    m_gpsStatus.packetNum  = m_gpsQueue.pushedNum();
+    m_gpsStatus.droppedNum = m_gpsQueue.droppedNum();
+    *status = m_gpsStatus;
+}
+
+void SideChannels::getHealth(HealthStatus* status)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SidePacket packet;
+    while (m_faultQueue.pop(packet)) {
+        const HS_LIDAR_FAULT_MESSAGE_HEADER* fault =
+            reinterpret_cast<const HS_LIDAR_FAULT_MESSAGE_HEADER*>(packet.data);
+        if (packet.len < sizeof(HS_LIDAR_FAULT_MESSAGE_HEADER) || !fault->IsValid()) {
+            continue;
+        }
+        m_health.valid             = true;
+        m_health.operationState    = fault->m_u8OperationState;
+        m_health.faultState        = fault->m_u8FaultState;
+        m_health.faultCodeType     = fault->m_u8FaultCodeType;
+        m_health.totalFaultCodeNum = fault->m_u8TotalFaultCodeNum;
+        m_health.faultCodeId       = fault->m_u8FaultCodeId;
+        m_health.faultCode         = fault->GetFaultCode();
+        m_health.lidarTime = toEpochUs(fault->m_u8UTC[0] + 1900, fault->m_u8UTC[1], fault->m_u8UTC[2],
+                                       fault->m_u8UTC[3], fault->m_u8UTC[4], fault->m_u8UTC[5],
+                                       fault->GetTimestamp());
+        m_health.hostTime = packet.hostTime;
+        if (fault->m_u8FaultState != 0) {
+            m_health.faultNum++;
+        }
+    }
+    m_health.faultMessageNum = m_faultQueue.pushedNum();
+    m_health.droppedNum      = m_faultQueue.droppedNum();
+    *status = m_health;
+}
+
+bool SideChannels::popLogReport(SidePacket& packet)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_logQueue.pop(packet);
+}
+
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
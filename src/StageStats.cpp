@@ -0,0 +1,150 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <algorithm>
+
+#include "StageStats.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+
+void LatencyHistogram::reset()
+{
+    for (std::atomic<uint64_t>& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_sumNs.store(0, std::memory_order_relaxed);
+    m_maxNs.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::bucketUpperNs(uint32_t index)
+{
+    if (index < SUB_COUNT) {
+        return index;
+    }
+    uint32_t shift = index / SUB_COUNT - 1;
+    uint64_t lower = static_cast<uint64_t>(SUB_COUNT + index % SUB_COUNT) << shift;
+    return lower + (1ULL << shift) - 1;
+}
+
+LatencyHistogram::Summary LatencyHistogram::summarize() const
+{
+    Summary summary = {};
+    // a copy, so the percentiles are taken from one consistent total
+    uint64_t counts[BUCKET_NUM];
+    for (uint32_t i = 0; i < BUCKET_NUM; i++) {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        summary.count += counts[i];
+    }
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.maxNs  = m_maxNs.load(std::memory_order_relaxed);
+    summary.meanNs = m_sumNs.load(std::memory_order_relaxed) / summary.count;
+    const double quantiles[4] = {0.5, 0.9, 0.99, 0.999};
+    uint64_t* results[4]      = {&summary.p50Ns, &summary.p90Ns, &summary.p99Ns, &summary.p999Ns};
+    uint64_t seen             = 0;
+    uint32_t q                = 0;
+    for (uint32_t i = 0; i < BUCKET_NUM && q < 4; i++) {
+        seen += counts[i];
+        while (q < 4 && seen > 0 && seen >= quantiles[q] * summary.count) {
+            // the max is exact, the bucket bound is not
+            *results[q++] = std::min(bucketUpperNs(i), summary.maxNs);
+        }
+    }
+    return summary;
+}
+
+void StageStats::snapshot(StageStatsSnapshot& out, const StageDrops& drops) const
+{
+    out.received     = m_received.load(std::memory_order_relaxed);
+    out.pushed       = m_pushed.load(std::memory_order_relaxed);
+    out.parsed       = m_parsed.load(std::memory_order_relaxed);
+    out.points       = m_points.load(std::memory_order_relaxed);
+    out.frames       = m_frames.load(std::memory_order_relaxed);
+    out.decodeErrors = m_decodeError.load(std::memory_order_relaxed);
+    out.drops        = drops;
+    for (int i = 0; i < STAGE_NUM; i++) {
+        out.stage[i] = m_stage[i].summarize();
+    }
+}
+
+void StageStats::reset()
+{
+    m_received.store(0);
+    m_pushed.store(0);
+    m_parsed.store(0);
+    m_points.store(0);
+    m_frames.store(0);
+    m_decodeError.store(0);
+    m_frameParseNs = 0;
+    for (LatencyHistogram& histogram : m_stage) {
+        histogram.reset();
+    }
+}
+
+const char* StageStats::StageName(PacketStage stage)
+{
+    switch (stage) {
+    case STAGE_RECEIVE_TO_READ:
+        return "receive_to_read";
+    case STAGE_READ_TO_PUSH:
+        return "read_to_push";
+    case STAGE_PARSE_PACKET:
+        return "parse_packet";
+    case STAGE_PARSE_FRAME:
+        return "parse_frame";
+    case STAGE_RECEIVE_TO_PARSED:
+        return "receive_to_parsed";
+    default:
+        return "unknown";
+    }
+}
+
+void StageStats::print(const char* name, const StageStatsSnapshot& snapshot)
+{
+    printf("StageStats %s: %llu received, %llu pushed, %llu parsed, %llu points, %llu frames, %llu decode errors, "
+           "drops %llu slot miss %llu oldest %llu queue full %llu early\n",
+           name, static_cast<unsigned long long>(snapshot.received),
+           static_cast<unsigned long long>(snapshot.pushed), static_cast<unsigned long long>(snapshot.parsed),
+           static_cast<unsigned long long>(snapshot.points), static_cast<unsigned long long>(snapshot.frames),
+           static_cast<unsigned long long>(snapshot.decodeErrors),
+           static_cast<unsigned long long>(snapshot.drops.slotMiss),
+           static_cast<unsigned long long>(snapshot.drops.dropOldest),
+           static_cast<unsigned long long>(snapshot.drops.queueFull),
+           static_cast<unsigned long long>(snapshot.drops.early));
+    for (int i = 0; i < STAGE_NUM; i++) {
+        const LatencyHistogram::Summary& stage = snapshot.stage[i];
+        if (stage.count == 0) {
+            continue;
+        }
+        printf("  %-17s %10llu, us mean %.1f p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f max %.1f\n",
+               StageName(static_cast<PacketStage>(i)), static_cast<unsigned long long>(stage.count),
+               stage.meanNs / 1e3, stage.p50Ns / 1e3, stage.p90Ns / 1e3, stage.p99Ns / 1e3, stage.p999Ns / 1e3,
+               stage.maxNs / 1e3);
+    }
+}
+
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
@@ -0,0 +1,130 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "StatusPoller.h"
+#include "TcpCommandClient.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+
+namespace
+{
+// Reply of PTC_COMMAND_GET_LIDAR_STATUS, big endian
+struct PtcLidarStatus
+{
+    uint32_t systemUptime;
+    uint16_t motorSpeed;
+    // 0.01 degree Celsius
+    int32_t temperature[8];
+    uint8_t gpsPpsLock;
+    uint8_t gpsGprmcStatus;
+    uint32_t startupTimes;
+    uint32_t totalOperationTime;
+    uint8_t ptpClockStatus;
+} __attribute__((packed));
+} // namespace
+
+StatusPoller::StatusPoller(void* ptcClient, GeneralParser* parser, dwContextHandle_t ctx, int intervalMs)
+    : m_ptcClient(ptcClient)
+    , m_parser(parser)
+    , m_ctx(ctx)
+    , m_intervalMs(intervalMs)
+{
+    LidarStatusSnapshot empty = {};
+    m_snapshot.store(empty);
+    m_thread = std::thread(&StatusPoller::run, this);
+}
+
+StatusPoller::~StatusPoller()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+void StatusPoller::run()
+{
+    // nice rather than SCHED_IDLE, the PTC client lock is shared with the calibration fetches
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19) != 0) {
+        printf("StatusPoller: lower the thread priority Error\n");
+    }
+    LidarStatusSnapshot snapshot = {};
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_cond.wait_for(lock, std::chrono::milliseconds(m_intervalMs), [this] { return m_stop; })) {
+        lock.unlock();
+        poll(snapshot);
+        m_snapshot.store(snapshot);
+        lock.lock();
+    }
+}
+
+void StatusPoller::poll(LidarStatusSnapshot& snapshot)
+{
+    snapshot.version++;
+    dwContext_getCurrentTime(&snapshot.hostTime, m_ctx);
+
+    unsigned char* buffer = NULL;
+    unsigned int len = 0;
+    snapshot.ptcValid = false;
+    if (m_ptcClient != nullptr && TcpCommandGetLidarStatus(m_ptcClient, &buffer, &len) == PTC_ERROR_NO_ERROR &&
+        buffer != NULL && len >= sizeof(PtcLidarStatus)) {
+        PtcLidarStatus status;
+        memcpy(&status, buffer, sizeof(status));
+        snapshot.ptcValid      = true;
+        snapshot.uptimeS       = ntohl(status.systemUptime);
+        snapshot.motorSpeedRpm = ntohs(status.motorSpeed);
+        for (int i = 0; i < 8; i++) {
+            snapshot.temperatureC[i] = static_cast<int32_t>(ntohl(status.temperature[i])) / 100.0f;
+        }
+        snapshot.gpsPpsLock        = status.gpsPpsLock;
+        snapshot.gpsGprmcStatus    = status.gpsGprmcStatus;
+        snapshot.ptpClockStatus    = status.ptpClockStatus;
+        snapshot.startupTimes      = ntohl(status.startupTimes);
+        snapshot.totalOperationMin = ntohl(status.totalOperationTime);
+    }
+    free(buffer);
+
+    snapshot.tailValid = false;
+    if (m_sampleReady.load(std::memory_order_acquire)) {
+        TailStatus tail;
+        snapshot.tailValid = m_parser->ParseTailStatus(m_sample.m_u8Buf, m_sampleLen, tail);
+        if (snapshot.tailValid) {
+            snapshot.tail = tail;
+        }
+        m_sampleReady.store(false, std::memory_order_relaxed);
+        // the receive side owns the sample again
+        m_sampleWanted.store(true, std::memory_order_release);
+    }
+}
+
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
@@ -20,6 +20,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <pthread.h>
 #include <setjmp.h>
 #include <signal.h>
@@ -81,51 +82,84 @@ static int tcpCommandHeaderParser(unsigned char* buffer, TcpCommandHeader* heade
   return 0;
 }
 
-static int tcpCommandReadCommand(int connfd, TC_Command* cmd) {
-  int ret = 0;
-  if (!cmd) {
-    return -1;
-  }
-  memset(cmd, 0, sizeof(TC_Command));
-  unsigned char buffer[1500];
-  ret = sys_readn(connfd, buffer, 2);
-  if (ret <= 0 || buffer[0] != 0x47 || buffer[1] != 0x74) {
-    printf("Server Read failed\n");
-    return -1;
-  }
-
-  ret = sys_readn(connfd, buffer + 2, 6);
-  if (ret != 6) {
+// Read the 8 byte header and the payload of one reply. A buffer is malloced with a terminating zero if
+// reply->buffer is NULL, a payload larger than the caller buffer is drained and reported as no memory
+static PTC_ErrCode tcpCommandReadReply(int connfd, TcpCommandReply* reply) {
+  unsigned char buffer[8];
+  int ret = sys_readn(connfd, buffer, 8);
+  if (ret != 8 || buffer[0] != 0x47 || buffer[1] != 0x74) {
     printf("Server Read failed\n");
-    return -1;
+    return PTC_ERROR_TRANSFER_FAILED;
   }
-
-  // print_mem(buffer, 8);
-
-  tcpCommandHeaderParser(buffer + 2, &cmd->header);
-
-  if (cmd->header.len > 0) {
-    cmd->data = malloc(cmd->header.len);
-    if (!cmd->data) {
+  TcpCommandHeader header;
+  tcpCommandHeaderParser(buffer + 2, &header);
+  reply->ret_code = header.ret_code;
+  reply->len = header.len;
+
+  int allocated = reply->buffer == NULL;
+  if (allocated) {
+    reply->buffer = malloc(header.len + 1);
+    if (!reply->buffer) {
       printf("malloc data error\n");
-      return -1;
+      return PTC_ERROR_TRANSFER_FAILED;
+    }
+    reply->capacity = header.len + 1;
+  } else if (header.len > reply->capacity) {
+    // keep the stream in step for the next reply
+    unsigned char drain[1024];
+    unsigned int left = header.len;
+    while (left > 0) {
+      int size = left < sizeof(drain) ? left : sizeof(drain);
+      if (sys_readn(connfd, drain, size) != size) {
+        printf("Server Read failed\n");
+        return PTC_ERROR_TRANSFER_FAILED;
+      }
+      left -= size;
     }
+    printf("Reply of command 0x%x is %u bytes, larger than the buffer\n", reply->cmd, header.len);
+    reply->status = PTC_ERROR_NO_MEMORY;
+    return PTC_ERROR_NO_ERROR;
   }
 
-  ret = sys_readn(connfd, cmd->data, cmd->header.len);
-  if (ret != cmd->header.len) {
-    free(cmd->data);
+  ret = sys_readn(connfd, reply->buffer, header.len);
+  if (ret != (int)header.len) {
+    if (allocated) {
+      // sized for this reply, the retry reads a new one
+      free(reply->buffer);
+      reply->buffer = NULL;
+      reply->capacity = 0;
+    }
     printf("Server Read failed\n");
-    return -1;
+    return PTC_ERROR_TRANSFER_FAILED;
   }
+  if (reply->capacity > header.len) {
+    reply->buffer[header.len] = '\0';
+  }
+  reply->status = PTC_ERROR_NO_ERROR;
+  return PTC_ERROR_NO_ERROR;
+}
 
-  // cmd->ret_size = cmd->header.len;
-
-  // print_mem(cmd->data, cmd->header.len);
-
+static int tcpCommandClientConnect(TcpCommandClient* client) {
+  if (client->fd >= 0) {
+    return 0;
+  }
+  client->fd = tcp_open(client->ip, client->port);
+  if (client->fd < 0) {
+    return -1;
+  }
+  // the requests are small and a reply is waited for, don't let Nagle hold them back
+  int noDelay = 1;
+  setsockopt(client->fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
   return 0;
 }
 
+static void tcpCommandClientDisconnect(TcpCommandClient* client) {
+  if (client->fd >= 0) {
+    close(client->fd);
+    client->fd = -1;
+  }
+}
+
 void BuildCmd(TC_Command command, PTC_COMMAND cmd, unsigned char* data){;
   // memset(&cmd, 0, sizeof(TC_Command));
   command.header.cmd = cmd;
@@ -151,10 +185,91 @@ static int TcpCommand_buildHeader(unsigned char* buffer, TC_Command* cmd) {
   return index;
 }
 
+// Whether the command only reads the lidar, so sending it again does no harm
+static int tcpCommandIsQuery(unsigned char cmd) {
+  switch (cmd) {
+    case PTC_COMMAND_GET_CALIBRATION:
+    case PTC_COMMAND_HEARTBEAT:
+    case PTC_COMMAND_GET_LIDAR_CALIBRATION:
+    case PTC_COMMAND_GET_LIDAR_CONFIG_INFO:
+    case PTC_COMMAND_GET_LIDAR_STATUS:
+    case PTC_COMMAND_GET_LIDAR_LENS_HEAT_SWITCH:
+    case PTC_COMMAND_GET_LIDAR_CHANNEL_CONFIG:
+    case PTC_COMMAND_GET_LIDAR_FIRETIMES:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+// Write the requests back to back, then read the replies in order on the persistent connection.
+// On a transfer error the connection is opened again once and the commands without reply are sent again,
+// only if all of them are queries: a set command may have been applied by the lidar before the reply was lost
+static PTC_ErrCode tcpCommandClientTransact(TcpCommandClient* client, TC_Command* cmds,
+                                            TcpCommandReply* replies, int num) {
+  int done = 0;
+  int retry = 1;
+  pthread_mutex_lock(&client->lock);
+  while (done < num) {
+    if (tcpCommandClientConnect(client) != 0) {
+      pthread_mutex_unlock(&client->lock);
+      printf("connect server failed\n");
+      return PTC_ERROR_CONNECT_SERVER_FAILED;
+    }
+
+    int size = 0;
+    for (int i = done; i < num; i++) {
+      size += 8 + cmds[i].header.len;
+    }
+    unsigned char stackBuffer[512];
+    unsigned char* buffer = size <= (int)sizeof(stackBuffer) ? stackBuffer : malloc(size);
+    if (!buffer) {
+      pthread_mutex_unlock(&client->lock);
+      return PTC_ERROR_NO_MEMORY;
+    }
+    int index = 0;
+    for (int i = done; i < num; i++) {
+      index += TcpCommand_buildHeader(buffer + index, &cmds[i]);
+      if (cmds[i].header.len > 0) {
+        memcpy(buffer + index, cmds[i].data, cmds[i].header.len);
+        index += cmds[i].header.len;
+      }
+    }
+    int ret = sys_writen(client->fd, buffer, size);
+    if (buffer != stackBuffer) {
+      free(buffer);
+    }
+
+    PTC_ErrCode errorCode = ret == size ? PTC_ERROR_NO_ERROR : PTC_ERROR_TRANSFER_FAILED;
+    while (errorCode == PTC_ERROR_NO_ERROR && done < num) {
+      errorCode = tcpCommandReadReply(client->fd, &replies[done]);
+      if (errorCode == PTC_ERROR_NO_ERROR) {
+        done++;
+      }
+    }
+    if (errorCode != PTC_ERROR_NO_ERROR) {
+      // the lidar may have closed an idle connection, the stream is out of step anyway
+      tcpCommandClientDisconnect(client);
+      int queries = 1;
+      for (int i = done; i < num; i++) {
+        queries = queries && tcpCommandIsQuery(cmds[i].header.cmd);
+      }
+      if (queries && retry-- > 0) {
+        continue;
+      }
+      pthread_mutex_unlock(&client->lock);
+      printf("Receive feed back failed!!!\n");
+      return PTC_ERROR_TRANSFER_FAILED;
+    }
+  }
+  pthread_mutex_unlock(&client->lock);
+  return PTC_ERROR_NO_ERROR;
+}
+
 static PTC_ErrCode tcpCommandClientSendCmdWithoutSecurity(TcpCommandClient* client,
                                             TC_Command* cmd) {
   // printf("tcpCommandClientSendCmdWithoutSecurity: ");
-  if (!client && !cmd) {
+  if (!client || !cmd) {
     printf("Bad Parameter\n");
     return PTC_ERROR_BAD_PARAMETER;
   }
@@ -163,54 +278,19 @@ static PTC_ErrCode tcpCommandClientSendCmdWithoutSecurity(TcpCommandClient* clie
     printf("Bad Parameter : payload is null\n");
     return PTC_ERROR_BAD_PARAMETER;
   }
-  pthread_mutex_lock(&client->lock);
-
-  int fd = tcp_open(client->ip, client->port);
-  if (fd < 0) {
-    pthread_mutex_unlock(&client->lock);
-     printf("connect server failed\n");
-    return PTC_ERROR_CONNECT_SERVER_FAILED;
-  }
-  unsigned char buffer[128];
-  int size = TcpCommand_buildHeader(buffer, cmd);
-
-  // print_mem(buffer, size);
-  int ret = write(fd, buffer, size);
-  if (ret != size) {
-    close(fd);
-    pthread_mutex_unlock(&client->lock);
-    printf("Write header error\n");
-    return PTC_ERROR_TRANSFER_FAILED;
-  }
-  if (cmd->header.len > 0 && cmd->data) {
-    // print_mem(cmd->data, cmd->header.len);
-    ret = write(fd, cmd->data, cmd->header.len);
-    if (ret != cmd->header.len) {
-      printf("Write Payload error\n");
-      close(fd);
-      pthread_mutex_unlock(&client->lock);
-      return PTC_ERROR_TRANSFER_FAILED;
-    }
-  }
 
-  TC_Command feedBack;
-  ret = tcpCommandReadCommand(fd, &feedBack);
-  if (ret != 0) {
-    printf("Receive feed back failed!!!\n");
-    close(fd);
-    pthread_mutex_unlock(&client->lock);
-    return PTC_ERROR_TRANSFER_FAILED;
+  TcpCommandReply reply;
+  memset(&reply, 0, sizeof(reply));
+  reply.cmd = cmd->header.cmd;
+  PTC_ErrCode errorCode = tcpCommandClientTransact(client, cmd, &reply, 1);
+  if (errorCode != PTC_ERROR_NO_ERROR) {
+    free(reply.buffer);
+    return errorCode;
   }
-  // printf("feed back : %d %d %d \n", feedBack.header.len ,
-  // cmd->header.ret_code,
-  //        cmd->header.cmd);
-
-  cmd->ret_data = feedBack.data;
-  cmd->ret_size = feedBack.header.len;
-  cmd->header.ret_code = feedBack.header.ret_code;
 
-  close(fd);
-  pthread_mutex_unlock(&client->lock);
+  cmd->ret_data = reply.buffer;
+  cmd->ret_size = reply.len;
+  cmd->header.ret_code = reply.ret_code;
   return PTC_ERROR_NO_ERROR;
 }
 
@@ -230,13 +310,8 @@ static PTC_ErrCode tcpCommandClient_RecieveCmd(TcpCommandClient *client, TC_Comm
     return errorCode;
   }
 
-  unsigned char* ret_str = (unsigned char*)malloc(cmd->ret_size + 1);
-  memcpy(ret_str, cmd->ret_data, cmd->ret_size);
-  ret_str[cmd->ret_size] = '\0';
-
-  free(cmd->ret_data);
-
-  *buffer = ret_str;
+  // the reply is read into a buffer with a terminating zero, hand it over as is
+  *buffer = cmd->ret_data;
   *len = cmd->ret_size + 1;
 
   return cmd->header.ret_code;
@@ -315,13 +390,7 @@ PTC_ErrCode TcpCommandGetCalibration(const void* handle, char** buffer,
     return errorCode;
   }
 
-  char* ret_str = (char*)malloc(cmd.ret_size + 1);
-  memcpy(ret_str, cmd.ret_data, cmd.ret_size);
-  ret_str[cmd.ret_size] = '\0';
-
-  free(cmd.ret_data);
-
-  *buffer = ret_str;
+  *buffer = (char*)cmd.ret_data;
   *len = cmd.ret_size + 1;
 
   return cmd.header.ret_code;
@@ -367,6 +436,49 @@ PTC_ErrCode TcpCommandGet(const void* handle, PTC_COMMAND command, unsigned char
   return errorCode;
 }
 
+PTC_ErrCode TcpCommandGetInto(const void* handle, PTC_COMMAND command, unsigned char* buffer,
+                              unsigned int capacity, unsigned int* len, unsigned char* retCode) {
+  if (!handle || !buffer || !len) {
+    printf("TcpCommandGetInto: Bad Parameter!!!\n");
+    return PTC_ERROR_BAD_PARAMETER;
+  }
+  TcpCommandReply reply;
+  memset(&reply, 0, sizeof(reply));
+  reply.cmd = command;
+  reply.buffer = buffer;
+  reply.capacity = capacity;
+  PTC_ErrCode errorCode = TcpCommandGetPipelined(handle, &reply, 1);
+  *len = reply.len;
+  if (retCode) {
+    *retCode = reply.ret_code;
+  }
+  return errorCode != PTC_ERROR_NO_ERROR ? errorCode : reply.status;
+}
+
+PTC_ErrCode TcpCommandGetPipelined(const void* handle, TcpCommandReply* replies, int num) {
+  if (!handle || !replies || num <= 0) {
+    printf("TcpCommandGetPipelined: Bad Parameter!!!\n");
+    return PTC_ERROR_BAD_PARAMETER;
+  }
+  TcpCommandClient* client = (TcpCommandClient*)handle;
+
+  TC_Command stackCmds[8];
+  TC_Command* cmds = num <= 8 ? stackCmds : malloc(sizeof(TC_Command) * num);
+  if (!cmds) {
+    return PTC_ERROR_NO_MEMORY;
+  }
+  memset(cmds, 0, sizeof(TC_Command) * num);
+  for (int i = 0; i < num; i++) {
+    cmds[i].header.cmd = replies[i].cmd;
+    replies[i].status = PTC_ERROR_TRANSFER_FAILED;
+  }
+  PTC_ErrCode errorCode = tcpCommandClientTransact(client, cmds, replies, num);
+  if (cmds != stackCmds) {
+    free(cmds);
+  }
+  return errorCode;
+}
+
 PTC_ErrCode TcpCommandSetLidarStandbyMode(const void* handle) {
   uint8_t buff[] = {1};
   return TcpCommandSet(handle, PTC_COMMAND_SET_LIDAR_OPERATE_MODE, buff, sizeof(buff));
@@ -436,6 +548,13 @@ PTC_ErrCode TcpCommandResetCalibration(const void* handle) {
 }
 
 void TcpCommandClientDestroy(const void* handle) {
-  (void) handle;
-  //do something?
+  if (!handle) {
+    return;
+  }
+  TcpCommandClient* client = (TcpCommandClient*)handle;
+  pthread_mutex_lock(&client->lock);
+  tcpCommandClientDisconnect(client);
+  pthread_mutex_unlock(&client->lock);
+  pthread_mutex_destroy(&client->lock);
+  free(client);
 }
\ No newline at end of file
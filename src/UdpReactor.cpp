@@ -0,0 +1,191 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+
+#include "UdpReactor.h"
+#include "HugePageAllocator.h"
+#include "StageStats.h"
+
+UdpChannel::UdpChannel(size_t capacity) : m_vPackets(capacity), m_vRecvTimes(capacity) {}
+
+size_t UdpChannel::ResidentBytes() const {
+    return HugePageResidentBytes(m_vPackets.data(), m_vPackets.capacity() * sizeof(UdpPacket)) +
+           HugePageResidentBytes(m_vRecvTimes.data(), m_vRecvTimes.capacity() * sizeof(uint64_t));
+}
+
+bool UdpChannel::Pop(UdpPacket *pkt, int timeout, uint64_t *recvTime) {
+    uint64_t head = m_u64Head.load(std::memory_order_relaxed);
+    if (m_u64Tail.load(std::memory_order_acquire) == head) {
+        if (timeout <= 0) return false;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        // the reactor only notifies while the flag is set, it checks the flag after it moves the tail
+        m_bWaiting.store(true);
+        bool ready = m_cond.wait_for(lock, std::chrono::milliseconds(timeout),
+                                     [this, head] { return m_u64Tail.load() != head; });
+        m_bWaiting.store(false);
+        if (!ready) return false;
+    }
+    const UdpPacket &slot = m_vPackets[head % m_vPackets.size()];
+    memcpy(pkt->m_u8Buf, slot.m_u8Buf, slot.m_i16Len);
+    pkt->m_i16Len = slot.m_i16Len;
+    if (recvTime != nullptr) *recvTime = m_vRecvTimes[head % m_vPackets.size()];
+    m_u64Head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+size_t UdpChannel::FreeNum() const {
+    return m_vPackets.size() - (m_u64Tail.load(std::memory_order_relaxed) - m_u64Head.load(std::memory_order_acquire));
+}
+
+void UdpChannel::Commit(size_t num) {
+    m_u64Tail.store(m_u64Tail.load(std::memory_order_relaxed) + num);
+    if (m_bWaiting.load()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cond.notify_one();
+    }
+}
+
+UdpReactor &UdpReactor::Instance() {
+    static UdpReactor reactor;
+    return reactor;
+}
+
+UdpReactor::~UdpReactor() {
+    if (m_bRunning.load()) Stop();
+}
+
+int UdpReactor::Register(int fd, std::shared_ptr<UdpChannel> channel) {
+    if (fd < 0 || channel == nullptr) return -1;
+    std::lock_guard<std::mutex> lifeLock(m_lifeMutex);
+    if (!m_bRunning.load()) {
+        Start();
+        if (!m_bRunning.load()) return -1;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(m_iEpollfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        printf("UdpReactor: Register fd %d error=%d(%s)\n", fd, errno, strerror(errno));
+        return -1;
+    }
+    m_mapChannels[fd] = channel;
+    return 0;
+}
+
+void UdpReactor::Unregister(int fd) {
+    std::lock_guard<std::mutex> lifeLock(m_lifeMutex);
+    bool empty = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_mapChannels.erase(fd) == 0) return;
+        epoll_ctl(m_iEpollfd, EPOLL_CTL_DEL, fd, nullptr);
+        empty = m_mapChannels.empty();
+    }
+    if (empty) Stop();
+}
+
+void UdpReactor::Start() {
+    m_iEpollfd = epoll_create1(EPOLL_CLOEXEC);
+    m_iEventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_iEpollfd < 0 || m_iEventfd < 0) {
+        perror("UdpReactor: epoll");
+        if (m_iEpollfd >= 0) close(m_iEpollfd);
+        if (m_iEventfd >= 0) close(m_iEventfd);
+        m_iEpollfd = m_iEventfd = -1;
+        return;
+    }
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = m_iEventfd;
+    epoll_ctl(m_iEpollfd, EPOLL_CTL_ADD, m_iEventfd, &event);
+    m_vDiscard.resize(UDP_REACTOR_BATCH_NUM);
+    m_bRunning.store(true);
+    m_thread = std::thread(&UdpReactor::Run, this);
+}
+
+void UdpReactor::Stop() {
+    m_bRunning.store(false);
+    uint64_t one = 1;
+    if (write(m_iEventfd, &one, sizeof(one)) < 0) perror("UdpReactor: eventfd");
+    if (m_thread.joinable()) m_thread.join();
+    close(m_iEventfd);
+    close(m_iEpollfd);
+    m_iEpollfd = m_iEventfd = -1;
+}
+
+void UdpReactor::Run() {
+    epoll_event events[16];
+    while (m_bRunning.load()) {
+        int num = epoll_wait(m_iEpollfd, events, 16, -1);
+        if (num < 0) {
+            if (errno == EINTR) continue;
+            printf("UdpReactor: epoll_wait error=%d(%s)\n", errno, strerror(errno));
+            break;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int i = 0; i < num; i++) {
+            int fd = events[i].data.fd;
+            if (fd == m_iEventfd) continue;
+            // the socket may be unregistered after epoll_wait returns
+            auto it = m_mapChannels.find(fd);
+            if (it != m_mapChannels.end()) Receive(fd, it->second.get());
+        }
+    }
+}
+
+void UdpReactor::Receive(int fd, UdpChannel *channel) {
+    // level triggered, a socket with more than one batch is served again in the next round.
+    // received into the ring, 'Pop' copies the packet into the slot of the sensor, see UdpReactor.h
+    mmsghdr msgs[UDP_REACTOR_BATCH_NUM];
+    iovec iovs[UDP_REACTOR_BATCH_NUM];
+    size_t num = std::min<size_t>(channel->FreeNum(), UDP_REACTOR_BATCH_NUM);
+    bool discard = num == 0;
+    if (discard) num = UDP_REACTOR_BATCH_NUM;
+    memset(msgs, 0, sizeof(msgs[0]) * num);
+    for (size_t i = 0; i < num; i++) {
+        UdpPacket *pkt = discard ? &m_vDiscard[i] : channel->Slot(i);
+        iovs[i].iov_base = pkt->m_u8Buf;
+        iovs[i].iov_len = sizeof(pkt->m_u8Buf);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int ret = recvmmsg(fd, msgs, num, MSG_DONTWAIT, nullptr);
+    if (ret <= 0) return;
+    if (discard) {
+        channel->m_u64Dropped.fetch_add(ret, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t now = dw::plugins::lidar::StageClockNs();
+    for (int i = 0; i < ret; i++) {
+        channel->Slot(i)->m_i16Len = static_cast<int16_t>(std::min<size_t>(msgs[i].msg_len, sizeof(UdpPacket().m_u8Buf)));
+        channel->m_vRecvTimes[channel->SlotIndex(i)] = now;
+    }
+    channel->Commit(ret);
+}
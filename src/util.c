@@ -73,7 +73,8 @@ int sys_writen(int fd, const void* vptr, int n) {
   ptr = vptr;
   nleft = n;
   while (nleft > 0) {
-    if ((nwritten = write(fd, ptr, nleft)) <= 0) {
+    // a socket closed by the peer fails with EPIPE instead of raising SIGPIPE
+    if ((nwritten = send(fd, ptr, nleft, MSG_NOSIGNAL)) <= 0) {
       if (nwritten < 0 && errno == EINTR)
         nwritten = 0; /* and call write() again */
       else
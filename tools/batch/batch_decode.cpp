@@ -0,0 +1,365 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Decode a whole recording offline into one columnar point cloud file per frame, e.g. to build a dataset. The frames
+// of the frame index are handed to worker threads, each one with its own reader and parser with the full
+// calibration, so the decode scales with the cores. Each frame is written as SoA x/y/z/intensity/ring/time, see
+// 'PointFrame', optionally compressed, and a manifest.json lists the frames
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameIndex.h"
+#include "ParserFactory.h"
+#include "PointFrame.h"
+#include "RecordReader.h"
+
+using namespace dw::plugins::lidar;
+using namespace dw::plugins::lidar::tools;
+
+namespace
+{
+struct Options
+{
+    std::string recording;
+    std::string output;
+    std::string index;
+    unsigned threads = 0;
+    ColumnCompression compression = ColumnCompression::NONE;
+    bool hasType   = false;
+    LidarType type = LidarType::P128;
+    uint16_t port  = 0;
+    std::string share = HESAI_SHARE_DIR;
+    std::string correction;
+    // leave out the cut frames at the start and the end
+    bool completeOnly = false;
+};
+
+// Outcome of one frame, filled by the worker which decoded it
+struct FrameResult
+{
+    bool written     = false;
+    uint32_t packets = 0;
+    uint32_t failed  = 0;
+    uint32_t points  = 0;
+    size_t bytes     = 0;
+};
+
+struct Worker
+{
+    uint64_t frames  = 0;
+    uint64_t packets = 0;
+    double seconds   = 0;
+    bool failed      = false;
+};
+
+void usage(const char* name)
+{
+    printf("Usage: %s [options] <recording> <output dir>\n"
+           "  The recording is a pcap or pcapng capture or a DriveWorks .bin recording of the plugin\n"
+           "  --threads <n>         worker threads, one per core by default\n"
+           "  --compress            deflate the columns, if built with zlib\n"
+           "  --index <file>        frame index of 'frame_index', <recording>.frames if it is there,\n"
+           "                        the recording is indexed first otherwise\n"
+           "  --lidar <type>        P128, QT128 or AT128, the type of the first point cloud packet by default\n"
+           "  --port <port>         only the datagrams of a capture sent to this port\n"
+           "  --share <dir>         folder of the correction and firetime files, default %s\n"
+           "  --correction <file>   correction file of the recorded lidar\n"
+           "  --complete-only       leave out the cut frames at the start and the end\n",
+           name, HESAI_SHARE_DIR);
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    static const struct option longOptions[] = {
+        {"threads", required_argument, nullptr, 't'},    {"compress", no_argument, nullptr, 'z'},
+        {"index", required_argument, nullptr, 'i'},      {"lidar", required_argument, nullptr, 'l'},
+        {"port", required_argument, nullptr, 'p'},       {"share", required_argument, nullptr, 'd'},
+        {"correction", required_argument, nullptr, 'c'}, {"complete-only", no_argument, nullptr, 'C'},
+        {"help", no_argument, nullptr, 'h'},             {nullptr, 0, nullptr, 0}};
+    int c;
+    while ((c = getopt_long(argc, argv, "h", longOptions, nullptr)) != -1) {
+        switch (c) {
+        case 't': options.threads = static_cast<unsigned>(atoi(optarg)); break;
+        case 'z': options.compression = ColumnCompression::ZLIB; break;
+        case 'i': options.index = optarg; break;
+        case 'l':
+            if (!ParseLidarType(optarg, options.type)) {
+                printf("unknown lidar type %s\n", optarg);
+                return false;
+            }
+            options.hasType = true;
+            break;
+        case 'p': options.port = static_cast<uint16_t>(atoi(optarg)); break;
+        case 'd': options.share = optarg; break;
+        case 'c': options.correction = optarg; break;
+        case 'C': options.completeOnly = true; break;
+        default: return false;
+        }
+    }
+    if (optind + 2 != argc) {
+        printf("a recording and an output folder are needed\n");
+        return false;
+    }
+    options.recording = argv[optind];
+    options.output    = argv[optind + 1];
+    if (!IsCompressionSupported(options.compression)) {
+        printf("built without zlib, --compress is not available\n");
+        return false;
+    }
+    if (options.threads == 0) {
+        options.threads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+    }
+    return true;
+}
+
+// The index of the recording from its file if it matches, built here otherwise
+bool loadIndex(const Options& options, RecordReader& reader, FrameIndex& index)
+{
+    std::string path = options.index.empty() ? FrameIndex::DefaultPath(options.recording) : options.index;
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && index.load(path)) {
+        if (index.recordSize() == reader.fileSize() && index.port() == options.port &&
+            (!options.hasType || index.lidarType() == options.type)) {
+            return true;
+        }
+        printf("%s is of another recording, lidar or port, indexing again\n", path.c_str());
+    } else if (!options.index.empty()) {
+        return false;
+    }
+    LidarType type = options.type;
+    RecordPacket packet;
+    bool found = options.hasType;
+    while (!found && reader.next(packet)) {
+        found = DetectLidarType(packet.data, packet.length, type);
+    }
+    if (!found) {
+        printf("no point cloud packet in %s\n", options.recording.c_str());
+        return false;
+    }
+    std::unique_ptr<GeneralParser> parser = CreateParser(type, options.share, options.correction);
+    return parser != nullptr && index.build(reader, type, options.port, *parser);
+}
+
+std::string framePath(const std::string& output, size_t frame)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "frame_%06zu.hspc", frame);
+    return output + "/" + name;
+}
+
+/**
+ * @brief Decode the frames handed out by the counter until none is left. The points without a return are left out,
+ * the ring is the laser id of the compact point
+ */
+void runWorker(const Options& options, const FrameIndex& index, std::atomic<size_t>& nextFrame,
+               std::vector<FrameResult>& results, Worker& worker)
+{
+    auto begin = std::chrono::steady_clock::now();
+    RecordReader reader;
+    std::unique_ptr<GeneralParser> parser = CreateParser(index.lidarType(), options.share, options.correction);
+    if (!reader.open(options.recording, options.port) || parser == nullptr) {
+        worker.failed = true;
+        return;
+    }
+    const size_t maxPoints = MAX_LASER_NUM * MAX_BLOCK_NUM;
+    std::vector<dwLidarPointXYZI> pointXYZI(maxPoints);
+    std::vector<dwLidarPointRTHI> pointRTHI(maxPoints);
+    std::vector<dwTime_t> pointTimestamp(maxPoints);
+    std::vector<CompactPoint> compactPoint(maxPoints);
+    PointExtraOutput extra;
+    extra.pointTimestamp = pointTimestamp.data();
+    extra.compactPoint   = compactPoint.data();
+    PointFrame frame;
+    size_t lastPoints = maxPoints;
+
+    for (size_t i = nextFrame.fetch_add(1); i < index.frameNum(); i = nextFrame.fetch_add(1)) {
+        const FrameEntry& entry = index.frame(i);
+        if (options.completeOnly && (entry.flags & FRAME_COMPLETE) == 0) {
+            continue;
+        }
+        if (!index.seekFrame(reader, i)) {
+            printf("frame %zu: seek Error\n", i);
+            worker.failed = true;
+            return;
+        }
+        FrameResult& result = results[i];
+        frame.clear();
+        frame.frameIndex  = static_cast<uint32_t>(i);
+        frame.lidarType   = static_cast<uint8_t>(index.lidarType());
+        frame.sensorTime  = entry.sensorTime;
+        frame.captureTime = entry.captureTime;
+        RecordPacket packet;
+        while (result.packets < entry.packetNum && reader.next(packet)) {
+            LidarType type;
+            if (!DetectLidarType(packet.data, packet.length, type) || type != index.lidarType()) {
+                continue;
+            }
+            result.packets++;
+            // AT128 leaves the points of the blocks out of its fields untouched
+            memset(pointRTHI.data(), 0, lastPoints * sizeof(dwLidarPointRTHI));
+            dwLidarDecodedPacket output;
+            memset(&output, 0, sizeof(output));
+            PacketDecodeInfo info;
+            if (parser->DecodePacket(&output, packet.data, packet.length, pointXYZI.data(), pointRTHI.data(), &extra,
+                                     nullptr, info) != DW_SUCCESS) {
+                result.failed++;
+                continue;
+            }
+            lastPoints = output.nPoints < maxPoints ? output.nPoints : maxPoints;
+            for (size_t k = 0; k < lastPoints; k++) {
+                if (pointRTHI[k].radius <= 0) {
+                    continue;
+                }
+                frame.x.push_back(pointXYZI[k].x);
+                frame.y.push_back(pointXYZI[k].y);
+                frame.z.push_back(pointXYZI[k].z);
+                frame.intensity.push_back(static_cast<uint8_t>(pointXYZI[k].intensity));
+                frame.ring.push_back(compactPoint[k].laserId);
+                frame.time.push_back(static_cast<int32_t>(pointTimestamp[k] - entry.sensorTime));
+            }
+        }
+        result.points = static_cast<uint32_t>(frame.size());
+        result.bytes  = WritePointFrame(framePath(options.output, i), frame, options.compression);
+        if (result.bytes == 0) {
+            worker.failed = true;
+            return;
+        }
+        result.written = true;
+        worker.frames++;
+        worker.packets += result.packets;
+    }
+    worker.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+bool writeManifest(const Options& options, const FrameIndex& index, const std::vector<FrameResult>& results)
+{
+    std::string path = options.output + "/manifest.json";
+    FILE* fp = fopen(path.c_str(), "w");
+    if (fp == nullptr) {
+        printf("write %s Error, %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"recording\": \"%s\",\n", options.recording.c_str());
+    fprintf(fp, "  \"lidar\": \"%s\",\n", LidarTypeName(index.lidarType()));
+    fprintf(fp, "  \"format\": \"hspc\",\n");
+    fprintf(fp, "  \"version\": 1,\n");
+    fprintf(fp, "  \"compression\": \"%s\",\n", ColumnCompressionName(options.compression));
+    fprintf(fp, "  \"columns\": [\n"
+                "    {\"name\": \"x\", \"type\": \"float32\", \"unit\": \"m\"},\n"
+                "    {\"name\": \"y\", \"type\": \"float32\", \"unit\": \"m\"},\n"
+                "    {\"name\": \"z\", \"type\": \"float32\", \"unit\": \"m\"},\n"
+                "    {\"name\": \"intensity\", \"type\": \"uint8\"},\n"
+                "    {\"name\": \"ring\", \"type\": \"uint8\"},\n"
+                "    {\"name\": \"time\", \"type\": \"int32\", \"unit\": \"us from sensor_time_us\"}\n"
+                "  ],\n");
+    fprintf(fp, "  \"frames\": [");
+    bool first = true;
+    for (size_t i = 0; i < results.size(); i++) {
+        if (!results[i].written) {
+            continue;
+        }
+        const FrameEntry& entry = index.frame(i);
+        fprintf(fp,
+                "%s\n    {\"frame\": %zu, \"file\": \"frame_%06zu.hspc\", \"sensor_time_us\": %lld, "
+                "\"capture_time_ns\": %lld, \"points\": %u, \"packets\": %u, \"failed_packets\": %u, "
+                "\"bytes\": %zu, \"complete\": %s}",
+                first ? "" : ",", i, i, static_cast<long long>(entry.sensorTime),
+                static_cast<long long>(entry.captureTime), results[i].points, results[i].packets, results[i].failed,
+                results[i].bytes, (entry.flags & FRAME_COMPLETE) != 0 ? "true" : "false");
+        first = false;
+    }
+    fprintf(fp, "\n  ]\n}\n");
+    if (fclose(fp) != 0) {
+        printf("write %s Error\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+    RecordReader reader;
+    if (!reader.open(options.recording, options.port)) {
+        return 1;
+    }
+    auto begin = std::chrono::steady_clock::now();
+    FrameIndex index;
+    if (!loadIndex(options, reader, index)) {
+        return 1;
+    }
+    double indexSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (mkdir(options.output.c_str(), 0755) != 0 && errno != EEXIST) {
+        printf("create folder %s Error, %s\n", options.output.c_str(), strerror(errno));
+        return 1;
+    }
+
+    begin = std::chrono::steady_clock::now();
+    std::vector<FrameResult> results(index.frameNum());
+    std::vector<Worker> workers(options.threads);
+    std::vector<std::thread> threads;
+    std::atomic<size_t> nextFrame{0};
+    for (unsigned i = 0; i < options.threads; i++) {
+        threads.emplace_back(runWorker, std::cref(options), std::cref(index), std::ref(nextFrame), std::ref(results),
+                             std::ref(workers[i]));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    uint64_t frames = 0, packets = 0, points = 0, bytes = 0, failed = 0;
+    for (const FrameResult& result : results) {
+        if (!result.written) continue;
+        frames++;
+        packets += result.packets;
+        points += result.points;
+        bytes += result.bytes;
+        failed += result.failed;
+    }
+    bool ok = writeManifest(options, index, results);
+    for (size_t i = 0; i < workers.size(); i++) {
+        ok = ok && !workers[i].failed;
+        printf("worker %zu: %llu frames, %.0f packets/s\n", i, static_cast<unsigned long long>(workers[i].frames),
+               workers[i].seconds > 0 ? workers[i].packets / workers[i].seconds : 0.0);
+    }
+    printf("%s: %s, %llu frames, %llu packets (%llu failed), %llu points in %.3f s with %u threads, "
+           "%.0f packets/s, %.1f Mpoints/s, %.1f MB written, index %.3f s\n",
+           options.recording.c_str(), LidarTypeName(index.lidarType()), static_cast<unsigned long long>(frames),
+           static_cast<unsigned long long>(packets), static_cast<unsigned long long>(failed),
+           static_cast<unsigned long long>(points), seconds, options.threads, packets / seconds,
+           points / seconds / 1e6, bytes / 1e6, indexSeconds);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,442 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Decode benchmark of the udp parsers without DriveWorks. Synthetic or captured packets of each lidar go
+// through 'ParserOnePacket', with and without the stage stats of 'parseData', then through the ByteQueue and
+// the BufferPool of the plugin and the copy out of the UdpChannel of the reactor. Reports ns per packet, points
+// per second, heap allocations and cache and TLB misses per packet. '--pages both' decodes again with the tables
+// and point buffers in 4 KB pages and reports the difference
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BufferPool.hpp"
+#include "ByteQueue.hpp"
+#include "HugePageAllocator.h"
+#include "InputSocket.h"
+#include "PacketGenerator.h"
+#include "ParserFactory.h"
+#include "PcapFile.h"
+#include "PerfCounter.h"
+#include "StageStats.h"
+#include "UdpReactor.h"
+
+using namespace dw::plugins::lidar;
+using namespace dw::plugins::lidar::tools;
+
+namespace
+{
+// raw packet slot of HesaiLidar, the udp packet behind the length and the host time
+struct RawSlot
+{
+    uint8_t rawData[sizeof(UdpPacket) + sizeof(uint32_t) + sizeof(dwTime_t)];
+};
+// slot count of the plugin when 'slot_count' is not given
+const size_t BENCH_SLOT_COUNT = 10;
+
+// Pages of the parser tables and the point buffers, see 'HugePageSetEnabled'
+enum class PageMode
+{
+    HUGE,
+    SMALL,
+    BOTH,
+};
+
+struct Options
+{
+    std::vector<LidarType> types;
+    std::string pcap;
+    int port = 0;
+    // synthetic packets per lidar, 0 for one spin
+    uint32_t packets = 0;
+    double seconds   = 1.0;
+    bool timestamps  = false;
+    PageMode pages    = PageMode::HUGE;
+    std::string share = HESAI_SHARE_DIR;
+};
+
+// Packets of one lidar, back to back in one buffer or pointing into a capture
+struct PacketSet
+{
+    std::vector<uint8_t> storage;
+    std::vector<const uint8_t*> data;
+    std::vector<size_t> length;
+    size_t bytes = 0;
+};
+
+struct Result
+{
+    uint64_t packets = 0;
+    uint64_t points  = 0;
+    uint64_t frames  = 0;
+    uint64_t failed  = 0;
+    double ns        = 0;
+    AllocCount alloc;
+    uint64_t llcMisses = 0;
+    uint64_t l1dMisses = 0;
+    uint64_t dtlbMisses = 0;
+};
+
+void usage(const char* name)
+{
+    printf("Usage: %s [options]\n"
+           "  --lidar <type>     P128, QT128 or AT128, may be repeated. All three by default\n"
+           "  --pcap <file>      replay the point cloud packets of a capture instead of synthetic ones\n"
+           "  --port <port>      only the datagrams of the capture sent to this port\n"
+           "  --packets <n>      synthetic packets per lidar, one spin by default\n"
+           "  --seconds <s>      minimum measured time of each case, default 1\n"
+           "  --timestamps       also fill the per-point timestamps\n"
+           "  --pages <mode>     huge, 4k or both, pages of the parser tables and point buffers. both decodes\n"
+           "                     twice and reports the dTLB misses and time the 4 KB pages add, default huge\n"
+           "  --share <dir>      folder of the correction and firetime files, default %s\n",
+           name, HESAI_SHARE_DIR);
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    static const struct option longOptions[] = {
+        {"lidar", required_argument, nullptr, 'l'},   {"pcap", required_argument, nullptr, 'f'},
+        {"port", required_argument, nullptr, 'p'},    {"packets", required_argument, nullptr, 'n'},
+        {"seconds", required_argument, nullptr, 's'}, {"timestamps", no_argument, nullptr, 't'},
+        {"share", required_argument, nullptr, 'd'},   {"pages", required_argument, nullptr, 'g'},
+        {"help", no_argument, nullptr, 'h'},          {nullptr, 0, nullptr, 0}};
+    int c;
+    while ((c = getopt_long(argc, argv, "h", longOptions, nullptr)) != -1) {
+        switch (c) {
+        case 'l': {
+            LidarType type;
+            if (!ParseLidarType(optarg, type)) {
+                printf("unknown lidar type %s\n", optarg);
+                return false;
+            }
+            options.types.push_back(type);
+            break;
+        }
+        case 'f': options.pcap = optarg; break;
+        case 'p': options.port = atoi(optarg); break;
+        case 'n': options.packets = static_cast<uint32_t>(strtoul(optarg, nullptr, 10)); break;
+        case 's': options.seconds = atof(optarg); break;
+        case 't': options.timestamps = true; break;
+        case 'd': options.share = optarg; break;
+        case 'g':
+            if (strcmp(optarg, "huge") == 0) {
+                options.pages = PageMode::HUGE;
+            } else if (strcmp(optarg, "4k") == 0) {
+                options.pages = PageMode::SMALL;
+            } else if (strcmp(optarg, "both") == 0) {
+                options.pages = PageMode::BOTH;
+            } else {
+                printf("unknown page mode %s\n", optarg);
+                return false;
+            }
+            break;
+        default: return false;
+        }
+    }
+    if (options.types.empty()) {
+        options.types = {LidarType::P128, LidarType::QT128, LidarType::AT128};
+    }
+    return true;
+}
+
+void generatePackets(LidarType type, uint32_t count, PacketSet& set)
+{
+    GeneratorConfig config;
+    config.type = type;
+    PacketGenerator generator(config);
+    if (count == 0) {
+        count = generator.packetsPerSpin();
+    }
+    size_t size = generator.packetSize();
+    set.storage.resize(static_cast<size_t>(count) * size);
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t* packet = set.storage.data() + i * size;
+        set.data.push_back(packet);
+        set.length.push_back(generator.next(packet));
+        set.bytes += size;
+    }
+}
+
+// Point cloud packets of a capture by lidar type, the payloads stay in the mapping
+void loadCapture(PcapFile& pcap, int port, std::vector<PacketSet>& sets)
+{
+    UdpDatagram datagram;
+    while (pcap.next(datagram)) {
+        LidarType type;
+        if ((port != 0 && datagram.dstPort != port) || !DetectLidarType(datagram.payload, datagram.length, type)) {
+            continue;
+        }
+        PacketSet& set = sets[static_cast<int>(type)];
+        set.data.push_back(datagram.payload);
+        set.length.push_back(datagram.length);
+        set.bytes += datagram.length;
+    }
+}
+
+// Repeat passes over the packets until the time is reached, the first pass is a warm up
+template <typename Pass>
+Result measure(const PacketSet& set, double seconds, PerfCounter& perf, Pass pass)
+{
+    Result result;
+    pass(result);
+    result = Result();
+    AllocCount allocBefore = GetAllocCount();
+    perf.start();
+    auto begin = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        pass(result);
+        result.packets += set.data.size();
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    } while (elapsed < seconds);
+    perf.stop();
+    AllocCount allocAfter = GetAllocCount();
+    result.ns          = elapsed * 1e9;
+    result.alloc.calls = allocAfter.calls - allocBefore.calls;
+    result.alloc.bytes = allocAfter.bytes - allocBefore.bytes;
+    result.llcMisses   = perf.llcMisses();
+    result.l1dMisses   = perf.l1dMisses();
+    result.dtlbMisses  = perf.dtlbMisses();
+    return result;
+}
+
+// The point buffers are in huge pages like the rings of the plugin, unless they are disabled
+Result benchParser(GeneralParser& parser, const PacketSet& set, const Options& options, PerfCounter& perf)
+{
+    HugePageArray<dwLidarPointXYZI> pointXYZI(MAX_LASER_NUM * MAX_BLOCK_NUM);
+    HugePageArray<dwLidarPointRTHI> pointRTHI(MAX_LASER_NUM * MAX_BLOCK_NUM);
+    HugePageArray<dwTime_t> pointTimestamp(MAX_LASER_NUM * MAX_BLOCK_NUM);
+    pointXYZI.Prefault();
+    pointRTHI.Prefault();
+    pointTimestamp.Prefault();
+    PointExtraOutput extra;
+    extra.pointTimestamp = options.timestamps ? pointTimestamp.data() : nullptr;
+    return measure(set, options.seconds, perf, [&](Result& result) {
+        dwLidarDecodedPacket output;
+        for (size_t i = 0; i < set.data.size(); i++) {
+            memset(&output, 0, sizeof(output));
+            dwStatus status = parser.ParserOnePacket(&output, set.data[i], set.length[i], pointXYZI.data(),
+                                                     pointRTHI.data(), &extra);
+            if (status != DW_SUCCESS) {
+                result.failed++;
+                continue;
+            }
+            result.points += output.nPoints;
+            result.frames += output.scanComplete;
+        }
+    });
+}
+
+// Same as above with the clock reads and recording of 'parseData', the difference is the cost of the stats
+Result benchParserStats(GeneralParser& parser, const PacketSet& set, const Options& options, PerfCounter& perf)
+{
+    std::vector<dwLidarPointXYZI> pointXYZI(MAX_LASER_NUM * MAX_BLOCK_NUM);
+    std::vector<dwLidarPointRTHI> pointRTHI(MAX_LASER_NUM * MAX_BLOCK_NUM);
+    std::vector<dwTime_t> pointTimestamp(MAX_LASER_NUM * MAX_BLOCK_NUM);
+    PointExtraOutput extra;
+    extra.pointTimestamp = options.timestamps ? pointTimestamp.data() : nullptr;
+    std::unique_ptr<StageStats> stats(new StageStats());
+    return measure(set, options.seconds, perf, [&](Result& result) {
+        dwLidarDecodedPacket output;
+        for (size_t i = 0; i < set.data.size(); i++) {
+            uint64_t parseStart = StageClockNs();
+            memset(&output, 0, sizeof(output));
+            dwStatus status = parser.ParserOnePacket(&output, set.data[i], set.length[i], pointXYZI.data(),
+                                                     pointRTHI.data(), &extra);
+            if (status != DW_SUCCESS) {
+                stats->countDecodeError();
+                result.failed++;
+            }
+            uint64_t parseEnd = StageClockNs();
+            stats->recordParse(parseEnd - parseStart, output.nPoints, output.scanComplete);
+            stats->recordStage(STAGE_RECEIVE_TO_PARSED, parseStart, parseEnd);
+            result.points += output.nPoints;
+            result.frames += output.scanComplete;
+        }
+    });
+}
+
+// 'pushData' and 'parseDataBuffer' of the plugin: whole udp packets through the byte queue
+Result benchByteQueue(const PacketSet& set, const Options& options, PerfCounter& perf)
+{
+    dw::plugin::common::ByteQueue queue(sizeof(UdpPacket));
+    UdpPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    return measure(set, options.seconds, perf, [&](Result&) {
+        for (size_t i = 0; i < set.data.size(); i++) {
+            memcpy(packet.m_u8Buf, set.data[i], set.length[i]);
+            packet.m_i16Len = static_cast<int16_t>(set.length[i]);
+            queue.enqueue(reinterpret_cast<const uint8_t*>(&packet), sizeof(packet));
+            // a few packets in flight, as driveworks pushes ahead of the decode
+            if (queue.size() > 4) {
+                const uint8_t* message = nullptr;
+                queue.peek(&message);
+                queue.dequeue();
+            }
+        }
+    });
+}
+
+// 'readRawData' and 'returnRawData' of the plugin: a slot per packet from the pool
+Result benchBufferPool(const PacketSet& set, const Options& options, PerfCounter& perf)
+{
+    dw::plugins::common::BufferPool<RawSlot> pool(BENCH_SLOT_COUNT);
+    return measure(set, options.seconds, perf, [&](Result& result) {
+        for (size_t i = 0; i < set.data.size(); i++) {
+            RawSlot* slot = nullptr;
+            if (!pool.get(slot, 1000)) {
+                result.failed++;
+                continue;
+            }
+            uint32_t length = static_cast<uint32_t>(set.length[i]);
+            memcpy(slot->rawData, &length, sizeof(length));
+            memcpy(slot->rawData + sizeof(uint32_t) + sizeof(dwTime_t), set.data[i], set.length[i]);
+            pool.put(slot);
+        }
+    });
+}
+
+// 'UdpChannel::Pop' of the reactor path: the packet is copied from the ring of the channel into the slot of
+// 'readRawData', on top of the copy of recvmmsg into the ring. The ring is filled before the measure
+Result benchChannelPop(const PacketSet& set, const Options& options, PerfCounter& perf)
+{
+    std::vector<UdpPacket> ring(UDP_CHANNEL_PACKET_NUM);
+    for (size_t i = 0; i < ring.size(); i++) {
+        size_t index = i % set.data.size();
+        memcpy(ring[i].m_u8Buf, set.data[index], set.length[index]);
+        ring[i].m_i16Len = static_cast<int16_t>(set.length[index]);
+    }
+    std::vector<RawSlot> slots(BENCH_SLOT_COUNT);
+    uint64_t head = 0;
+    return measure(set, options.seconds, perf, [&](Result&) {
+        for (size_t i = 0; i < set.data.size(); i++, head++) {
+            const UdpPacket& packet = ring[head % ring.size()];
+            UdpPacket* slot = reinterpret_cast<UdpPacket*>(slots[head % slots.size()].rawData + sizeof(uint32_t) +
+                                                           sizeof(dwTime_t));
+            memcpy(slot->m_u8Buf, packet.m_u8Buf, packet.m_i16Len);
+            slot->m_i16Len = packet.m_i16Len;
+        }
+    });
+}
+
+void printHeader(const PerfCounter& perf)
+{
+    printf("%-6s %-18s %9s %8s %11s %10s %9s %11s %11s %11s %11s\n", "lidar", "case", "packets", "bytes",
+           "ns/packet", "Mpoints/s", "frames", "alloc/pkt", "llc/pkt", "l1d/pkt", "dtlb/pkt");
+    if (!perf.llcAvailable() || !perf.l1dAvailable() || !perf.dtlbAvailable()) {
+        printf("(cache and TLB miss counters not available here, see kernel.perf_event_paranoid, shown as -)\n");
+    }
+}
+
+void printResult(LidarType type, const char* name, const PacketSet& set, const Result& result,
+                 const PerfCounter& perf)
+{
+    double packets = result.packets != 0 ? static_cast<double>(result.packets) : 1;
+    char rate[32] = "-";
+    char llc[32]  = "-";
+    char l1d[32]  = "-";
+    char dtlb[32] = "-";
+    if (result.points != 0) snprintf(rate, sizeof(rate), "%.2f", result.points / result.ns * 1e3);
+    if (perf.llcAvailable()) snprintf(llc, sizeof(llc), "%.2f", result.llcMisses / packets);
+    if (perf.l1dAvailable()) snprintf(l1d, sizeof(l1d), "%.2f", result.l1dMisses / packets);
+    if (perf.dtlbAvailable()) snprintf(dtlb, sizeof(dtlb), "%.3f", result.dtlbMisses / packets);
+    printf("%-6s %-18s %9zu %8zu %11.1f %10s %9lu %11.3f %11s %11s %11s\n", LidarTypeName(type), name,
+           set.data.size(), set.data.empty() ? 0 : set.bytes / set.data.size(), result.ns / packets,
+           rate, static_cast<unsigned long>(result.frames),
+           result.alloc.calls / packets, llc, l1d, dtlb);
+    if (result.failed != 0) {
+        printf("%-6s %-18s %lu packets failed to decode\n", "", "", static_cast<unsigned long>(result.failed));
+    }
+}
+
+// What the 4 KB pages add to the decode, per packet
+void printPageDelta(const Result& huge, const Result& small, const PerfCounter& perf)
+{
+    double hugePackets  = huge.packets != 0 ? static_cast<double>(huge.packets) : 1;
+    double smallPackets = small.packets != 0 ? static_cast<double>(small.packets) : 1;
+    char dtlb[32] = "-";
+    if (perf.dtlbAvailable()) {
+        snprintf(dtlb, sizeof(dtlb), "%+.3f", small.dtlbMisses / smallPackets - huge.dtlbMisses / hugePackets);
+    }
+    printf("%-6s %-18s 4 KB pages: dtlb/pkt %s, ns/packet %+.1f\n", "", "", dtlb,
+           small.ns / smallPackets - huge.ns / hugePackets);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<PacketSet> sets(3);
+    PcapFile pcap;
+    if (!options.pcap.empty()) {
+        if (!pcap.open(options.pcap)) {
+            return 1;
+        }
+        loadCapture(pcap, options.port, sets);
+    } else {
+        for (LidarType type : options.types) {
+            generatePackets(type, options.packets, sets[static_cast<int>(type)]);
+        }
+    }
+
+    PerfCounter perf;
+    printHeader(perf);
+    int ret = 0;
+    for (LidarType type : options.types) {
+        const PacketSet& set = sets[static_cast<int>(type)];
+        if (set.data.empty()) {
+            continue;
+        }
+        // the tables are mapped by the parser, the point buffers by the case
+        HugePageSetEnabled(options.pages != PageMode::SMALL);
+        std::unique_ptr<GeneralParser> parser = CreateParser(type, options.share);
+        if (parser == nullptr) {
+            ret = 1;
+            continue;
+        }
+        Result decode = benchParser(*parser, set, options, perf);
+        printResult(type, options.pages == PageMode::SMALL ? "ParserOnePacket/4k" : "ParserOnePacket", set, decode,
+                    perf);
+        if (options.pages == PageMode::BOTH) {
+            HugePageSetEnabled(false);
+            std::unique_ptr<GeneralParser> smallParser = CreateParser(type, options.share);
+            if (smallParser != nullptr) {
+                Result small = benchParser(*smallParser, set, options, perf);
+                printResult(type, "ParserOnePacket/4k", set, small, perf);
+                printPageDelta(decode, small, perf);
+            }
+            HugePageSetEnabled(true);
+        }
+        printResult(type, "+StageStats", set, benchParserStats(*parser, set, options, perf), perf);
+        printResult(type, "ByteQueue", set, benchByteQueue(set, options, perf), perf);
+        printResult(type, "BufferPool", set, benchBufferPool(set, options, perf), perf);
+        printResult(type, "UdpChannel::Pop", set, benchChannelPop(set, options, perf), perf);
+    }
+    return ret;
+}
@@ -0,0 +1,334 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Compress a recording losslessly, a pcap or pcapng capture or a DriveWorks .bin recording of the plugin, and
+// restore it bit for bit. The point cloud packets are coded by 'PacketEncoder', the bytes between them, the
+// record headers of the file and the other datagrams, go as plain items. Any other file is coded as plain
+// bytes, so the round trip always holds
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "PacketCodec.h"
+#include "RecordReader.h"
+
+using namespace dw::plugins::lidar::tools;
+
+namespace
+{
+const char FILE_MAGIC[4]    = {'H', 'S', 'P', 'Z'};
+const uint32_t FILE_VERSION = 1;
+// the bytes between two packets are cut in items of this size at most
+const size_t GAP_ITEM_BYTES = 64 * 1024;
+
+struct FileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t rawSize;
+};
+
+const char* LANE_NAMES[LANE_NUM] = {"meta", "xor", "azimuth", "dist_low", "dist_high", "intensity", "confidence"};
+
+struct Options
+{
+    std::string input;
+    std::string output;
+    bool decompress = false;
+    bool check      = false;
+    size_t chunkBytes = PACKET_CODEC_CHUNK_BYTES;
+};
+
+void usage(const char* name)
+{
+    printf("Usage: %s [options] <file>\n"
+           "  Compress a pcap or pcapng capture or a DriveWorks .bin recording of the plugin to <file>.hsz\n"
+           "  --decompress          restore <file>, a .hsz file, to <file> without the extension\n"
+           "  --output <file>       the file written\n"
+           "  --chunk <KB>          raw bytes of a chunk, default %d, larger ones compress a little better\n"
+           "  --check               compress and decompress in memory, compare the bytes, print the ratio and\n"
+           "                        the speed, no file is written\n",
+           name, PACKET_CODEC_CHUNK_BYTES / 1024);
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    static const struct option longOptions[] = {
+        {"decompress", no_argument, nullptr, 'd'}, {"output", required_argument, nullptr, 'o'},
+        {"chunk", required_argument, nullptr, 'k'}, {"check", no_argument, nullptr, 'c'},
+        {"help", no_argument, nullptr, 'h'},       {nullptr, 0, nullptr, 0}};
+    int c;
+    while ((c = getopt_long(argc, argv, "h", longOptions, nullptr)) != -1) {
+        switch (c) {
+        case 'd': options.decompress = true; break;
+        case 'o': options.output = optarg; break;
+        case 'k': options.chunkBytes = static_cast<size_t>(atol(optarg)) * 1024; break;
+        case 'c': options.check = true; break;
+        default: return false;
+        }
+    }
+    if (optind + 1 != argc) {
+        printf("one file is needed\n");
+        return false;
+    }
+    // the chunk header keeps its raw bytes in 32 bits
+    if (options.chunkBytes == 0 || options.chunkBytes > (1u << 30)) {
+        printf("the chunk is 1 KB to 1 GB\n");
+        return false;
+    }
+    options.input = argv[optind];
+    if (options.output.empty() && !options.check) {
+        const std::string ext = ".hsz";
+        if (!options.decompress) {
+            options.output = options.input + ext;
+        } else if (options.input.size() > ext.size() &&
+                   options.input.compare(options.input.size() - ext.size(), ext.size(), ext) == 0) {
+            options.output = options.input.substr(0, options.input.size() - ext.size());
+        } else {
+            printf("%s has no .hsz extension, --output is needed\n", options.input.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whole file mapped read only
+class MappedFile
+{
+public:
+    ~MappedFile()
+    {
+        if (m_data != nullptr) munmap(m_data, m_size);
+    }
+
+    bool open(const std::string& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            printf("open %s Error, %s\n", path.c_str(), strerror(errno));
+            if (fd >= 0) close(fd);
+            return false;
+        }
+        m_size = st.st_size;
+        if (m_size > 0) {
+            void* map = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map == MAP_FAILED) {
+                printf("mmap %s Error, %s\n", path.c_str(), strerror(errno));
+                close(fd);
+                return false;
+            }
+            m_data = static_cast<uint8_t*>(map);
+        }
+        close(fd);
+        return true;
+    }
+
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    uint8_t* m_data = nullptr;
+    size_t m_size   = 0;
+};
+
+/**
+ * @brief Compress a file, the chunks are given to 'sink' as they are made. The payloads of the point cloud
+ * packets are items of their own, the bytes between them are cut into plain items
+ */
+template <typename Sink>
+bool compress(const std::string& path, const MappedFile& file, PacketEncoder& encoder, Sink sink)
+{
+    std::vector<uint8_t> out;
+    uint64_t pos = 0;
+    auto addGap  = [&](uint64_t end) {
+        while (pos < end) {
+            size_t length = static_cast<size_t>(std::min<uint64_t>(end - pos, GAP_ITEM_BYTES));
+            encoder.add(file.data() + pos, length, out);
+            pos += length;
+        }
+    };
+    auto flush = [&]() {
+        bool ok = out.empty() || sink(out);
+        out.clear();
+        return ok;
+    };
+    RecordReader reader;
+    if (reader.open(path)) {
+        RecordPacket packet;
+        while (reader.next(packet)) {
+            // the packets come in file order, a payload can not go back
+            if (packet.dataOffset < pos || packet.dataOffset + packet.length > file.size()) {
+                continue;
+            }
+            addGap(packet.dataOffset);
+            encoder.add(file.data() + pos, packet.length, out);
+            pos += packet.length;
+            if (!flush()) return false;
+        }
+    } else {
+        printf("%s is coded as plain bytes\n", path.c_str());
+    }
+    addGap(file.size());
+    encoder.finish(out);
+    return flush();
+}
+
+bool decompress(const uint8_t* data, size_t size, PacketDecoder& decoder, std::vector<uint8_t>& raw)
+{
+    FileHeader header;
+    if (size < sizeof(header)) {
+        printf("not a compressed recording\n");
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION) {
+        printf("not a compressed recording\n");
+        return false;
+    }
+    raw.clear();
+    raw.reserve(header.rawSize);
+    std::vector<uint32_t> lengths;
+    for (size_t pos = sizeof(header); pos < size;) {
+        lengths.clear();
+        size_t used = decoder.decode(data + pos, size - pos, raw, lengths);
+        if (used == 0) {
+            printf("chunk at %zu is corrupted\n", pos);
+            return false;
+        }
+        pos += used;
+    }
+    if (raw.size() != header.rawSize) {
+        printf("%zu bytes decoded, %llu expected\n", raw.size(), static_cast<unsigned long long>(header.rawSize));
+        return false;
+    }
+    return true;
+}
+
+void printLanes(const PacketEncoder& encoder, uint64_t rawSize)
+{
+    printf("%12s %14s %8s\n", "lane", "bytes", "of raw");
+    for (int lane = 0; lane < LANE_NUM; lane++) {
+        uint64_t bytes = encoder.laneBytes()[lane];
+        printf("%12s %14llu %7.2f%%\n", LANE_NAMES[lane], static_cast<unsigned long long>(bytes),
+               rawSize > 0 ? 100.0 * bytes / rawSize : 0.0);
+    }
+}
+
+int runCheck(const Options& options, const MappedFile& file)
+{
+    PacketEncoder encoder(options.chunkBytes);
+    FileHeader header;
+    memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.rawSize = file.size();
+    std::vector<uint8_t> coded(reinterpret_cast<const uint8_t*>(&header),
+                               reinterpret_cast<const uint8_t*>(&header) + sizeof(header));
+    auto begin = std::chrono::steady_clock::now();
+    compress(options.input, file, encoder, [&](const std::vector<uint8_t>& chunk) {
+        coded.insert(coded.end(), chunk.begin(), chunk.end());
+        return true;
+    });
+    double encodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // repeated until the time is measurable, the output buffer is warm after the first pass
+    PacketDecoder decoder;
+    std::vector<uint8_t> raw;
+    int passes = 0;
+    double decodeSeconds = 0;
+    begin = std::chrono::steady_clock::now();
+    do {
+        if (!decompress(coded.data(), coded.size(), decoder, raw)) {
+            return 1;
+        }
+        passes++;
+        decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    } while (decodeSeconds < 0.5 && passes < 1000);
+    if (raw.size() != file.size() || memcmp(raw.data(), file.data(), file.size()) != 0) {
+        printf("%s: the round trip differs\n", options.input.c_str());
+        return 1;
+    }
+    printf("%s: %zu -> %zu bytes, ratio %.2f, encode %.1f MB/s, decode %.2f GB/s, identical\n",
+           options.input.c_str(), file.size(), coded.size(), static_cast<double>(file.size()) / coded.size(),
+           file.size() / encodeSeconds / 1e6, static_cast<double>(file.size()) * passes / decodeSeconds / 1e9);
+    printLanes(encoder, file.size());
+    return 0;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+    MappedFile file;
+    if (!file.open(options.input)) {
+        return 1;
+    }
+    if (options.check) {
+        return runCheck(options, file);
+    }
+
+    FILE* fp = fopen(options.output.c_str(), "wb");
+    if (fp == nullptr) {
+        printf("write %s Error, %s\n", options.output.c_str(), strerror(errno));
+        return 1;
+    }
+    bool ok;
+    if (options.decompress) {
+        PacketDecoder decoder;
+        std::vector<uint8_t> raw;
+        ok = decompress(file.data(), file.size(), decoder, raw) && fwrite(raw.data(), 1, raw.size(), fp) == raw.size();
+    } else {
+        FileHeader header;
+        memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FILE_VERSION;
+        header.rawSize = file.size();
+        uint64_t written = sizeof(header);
+        PacketEncoder encoder(options.chunkBytes);
+        ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+             compress(options.input, file, encoder, [&](const std::vector<uint8_t>& chunk) {
+                 written += chunk.size();
+                 return fwrite(chunk.data(), 1, chunk.size(), fp) == chunk.size();
+             });
+        if (ok) {
+            printf("%s: %zu -> %llu bytes, ratio %.2f\n", options.input.c_str(), file.size(),
+                   static_cast<unsigned long long>(written), static_cast<double>(file.size()) / written);
+        }
+    }
+    ok = fclose(fp) == 0 && ok;
+    if (!ok) {
+        printf("write %s Error\n", options.output.c_str());
+        unlink(options.output.c_str());
+        return 1;
+    }
+    return 0;
+}
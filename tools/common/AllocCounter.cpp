@@ -0,0 +1,155 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Replaces the global operator new and delete of the tool it is linked into, to count the allocations.
+// Kept out of the tools library, only the executables that report allocations link it
+
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+#include "PerfCounter.h"
+
+namespace
+{
+std::atomic<uint64_t> g_allocCalls{0};
+std::atomic<uint64_t> g_allocBytes{0};
+
+void* countedAlloc(size_t size)
+{
+    g_allocCalls.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    void* p = malloc(size != 0 ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* countedAlignedAlloc(size_t size, std::align_val_t align)
+{
+    g_allocCalls.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    size_t alignment = static_cast<size_t>(align);
+    void* p = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+} // namespace
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+AllocCount GetAllocCount()
+{
+    AllocCount count;
+    count.calls = g_allocCalls.load(std::memory_order_relaxed);
+    count.bytes = g_allocBytes.load(std::memory_order_relaxed);
+    return count;
+}
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+void* operator new(size_t size)
+{
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size)
+{
+    return countedAlloc(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return countedAlloc(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return countedAlloc(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new(size_t size, std::align_val_t align)
+{
+    return countedAlignedAlloc(size, align);
+}
+
+void* operator new[](size_t size, std::align_val_t align)
+{
+    return countedAlignedAlloc(size, align);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept
+{
+    free(p);
+}
@@ -0,0 +1,167 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "FrameIndex.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+namespace
+{
+const char INDEX_MAGIC[4]    = {'H', 'S', 'F', 'I'};
+const uint32_t INDEX_VERSION = 1;
+
+struct IndexHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint8_t lidarType;
+    uint8_t format;
+    uint16_t port;
+    uint32_t frameNum;
+    uint64_t recordSize;
+    uint64_t packetNum;
+};
+
+static_assert(sizeof(IndexHeader) == 32, "index header size");
+static_assert(sizeof(FrameEntry) == 32, "index entry size");
+} // namespace
+
+bool FrameIndex::build(RecordReader& reader, LidarType type, uint16_t port, GeneralParser& parser)
+{
+    m_frames.clear();
+    m_type       = type;
+    m_format     = reader.format();
+    m_port       = port;
+    m_packetNum  = 0;
+    m_recordSize = reader.fileSize();
+    reader.rewind();
+
+    RecordPacket packet;
+    dwLidarDecodedPacket output;
+    bool inFrame = false;
+    while (reader.next(packet)) {
+        LidarType packetType;
+        if (!DetectLidarType(packet.data, packet.length, packetType) || packetType != type) {
+            continue;
+        }
+        PacketDecodeInfo info;
+        int64_t sensorTime = 0;
+        // a packet that can not be read belongs to the frame but is not checked for the split, as a failed decode
+        if (!parser.ScanPacket(packet.data, packet.length, info, sensorTime)) {
+            info.splitAzimuthNum = 0;
+        }
+        if (!inFrame) {
+            FrameEntry entry;
+            entry.offset      = packet.offset;
+            entry.sensorTime  = sensorTime;
+            entry.captureTime = packet.captureTime;
+            m_frames.push_back(entry);
+            inFrame = true;
+        }
+        FrameEntry& frame = m_frames.back();
+        frame.packetNum++;
+        m_packetNum++;
+
+        memset(&output, 0, sizeof(output));
+        output.sensorTimestamp = sensorTime;
+        parser.SequencePacket(&output, info);
+        if (output.scanComplete) {
+            if (m_frames.size() > 1) frame.flags |= FRAME_COMPLETE;
+            inFrame = false;
+        }
+    }
+    reader.rewind();
+    return m_packetNum > 0;
+}
+
+bool FrameIndex::write(const std::string& path) const
+{
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr) {
+        printf("FrameIndex: write %s Error, %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    IndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version    = INDEX_VERSION;
+    header.lidarType  = static_cast<uint8_t>(m_type);
+    header.format     = static_cast<uint8_t>(m_format);
+    header.port       = m_port;
+    header.frameNum   = static_cast<uint32_t>(m_frames.size());
+    header.recordSize = m_recordSize;
+    header.packetNum  = m_packetNum;
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(m_frames.data(), sizeof(FrameEntry), m_frames.size(), fp) == m_frames.size();
+    ok = fclose(fp) == 0 && ok;
+    if (!ok) {
+        printf("FrameIndex: write %s Error\n", path.c_str());
+    }
+    return ok;
+}
+
+bool FrameIndex::load(const std::string& path)
+{
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (fp == nullptr) {
+        printf("FrameIndex: open %s Error, %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    IndexHeader header;
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1 &&
+              memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 && header.version == INDEX_VERSION &&
+              header.lidarType <= static_cast<uint8_t>(LidarType::AT128) &&
+              header.format <= static_cast<uint8_t>(RecordFormat::DW_RAW);
+    if (ok) {
+        m_frames.resize(header.frameNum);
+        ok = fread(m_frames.data(), sizeof(FrameEntry), m_frames.size(), fp) == m_frames.size();
+    }
+    fclose(fp);
+    if (!ok) {
+        printf("FrameIndex: %s is not a frame index of this version\n", path.c_str());
+        m_frames.clear();
+        return false;
+    }
+    m_type       = static_cast<LidarType>(header.lidarType);
+    m_format     = static_cast<RecordFormat>(header.format);
+    m_port       = header.port;
+    m_packetNum  = header.packetNum;
+    m_recordSize = header.recordSize;
+    return true;
+}
+
+bool FrameIndex::seekFrame(RecordReader& reader, size_t frame) const
+{
+    return frame < m_frames.size() && reader.seek(m_frames[frame].offset);
+}
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
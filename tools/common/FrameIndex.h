@@ -0,0 +1,119 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: tools</b>
+ *
+ * @b Description: Frame index of a recording, the file offset, times and packet count of each spin.
+ */
+
+#ifndef FRAME_INDEX_H
+#define FRAME_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "GeneralParser.h"
+#include "PacketGenerator.h"
+#include "RecordReader.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+// The frame starts after a frame split and ends with one, the first and the last frame of a recording are cut
+#define FRAME_COMPLETE (1u << 0)
+
+// One frame of a recording, 32 bytes in the index file
+struct FrameEntry
+{
+    // file offset of the record of its first packet, see 'RecordReader::seek'
+    uint64_t offset = 0;
+    // us, sensor time of its first packet
+    int64_t sensorTime = 0;
+    // ns, capture time of its first packet
+    int64_t captureTime = 0;
+    // packets of the lidar up to the one with 'scanComplete', included
+    uint32_t packetNum = 0;
+    uint32_t flags     = 0;
+};
+
+/**
+ * @brief Frames of one lidar in a recording, split like the plugin does: each packet goes through 'ScanPacket'
+ * then 'SequencePacket', the packet with 'scanComplete' ends its frame. The index file is a 32 byte header
+ * then the entries, so frame N of a file is at a known place without reading the others:
+ *   <recording>.frames
+ */
+class FrameIndex
+{
+public:
+    /**
+     * @brief Read the whole recording once, from its start
+     *
+     * @param parser a parser of the lidar type not used before, its frame split state is changed
+     * @param port the port the reader filters on, kept in the index
+     * @return false if no packet of the lidar type is found
+     */
+    bool build(RecordReader& reader, LidarType type, uint16_t port, GeneralParser& parser);
+
+    // false on a file error, the error is printed
+    bool write(const std::string& path) const;
+
+    // false if the file is missing or not an index, the error is printed
+    bool load(const std::string& path);
+
+    /**
+     * @brief Position a reader of the indexed recording at a frame, the next 'packetNum' packets of the lidar
+     * type are the frame. The reader also returns the packets of the other lidars of the recording, if any
+     */
+    bool seekFrame(RecordReader& reader, size_t frame) const;
+
+    size_t frameNum() const { return m_frames.size(); }
+    const FrameEntry& frame(size_t index) const { return m_frames[index]; }
+    LidarType lidarType() const { return m_type; }
+    RecordFormat format() const { return m_format; }
+    uint16_t port() const { return m_port; }
+    uint64_t packetNum() const { return m_packetNum; }
+    // size of the recording when it was indexed, to tell a stale index
+    uint64_t recordSize() const { return m_recordSize; }
+
+    static std::string DefaultPath(const std::string& recording) { return recording + ".frames"; }
+
+private:
+    std::vector<FrameEntry> m_frames;
+    LidarType m_type       = LidarType::P128;
+    RecordFormat m_format  = RecordFormat::PCAP;
+    uint16_t m_port        = 0;
+    uint64_t m_packetNum   = 0;
+    uint64_t m_recordSize  = 0;
+};
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // FRAME_INDEX_H
@@ -0,0 +1,828 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <algorithm>
+
+#include "HsLidarMeV4.h"
+#include "HsLidarQTV2.h"
+#include "HsLidarStV3.h"
+#include "PacketCodec.h"
+#include "PacketGenerator.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+// The fields are read and written as host integers, the host is little endian like the packets
+namespace
+{
+const uint32_t CHUNK_MAGIC     = 0x4b505348; // "HSPK"
+const size_t CHUNK_HEADER_SIZE = 16;
+// longer codes are flattened away, the decode table stays in L1
+const uint32_t HUFFMAN_MAX_BITS = 11;
+const size_t HUFFMAN_TABLE_SIZE = 1 << HUFFMAN_MAX_BITS;
+const size_t STREAM_NUM         = 4;
+// zeros after each stream, the decoder reads 8 bytes at a time
+const size_t STREAM_PAD = 8;
+// a lane of a corrupted chunk is not allocated beyond it
+const uint64_t LANE_MAX_BYTES = 1ULL << 31;
+
+enum ItemKind : uint8_t
+{
+    ITEM_RAW,
+    ITEM_ME_V4,
+    ITEM_QT_V2,
+    ITEM_ST_V3,
+};
+
+enum LaneMode : uint8_t
+{
+    LANE_STORED,
+    LANE_HUFFMAN,
+    // one byte value repeated
+    LANE_RUN,
+};
+
+// Point body of a packet, the blocks of azimuth then channel units
+struct BodyLayout
+{
+    size_t bodyOffset = 0;
+    size_t bodyEnd    = 0;
+    uint32_t blockNum = 0;
+    uint32_t laserNum = 0;
+    // 2, 3 with the fine azimuth of ST_V3
+    uint32_t azimuthBytes = 0;
+    // 3, 4 with the confidence
+    uint32_t unitSize = 0;
+};
+
+// The header of the packet is read, false if the packet is shorter than its body
+bool bodyLayout(uint8_t kind, const uint8_t* data, size_t length, BodyLayout& layout)
+{
+    const uint8_t* header = data + sizeof(HS_LIDAR_PRE_HEADER);
+    switch (kind) {
+    case ITEM_ME_V4: {
+        layout.bodyOffset = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_ME_V4);
+        if (length < layout.bodyOffset) return false;
+        const auto* pHeader  = reinterpret_cast<const HS_LIDAR_HEADER_ME_V4*>(header);
+        layout.blockNum      = pHeader->GetBlockNum();
+        layout.laserNum      = pHeader->GetLaserNum();
+        layout.azimuthBytes  = sizeof(HS_LIDAR_BODY_AZIMUTH_ME_V4);
+        layout.unitSize      = pHeader->HasConfidenceLevel() ? sizeof(HS_LIDAR_BODY_CHN_UNIT_ME_V4)
+                                                             : sizeof(HS_LIDAR_BODY_CHN_UNIT_NO_CONF_ME_V4);
+        break;
+    }
+    case ITEM_QT_V2: {
+        layout.bodyOffset = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_QT_V2);
+        if (length < layout.bodyOffset) return false;
+        const auto* pHeader  = reinterpret_cast<const HS_LIDAR_HEADER_QT_V2*>(header);
+        layout.blockNum      = pHeader->GetBlockNum();
+        layout.laserNum      = pHeader->GetLaserNum();
+        layout.azimuthBytes  = sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2);
+        layout.unitSize      = pHeader->HasConfidenceLevel() ? sizeof(HS_LIDAR_BODY_CHN_UNIT_QT_V2)
+                                                             : sizeof(HS_LIDAR_BODY_CHN_UNIT_NO_CONF_QT_V2);
+        break;
+    }
+    case ITEM_ST_V3: {
+        layout.bodyOffset = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_ST_V3);
+        if (length < layout.bodyOffset) return false;
+        const auto* pHeader  = reinterpret_cast<const HS_LIDAR_HEADER_ST_V3*>(header);
+        layout.blockNum      = pHeader->GetBlockNum();
+        layout.laserNum      = pHeader->GetLaserNum();
+        layout.azimuthBytes  = sizeof(HS_LIDAR_BODY_AZIMUTH_ST_V3) + sizeof(HS_LIDAR_BODY_FINE_AZIMUTH_ST_V3);
+        layout.unitSize      = sizeof(HS_LIDAR_BODY_CHN_NNIT_ST_V3);
+        break;
+    }
+    default:
+        return false;
+    }
+    layout.bodyEnd = layout.bodyOffset +
+                     static_cast<size_t>(layout.blockNum) * (layout.azimuthBytes + layout.unitSize * layout.laserNum);
+    return layout.bodyEnd <= length;
+}
+
+uint8_t itemKind(const uint8_t* data, size_t length, BodyLayout& layout)
+{
+    LidarType type;
+    if (!DetectLidarType(data, length, type)) {
+        return ITEM_RAW;
+    }
+    ItemKind kind = type == LidarType::P128 ? ITEM_ME_V4 : type == LidarType::QT128 ? ITEM_QT_V2 : ITEM_ST_V3;
+    return bodyLayout(kind, data, length, layout) ? kind : ITEM_RAW;
+}
+
+inline uint16_t zigzag(uint16_t delta)
+{
+    int16_t value = static_cast<int16_t>(delta);
+    return static_cast<uint16_t>(static_cast<uint16_t>(value) << 1) ^ static_cast<uint16_t>(value >> 15);
+}
+
+inline uint16_t unzigzag(uint16_t code)
+{
+    return static_cast<uint16_t>((code >> 1) ^ static_cast<uint16_t>(-static_cast<int16_t>(code & 1)));
+}
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value)
+{
+    value = 0;
+    for (uint32_t shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+inline void putU32(uint8_t* p, uint32_t value)
+{
+    memcpy(p, &value, sizeof(value));
+}
+
+inline uint32_t getU32(const uint8_t* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Huffman code lengths of the used symbols, two queues over the sorted counts. The counts are halved
+ * until no code is longer than HUFFMAN_MAX_BITS, which costs little as only rare symbols get longer codes
+ */
+void buildLengths(const uint32_t* counts, uint8_t* lengths)
+{
+    uint32_t scaled[256];
+    memcpy(scaled, counts, sizeof(scaled));
+    while (true) {
+        uint16_t symbols[256];
+        int n = 0;
+        for (int s = 0; s < 256; s++) {
+            if (scaled[s] != 0) symbols[n++] = static_cast<uint16_t>(s);
+        }
+        std::sort(symbols, symbols + n, [&](uint16_t a, uint16_t b) { return scaled[a] < scaled[b]; });
+        uint64_t weight[511];
+        int parent[511];
+        uint8_t depth[511];
+        for (int i = 0; i < n; i++) {
+            weight[i] = scaled[symbols[i]];
+        }
+        // the nodes are made in increasing weight, so they are a sorted queue too
+        int leaf = 0, node = n;
+        for (int next = n; next < 2 * n - 1; next++) {
+            int pick[2];
+            for (int& p : pick) {
+                p = leaf < n && (node >= next || weight[leaf] <= weight[node]) ? leaf++ : node++;
+            }
+            weight[next]                    = weight[pick[0]] + weight[pick[1]];
+            parent[pick[0]] = parent[pick[1]] = next;
+        }
+        depth[2 * n - 2] = 0;
+        uint8_t maxDepth = 0;
+        for (int i = 2 * n - 3; i >= 0; i--) {
+            depth[i] = depth[parent[i]] + 1;
+            maxDepth = std::max(maxDepth, depth[i]);
+        }
+        if (maxDepth <= HUFFMAN_MAX_BITS) {
+            memset(lengths, 0, 256);
+            for (int i = 0; i < n; i++) {
+                lengths[symbols[i]] = depth[i];
+            }
+            return;
+        }
+        for (uint32_t& count : scaled) {
+            if (count != 0) count = (count >> 1) | 1;
+        }
+    }
+}
+
+/**
+ * @brief Canonical codes of the lengths, bit reversed as the streams are read from the low bit
+ *
+ * @return false if the lengths are not a complete prefix code
+ */
+bool buildCodes(const uint8_t* lengths, uint16_t* codes)
+{
+    uint32_t lengthNum[HUFFMAN_MAX_BITS + 1] = {0};
+    for (int s = 0; s < 256; s++) {
+        if (lengths[s] > HUFFMAN_MAX_BITS) return false;
+        lengthNum[lengths[s]]++;
+    }
+    lengthNum[0] = 0;
+    uint32_t next[HUFFMAN_MAX_BITS + 1] = {0};
+    uint32_t code  = 0;
+    uint32_t kraft = 0;
+    for (uint32_t bits = 1; bits <= HUFFMAN_MAX_BITS; bits++) {
+        code       = (code + lengthNum[bits - 1]) << 1;
+        next[bits] = code;
+        kraft += lengthNum[bits] << (HUFFMAN_MAX_BITS - bits);
+    }
+    if (kraft != HUFFMAN_TABLE_SIZE) {
+        return false;
+    }
+    for (int s = 0; s < 256; s++) {
+        uint32_t length = lengths[s];
+        if (length == 0) continue;
+        uint32_t value    = next[length]++;
+        uint32_t reversed = 0;
+        for (uint32_t i = 0; i < length; i++) {
+            reversed |= ((value >> i) & 1) << (length - 1 - i);
+        }
+        codes[s] = static_cast<uint16_t>(reversed);
+    }
+    return true;
+}
+
+void writeStream(const uint8_t* src, size_t n, const uint16_t* codes, const uint8_t* lengths, std::vector<uint8_t>& out)
+{
+    size_t start = out.size();
+    out.resize(start + (n * HUFFMAN_MAX_BITS + 7) / 8 + sizeof(uint32_t) + STREAM_PAD);
+    uint8_t* p   = out.data() + start;
+    uint64_t acc = 0;
+    uint32_t bits = 0;
+    for (size_t i = 0; i < n; i++) {
+        acc |= static_cast<uint64_t>(codes[src[i]]) << bits;
+        bits += lengths[src[i]];
+        if (bits >= 32) {
+            putU32(p, static_cast<uint32_t>(acc));
+            p += 4;
+            acc >>= 32;
+            bits -= 32;
+        }
+    }
+    for (; bits > 0; bits = bits > 8 ? bits - 8 : 0) {
+        *p++ = static_cast<uint8_t>(acc);
+        acc >>= 8;
+    }
+    memset(p, 0, STREAM_PAD);
+    out.resize(p + STREAM_PAD - out.data());
+}
+
+void encodeLane(const uint8_t* src, size_t n, std::vector<uint8_t>& out)
+{
+    putVarint(out, n);
+    if (n == 0) {
+        return;
+    }
+    uint32_t counts[256] = {0};
+    for (size_t i = 0; i < n; i++) {
+        counts[src[i]]++;
+    }
+    if (counts[src[0]] == n) {
+        out.push_back(LANE_RUN);
+        out.push_back(src[0]);
+        return;
+    }
+    uint8_t lengths[256];
+    uint16_t codes[256];
+    buildLengths(counts, lengths);
+    buildCodes(lengths, codes);
+    uint64_t bits = 0;
+    for (int s = 0; s < 256; s++) {
+        bits += static_cast<uint64_t>(counts[s]) * lengths[s];
+    }
+    if (128 + STREAM_NUM * (sizeof(uint32_t) + STREAM_PAD + 1) + bits / 8 >= n) {
+        out.push_back(LANE_STORED);
+        out.insert(out.end(), src, src + n);
+        return;
+    }
+    out.push_back(LANE_HUFFMAN);
+    for (int s = 0; s < 256; s += 2) {
+        out.push_back(static_cast<uint8_t>(lengths[s] | lengths[s + 1] << 4));
+    }
+    const size_t quarter = (n + STREAM_NUM - 1) / STREAM_NUM;
+    size_t sizeAt = out.size();
+    out.resize(sizeAt + STREAM_NUM * sizeof(uint32_t));
+    for (size_t k = 0; k < STREAM_NUM; k++) {
+        size_t begin = std::min(n, k * quarter);
+        size_t end   = std::min(n, begin + quarter);
+        size_t at    = out.size();
+        writeStream(src + begin, end - begin, codes, lengths, out);
+        putU32(out.data() + sizeAt + k * sizeof(uint32_t), static_cast<uint32_t>(out.size() - at));
+    }
+}
+
+// Bit position in one stream, the next code is in the low bits of the 8 bytes at 'pos / 8'
+struct BitStream
+{
+    const uint8_t* data;
+    size_t size;
+    uint64_t pos;
+    // symbols written and left
+    uint8_t* out;
+    size_t count;
+};
+
+/**
+ * @brief Decode tables of a lane, indexed by the next HUFFMAN_MAX_BITS bits. 'single' has the symbol and its
+ * length, 'pair' up to two symbols whose codes fit in the index, their bits and their count. The residuals
+ * have short codes, most lookups of 'pair' give two symbols
+ */
+struct DecodeTable
+{
+    uint16_t single[HUFFMAN_TABLE_SIZE];
+    uint32_t pair[HUFFMAN_TABLE_SIZE];
+
+    void build(const uint8_t* lengths, const uint16_t* codes)
+    {
+        for (int s = 0; s < 256; s++) {
+            for (uint32_t fill = codes[s]; lengths[s] != 0 && fill < HUFFMAN_TABLE_SIZE; fill += 1u << lengths[s]) {
+                single[fill] = static_cast<uint16_t>(s | lengths[s] << 8);
+            }
+        }
+        for (uint32_t index = 0; index < HUFFMAN_TABLE_SIZE; index++) {
+            uint32_t first  = single[index];
+            uint32_t bits   = first >> 8;
+            uint32_t second = single[index >> bits];
+            pair[index]     = (second >> 8) <= HUFFMAN_MAX_BITS - bits
+                                  ? (first & 0xff) | (second & 0xff) << 8 | (bits + (second >> 8)) << 16 | 2u << 24
+                                  : (first & 0xff) | bits << 16 | 1u << 24;
+        }
+    }
+};
+
+inline uint64_t load64(const uint8_t* p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Near the end of a stream, the bytes past it read as zero
+inline uint8_t decodeChecked(BitStream& stream, const DecodeTable& table)
+{
+    uint64_t value = 0;
+    size_t byte    = stream.pos >> 3;
+    if (byte < stream.size) {
+        memcpy(&value, stream.data + byte, std::min<size_t>(8, stream.size - byte));
+    }
+    uint16_t entry = table.single[(value >> (stream.pos & 7)) & (HUFFMAN_TABLE_SIZE - 1)];
+    stream.pos += entry >> 8;
+    return static_cast<uint8_t>(entry);
+}
+
+// The symbols left near the end of a stream
+void decodeTail(BitStream& stream, const DecodeTable& table)
+{
+    for (; stream.count > 0; stream.count--) {
+        *stream.out++ = decodeChecked(stream, table);
+    }
+}
+
+// Lookups of each stream per refill of its bit buffer, a refill gives at least 56 bits
+const size_t REFILL_LOOKUPS = 56 / HUFFMAN_MAX_BITS;
+
+// Refills of the bit buffer before the 8 byte load reaches the end of a stream, each one moves at most 7 bytes
+inline size_t safeRefills(const BitStream& stream)
+{
+    size_t byte = stream.pos >> 3;
+    return stream.size >= byte + 8 ? (stream.size - byte - 8) / 7 : 0;
+}
+
+// Bit buffer of the fast path, the low bits are the next ones
+struct BitReader
+{
+    const uint8_t* ptr;
+    uint64_t bits;
+    uint32_t count;
+    uint8_t* out;
+
+    explicit BitReader(const BitStream& stream)
+    {
+        uint32_t skip = stream.pos & 7;
+        ptr           = stream.data + (stream.pos >> 3) + 7;
+        bits          = load64(ptr - 7) >> skip;
+        count         = 56 - skip;
+        out           = stream.out;
+    }
+
+    inline void refill()
+    {
+        bits |= load64(ptr) << count;
+        ptr += (63 - count) >> 3;
+        count |= 56;
+    }
+
+    // Both bytes are written, the second one is overwritten next if it is not a symbol
+    inline void decode(const uint32_t* pair)
+    {
+        uint32_t entry = pair[bits & (HUFFMAN_TABLE_SIZE - 1)];
+        uint16_t symbols = static_cast<uint16_t>(entry);
+        memcpy(out, &symbols, sizeof(symbols));
+        out += entry >> 24;
+        bits >>= (entry >> 16) & 0xff;
+        count -= (entry >> 16) & 0xff;
+    }
+
+    void store(BitStream& stream) const
+    {
+        stream.pos = static_cast<uint64_t>(ptr - stream.data) * 8 - count;
+        stream.count -= out - stream.out;
+        stream.out = out;
+    }
+};
+
+void decodeStreams(BitStream* streams, const DecodeTable& table)
+{
+    // the bounds of a batch are loose, a few batches get near the end of the streams
+    while (true) {
+        // a round writes up to two bytes per lookup, one symbol is kept in reserve so the second byte
+        // stays in the stream
+        size_t rounds = SIZE_MAX;
+        for (size_t k = 0; k < STREAM_NUM; k++) {
+            size_t symbols = streams[k].count > 0 ? (streams[k].count - 1) / (2 * REFILL_LOOKUPS) : 0;
+            rounds         = std::min(rounds, std::min(symbols, safeRefills(streams[k])));
+        }
+        if (rounds < 4) break;
+        // four independent chains, each bit buffer is refilled once for several lookups, the refill adds the
+        // whole bytes that fit and the bits past them are read again by the next one. Plain locals, so the
+        // buffers stay in registers
+        BitReader r0(streams[0]), r1(streams[1]), r2(streams[2]), r3(streams[3]);
+        for (size_t round = 0; round < rounds; round++) {
+            r0.refill();
+            r1.refill();
+            r2.refill();
+            r3.refill();
+            for (size_t i = 0; i < REFILL_LOOKUPS; i++) {
+                r0.decode(table.pair);
+                r1.decode(table.pair);
+                r2.decode(table.pair);
+                r3.decode(table.pair);
+            }
+        }
+        r0.store(streams[0]);
+        r1.store(streams[1]);
+        r2.store(streams[2]);
+        r3.store(streams[3]);
+    }
+    for (size_t k = 0; k < STREAM_NUM; k++) {
+        decodeTail(streams[k], table);
+    }
+}
+
+bool decodeLane(const uint8_t*& p, const uint8_t* end, std::vector<uint8_t>& lane)
+{
+    uint64_t n;
+    if (!getVarint(p, end, n) || n > LANE_MAX_BYTES) {
+        return false;
+    }
+    lane.resize(n);
+    if (n == 0) {
+        return true;
+    }
+    if (p >= end) {
+        return false;
+    }
+    uint8_t mode = *p++;
+    if (mode == LANE_STORED) {
+        if (static_cast<uint64_t>(end - p) < n) return false;
+        memcpy(lane.data(), p, n);
+        p += n;
+        return true;
+    }
+    if (mode == LANE_RUN) {
+        if (p >= end) return false;
+        memset(lane.data(), *p++, n);
+        return true;
+    }
+    if (mode != LANE_HUFFMAN || static_cast<size_t>(end - p) < 128 + STREAM_NUM * sizeof(uint32_t)) {
+        return false;
+    }
+    uint8_t lengths[256];
+    for (int s = 0; s < 256; s += 2) {
+        lengths[s]     = *p & 0x0f;
+        lengths[s + 1] = *p >> 4;
+        p++;
+    }
+    uint16_t codes[256];
+    if (!buildCodes(lengths, codes)) {
+        return false;
+    }
+    DecodeTable table;
+    table.build(lengths, codes);
+    const size_t quarter = (n + STREAM_NUM - 1) / STREAM_NUM;
+    BitStream streams[STREAM_NUM];
+    const uint8_t* data = p + STREAM_NUM * sizeof(uint32_t);
+    for (size_t k = 0; k < STREAM_NUM; k++) {
+        size_t begin = std::min<size_t>(n, k * quarter);
+        streams[k].size  = getU32(p + k * sizeof(uint32_t));
+        streams[k].data  = data;
+        streams[k].pos   = 0;
+        streams[k].out   = lane.data() + begin;
+        streams[k].count = std::min<size_t>(n, begin + quarter) - begin;
+        if (static_cast<size_t>(end - data) < streams[k].size) return false;
+        data += streams[k].size;
+    }
+    p = data;
+    decodeStreams(streams, table);
+    for (const BitStream& stream : streams) {
+        if (stream.pos > stream.size * 8) return false;
+    }
+    return true;
+}
+
+// Read position in a decoded lane
+struct LaneReader
+{
+    const uint8_t* p;
+    const uint8_t* end;
+
+    bool has(size_t n) const { return static_cast<size_t>(end - p) >= n; }
+};
+} // namespace
+
+PacketEncoder::PacketEncoder(size_t chunkBytes)
+    : m_chunkBytes(chunkBytes)
+{
+    reset();
+}
+
+void PacketEncoder::reset()
+{
+    for (std::vector<uint8_t>& lane : m_lanes) {
+        lane.clear();
+    }
+    m_itemNum  = 0;
+    m_rawBytes = 0;
+    m_prevPacket.clear();
+    m_prevRaw.clear();
+    memset(m_distance, 0, sizeof(m_distance));
+    memset(m_intensity, 0, sizeof(m_intensity));
+    memset(m_confidence, 0, sizeof(m_confidence));
+    m_azimuth[0]  = 0;
+    m_azimuth[1]  = 0;
+    m_fineAzimuth = 0;
+}
+
+void PacketEncoder::add(const uint8_t* data, size_t length, std::vector<uint8_t>& out)
+{
+    BodyLayout layout;
+    const uint8_t kind = itemKind(data, length, layout);
+    m_lanes[LANE_META].push_back(kind);
+    putVarint(m_lanes[LANE_META], length);
+    std::vector<uint8_t>& prev = kind == ITEM_RAW ? m_prevRaw : m_prevPacket;
+    const uint8_t* ref         = prev.size() == length ? prev.data() : nullptr;
+    std::vector<uint8_t>& xorLane = m_lanes[LANE_XOR];
+    auto putXor = [&](size_t begin, size_t end) {
+        size_t at = xorLane.size();
+        xorLane.resize(at + end - begin);
+        uint8_t* dst = xorLane.data() + at - begin;
+        if (ref == nullptr) {
+            memcpy(dst + begin, data + begin, end - begin);
+            return;
+        }
+        for (size_t i = begin; i < end; i++) {
+            dst[i] = data[i] ^ ref[i];
+        }
+    };
+    if (kind == ITEM_RAW) {
+        putXor(0, length);
+    } else {
+        putXor(0, layout.bodyOffset);
+        putXor(layout.bodyEnd, length);
+        const size_t unitNum = static_cast<size_t>(layout.blockNum) * layout.laserNum;
+        const bool confidence = layout.unitSize > 3;
+        std::vector<uint8_t>& azimuthLane = m_lanes[LANE_AZIMUTH];
+        size_t at[LANE_NUM];
+        for (int lane = LANE_DIST_LOW; lane < LANE_NUM; lane++) {
+            at[lane] = m_lanes[lane].size();
+            if (lane != LANE_CONFIDENCE || confidence) m_lanes[lane].resize(at[lane] + unitNum);
+        }
+        uint8_t* low        = m_lanes[LANE_DIST_LOW].data() + at[LANE_DIST_LOW];
+        uint8_t* high       = m_lanes[LANE_DIST_HIGH].data() + at[LANE_DIST_HIGH];
+        uint8_t* intensity  = m_lanes[LANE_INTENSITY].data() + at[LANE_INTENSITY];
+        uint8_t* confidences = m_lanes[LANE_CONFIDENCE].data() + at[LANE_CONFIDENCE];
+        const uint8_t* block = data + layout.bodyOffset;
+        for (uint32_t b = 0; b < layout.blockNum; b++) {
+            uint16_t azimuth = static_cast<uint16_t>(block[0] | block[1] << 8);
+            uint16_t code = zigzag(static_cast<uint16_t>(azimuth - (2 * m_azimuth[0] - m_azimuth[1])));
+            azimuthLane.push_back(static_cast<uint8_t>(code));
+            azimuthLane.push_back(static_cast<uint8_t>(code >> 8));
+            if (layout.azimuthBytes > 2) {
+                azimuthLane.push_back(static_cast<uint8_t>(block[2] - m_fineAzimuth));
+                m_fineAzimuth = block[2];
+            }
+            m_azimuth[1] = m_azimuth[0];
+            m_azimuth[0] = azimuth;
+            const uint8_t* unit = block + layout.azimuthBytes;
+            for (uint32_t l = 0; l < layout.laserNum; l++, unit += layout.unitSize) {
+                uint16_t distance = static_cast<uint16_t>(unit[0] | unit[1] << 8);
+                code              = zigzag(static_cast<uint16_t>(distance - m_distance[l]));
+                *low++            = static_cast<uint8_t>(code);
+                *high++           = static_cast<uint8_t>(code >> 8);
+                *intensity++      = static_cast<uint8_t>(unit[2] - m_intensity[l]);
+                m_distance[l]     = distance;
+                m_intensity[l]    = unit[2];
+                if (confidence) {
+                    *confidences++  = static_cast<uint8_t>(unit[3] - m_confidence[l]);
+                    m_confidence[l] = unit[3];
+                }
+            }
+            block = unit;
+        }
+    }
+    prev.assign(data, data + length);
+    m_itemNum++;
+    m_rawBytes += length;
+    if (m_rawBytes >= m_chunkBytes) {
+        finish(out);
+    }
+}
+
+void PacketEncoder::finish(std::vector<uint8_t>& out)
+{
+    if (m_itemNum == 0) {
+        return;
+    }
+    size_t start = out.size();
+    out.resize(start + CHUNK_HEADER_SIZE);
+    for (int lane = 0; lane < LANE_NUM; lane++) {
+        size_t before = out.size();
+        encodeLane(m_lanes[lane].data(), m_lanes[lane].size(), out);
+        m_laneBytes[lane] += out.size() - before;
+    }
+    uint8_t* header = out.data() + start;
+    putU32(header, CHUNK_MAGIC);
+    putU32(header + 4, static_cast<uint32_t>(out.size() - start));
+    putU32(header + 8, m_itemNum);
+    putU32(header + 12, static_cast<uint32_t>(m_rawBytes));
+    reset();
+}
+
+size_t PacketDecoder::decode(const uint8_t* chunk, size_t size, std::vector<uint8_t>& data,
+                             std::vector<uint32_t>& lengths)
+{
+    if (size < CHUNK_HEADER_SIZE || getU32(chunk) != CHUNK_MAGIC) {
+        return 0;
+    }
+    const size_t chunkBytes = getU32(chunk + 4);
+    const uint32_t itemNum  = getU32(chunk + 8);
+    const size_t rawBytes   = getU32(chunk + 12);
+    if (chunkBytes < CHUNK_HEADER_SIZE || chunkBytes > size) {
+        return 0;
+    }
+    const uint8_t* p   = chunk + CHUNK_HEADER_SIZE;
+    const uint8_t* end = chunk + chunkBytes;
+    LaneReader lanes[LANE_NUM];
+    for (int lane = 0; lane < LANE_NUM; lane++) {
+        if (!decodeLane(p, end, m_lanes[lane])) return 0;
+        lanes[lane] = LaneReader{m_lanes[lane].data(), m_lanes[lane].data() + m_lanes[lane].size()};
+    }
+    if (p != end) {
+        return 0;
+    }
+
+    uint16_t distances[256]  = {0};
+    uint8_t intensities[256] = {0};
+    uint8_t confidences[256] = {0};
+    uint16_t azimuths[2]     = {0, 0};
+    uint8_t fineAzimuth      = 0;
+    // previous item of each class, as an offset as the output may be moved
+    size_t prevOffset[2] = {0, 0};
+    size_t prevLength[2] = {SIZE_MAX, SIZE_MAX};
+    const size_t base    = data.size();
+    data.reserve(base + rawBytes);
+    LaneReader& meta    = lanes[LANE_META];
+    LaneReader& xorLane = lanes[LANE_XOR];
+    for (uint32_t item = 0; item < itemNum; item++) {
+        uint64_t length;
+        if (!meta.has(1)) return 0;
+        const uint8_t kind = *meta.p++;
+        if (kind > ITEM_ST_V3 || !getVarint(meta.p, meta.end, length) || length > base + rawBytes - data.size()) {
+            return 0;
+        }
+        const int cls      = kind == ITEM_RAW ? 0 : 1;
+        const size_t at    = data.size();
+        data.resize(at + length);
+        uint8_t* dst       = data.data() + at;
+        const uint8_t* ref = prevLength[cls] == length ? data.data() + prevOffset[cls] : nullptr;
+        auto getXor = [&](size_t begin, size_t end) {
+            if (!xorLane.has(end - begin)) return false;
+            const uint8_t* src = xorLane.p - begin;
+            if (ref == nullptr) {
+                memcpy(dst + begin, src + begin, end - begin);
+            } else {
+                for (size_t i = begin; i < end; i++) {
+                    dst[i] = src[i] ^ ref[i];
+                }
+            }
+            xorLane.p += end - begin;
+            return true;
+        };
+        if (kind == ITEM_RAW) {
+            if (!getXor(0, length)) return 0;
+        } else {
+            // the header comes first, it tells the body
+            BodyLayout layout;
+            bodyLayout(kind, dst, 0, layout);
+            if (length < layout.bodyOffset || !getXor(0, layout.bodyOffset) || !bodyLayout(kind, dst, length, layout) ||
+                !getXor(layout.bodyEnd, length)) {
+                return 0;
+            }
+            const size_t unitNum  = static_cast<size_t>(layout.blockNum) * layout.laserNum;
+            const bool confidence = layout.unitSize > 3;
+            LaneReader& azimuthLane = lanes[LANE_AZIMUTH];
+            if (!azimuthLane.has(layout.blockNum * layout.azimuthBytes) || !lanes[LANE_DIST_LOW].has(unitNum) ||
+                !lanes[LANE_DIST_HIGH].has(unitNum) || !lanes[LANE_INTENSITY].has(unitNum) ||
+                (confidence && !lanes[LANE_CONFIDENCE].has(unitNum))) {
+                return 0;
+            }
+            const uint8_t* low       = lanes[LANE_DIST_LOW].p;
+            const uint8_t* high      = lanes[LANE_DIST_HIGH].p;
+            const uint8_t* intensity = lanes[LANE_INTENSITY].p;
+            const uint8_t* conf      = lanes[LANE_CONFIDENCE].p;
+            uint8_t* block           = dst + layout.bodyOffset;
+            for (uint32_t b = 0; b < layout.blockNum; b++) {
+                const uint8_t* a = azimuthLane.p;
+                uint16_t residual = unzigzag(static_cast<uint16_t>(a[0] | a[1] << 8));
+                uint16_t azimuth  = static_cast<uint16_t>(2 * azimuths[0] - azimuths[1] + residual);
+                block[0] = static_cast<uint8_t>(azimuth);
+                block[1] = static_cast<uint8_t>(azimuth >> 8);
+                if (layout.azimuthBytes > 2) {
+                    fineAzimuth = static_cast<uint8_t>(fineAzimuth + a[2]);
+                    block[2]    = fineAzimuth;
+                }
+                azimuthLane.p += layout.azimuthBytes;
+                azimuths[1] = azimuths[0];
+                azimuths[0] = azimuth;
+                uint8_t* unit = block + layout.azimuthBytes;
+                // the state of the channels first, these loops are vectorized, then the units are written
+                const uint32_t laserNum = layout.laserNum;
+                for (uint32_t l = 0; l < laserNum; l++) {
+                    uint16_t residual = unzigzag(static_cast<uint16_t>(low[l] | high[l] << 8));
+                    distances[l]      = static_cast<uint16_t>(distances[l] + residual);
+                    intensities[l]    = static_cast<uint8_t>(intensities[l] + intensity[l]);
+                }
+                low += laserNum;
+                high += laserNum;
+                intensity += laserNum;
+                if (confidence) {
+                    for (uint32_t l = 0; l < laserNum; l++) {
+                        confidences[l] = static_cast<uint8_t>(confidences[l] + conf[l]);
+                    }
+                    conf += laserNum;
+                    for (uint32_t l = 0; l < laserNum; l++, unit += 4) {
+                        uint32_t value =
+                            distances[l] | intensities[l] << 16 | static_cast<uint32_t>(confidences[l]) << 24;
+                        memcpy(unit, &value, sizeof(value));
+                    }
+                } else if (laserNum > 0) {
+                    // 4 bytes a unit, the last one is overwritten by the next unit
+                    for (uint32_t l = 0; l + 1 < laserNum; l++, unit += 3) {
+                        uint32_t value = distances[l] | intensities[l] << 16;
+                        memcpy(unit, &value, sizeof(value));
+                    }
+                    memcpy(unit, &distances[laserNum - 1], sizeof(uint16_t));
+                    unit[2] = intensities[laserNum - 1];
+                    unit += 3;
+                }
+                block = unit;
+            }
+            lanes[LANE_DIST_LOW].p  = low;
+            lanes[LANE_DIST_HIGH].p = high;
+            lanes[LANE_INTENSITY].p = intensity;
+            if (confidence) lanes[LANE_CONFIDENCE].p = conf;
+        }
+        prevOffset[cls] = at;
+        prevLength[cls] = length;
+        lengths.push_back(static_cast<uint32_t>(length));
+    }
+    for (const LaneReader& lane : lanes) {
+        if (lane.p != lane.end) return 0;
+    }
+    return data.size() - base == rawBytes ? chunkBytes : 0;
+}
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
@@ -0,0 +1,117 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: tools</b>
+ *
+ * @b Description: Lossless streaming codec of the raw packets of ME_V4, QT_V2 and ST_V3, for recordings.
+ */
+
+#ifndef PACKET_CODEC_H
+#define PACKET_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+// Raw bytes of the items of one chunk, the prediction restarts at each chunk so chunks decode on their own
+#define PACKET_CODEC_CHUNK_BYTES (1 << 20)
+
+// Byte streams of a chunk, each one entropy coded with its own table
+enum PacketCodecLane
+{
+    LANE_META,      // kind and length of each item
+    LANE_XOR,       // bytes out of the point body, xor the previous item of the same class and length
+    LANE_AZIMUTH,   // azimuth of each block less its linear prediction, zigzag, then the fine azimuth delta
+    LANE_DIST_LOW,  // distance of each channel less the one of the block before, zigzag, low byte
+    LANE_DIST_HIGH, // and high byte
+    LANE_INTENSITY, // reflectivity delta to the block before
+    LANE_CONFIDENCE,
+    LANE_NUM,
+};
+
+/**
+ * @brief Code a stream of items, the udp payloads of the lidars or any other bytes, in chunks. The point body
+ * of the ME_V4, QT_V2 and ST_V3 packets is delta coded against the block before, per channel, the rest of
+ * their bytes against the packet before. The residuals are split by field into lanes and Huffman coded,
+ * four interleaved streams per lane so the decode is not bound by the bit reader
+ */
+class PacketEncoder
+{
+public:
+    explicit PacketEncoder(size_t chunkBytes = PACKET_CODEC_CHUNK_BYTES);
+
+    // Append an item, the chunk is coded to 'out' once it is full
+    void add(const uint8_t* data, size_t length, std::vector<uint8_t>& out);
+
+    // Code the items added since the last chunk, if any
+    void finish(std::vector<uint8_t>& out);
+
+    // Coded bytes of each lane since the start, to see where the bytes go
+    const uint64_t* laneBytes() const { return m_laneBytes; }
+
+private:
+    void reset();
+
+    size_t m_chunkBytes;
+    std::vector<uint8_t> m_lanes[LANE_NUM];
+    uint64_t m_laneBytes[LANE_NUM] = {0};
+    uint32_t m_itemNum  = 0;
+    size_t m_rawBytes   = 0;
+    // previous item of each class, the packets of the lidars and the rest
+    std::vector<uint8_t> m_prevPacket;
+    std::vector<uint8_t> m_prevRaw;
+    // previous block, per channel
+    uint16_t m_distance[256];
+    uint8_t m_intensity[256];
+    uint8_t m_confidence[256];
+    // azimuth of the two blocks before
+    uint16_t m_azimuth[2];
+    uint8_t m_fineAzimuth;
+};
+
+class PacketDecoder
+{
+public:
+    /**
+     * @brief Decode one chunk, its items are appended back to back to 'data' and their lengths to 'lengths'
+     *
+     * @return the bytes of the chunk, 0 if it is truncated or corrupted
+     */
+    size_t decode(const uint8_t* chunk, size_t size, std::vector<uint8_t>& data, std::vector<uint32_t>& lengths);
+
+private:
+    std::vector<uint8_t> m_lanes[LANE_NUM];
+};
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // PACKET_CODEC_H
@@ -0,0 +1,476 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "HsLidarMeV4.h"
+#include "HsLidarQTV2.h"
+#include "HsLidarStV3.h"
+#include "PacketGenerator.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+namespace
+{
+// 4 mm, unit of the distance of all three protocols
+const uint8_t DIST_UNIT_MM = HS_LIDAR_HEADER_ME_V4::kDistUnit;
+const double DIST_UNIT_M   = DIST_UNIT_MM / 1000.0;
+
+// xorshift, the same stream for the same seed
+inline uint32_t nextNoise(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+inline uint16_t toDistance(float range)
+{
+    double raw = range / DIST_UNIT_M;
+    return raw >= 65535 ? 65535 : static_cast<uint16_t>(raw);
+}
+} // namespace
+
+const char* LidarTypeName(LidarType type)
+{
+    switch (type) {
+    case LidarType::P128: return "P128";
+    case LidarType::QT128: return "QT128";
+    case LidarType::AT128: return "AT128";
+    }
+    return "unknown";
+}
+
+bool ParseLidarType(const std::string& name, LidarType& type)
+{
+    if (strcasecmp(name.c_str(), "P128") == 0 || strcasecmp(name.c_str(), "Pandar128") == 0) {
+        type = LidarType::P128;
+    } else if (strcasecmp(name.c_str(), "QT128") == 0) {
+        type = LidarType::QT128;
+    } else if (strcasecmp(name.c_str(), "AT128") == 0) {
+        type = LidarType::AT128;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* ReturnModeName(ReturnMode mode)
+{
+    switch (mode) {
+    case ReturnMode::STRONGEST: return "strongest";
+    case ReturnMode::LAST: return "last";
+    case ReturnMode::DUAL: return "dual";
+    }
+    return "unknown";
+}
+
+bool ParseReturnMode(const std::string& name, ReturnMode& mode)
+{
+    for (ReturnMode candidate : {ReturnMode::STRONGEST, ReturnMode::LAST, ReturnMode::DUAL}) {
+        if (strcasecmp(name.c_str(), ReturnModeName(candidate)) == 0) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* SceneName(Scene scene)
+{
+    switch (scene) {
+    case Scene::HALL: return "hall";
+    case Scene::EMPTY: return "empty";
+    case Scene::SPHERE: return "sphere";
+    case Scene::RANDOM: return "random";
+    }
+    return "unknown";
+}
+
+bool ParseScene(const std::string& name, Scene& scene)
+{
+    for (Scene candidate : {Scene::HALL, Scene::EMPTY, Scene::SPHERE, Scene::RANDOM}) {
+        if (strcasecmp(name.c_str(), SceneName(candidate)) == 0) {
+            scene = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DetectLidarType(const uint8_t* data, size_t length, LidarType& type)
+{
+    if (length < sizeof(HS_LIDAR_PRE_HEADER)) {
+        return false;
+    }
+    const HS_LIDAR_PRE_HEADER* pre = reinterpret_cast<const HS_LIDAR_PRE_HEADER*>(data);
+    if (!pre->IsValidDelimiter()) {
+        return false;
+    }
+    if (pre->GetVersionMajor() == HS_LIDAR_PRE_HEADER::kME && pre->GetVersionMinor() == HS_LIDAR_PRE_HEADER::kV4) {
+        type = LidarType::P128;
+    } else if (pre->GetVersionMajor() == HS_LIDAR_PRE_HEADER::kQT && pre->GetVersionMinor() == HS_LIDAR_PRE_HEADER::kV2) {
+        type = LidarType::QT128;
+    } else if (pre->GetVersionMajor() == HS_LIDAR_PRE_HEADER::kST && pre->GetVersionMinor() == HS_LIDAR_PRE_HEADER::kV3) {
+        type = LidarType::AT128;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+PacketGenerator::PacketGenerator(const GeneratorConfig& config)
+    : m_config(config)
+{
+    switch (m_config.type) {
+    case LidarType::P128:
+        // 0.2 degree at 10 Hz
+        m_firingsPerRev = 1800;
+        if (m_config.rpm == 0) m_config.rpm = 600;
+        break;
+    case LidarType::QT128:
+        // 0.4 degree at 10 Hz
+        m_firingsPerRev = 900;
+        if (m_config.rpm == 0) m_config.rpm = 600;
+        break;
+    case LidarType::AT128:
+        // 0.05 degree of the rotor, 0.1 degree once reflected by the mirror
+        m_firingsPerRev = 7200;
+        if (m_config.rpm == 0) m_config.rpm = 200;
+        break;
+    }
+    if (m_config.laserNum == 0 || m_config.laserNum > 128) m_config.laserNum = 128;
+    if (m_config.blockNum == 0 || m_config.blockNum > 8) m_config.blockNum = 2;
+    if (m_config.dualReturn() && m_config.blockNum % 2 != 0) m_config.blockNum++;
+    // only Pandar128 and QT128 have the functional safety part, only Pandar128 the IMU
+    if (m_config.type == LidarType::AT128) m_config.funcSafety = false;
+    if (m_config.type != LidarType::P128) m_config.imu = false;
+    m_azimuthStep = 360.0 / m_firingsPerRev;
+    m_noise       = m_config.seed != 0 ? m_config.seed : 1;
+
+    // the size comes from the header the packets are built with
+    uint8_t packet[TOOLS_MAX_PACKET_SIZE];
+    PacketGenerator probe = *this;
+    m_packetSize = probe.next(packet);
+}
+
+uint32_t PacketGenerator::packetsPerSpin() const
+{
+    uint32_t firingsPerPacket = m_config.dualReturn() ? m_config.blockNum / 2 : m_config.blockNum;
+    return (m_firingsPerRev + firingsPerPacket - 1) / firingsPerPacket;
+}
+
+double PacketGenerator::packetRate() const
+{
+    uint32_t firingsPerPacket = m_config.dualReturn() ? m_config.blockNum / 2 : m_config.blockNum;
+    return static_cast<double>(m_firingsPerRev) * m_config.rpm / 60.0 / firingsPerPacket;
+}
+
+int64_t PacketGenerator::packetTime() const
+{
+    return m_config.startTime * 1000000000LL + static_cast<int64_t>(m_packetIndex * 1e9 / packetRate());
+}
+
+size_t PacketGenerator::next(uint8_t* buffer)
+{
+    size_t size = 0;
+    switch (m_config.type) {
+    case LidarType::P128: size = nextMeV4(buffer); break;
+    case LidarType::QT128: size = nextQtV2(buffer); break;
+    case LidarType::AT128: size = nextStV3(buffer); break;
+    }
+    m_sequence++;
+    m_packetIndex++;
+    return size;
+}
+
+void PacketGenerator::scene(uint32_t laser, double azimuth, float& range, uint8_t& intensity)
+{
+    switch (m_config.scene) {
+    case Scene::HALL:
+        hall(laser, azimuth, range, intensity);
+        break;
+    case Scene::EMPTY:
+        range     = 0;
+        intensity = 0;
+        break;
+    case Scene::SPHERE:
+        range     = m_config.sceneRange;
+        intensity = 100;
+        break;
+    case Scene::RANDOM: {
+        uint32_t noise = nextNoise(m_noise);
+        // 0.5 m to about 200 m
+        range     = 0.5f + (noise >> 16) * 0.003f;
+        intensity = static_cast<uint8_t>(noise);
+        break;
+    }
+    }
+}
+
+void PacketGenerator::hall(uint32_t laser, double azimuth, float& range, uint8_t& intensity)
+{
+    double rad = azimuth * M_PI / 180;
+    // walls of a 30 m x 20 m hall around the lidar
+    double wallX = 15 / fmax(fabs(cos(rad)), 1e-6);
+    double wallY = 10 / fmax(fabs(sin(rad)), 1e-6);
+    double wall  = fmin(wallX, wallY);
+    // the lower lasers see the floor
+    double floor = laser >= m_config.laserNum * 3 / 4 ? 2.0 + (m_config.laserNum - laser) * 0.5 : wall;
+    range        = static_cast<float>(fmin(wall, floor));
+    intensity    = static_cast<uint8_t>(20 + (static_cast<uint32_t>(azimuth) * 7 + laser * 3) % 180);
+    // a pole every 45 degree, 2 degree wide, a retro reflector
+    if (fmod(azimuth, 45.0) < 2.0) {
+        range     = 6.0f;
+        intensity = 250;
+    }
+    // a few cm of noise, and some lasers without return
+    uint32_t noise = nextNoise(m_noise);
+    range += ((noise & 0xff) - 128) * 0.0002f;
+    if ((noise >> 8) % 97 == 0) {
+        range     = 0;
+        intensity = 0;
+    }
+}
+
+void PacketGenerator::fillTime(uint8_t utc[6], uint32_t& us) const
+{
+    double offset = m_packetIndex / packetRate();
+    time_t second = static_cast<time_t>(m_config.startTime + static_cast<int64_t>(offset));
+    us            = static_cast<uint32_t>((offset - floor(offset)) * 1e6);
+    // the parsers read it back with mktime, so the fields are local time
+    struct tm t;
+    localtime_r(&second, &t);
+    utc[0] = static_cast<uint8_t>(t.tm_year);
+    utc[1] = static_cast<uint8_t>(t.tm_mon + 1);
+    utc[2] = static_cast<uint8_t>(t.tm_mday);
+    utc[3] = static_cast<uint8_t>(t.tm_hour);
+    utc[4] = static_cast<uint8_t>(t.tm_min);
+    utc[5] = static_cast<uint8_t>(t.tm_sec);
+}
+
+uint8_t PacketGenerator::returnMode(uint8_t strongest, uint8_t last, uint8_t dual) const
+{
+    switch (m_config.returnMode) {
+    case ReturnMode::LAST: return last;
+    case ReturnMode::DUAL: return dual;
+    default: return strongest;
+    }
+}
+
+// pre-header, header, blocks, crc, [functional safety], tail, [sequence number], [imu], tail crc
+size_t PacketGenerator::nextMeV4(uint8_t* buffer)
+{
+    HS_LIDAR_HEADER_ME_V4 header;
+    header.m_u8LaserNum  = static_cast<uint8_t>(m_config.laserNum);
+    header.m_u8BlockNum  = static_cast<uint8_t>(m_config.blockNum);
+    header.m_u8EchoCount = 0;
+    header.m_u8DistUnit  = DIST_UNIT_MM;
+    header.m_u8EchoNum   = m_config.dualReturn() ? 2 : 1;
+    header.m_u8Status    = (m_config.funcSafety ? HS_LIDAR_HEADER_ME_V4::kFunctionSafety : 0) |
+                        (m_config.seqNum ? HS_LIDAR_HEADER_ME_V4::kSequenceNum : 0) |
+                        (m_config.imu ? HS_LIDAR_HEADER_ME_V4::kIMU : 0);
+    size_t size          = header.GetPacketSize();
+    memset(buffer, 0, size);
+
+    uint8_t* p = buffer;
+    reinterpret_cast<HS_LIDAR_PRE_HEADER*>(p)->Init(HS_LIDAR_PRE_HEADER::kME, HS_LIDAR_PRE_HEADER::kV4);
+    p += sizeof(HS_LIDAR_PRE_HEADER);
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    for (uint32_t block = 0; block < m_config.blockNum; block++) {
+        auto* azimuth        = reinterpret_cast<HS_LIDAR_BODY_AZIMUTH_ME_V4*>(p);
+        azimuth->m_u16Azimuth = static_cast<uint16_t>(m_azimuth * 100);
+        p += sizeof(HS_LIDAR_BODY_AZIMUTH_ME_V4);
+        for (uint32_t laser = 0; laser < m_config.laserNum; laser++) {
+            float range       = 0;
+            uint8_t intensity = 0;
+            scene(laser, m_azimuth, range, intensity);
+            auto* unit             = reinterpret_cast<HS_LIDAR_BODY_CHN_UNIT_NO_CONF_ME_V4*>(p);
+            unit->m_u16Distance    = toDistance(range);
+            unit->m_u8Reflectivity = intensity;
+            p += sizeof(HS_LIDAR_BODY_CHN_UNIT_NO_CONF_ME_V4);
+        }
+        if (!m_config.dualReturn() || block % 2 == 1) {
+            m_azimuth = fmod(m_azimuth + m_azimuthStep, 360.0);
+        }
+    }
+    p += sizeof(HS_LIDAR_BODY_CRC_ME_V4);
+    if (m_config.funcSafety) {
+        auto* safety      = reinterpret_cast<HS_LIDAR_FUNC_SAFETY_ME_V4*>(p);
+        safety->m_u8Version = 1;
+        p += sizeof(HS_LIDAR_FUNC_SAFETY_ME_V4);
+    }
+    auto* tail           = reinterpret_cast<HS_LIDAR_TAIL_ME_V4*>(p);
+    tail->m_u8ReturnMode = returnMode(HS_LIDAR_TAIL_ME_V4::kStrongestReturn, HS_LIDAR_TAIL_ME_V4::kLastReturn,
+                                      HS_LIDAR_TAIL_ME_V4::kDualReturn);
+    tail->m_u16MotorSpeed  = m_config.rpm;
+    uint32_t us;
+    fillTime(tail->m_u8UTC, us);
+    tail->m_u32Timestamp = us;
+    tail->m_u8FactoryInfo = 0x42;
+    p += sizeof(HS_LIDAR_TAIL_ME_V4);
+    if (m_config.seqNum) {
+        reinterpret_cast<HS_LIDAR_TAIL_SEQ_NUM_ME_V4*>(p)->m_u32SeqNum = m_sequence;
+        p += sizeof(HS_LIDAR_TAIL_SEQ_NUM_ME_V4);
+    }
+    if (m_config.imu) {
+        // at rest and level, 1 mg and 0.01 deg/s units
+        auto* imu                = reinterpret_cast<HS_LIDAR_TAIL_IMU_ME_V4*>(p);
+        imu->m_i16IMUTemperature = 40;
+        imu->m_u16IMUAccelUnit   = 1;
+        imu->m_u16IMUAngVelUnit  = 10;
+        imu->m_u32IMUTimeStamp   = us;
+        imu->m_i16IMUZAccel      = 1000;
+    }
+    return size;
+}
+
+// pre-header, header, blocks, crc, [functional safety], tail, [sequence number], tail crc
+size_t PacketGenerator::nextQtV2(uint8_t* buffer)
+{
+    HS_LIDAR_HEADER_QT_V2 header;
+    header.m_u8LaserNum  = static_cast<uint8_t>(m_config.laserNum);
+    header.m_u8BlockNum  = static_cast<uint8_t>(m_config.blockNum);
+    header.m_u8EchoCount = 0;
+    header.m_u8DistUnit  = DIST_UNIT_MM;
+    header.m_u8EchoNum   = m_config.dualReturn() ? 2 : 1;
+    // Udp3_2_Parser reads the channel units with the confidence byte
+    header.m_u8Status = (m_config.funcSafety ? HS_LIDAR_HEADER_QT_V2::kFunctionSafety : 0) |
+                        (m_config.seqNum ? HS_LIDAR_HEADER_QT_V2::kSequenceNum : 0) |
+                        HS_LIDAR_HEADER_QT_V2::kConfidenceLevel;
+    size_t size = header.GetPacketSize();
+    memset(buffer, 0, size);
+
+    uint8_t* p = buffer;
+    reinterpret_cast<HS_LIDAR_PRE_HEADER*>(p)->Init(HS_LIDAR_PRE_HEADER::kQT, HS_LIDAR_PRE_HEADER::kV2);
+    p += sizeof(HS_LIDAR_PRE_HEADER);
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    for (uint32_t block = 0; block < m_config.blockNum; block++) {
+        auto* azimuth         = reinterpret_cast<HS_LIDAR_BODY_AZIMUTH_QT_V2*>(p);
+        azimuth->m_u16Azimuth = static_cast<uint16_t>(m_azimuth * 100);
+        p += sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2);
+        for (uint32_t laser = 0; laser < m_config.laserNum; laser++) {
+            float range       = 0;
+            uint8_t intensity = 0;
+            scene(laser, m_azimuth, range, intensity);
+            auto* unit             = reinterpret_cast<HS_LIDAR_BODY_CHN_UNIT_QT_V2*>(p);
+            unit->m_u16Distance    = toDistance(range);
+            unit->m_u8Reflectivity = intensity;
+            unit->m_u8Confidence   = range > 0 ? 2 : 0;
+            p += sizeof(HS_LIDAR_BODY_CHN_UNIT_QT_V2);
+        }
+        if (!m_config.dualReturn() || block % 2 == 1) {
+            m_azimuth = fmod(m_azimuth + m_azimuthStep, 360.0);
+        }
+    }
+    p += sizeof(HS_LIDAR_BODY_CRC_QT_V2);
+    if (m_config.funcSafety) {
+        auto* safety         = reinterpret_cast<HS_LIDAR_FUNCTION_SAFETY*>(p);
+        safety->m_u8FSVersion = 1;
+        p += sizeof(HS_LIDAR_FUNCTION_SAFETY);
+    }
+    auto* tail            = reinterpret_cast<HS_LIDAR_TAIL_QT_V2*>(p);
+    tail->m_u8ReturnMode  = returnMode(HS_LIDAR_TAIL_QT_V2::kStrongestReturn, HS_LIDAR_TAIL_QT_V2::kLastReturn,
+                                       HS_LIDAR_TAIL_QT_V2::kLastAndStrongestReturn);
+    tail->m_u16MotorSpeed = m_config.rpm;
+    uint32_t us;
+    fillTime(tail->m_u8UTC, us);
+    tail->m_u32Timestamp  = us;
+    tail->m_u8FactoryInfo = 0x42;
+    p += sizeof(HS_LIDAR_TAIL_QT_V2);
+    if (m_config.seqNum) {
+        reinterpret_cast<HS_LIDAR_TAIL_SEQ_NUM_QT_V2*>(p)->m_u32SeqNum = m_sequence;
+    }
+    return size;
+}
+
+// pre-header, header, blocks, crc, tail, [sequence number], tail crc
+size_t PacketGenerator::nextStV3(uint8_t* buffer)
+{
+    HS_LIDAR_HEADER_ST_V3 header;
+    header.m_u8LaserNum  = static_cast<uint8_t>(m_config.laserNum);
+    header.m_u8BlockNum  = static_cast<uint8_t>(m_config.blockNum);
+    header.m_u8EchoCount = 0;
+    header.m_u8DistUnit  = DIST_UNIT_MM;
+    header.m_u8EchoNum   = m_config.dualReturn() ? 2 : 1;
+    header.m_u8Status    = (m_config.seqNum ? HS_LIDAR_HEADER_ST_V3::kSequenceNum : 0) |
+                        HS_LIDAR_HEADER_ST_V3::kConfidenceLevel;
+    size_t size          = header.GetPacketSize();
+    memset(buffer, 0, size);
+
+    uint8_t* p = buffer;
+    reinterpret_cast<HS_LIDAR_PRE_HEADER*>(p)->Init(HS_LIDAR_PRE_HEADER::kST, HS_LIDAR_PRE_HEADER::kV3);
+    p += sizeof(HS_LIDAR_PRE_HEADER);
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    for (uint32_t block = 0; block < m_config.blockNum; block++) {
+        // 1/100 degree, then 1/256 of it in the fine azimuth
+        uint32_t fine         = static_cast<uint32_t>(m_azimuth * 25600);
+        auto* azimuth         = reinterpret_cast<HS_LIDAR_BODY_AZIMUTH_ST_V3*>(p);
+        azimuth->m_u16Azimuth = static_cast<uint16_t>(fine / 256);
+        p += sizeof(HS_LIDAR_BODY_AZIMUTH_ST_V3);
+        reinterpret_cast<HS_LIDAR_BODY_FINE_AZIMUTH_ST_V3*>(p)->m_u8FineAzimuth = static_cast<uint8_t>(fine % 256);
+        p += sizeof(HS_LIDAR_BODY_FINE_AZIMUTH_ST_V3);
+        for (uint32_t laser = 0; laser < m_config.laserNum; laser++) {
+            float range       = 0;
+            uint8_t intensity = 0;
+            scene(laser, m_azimuth, range, intensity);
+            auto* unit             = reinterpret_cast<HS_LIDAR_BODY_CHN_NNIT_ST_V3*>(p);
+            unit->m_u16Distance    = toDistance(range);
+            unit->m_u8Reflectivity = intensity;
+            unit->m_u8Confidence   = range > 0 ? 2 : 0;
+            p += sizeof(HS_LIDAR_BODY_CHN_NNIT_ST_V3);
+        }
+        if (!m_config.dualReturn() || block % 2 == 1) {
+            m_azimuth = fmod(m_azimuth + m_azimuthStep, 360.0);
+        }
+    }
+    p += sizeof(HS_LIDAR_BODY_CRC_ST_V3);
+    auto* tail            = reinterpret_cast<HS_LIDAR_TAIL_ST_V3*>(p);
+    tail->m_u8ReturnMode  = returnMode(HS_LIDAR_TAIL_ST_V3::kStrongestReturn, HS_LIDAR_TAIL_ST_V3::kLastReturn,
+                                       HS_LIDAR_TAIL_ST_V3::kDualReturn);
+    // 0.1 rpm
+    tail->m_i16MotorSpeed = static_cast<int16_t>(m_config.rpm * 10);
+    uint32_t us;
+    fillTime(tail->m_u8UTC, us);
+    tail->m_u32Timestamp  = us;
+    tail->m_u8FactoryInfo = 0x42;
+    p += sizeof(HS_LIDAR_TAIL_ST_V3);
+    if (m_config.seqNum) {
+        reinterpret_cast<HS_LIDAR_TAIL_SEQ_NUM_ST_V3*>(p)->m_u32SeqNum = m_sequence;
+    }
+    return size;
+}
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
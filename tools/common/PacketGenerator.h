@@ -0,0 +1,175 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: tools</b>
+ *
+ * @b Description: Synthetic point cloud packets of AT128, QT128 and Pandar128, built from the structs of
+ * UdpProtocol so the parsers can be exercised without a sensor or a capture.
+ */
+
+#ifndef PACKET_GENERATOR_H
+#define PACKET_GENERATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+// max udp payload of the lidars
+#define TOOLS_MAX_PACKET_SIZE (1500)
+
+enum class LidarType
+{
+    P128,  // Pandar128, ME_V4 protocol, Udp1_4_Parser
+    QT128, // QT_V2 protocol, Udp3_2_Parser
+    AT128, // ST_V3 protocol, Udp4_3_Parser
+};
+
+// "P128", "QT128" or "AT128", as the lidar types of the plugin
+const char* LidarTypeName(LidarType type);
+
+// Case insensitive, also takes "Pandar128"
+bool ParseLidarType(const std::string& name, LidarType& type);
+
+// Lidar type from the version in the pre-header of a packet, false if it is not a point cloud packet
+bool DetectLidarType(const uint8_t* data, size_t length, LidarType& type);
+
+// Return mode in the tail, the dual return has two blocks of the same azimuth per firing
+enum class ReturnMode
+{
+    STRONGEST,
+    LAST,
+    DUAL,
+};
+
+// What the lasers see
+enum class Scene
+{
+    // a 30 m x 20 m hall with a floor and a pole every 45 degree, a few cm of noise
+    HALL,
+    // no return at all, e.g. the lidar looks at the sky
+    EMPTY,
+    // every laser at 'sceneRange', no noise
+    SPHERE,
+    // uniform random range and intensity, the worst case for compression or caches
+    RANDOM,
+};
+
+const char* ReturnModeName(ReturnMode mode);
+bool ParseReturnMode(const std::string& name, ReturnMode& mode);
+const char* SceneName(Scene scene);
+bool ParseScene(const std::string& name, Scene& scene);
+
+struct GeneratorConfig
+{
+    LidarType type = LidarType::P128;
+    uint16_t laserNum = 128;
+    uint16_t blockNum = 2;
+    ReturnMode returnMode = ReturnMode::STRONGEST;
+    // header flags of the optional packet parts. Functional safety is sent by Pandar128 and QT128 only,
+    // the IMU by Pandar128 only. The confidence byte follows the parser of each lidar and is not an option
+    bool funcSafety = true;
+    bool seqNum = true;
+    bool imu = false;
+    // 0 is the default of the lidar, 600 for QT128 and Pandar128, 200 for the AT128 rotor. The AT128 tail
+    // carries it in 0.1 rpm
+    uint16_t rpm = 0;
+    Scene scene = Scene::HALL;
+    // in m, of 'Scene::SPHERE'
+    float sceneRange = 10;
+    // utc of the first packet, seconds since 1970
+    int64_t startTime = 1767225600;
+    // seed of the noise added to the distance
+    uint32_t seed = 1;
+
+    bool dualReturn() const { return returnMode == ReturnMode::DUAL; }
+};
+
+/**
+ * @brief Endless packet stream of one lidar, spinning at constant speed through a simple scene.
+ * Packets follow each other as sent by the lidar: azimuth, timestamp and sequence number advance
+ * with each packet, the whole revolution is sent. 'next' writes into memory, see UdpSender to send them
+ */
+class PacketGenerator
+{
+public:
+    explicit PacketGenerator(const GeneratorConfig& config);
+
+    const GeneratorConfig& config() const { return m_config; }
+
+    // Size of each packet in byte
+    size_t packetSize() const { return m_packetSize; }
+
+    // Packets of one revolution of the motor, AT128 has three frames in it, one per mirror face
+    uint32_t packetsPerSpin() const;
+
+    // Packets per second at the configured speed
+    double packetRate() const;
+
+    // Sensor time of the next packet in ns since 1970, the time in its tail
+    int64_t packetTime() const;
+
+    /**
+     * @brief Write the next packet
+     *
+     * @param[out] buffer at least 'packetSize' bytes
+     * @return size of the packet
+     */
+    size_t next(uint8_t* buffer);
+
+private:
+    size_t nextMeV4(uint8_t* buffer);
+    size_t nextQtV2(uint8_t* buffer);
+    size_t nextStV3(uint8_t* buffer);
+
+    // Range in m and intensity of a laser at an azimuth in degree, see 'Scene'
+    void scene(uint32_t laser, double azimuth, float& range, uint8_t& intensity);
+    void hall(uint32_t laser, double azimuth, float& range, uint8_t& intensity);
+    // Tail byte of the configured return mode, the constants differ per protocol
+    uint8_t returnMode(uint8_t strongest, uint8_t last, uint8_t dual) const;
+    // Sensor time of the current packet, utc fields and us in the second
+    void fillTime(uint8_t utc[6], uint32_t& us) const;
+
+    GeneratorConfig m_config;
+    size_t m_packetSize = 0;
+    // degree per firing, the two blocks of a dual return share the azimuth
+    double m_azimuthStep = 0;
+    double m_azimuth = 0;
+    // firings per revolution of the motor
+    uint32_t m_firingsPerRev = 0;
+    uint32_t m_sequence = 0;
+    uint64_t m_packetIndex = 0;
+    uint32_t m_noise = 0;
+};
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // PACKET_GENERATOR_H
@@ -0,0 +1,72 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+
+#include "ParserFactory.h"
+#include "Udp1_4_Parser.h"
+#include "Udp3_2_Parser.h"
+#include "Udp4_3_Parser.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+std::unique_ptr<GeneralParser> CreateParser(LidarType type, const std::string& share, const std::string& correction)
+{
+    std::unique_ptr<GeneralParser> parser;
+    std::string correctionFile;
+    std::string firetimes;
+    switch (type) {
+    case LidarType::P128:
+        parser.reset(new Udp1_4_Parser());
+        correctionFile = share + "/correction_p128.dat";
+        firetimes      = share + "/firetime_correction_Pandar128.csv";
+        break;
+    case LidarType::QT128:
+        parser.reset(new Udp3_2_Parser());
+        correctionFile = share + "/correction_qt128.dat";
+        firetimes      = share + "/firetime_qt128.dat";
+        break;
+    case LidarType::AT128:
+        parser.reset(new Udp4_3_Parser());
+        correctionFile = share + "/correction_at128.dat";
+        break;
+    }
+    if (!correction.empty()) {
+        correctionFile = correction;
+    }
+    if (parser->LoadCorrectionFile(correctionFile) != 0) {
+        printf("%s: load %s Error\n", LidarTypeName(type), correctionFile.c_str());
+        return nullptr;
+    }
+    if (!firetimes.empty()) {
+        parser->LoadFiretimesFile(firetimes);
+    }
+    return parser;
+}
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
@@ -0,0 +1,59 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: tools</b>
+ *
+ * @b Description: Parsers of the lidar types with their calibration, for the offline tools.
+ */
+
+#ifndef PARSER_FACTORY_H
+#define PARSER_FACTORY_H
+
+#include <memory>
+#include <string>
+
+#include "GeneralParser.h"
+#include "PacketGenerator.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+/**
+ * @brief Parser of a lidar type with the calibration of the share folder, as 'createParser' and
+ * 'loadCalibration' of the plugin
+ *
+ * @param correction correction file of the recorded lidar, the shipped one of the type if empty
+ * @return nullptr if the correction can not be loaded, the error is printed
+ */
+std::unique_ptr<GeneralParser> CreateParser(LidarType type, const std::string& share,
+                                            const std::string& correction = "");
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // PARSER_FACTORY_H
@@ -0,0 +1,144 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "PcapWriter.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+namespace
+{
+const uint32_t PCAP_MAGIC_NS     = 0xa1b23c4d;
+const uint32_t LINKTYPE_ETHERNET = 1;
+const uint16_t ETHERTYPE_IPV4    = 0x0800;
+const uint8_t IPPROTO_UDP_       = 17;
+
+inline uint16_t readBe16(const uint8_t* p)
+{
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+inline void writeBe16(uint8_t* p, uint16_t value)
+{
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+inline void writeBe32(uint8_t* p, uint32_t value)
+{
+    writeBe16(p, static_cast<uint16_t>(value >> 16));
+    writeBe16(p + 2, static_cast<uint16_t>(value));
+}
+} // namespace
+
+PcapWriter::~PcapWriter()
+{
+    close();
+}
+
+bool PcapWriter::open(const std::string& path)
+{
+    close();
+    m_fp = fopen(path.c_str(), "wb");
+    if (m_fp == nullptr) {
+        printf("PcapWriter: open %s Error, %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    m_records = 0;
+    m_failed  = false;
+    // native byte order, version 2.4, no time zone, 64k snap length
+    uint32_t header[6] = {PCAP_MAGIC_NS, 0x00040002, 0, 0, 65535, LINKTYPE_ETHERNET};
+    if (fwrite(header, sizeof(header), 1, m_fp) != 1) {
+        m_failed = true;
+    }
+    return !m_failed;
+}
+
+bool PcapWriter::close()
+{
+    if (m_fp == nullptr) {
+        return !m_failed;
+    }
+    bool ok = fclose(m_fp) == 0 && !m_failed;
+    m_fp    = nullptr;
+    return ok;
+}
+
+bool PcapWriter::write(const UdpDatagram& datagram)
+{
+    if (m_fp == nullptr || datagram.length > 65535 - 28) {
+        return false;
+    }
+    // ethernet, ipv4 without options and udp headers
+    uint8_t frame[14 + 20 + 8];
+    memset(frame, 0, sizeof(frame));
+    // locally administered mac addresses made of the ip ones
+    frame[0] = 0x02;
+    writeBe32(frame + 2, datagram.dstAddr);
+    frame[6] = 0x02;
+    writeBe32(frame + 8, datagram.srcAddr);
+    writeBe16(frame + 12, ETHERTYPE_IPV4);
+    uint8_t* ip = frame + 14;
+    ip[0]       = 0x45;
+    writeBe16(ip + 2, static_cast<uint16_t>(20 + 8 + datagram.length));
+    writeBe16(ip + 4, m_ipId++);
+    // don't fragment
+    ip[6] = 0x40;
+    ip[8] = 64;
+    ip[9] = IPPROTO_UDP_;
+    writeBe32(ip + 12, datagram.srcAddr);
+    writeBe32(ip + 16, datagram.dstAddr);
+    uint32_t sum = 0;
+    for (int i = 0; i < 20; i += 2) {
+        sum += readBe16(ip + i);
+    }
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    writeBe16(ip + 10, static_cast<uint16_t>(~sum));
+    uint8_t* udp = ip + 20;
+    writeBe16(udp, datagram.srcPort);
+    writeBe16(udp + 2, datagram.dstPort);
+    // the udp checksum is optional in ipv4 and left at 0
+    writeBe16(udp + 4, static_cast<uint16_t>(8 + datagram.length));
+
+    uint32_t length    = static_cast<uint32_t>(sizeof(frame) + datagram.length);
+    uint32_t record[4] = {static_cast<uint32_t>(datagram.timestamp / 1000000000),
+                          static_cast<uint32_t>(datagram.timestamp % 1000000000), length, length};
+    if (fwrite(record, sizeof(record), 1, m_fp) != 1 || fwrite(frame, sizeof(frame), 1, m_fp) != 1 ||
+        fwrite(datagram.payload, 1, datagram.length, m_fp) != datagram.length) {
+        m_failed = true;
+        return false;
+    }
+    m_records++;
+    return true;
+}
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
@@ -0,0 +1,79 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: tools</b>
+ *
+ * @b Description: Writer of pcap captures of synthetic packets.
+ */
+
+#ifndef PCAP_WRITER_H
+#define PCAP_WRITER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+#include "PcapFile.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+/**
+ * @brief Write udp datagrams to a pcap file, ns time stamps and Ethernet/IPv4/UDP frames, as captured
+ * by tcpdump on the host of the lidar
+ */
+class PcapWriter
+{
+public:
+    PcapWriter() = default;
+    ~PcapWriter();
+    PcapWriter(const PcapWriter&) = delete;
+    PcapWriter& operator=(const PcapWriter&) = delete;
+
+    // Create the file and write its header, false on a file error, the error is printed
+    bool open(const std::string& path);
+
+    // Flush and close, false if a write failed
+    bool close();
+
+    // Append one datagram, 'srcAddr', 'dstAddr', 'srcPort' and 'dstPort' are read from it
+    bool write(const UdpDatagram& datagram);
+
+    uint64_t recordNum() const { return m_records; }
+
+private:
+    FILE* m_fp         = nullptr;
+    uint64_t m_records = 0;
+    uint16_t m_ipId    = 0;
+    bool m_failed      = false;
+};
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // PCAP_WRITER_H
@@ -0,0 +1,116 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <initializer_list>
+
+#include "PerfCounter.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+namespace
+{
+int openCounter(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = type;
+    attr.config         = config;
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    // this thread on any cpu
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+uint64_t readCounter(int fd)
+{
+    uint64_t value = 0;
+    if (fd < 0 || read(fd, &value, sizeof(value)) != sizeof(value)) {
+        return 0;
+    }
+    return value;
+}
+} // namespace
+
+PerfCounter::PerfCounter()
+{
+    m_llcFd = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    m_l1dFd = openCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    m_dtlbFd = openCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+}
+
+PerfCounter::~PerfCounter()
+{
+    if (m_llcFd >= 0) close(m_llcFd);
+    if (m_l1dFd >= 0) close(m_l1dFd);
+    if (m_dtlbFd >= 0) close(m_dtlbFd);
+}
+
+void PerfCounter::start()
+{
+    for (int fd : {m_llcFd, m_l1dFd, m_dtlbFd}) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void PerfCounter::stop()
+{
+    for (int fd : {m_llcFd, m_l1dFd, m_dtlbFd}) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+}
+
+uint64_t PerfCounter::llcMisses() const
+{
+    return readCounter(m_llcFd);
+}
+
+uint64_t PerfCounter::l1dMisses() const
+{
+    return readCounter(m_l1dFd);
+}
+
+uint64_t PerfCounter::dtlbMisses() const
+{
+    return readCounter(m_dtlbFd);
+}
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
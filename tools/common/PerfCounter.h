@@ -0,0 +1,85 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: tools</b>
+ *
+ * @b Description: Hardware cache and TLB miss counters of the calling thread with perf_event_open, and the count of
+ * the heap allocations of the process.
+ */
+
+#ifndef PERF_COUNTER_H
+#define PERF_COUNTER_H
+
+#include <stdint.h>
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+/**
+ * @brief Last level cache misses, L1 data cache and data TLB read misses of the calling thread, user space only.
+ * Not available in most containers and VMs, or with kernel.perf_event_paranoid > 2, then all counts stay 0
+ */
+class PerfCounter
+{
+public:
+    PerfCounter();
+    ~PerfCounter();
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    bool llcAvailable() const { return m_llcFd >= 0; }
+    bool l1dAvailable() const { return m_l1dFd >= 0; }
+    bool dtlbAvailable() const { return m_dtlbFd >= 0; }
+
+    // Zero and enable the counters
+    void start();
+    // Disable the counters, the counts are kept
+    void stop();
+
+    uint64_t llcMisses() const;
+    uint64_t l1dMisses() const;
+    uint64_t dtlbMisses() const;
+
+private:
+    int m_llcFd = -1;
+    int m_l1dFd = -1;
+    int m_dtlbFd = -1;
+};
+
+// Heap allocations with operator new since the start, counted once the tool links AllocCounter.cpp
+struct AllocCount
+{
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+};
+AllocCount GetAllocCount();
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // PERF_COUNTER_H
@@ -0,0 +1,292 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef HESAI_TOOLS_ZLIB
+#include <zlib.h>
+#endif
+
+#include "PointFrame.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+namespace
+{
+const char FRAME_MAGIC[4]    = {'H', 'S', 'P', 'C'};
+const uint32_t FRAME_VERSION = 1;
+const uint8_t COLUMN_NUM     = 6;
+
+struct FrameHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t frameIndex;
+    uint32_t pointNum;
+    int64_t sensorTime;
+    int64_t captureTime;
+    uint8_t lidarType;
+    uint8_t compression;
+    uint8_t columnNum;
+    uint8_t reserved[5];
+};
+
+struct ColumnHeader
+{
+    char name[12];
+    // bytes of one value
+    uint32_t width;
+    uint64_t rawBytes;
+    uint64_t storedBytes;
+};
+
+static_assert(sizeof(FrameHeader) == 40, "frame header size");
+static_assert(sizeof(ColumnHeader) == 32, "column header size");
+
+// Column of a frame, 'Byte' is const to write it
+template <typename Byte>
+struct Column
+{
+    const char* name;
+    uint32_t width;
+    Byte* data;
+    size_t size;
+};
+
+template <typename Byte, typename Vector>
+Column<Byte> column(const char* name, Vector& values)
+{
+    return Column<Byte>{name, sizeof(values[0]), reinterpret_cast<Byte*>(values.data()), values.size() * sizeof(values[0])};
+}
+
+template <typename Frame, typename Byte>
+void frameColumns(Frame& frame, Column<Byte>* columns)
+{
+    columns[0] = column<Byte>("x", frame.x);
+    columns[1] = column<Byte>("y", frame.y);
+    columns[2] = column<Byte>("z", frame.z);
+    columns[3] = column<Byte>("intensity", frame.intensity);
+    columns[4] = column<Byte>("ring", frame.ring);
+    columns[5] = column<Byte>("time", frame.time);
+}
+
+void resizeFrame(PointFrame& frame, size_t pointNum)
+{
+    frame.x.resize(pointNum);
+    frame.y.resize(pointNum);
+    frame.z.resize(pointNum);
+    frame.intensity.resize(pointNum);
+    frame.ring.resize(pointNum);
+    frame.time.resize(pointNum);
+}
+
+#ifdef HESAI_TOOLS_ZLIB
+// Byte k of each value to plane k, the high bytes of floats and small ints then compress well
+void shuffle(const uint8_t* src, uint8_t* dst, size_t count, uint32_t width)
+{
+    for (uint32_t k = 0; k < width; k++) {
+        uint8_t* plane = dst + k * count;
+        for (size_t i = 0; i < count; i++) {
+            plane[i] = src[i * width + k];
+        }
+    }
+}
+
+void unshuffle(const uint8_t* src, uint8_t* dst, size_t count, uint32_t width)
+{
+    for (uint32_t k = 0; k < width; k++) {
+        const uint8_t* plane = src + k * count;
+        for (size_t i = 0; i < count; i++) {
+            dst[i * width + k] = plane[i];
+        }
+    }
+}
+#endif
+} // namespace
+
+bool IsCompressionSupported(ColumnCompression compression)
+{
+#ifdef HESAI_TOOLS_ZLIB
+    return compression == ColumnCompression::NONE || compression == ColumnCompression::ZLIB;
+#else
+    return compression == ColumnCompression::NONE;
+#endif
+}
+
+const char* ColumnCompressionName(ColumnCompression compression)
+{
+    return compression == ColumnCompression::ZLIB ? "zlib" : "none";
+}
+
+void PointFrame::clear()
+{
+    x.clear();
+    y.clear();
+    z.clear();
+    intensity.clear();
+    ring.clear();
+    time.clear();
+}
+
+void PointFrame::reserve(size_t pointNum)
+{
+    x.reserve(pointNum);
+    y.reserve(pointNum);
+    z.reserve(pointNum);
+    intensity.reserve(pointNum);
+    ring.reserve(pointNum);
+    time.reserve(pointNum);
+}
+
+size_t WritePointFrame(const std::string& path, const PointFrame& frame, ColumnCompression compression)
+{
+    if (!IsCompressionSupported(compression)) {
+        printf("PointFrame: %s compression not built in\n", ColumnCompressionName(compression));
+        return 0;
+    }
+    Column<const uint8_t> columns[COLUMN_NUM];
+    frameColumns(frame, columns);
+    // shuffled and compressed columns back to back
+    thread_local std::vector<uint8_t> stored;
+#ifdef HESAI_TOOLS_ZLIB
+    thread_local std::vector<uint8_t> shuffled;
+#endif
+    ColumnHeader headers[COLUMN_NUM];
+    memset(headers, 0, sizeof(headers));
+    stored.clear();
+    for (uint8_t i = 0; i < COLUMN_NUM; i++) {
+        strncpy(headers[i].name, columns[i].name, sizeof(headers[i].name) - 1);
+        headers[i].width    = columns[i].width;
+        headers[i].rawBytes = columns[i].size;
+        const uint8_t* data = columns[i].data;
+        if (compression == ColumnCompression::NONE) {
+            stored.insert(stored.end(), data, data + columns[i].size);
+            headers[i].storedBytes = columns[i].size;
+            continue;
+        }
+#ifdef HESAI_TOOLS_ZLIB
+        const size_t storedBytes = stored.size();
+        shuffled.resize(columns[i].size);
+        shuffle(data, shuffled.data(), columns[i].size / columns[i].width, columns[i].width);
+        uLongf bound = compressBound(columns[i].size);
+        stored.resize(storedBytes + bound);
+        // the fastest level, the batch decode is bound by it otherwise
+        if (compress2(stored.data() + storedBytes, &bound, shuffled.data(), columns[i].size, 1) != Z_OK) {
+            printf("PointFrame: compress %s of %s Error\n", columns[i].name, path.c_str());
+            return 0;
+        }
+        stored.resize(storedBytes + bound);
+        headers[i].storedBytes = bound;
+#endif
+    }
+
+    FrameHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FRAME_MAGIC, sizeof(FRAME_MAGIC));
+    header.version     = FRAME_VERSION;
+    header.frameIndex  = frame.frameIndex;
+    header.pointNum    = static_cast<uint32_t>(frame.size());
+    header.sensorTime  = frame.sensorTime;
+    header.captureTime = frame.captureTime;
+    header.lidarType   = frame.lidarType;
+    header.compression = static_cast<uint8_t>(compression);
+    header.columnNum   = COLUMN_NUM;
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr) {
+        printf("PointFrame: write %s Error, %s\n", path.c_str(), strerror(errno));
+        return 0;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 && fwrite(headers, sizeof(headers), 1, fp) == 1 &&
+              fwrite(stored.data(), 1, stored.size(), fp) == stored.size();
+    ok = fclose(fp) == 0 && ok;
+    if (!ok) {
+        printf("PointFrame: write %s Error\n", path.c_str());
+        return 0;
+    }
+    return sizeof(header) + sizeof(headers) + stored.size();
+}
+
+bool ReadPointFrame(const std::string& path, PointFrame& frame)
+{
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (fp == nullptr) {
+        printf("PointFrame: open %s Error, %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    FrameHeader header;
+    ColumnHeader headers[COLUMN_NUM];
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1 && memcmp(header.magic, FRAME_MAGIC, sizeof(FRAME_MAGIC)) == 0 &&
+              header.version == FRAME_VERSION && header.columnNum == COLUMN_NUM &&
+              IsCompressionSupported(static_cast<ColumnCompression>(header.compression)) &&
+              fread(headers, sizeof(headers), 1, fp) == 1;
+    std::vector<uint8_t> stored;
+#ifdef HESAI_TOOLS_ZLIB
+    std::vector<uint8_t> shuffled;
+#endif
+    if (ok) {
+        frame.frameIndex  = header.frameIndex;
+        frame.lidarType   = header.lidarType;
+        frame.sensorTime  = header.sensorTime;
+        frame.captureTime = header.captureTime;
+        resizeFrame(frame, header.pointNum);
+        Column<uint8_t> columns[COLUMN_NUM];
+        frameColumns(frame, columns);
+        for (uint8_t i = 0; ok && i < COLUMN_NUM; i++) {
+            ok = strncmp(headers[i].name, columns[i].name, sizeof(headers[i].name)) == 0 &&
+                 headers[i].width == columns[i].width && headers[i].rawBytes == columns[i].size;
+            if (!ok) break;
+            stored.resize(headers[i].storedBytes);
+            ok = fread(stored.data(), 1, stored.size(), fp) == stored.size();
+            if (!ok) break;
+            if (header.compression == static_cast<uint8_t>(ColumnCompression::NONE)) {
+                ok = stored.size() == columns[i].size;
+                if (ok) memcpy(columns[i].data, stored.data(), stored.size());
+                continue;
+            }
+#ifdef HESAI_TOOLS_ZLIB
+            shuffled.resize(columns[i].size);
+            uLongf rawBytes = columns[i].size;
+            ok = uncompress(shuffled.data(), &rawBytes, stored.data(), stored.size()) == Z_OK &&
+                 rawBytes == columns[i].size;
+            if (ok) {
+                unshuffle(shuffled.data(), columns[i].data, columns[i].size / columns[i].width, columns[i].width);
+            }
+#endif
+        }
+    }
+    fclose(fp);
+    if (!ok) {
+        printf("PointFrame: %s is not a point frame of this version\n", path.c_str());
+        frame.clear();
+    }
+    return ok;
+}
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
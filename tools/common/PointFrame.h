@@ -0,0 +1,98 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: tools</b>
+ *
+ * @b Description: Columnar point cloud file of one frame, written by the batch decoder.
+ */
+
+#ifndef POINT_FRAME_H
+#define POINT_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+enum class ColumnCompression
+{
+    NONE,
+    // bytes of each value grouped by significance, then deflate. Only if the tools are built with zlib
+    ZLIB,
+};
+
+// True if the tools are built with zlib
+bool IsCompressionSupported(ColumnCompression compression);
+
+const char* ColumnCompressionName(ColumnCompression compression);
+
+/**
+ * @brief Points of one frame as one array per field, in decode order. The file is a header, a table of the
+ * columns then the data of each column:
+ *   x, y, z     float32, m
+ *   intensity   uint8
+ *   ring        uint8, laser id
+ *   time        int32, us from 'sensorTime'
+ */
+struct PointFrame
+{
+    uint32_t frameIndex = 0;
+    uint8_t lidarType   = 0;
+    // us, sensor time of the first packet
+    int64_t sensorTime = 0;
+    // ns, capture time of the first packet
+    int64_t captureTime = 0;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<uint8_t> intensity;
+    std::vector<uint8_t> ring;
+    std::vector<int32_t> time;
+
+    size_t size() const { return x.size(); }
+    void clear();
+    void reserve(size_t pointNum);
+};
+
+/**
+ * @brief Write a frame, the buffers are reused between the calls of one thread
+ *
+ * @return the bytes written, 0 on a file error, the error is printed
+ */
+size_t WritePointFrame(const std::string& path, const PointFrame& frame, ColumnCompression compression);
+
+// false if the file is not a frame of this version or its columns do not match, the error is printed
+bool ReadPointFrame(const std::string& path, PointFrame& frame);
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // POINT_FRAME_H
@@ -0,0 +1,214 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "RecordReader.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+namespace
+{
+// size and host time of a DriveWorks record, the same again at the start of the slot of the plugin
+const size_t RAW_RECORD_HEADER = sizeof(uint32_t) + sizeof(int64_t);
+// the records are looked for in the first bytes of the file only
+const size_t RAW_SEARCH_LIMIT = 1 << 20;
+
+inline uint32_t readU32(const uint8_t* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline bool isDelimiter(const uint8_t* p)
+{
+    return p[0] == 0xEE && p[1] == 0xFF;
+}
+} // namespace
+
+const char* RecordFormatName(RecordFormat format)
+{
+    return format == RecordFormat::PCAP ? "pcap" : "dw_raw";
+}
+
+RecordReader::~RecordReader()
+{
+    if (m_data != nullptr) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+}
+
+bool RecordReader::open(const std::string& path, uint16_t port)
+{
+    m_port = port;
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        printf("RecordReader: open %s Error, %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    m_fileSize = st.st_size;
+    uint8_t magic[4] = {0};
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (fp == nullptr || fread(magic, 1, sizeof(magic), fp) != sizeof(magic)) {
+        printf("RecordReader: %s is too short\n", path.c_str());
+        if (fp != nullptr) fclose(fp);
+        return false;
+    }
+    fclose(fp);
+    const uint32_t value = readU32(magic);
+    // pcap of either byte order and time unit, or the section header of pcapng
+    if (value == 0xa1b2c3d4 || value == 0xd4c3b2a1 || value == 0xa1b23c4d || value == 0x4d3cb2a1 ||
+        value == 0x0a0d0d0a) {
+        m_format = RecordFormat::PCAP;
+        return m_pcap.open(path);
+    }
+    m_format = RecordFormat::DW_RAW;
+    return openRaw(path);
+}
+
+bool RecordReader::openRaw(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        printf("RecordReader: open %s Error, %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    void* map = m_fileSize > 0 ? mmap(nullptr, m_fileSize, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        printf("RecordReader: mmap %s Error, %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    madvise(map, m_fileSize, MADV_SEQUENTIAL);
+    m_data = static_cast<const uint8_t*>(map);
+    m_size = m_fileSize;
+
+    // the first record is a point cloud packet followed by another record of the same size, unless it is the last one
+    const size_t limit = m_size < RAW_SEARCH_LIMIT ? m_size : RAW_SEARCH_LIMIT;
+    for (size_t offset = 0; offset + RAW_RECORD_HEADER * 2 + 2 <= limit; offset++) {
+        const size_t size = readU32(m_data + offset);
+        if (size < RAW_RECORD_HEADER + 2 || size > 0xffff) {
+            continue;
+        }
+        const size_t recordSize = RAW_RECORD_HEADER + size;
+        // the slot of the plugin starts with its own size and time, older recordings have the packet first
+        for (size_t packetOffset : {RAW_RECORD_HEADER * 2, RAW_RECORD_HEADER}) {
+            const size_t next = offset + recordSize;
+            if (!isDelimiter(m_data + offset + packetOffset) ||
+                (packetOffset > RAW_RECORD_HEADER && readU32(m_data + offset + RAW_RECORD_HEADER) != size)) {
+                continue;
+            }
+            // the next record may be a gps packet, only its size is checked
+            if (next != m_size && (next + RAW_RECORD_HEADER > m_size || readU32(m_data + next) != size)) {
+                continue;
+            }
+            m_firstOffset  = offset;
+            m_offset       = offset;
+            m_recordSize   = recordSize;
+            m_packetOffset = packetOffset;
+            return true;
+        }
+    }
+    printf("RecordReader: %s is not a pcap file nor a DriveWorks recording of the plugin\n", path.c_str());
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+    m_data = nullptr;
+    m_size = 0;
+    return false;
+}
+
+bool RecordReader::next(RecordPacket& packet)
+{
+    if (m_format == RecordFormat::PCAP) {
+        UdpDatagram datagram;
+        while (m_pcap.next(datagram)) {
+            if ((m_port != 0 && datagram.dstPort != m_port) || datagram.length < 2 || !isDelimiter(datagram.payload)) {
+                continue;
+            }
+            packet.data        = datagram.payload;
+            packet.length      = datagram.length;
+            packet.offset      = datagram.offset;
+            packet.dataOffset  = datagram.payload - m_pcap.data();
+            packet.captureTime = datagram.timestamp;
+            return true;
+        }
+        return false;
+    }
+    const uint32_t size = static_cast<uint32_t>(m_recordSize - RAW_RECORD_HEADER);
+    while (m_data != nullptr && m_offset + m_recordSize <= m_size) {
+        const uint8_t* record = m_data + m_offset;
+        if (readU32(record) != size) {
+            // not a record of the plugin, go on at the next one
+            m_offset++;
+            continue;
+        }
+        m_offset += m_recordSize;
+        // gps packets and the like
+        if (!isDelimiter(record + m_packetOffset)) {
+            continue;
+        }
+        int64_t hostTime;
+        memcpy(&hostTime, record + sizeof(uint32_t), sizeof(hostTime));
+        packet.data        = record + m_packetOffset;
+        packet.length      = m_recordSize - m_packetOffset;
+        packet.offset      = record - m_data;
+        packet.dataOffset  = packet.offset + m_packetOffset;
+        packet.captureTime = hostTime * 1000;
+        return true;
+    }
+    return false;
+}
+
+bool RecordReader::seek(uint64_t offset)
+{
+    if (m_format == RecordFormat::PCAP) {
+        return m_pcap.seek(offset);
+    }
+    if (m_data == nullptr || offset < m_firstOffset || offset + m_recordSize > m_size) {
+        return false;
+    }
+    m_offset = offset;
+    return true;
+}
+
+void RecordReader::rewind()
+{
+    if (m_format == RecordFormat::PCAP) {
+        m_pcap.rewind();
+    } else {
+        m_offset = m_firstOffset;
+    }
+}
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
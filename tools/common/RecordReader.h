@@ -0,0 +1,118 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: tools</b>
+ *
+ * @b Description: Reader of the lidar packets of a recording, a pcap or pcapng capture or a DriveWorks raw recording.
+ */
+
+#ifndef RECORD_READER_H
+#define RECORD_READER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+#include "PcapFile.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+enum class RecordFormat
+{
+    PCAP,   // pcap or pcapng capture, by 'PcapFile'
+    DW_RAW, // DriveWorks .bin recording of the raw data of the plugin
+};
+
+const char* RecordFormatName(RecordFormat format);
+
+// One packet of a recording, the data points into the mapping
+struct RecordPacket
+{
+    const uint8_t* data = nullptr;
+    // of a DriveWorks recording the whole slot, the packet is shorter
+    size_t length = 0;
+    // file offset of its record, for 'RecordReader::seek'
+    uint64_t offset = 0;
+    // file offset of the data
+    uint64_t dataOffset = 0;
+    // ns, capture time of a pcap or host time of a DriveWorks recording
+    int64_t captureTime = 0;
+};
+
+/**
+ * @brief Read the point cloud packets of a recording in file order, the ones starting with the 0xEEFF delimiter.
+ * The format is told by the content. A DriveWorks .bin recording stores each slot of 'readRawData' as a
+ * record of fixed size, its size and host time then the slot, which has the size, the time and the 'UdpPacket'.
+ * The records are found by this pattern, the header of the file before them is skipped
+ */
+class RecordReader
+{
+public:
+    RecordReader() = default;
+    ~RecordReader();
+    RecordReader(const RecordReader&) = delete;
+    RecordReader& operator=(const RecordReader&) = delete;
+
+    /**
+     * @param port of a capture only the datagrams sent to this port, 0 for all
+     * @return false if the file can not be read or is of no known format, the error is printed
+     */
+    bool open(const std::string& path, uint16_t port = 0);
+
+    bool next(RecordPacket& packet);
+
+    // Continue at the packet of a returned offset, O(1) but for pcapng, see 'PcapFile::seek'
+    bool seek(uint64_t offset);
+
+    void rewind();
+
+    RecordFormat format() const { return m_format; }
+    uint64_t fileSize() const { return m_fileSize; }
+
+private:
+    bool openRaw(const std::string& path);
+
+    RecordFormat m_format = RecordFormat::PCAP;
+    uint16_t m_port       = 0;
+    uint64_t m_fileSize   = 0;
+    PcapFile m_pcap;
+    // DriveWorks recording, mapped as a whole
+    const uint8_t* m_data = nullptr;
+    size_t m_size         = 0;
+    size_t m_offset       = 0;
+    size_t m_firstOffset  = 0;
+    size_t m_recordSize   = 0;
+    // of the packet in a record
+    size_t m_packetOffset = 0;
+};
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // RECORD_READER_H
@@ -0,0 +1,195 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "UdpSender.h"
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+bool ParseEndpoint(const std::string& text, uint32_t& addr, uint16_t& port)
+{
+    std::string host = "127.0.0.1";
+    std::string portText = text;
+    size_t colon = text.rfind(':');
+    if (colon != std::string::npos) {
+        host     = text.substr(0, colon);
+        portText = text.substr(colon + 1);
+    }
+    char* end;
+    unsigned long value = strtoul(portText.c_str(), &end, 10);
+    struct in_addr in;
+    if (portText.empty() || *end != '\0' || value > 65535 || inet_pton(AF_INET, host.c_str(), &in) != 1) {
+        return false;
+    }
+    addr = ntohl(in.s_addr);
+    port = static_cast<uint16_t>(value);
+    return true;
+}
+
+UdpSender::UdpSender(size_t batchNum)
+    : m_iovecs(batchNum != 0 ? batchNum : 1)
+    , m_msgs(m_iovecs.size())
+{
+}
+
+UdpSender::~UdpSender()
+{
+    close();
+}
+
+bool UdpSender::open(uint32_t dstAddr, uint16_t dstPort, uint32_t srcAddr, uint16_t srcPort)
+{
+    close();
+    m_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0) {
+        printf("UdpSender: socket Error, %s\n", strerror(errno));
+        return false;
+    }
+    // a deep send buffer, the bursts of a fast replay are not dropped by the local stack
+    int size = 8 * 1024 * 1024;
+    setsockopt(m_fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    if (srcAddr != 0 || srcPort != 0) {
+        struct sockaddr_in local;
+        memset(&local, 0, sizeof(local));
+        local.sin_family      = AF_INET;
+        local.sin_addr.s_addr = htonl(srcAddr);
+        local.sin_port        = htons(srcPort);
+        int reuse = 1;
+        setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (bind(m_fd, reinterpret_cast<struct sockaddr*>(&local), sizeof(local)) != 0) {
+            printf("UdpSender: bind %s:%u Error, %s\n", inet_ntoa(local.sin_addr), srcPort, strerror(errno));
+            close();
+            return false;
+        }
+    }
+    memset(&m_dest, 0, sizeof(m_dest));
+    m_dest.sin_family      = AF_INET;
+    m_dest.sin_addr.s_addr = htonl(dstAddr);
+    m_dest.sin_port        = htons(dstPort);
+    // not connected, a port nobody listens on does not fail the next sends with ECONNREFUSED
+    for (size_t i = 0; i < m_msgs.size(); i++) {
+        memset(&m_msgs[i], 0, sizeof(m_msgs[i]));
+        m_msgs[i].msg_hdr.msg_name    = &m_dest;
+        m_msgs[i].msg_hdr.msg_namelen = sizeof(m_dest);
+        m_msgs[i].msg_hdr.msg_iov     = &m_iovecs[i];
+        m_msgs[i].msg_hdr.msg_iovlen  = 1;
+    }
+    m_pending = 0;
+    return true;
+}
+
+void UdpSender::close()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    m_fd      = -1;
+    m_pending = 0;
+}
+
+bool UdpSender::add(const uint8_t* payload, size_t length)
+{
+    m_iovecs[m_pending].iov_base = const_cast<uint8_t*>(payload);
+    m_iovecs[m_pending].iov_len  = length;
+    m_pending++;
+    return m_pending < m_iovecs.size() || flush();
+}
+
+bool UdpSender::flush()
+{
+    size_t done = 0;
+    while (done < m_pending) {
+        int ret = sendmmsg(m_fd, &m_msgs[done], static_cast<unsigned int>(m_pending - done), 0);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            // e.g. ENOBUFS, counted and dropped
+            m_errors += m_pending - done;
+            m_pending = 0;
+            return false;
+        }
+        for (int i = 0; i < ret; i++) {
+            m_sentBytes += m_msgs[done + i].msg_len;
+        }
+        done += ret;
+        m_sent += ret;
+    }
+    m_pending = 0;
+    return true;
+}
+
+int64_t RatePacer::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void RatePacer::start()
+{
+    m_start  = now();
+    m_maxLag = 0;
+}
+
+int64_t RatePacer::elapsed() const
+{
+    return now() - m_start;
+}
+
+int64_t RatePacer::waitUntil(int64_t offsetNs)
+{
+    int64_t deadline = m_start + offsetNs;
+    int64_t current  = now();
+    if (deadline - current > m_spinNs) {
+        int64_t wake = deadline - m_spinNs;
+        struct timespec ts;
+        ts.tv_sec  = wake / 1000000000;
+        ts.tv_nsec = wake % 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+        current = now();
+    }
+    while (current < deadline) {
+        current = now();
+    }
+    int64_t lag = current - deadline;
+    if (lag > m_maxLag) {
+        m_maxLag = lag;
+    }
+    return lag;
+}
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
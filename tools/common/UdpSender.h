@@ -0,0 +1,145 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: tools</b>
+ *
+ * @b Description: Send udp datagrams in batches with sendmmsg, paced at an exact rate.
+ */
+
+#ifndef UDP_SENDER_H
+#define UDP_SENDER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <string>
+#include <vector>
+
+namespace dw
+{
+namespace plugins
+{
+namespace lidar
+{
+namespace tools
+{
+
+/**
+ * @brief Parse "ip:port" or "port", the address is 127.0.0.1 if missing
+ *
+ * @param[out] addr ipv4 address in host byte order
+ * @return false if it is not an ipv4 address and port
+ */
+bool ParseEndpoint(const std::string& text, uint32_t& addr, uint16_t& port);
+
+/**
+ * @brief One udp socket sending to a fixed address, as a lidar does.
+ * Datagrams are queued by 'add' and sent by 'flush' with one sendmmsg call, the payloads are not copied
+ * and must stay valid until then
+ */
+class UdpSender
+{
+public:
+    explicit UdpSender(size_t batchNum = 32);
+    ~UdpSender();
+    UdpSender(const UdpSender&) = delete;
+    UdpSender& operator=(const UdpSender&) = delete;
+
+    /**
+     * @brief Open the socket
+     *
+     * @param dstAddr, dstPort destination, host byte order
+     * @param srcAddr, srcPort local address to bind, 0 for any. A source address of another host works on
+     * the loopback interface only, e.g. 127.0.0.2 to look like a second lidar
+     * @return false on a socket error, the error is printed
+     */
+    bool open(uint32_t dstAddr, uint16_t dstPort, uint32_t srcAddr = 0, uint16_t srcPort = 0);
+
+    void close();
+
+    /**
+     * @brief Queue a datagram, the queue is flushed when full
+     *
+     * @return false if the flush failed
+     */
+    bool add(const uint8_t* payload, size_t length);
+
+    /**
+     * @brief Send the queued datagrams, partial sends are retried
+     *
+     * @return false on a socket error, the datagrams not sent are dropped
+     */
+    bool flush();
+
+    size_t pending() const { return m_pending; }
+    size_t batchNum() const { return m_iovecs.size(); }
+    uint64_t sentNum() const { return m_sent; }
+    uint64_t sentBytes() const { return m_sentBytes; }
+    uint64_t errorNum() const { return m_errors; }
+
+private:
+    int m_fd = -1;
+    struct sockaddr_in m_dest;
+    std::vector<struct iovec> m_iovecs;
+    std::vector<struct mmsghdr> m_msgs;
+    size_t m_pending     = 0;
+    uint64_t m_sent      = 0;
+    uint64_t m_sentBytes = 0;
+    uint64_t m_errors    = 0;
+};
+
+/**
+ * @brief Wait for points in time relative to a start, on CLOCK_MONOTONIC.
+ * Sleeps with an absolute clock_nanosleep up to 'spinNs' before the deadline then spins, so the error does
+ * not add up over a long run and a late wake up is caught up by the next ones
+ */
+class RatePacer
+{
+public:
+    explicit RatePacer(int64_t spinNs = 50000) : m_spinNs(spinNs) {}
+
+    // Start the clock, offsets are relative to now
+    void start();
+
+    // Wait until 'offsetNs' after the start, return the lag in ns, 0 if it was not late
+    int64_t waitUntil(int64_t offsetNs);
+
+    // ns since the start
+    int64_t elapsed() const;
+
+    // Largest lag seen by 'waitUntil'
+    int64_t maxLag() const { return m_maxLag; }
+
+    static int64_t now();
+
+private:
+    int64_t m_spinNs;
+    int64_t m_start  = 0;
+    int64_t m_maxLag = 0;
+};
+
+} // namespace tools
+} // namespace lidar
+} // namespace plugins
+} // namespace dw
+
+#endif // UDP_SENDER_H
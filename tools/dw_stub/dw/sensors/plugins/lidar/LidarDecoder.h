@@ -0,0 +1,44 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: stand-in DriveWorks headers</b>
+ *
+ * @b Description: Decoder constants of the lidar plugin API, see LidarPlugin.h of this folder.
+ */
+
+#ifndef DW_STUB_LIDAR_DECODER_H_
+#define DW_STUB_LIDAR_DECODER_H_
+
+#include <dw/sensors/plugins/lidar/LidarPlugin.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _dwSensorLidarDecoder_constants {
+    size_t maxPayloadSize;
+    dwLidarProperties properties;
+} _dwSensorLidarDecoder_constants;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DW_STUB_LIDAR_DECODER_H_
@@ -0,0 +1,128 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: stand-in DriveWorks headers</b>
+ *
+ * @b Description: The part of the DriveWorks lidar plugin API used by the udp parsers, so the parsers build
+ * and run on any Linux box for the tools. The layout of the types follows DriveWorks 5.x, only the fields
+ * the parsers touch are meant to be exact. Never put this folder on the include path of the plugin.
+ */
+
+#ifndef DW_STUB_LIDAR_PLUGIN_H_
+#define DW_STUB_LIDAR_PLUGIN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef float float32_t;
+typedef double float64_t;
+// us
+typedef int64_t dwTime_t;
+
+typedef enum dwStatus {
+    DW_SUCCESS = 0,
+    DW_INVALID_VERSION,
+    DW_INVALID_ARGUMENT,
+    DW_BAD_ALLOC,
+    DW_BAD_ALIGNMENT,
+    DW_BAD_CAST,
+    DW_NOT_IMPLEMENTED,
+    DW_END_OF_STREAM,
+    DW_INVALID_HANDLE,
+    DW_CALL_NOT_ALLOWED,
+    DW_NOT_AVAILABLE,
+    DW_NOT_RELEASED,
+    DW_NOT_SUPPORTED,
+    DW_NOT_INITIALIZED,
+    DW_INTERNAL_ERROR,
+    DW_FILE_NOT_FOUND,
+    DW_FILE_INVALID,
+    DW_CANNOT_CREATE_OBJECT,
+    DW_BUFFER_FULL,
+    DW_NOT_READY,
+    DW_TIME_OUT,
+    DW_BUSY_WAITING,
+    DW_LOST_PACKET,
+    DW_OUT_OF_BOUNDS,
+    DW_SAL_CANNOT_INITIALIZE,
+    DW_FAILURE
+} dwStatus;
+
+typedef struct dwContextObject* dwContextHandle_t;
+
+#define DW_MAX_LIDAR_ROWS 128
+
+typedef struct dwLidarPointXYZI {
+    float32_t x;
+    float32_t y;
+    float32_t z;
+    float32_t intensity;
+} dwLidarPointXYZI;
+
+typedef struct dwLidarPointRTHI {
+    float32_t theta;
+    float32_t phi;
+    float32_t radius;
+    float32_t intensity;
+} dwLidarPointRTHI;
+
+typedef struct dwLidarProperties {
+    char deviceString[256];
+    float32_t spinFrequency;
+    uint32_t packetsPerSecond;
+    uint32_t packetsPerSpin;
+    uint32_t pointsPerSecond;
+    uint32_t pointsPerPacket;
+    uint32_t pointsPerSpin;
+    uint32_t pointStride;
+    float32_t horizontalFOVStart;
+    float32_t horizontalFOVEnd;
+    uint32_t numberOfRows;
+    float32_t verticalFOVStart;
+    float32_t verticalFOVEnd;
+    float32_t verticalAngles[DW_MAX_LIDAR_ROWS];
+    float32_t horizontalAngles[DW_MAX_LIDAR_ROWS];
+} dwLidarProperties;
+
+typedef struct dwLidarDecodedPacket {
+    dwTime_t hostTimestamp;
+    dwTime_t sensorTimestamp;
+    dwTime_t duration;
+    uint32_t maxPoints;
+    uint32_t nPoints;
+    float32_t minHorizontalAngleRad;
+    float32_t maxHorizontalAngleRad;
+    float32_t minVerticalAngleRad;
+    float32_t maxVerticalAngleRad;
+    bool scanComplete;
+    const dwLidarPointRTHI* pointsRTHI;
+    const dwLidarPointXYZI* pointsXYZI;
+} dwLidarDecodedPacket;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DW_STUB_LIDAR_PLUGIN_H_
@@ -0,0 +1,248 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Synthetic lidar packets for stress tests of the plugin: sent over udp at the rate of the sensor, a multiple
+// of it or as fast as possible, or written to a pcap file. Reports the achieved rate and how late the sends were
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "PacketGenerator.h"
+#include "PcapWriter.h"
+#include "UdpSender.h"
+
+using namespace dw::plugins::lidar;
+using namespace dw::plugins::lidar::tools;
+
+namespace
+{
+// source of the packets in a capture when '--bind' is not given, the default address of the lidars
+const uint32_t LIDAR_ADDR = 0xc0a801c9;
+const uint16_t LIDAR_PORT = 10000;
+
+struct Options
+{
+    GeneratorConfig config;
+    std::string dest = "127.0.0.1:2368";
+    std::string bind;
+    std::string pcap;
+    // 0 for the duration
+    uint64_t count = 0;
+    double seconds = 10;
+    double rateScale = 1;
+    bool maxRate = false;
+    size_t batch = 8;
+};
+
+volatile sig_atomic_t g_stop = 0;
+
+void onSignal(int)
+{
+    g_stop = 1;
+}
+
+void usage(const char* name)
+{
+    printf("Usage: %s [options]\n"
+           "  --lidar <type>       P128, QT128 or AT128, default P128\n"
+           "  --lasers <n>         lasers per block, default 128\n"
+           "  --blocks <n>         blocks per packet, default 2\n"
+           "  --return <mode>      strongest, last or dual, default strongest\n"
+           "  --rpm <n>            motor speed, default of the lidar\n"
+           "  --scene <name>       hall, empty, sphere or random, default hall\n"
+           "  --range <m>          range of the sphere scene, default 10\n"
+           "  --no-seqnum          without the sequence number\n"
+           "  --no-safety          without the functional safety part, P128 and QT128\n"
+           "  --imu                with the imu part, P128 only\n"
+           "  --seed <n>           seed of the noise, default 1\n"
+           "  --dest <ip:port>     where to send, default 127.0.0.1:2368\n"
+           "  --bind <ip:port>     local address of the socket, e.g. 127.0.0.2:10000 for a second lidar\n"
+           "  --pcap <file>        write a capture instead of sending, with the sensor time\n"
+           "  --count <n>          packets to generate, instead of the duration\n"
+           "  --seconds <s>        duration, default 10. At max rate the packets of this time at the sensor rate\n"
+           "  --rate-scale <x>     send x times faster than the sensor, default 1\n"
+           "  --max-rate           send as fast as possible\n"
+           "  --batch <n>          packets per sendmmsg, sent as one burst, default 8\n",
+           name);
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    static const struct option longOptions[] = {
+        {"lidar", required_argument, nullptr, 'l'},      {"lasers", required_argument, nullptr, 'L'},
+        {"blocks", required_argument, nullptr, 'b'},     {"return", required_argument, nullptr, 'r'},
+        {"rpm", required_argument, nullptr, 'R'},        {"scene", required_argument, nullptr, 'S'},
+        {"range", required_argument, nullptr, 'g'},      {"no-seqnum", no_argument, nullptr, 'q'},
+        {"no-safety", no_argument, nullptr, 'F'},        {"imu", no_argument, nullptr, 'i'},
+        {"seed", required_argument, nullptr, 'e'},       {"dest", required_argument, nullptr, 'd'},
+        {"bind", required_argument, nullptr, 'B'},       {"pcap", required_argument, nullptr, 'f'},
+        {"count", required_argument, nullptr, 'n'},      {"seconds", required_argument, nullptr, 's'},
+        {"rate-scale", required_argument, nullptr, 'x'}, {"max-rate", no_argument, nullptr, 'm'},
+        {"batch", required_argument, nullptr, 'k'},      {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}};
+    GeneratorConfig& config = options.config;
+    int c;
+    while ((c = getopt_long(argc, argv, "h", longOptions, nullptr)) != -1) {
+        switch (c) {
+        case 'l':
+            if (!ParseLidarType(optarg, config.type)) {
+                printf("unknown lidar type %s\n", optarg);
+                return false;
+            }
+            break;
+        case 'L': config.laserNum = static_cast<uint16_t>(atoi(optarg)); break;
+        case 'b': config.blockNum = static_cast<uint16_t>(atoi(optarg)); break;
+        case 'r':
+            if (!ParseReturnMode(optarg, config.returnMode)) {
+                printf("unknown return mode %s\n", optarg);
+                return false;
+            }
+            break;
+        case 'R': config.rpm = static_cast<uint16_t>(atoi(optarg)); break;
+        case 'S':
+            if (!ParseScene(optarg, config.scene)) {
+                printf("unknown scene %s\n", optarg);
+                return false;
+            }
+            break;
+        case 'g': config.sceneRange = static_cast<float>(atof(optarg)); break;
+        case 'q': config.seqNum = false; break;
+        case 'F': config.funcSafety = false; break;
+        case 'i': config.imu = true; break;
+        case 'e': config.seed = static_cast<uint32_t>(strtoul(optarg, nullptr, 10)); break;
+        case 'd': options.dest = optarg; break;
+        case 'B': options.bind = optarg; break;
+        case 'f': options.pcap = optarg; break;
+        case 'n': options.count = strtoull(optarg, nullptr, 10); break;
+        case 's': options.seconds = atof(optarg); break;
+        case 'x': options.rateScale = atof(optarg); break;
+        case 'm': options.maxRate = true; break;
+        case 'k': options.batch = static_cast<size_t>(atoi(optarg)); break;
+        default: return false;
+        }
+    }
+    if (options.rateScale <= 0 || options.batch == 0 || options.batch > 1024) {
+        printf("the rate scale must be positive and the batch 1 to 1024\n");
+        return false;
+    }
+    return true;
+}
+
+int writeCapture(const Options& options, PacketGenerator& generator, uint64_t count)
+{
+    UdpDatagram datagram;
+    datagram.srcAddr = LIDAR_ADDR;
+    datagram.srcPort = LIDAR_PORT;
+    if (!options.bind.empty()) {
+        ParseEndpoint(options.bind, datagram.srcAddr, datagram.srcPort);
+    }
+    if (!ParseEndpoint(options.dest, datagram.dstAddr, datagram.dstPort)) {
+        printf("wrong destination %s\n", options.dest.c_str());
+        return 1;
+    }
+    PcapWriter writer;
+    if (!writer.open(options.pcap)) {
+        return 1;
+    }
+    std::vector<uint8_t> packet(generator.packetSize());
+    for (uint64_t i = 0; i < count; i++) {
+        datagram.timestamp = generator.packetTime();
+        datagram.length    = generator.next(packet.data());
+        datagram.payload   = packet.data();
+        if (!writer.write(datagram)) {
+            break;
+        }
+    }
+    if (!writer.close()) {
+        printf("write %s Error\n", options.pcap.c_str());
+        return 1;
+    }
+    printf("%lu packets of %zu bytes written to %s\n", static_cast<unsigned long>(writer.recordNum()),
+           generator.packetSize(), options.pcap.c_str());
+    return 0;
+}
+
+int sendPackets(const Options& options, PacketGenerator& generator, uint64_t count)
+{
+    uint32_t dstAddr, srcAddr = 0;
+    uint16_t dstPort, srcPort = 0;
+    if (!ParseEndpoint(options.dest, dstAddr, dstPort) ||
+        (!options.bind.empty() && !ParseEndpoint(options.bind, srcAddr, srcPort))) {
+        printf("wrong address %s %s\n", options.dest.c_str(), options.bind.c_str());
+        return 1;
+    }
+    UdpSender sender(options.batch);
+    if (!sender.open(dstAddr, dstPort, srcAddr, srcPort)) {
+        return 1;
+    }
+    double rate = generator.packetRate() * options.rateScale;
+    printf("%s %zu bytes, target %.0f packets/s%s to %s\n", LidarTypeName(generator.config().type),
+           generator.packetSize(), rate, options.maxRate ? ", sent as fast as possible," : "", options.dest.c_str());
+
+    // the payloads of one batch stay valid until its sendmmsg
+    size_t size = generator.packetSize();
+    std::vector<uint8_t> buffer(options.batch * size);
+    RatePacer pacer;
+    pacer.start();
+    uint64_t sent = 0;
+    while (sent < count && g_stop == 0) {
+        size_t num = static_cast<size_t>(std::min<uint64_t>(options.batch, count - sent));
+        for (size_t i = 0; i < num; i++) {
+            uint8_t* packet = buffer.data() + i * size;
+            sender.add(packet, generator.next(packet));
+        }
+        // the burst goes out when its last packet is due, the error does not add up
+        if (!options.maxRate) {
+            pacer.waitUntil(static_cast<int64_t>((sent + num - 1) * 1e9 / rate));
+        }
+        sender.flush();
+        sent += num;
+    }
+    double seconds = pacer.elapsed() / 1e9;
+    double achieved = seconds > 0 ? sender.sentNum() / seconds : 0;
+    printf("sent %lu packets, %.1f MB in %.3f s, %.0f packets/s (%.2f of the target), %lu errors, max lag %.1f us\n",
+           static_cast<unsigned long>(sender.sentNum()), sender.sentBytes() / 1e6, seconds, achieved,
+           achieved / rate, static_cast<unsigned long>(sender.errorNum()),
+           pacer.maxLag() / 1e3);
+    return sender.errorNum() == 0 ? 0 : 2;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    PacketGenerator generator(options.config);
+    uint64_t count = options.count;
+    if (count == 0) {
+        double rate = generator.packetRate() * (options.maxRate ? 1 : options.rateScale);
+        count       = static_cast<uint64_t>(options.seconds * rate + 0.5);
+    }
+    return options.pcap.empty() ? sendPackets(options, generator, count) : writeCapture(options, generator, count);
+}
@@ -0,0 +1,91 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Check of the AT128 point times against the rotor speed of the tail. The golden harness compares two parsers
+// that share the speed convention, here the time from one block to the next must be the time of one firing
+// of the generator, within one block and across two packets. The correction is not loaded, so that every block
+// is decoded whatever the field of its azimuth
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "PacketGenerator.h"
+#include "Udp4_3_Parser.h"
+
+using namespace dw::plugins::lidar::tools;
+
+namespace
+{
+const uint32_t PACKET_NUM = 2000;
+// the tail time and the point times are whole us
+const double TOLERANCE_US = 2;
+} // namespace
+
+int main()
+{
+    GeneratorConfig config;
+    config.type       = LidarType::AT128;
+    config.returnMode = ReturnMode::STRONGEST;
+    PacketGenerator generator(config);
+    const uint32_t laserNum = generator.config().laserNum;
+    const uint32_t blockNum = generator.config().blockNum;
+    const double firingUs   = 1e6 / generator.packetRate() / blockNum;
+
+    Udp4_3_Parser parser;
+    std::vector<uint8_t> packet(generator.packetSize());
+    std::vector<dwLidarPointXYZI> pointXYZI(laserNum * blockNum);
+    std::vector<dwLidarPointRTHI> pointRTHI(laserNum * blockNum);
+    std::vector<dwTime_t> pointTime(laserNum * blockNum);
+    double maxError = 0;
+    uint32_t maxErrorPacket = 0;
+    dwTime_t lastBlockTime = 0;
+    for (uint32_t i = 0; i < PACKET_NUM; i++) {
+        size_t size = generator.next(packet.data());
+        dwLidarDecodedPacket output;
+        memset(&output, 0, sizeof(output));
+        PointExtraOutput extra;
+        extra.pointTimestamp = pointTime.data();
+        if (parser.ParserOnePacket(&output, packet.data(), size, pointXYZI.data(), pointRTHI.data(), &extra) !=
+            DW_SUCCESS) {
+            printf("AT128 packet %u decode Error\n", i);
+            return 1;
+        }
+        // the tail time is the time of the first block
+        double error = fabs(static_cast<double>(pointTime[0] - output.sensorTimestamp));
+        for (uint32_t block = 0; block < blockNum; block++) {
+            dwTime_t blockTime = pointTime[block * laserNum];
+            dwTime_t formerTime = block > 0 ? pointTime[(block - 1) * laserNum] : lastBlockTime;
+            if (block > 0 || i > 0) {
+                error = std::max(error, fabs(static_cast<double>(blockTime - formerTime) - firingUs));
+            }
+        }
+        if (error > maxError) {
+            maxError       = error;
+            maxErrorPacket = i;
+        }
+        lastBlockTime = pointTime[(blockNum - 1) * laserNum];
+    }
+
+    bool ok = maxError <= TOLERANCE_US;
+    printf("AT128 block time: %u packets, firing %.3f us, max error %.3f us at packet %u, tolerance %.1f us %s\n",
+           PACKET_NUM, firingUs, maxError, maxErrorPacket, TOLERANCE_US, ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
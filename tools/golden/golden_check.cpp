@@ -0,0 +1,488 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Golden output harness of the udp parsers. Each packet of a synthetic or captured stream is decoded by the frozen
+// reference copy of the parsers in 'reference/' and by the current parsers, through 'ParserOnePacket' or through
+// the 'DecodePool' of the plugin, and the outputs are compared field by field. The max error of each field is
+// reported against its tolerance, the exit code is 1 if any is above it. The reference is the parsers of commit
+// 669ad15 with the output fixes listed at the head of each of its files, not the parsers of the first release.
+//
+// Tolerances, the defaults allow float rounding of reordered arithmetic only:
+//   status, nPoints, scanComplete, maxPoints    exact
+//   sensorTimestamp, duration                   --tol-time us, default 0
+//   per-point timestamp                         --tol-point-time us, default 1
+//   x, y, z                                     --tol-xyz m, default 1e-4
+//   radius                                      --tol-radius m, default 1e-4
+//   theta, phi and the packet min/max angles    --tol-angle rad, default 1e-5
+//   intensity                                   --tol-intensity, default 0
+// A fixed point or reduced precision decoder is validated with wider tolerances, e.g. --tol-xyz 0.005
+
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DecodePool.h"
+#include "PacketGenerator.h"
+#include "PcapFile.h"
+#include "Udp1_4_Parser.h"
+#include "Udp3_2_Parser.h"
+#include "Udp4_3_Parser.h"
+#include "reference/Udp1_4_Parser.h"
+#include "reference/Udp3_2_Parser.h"
+#include "reference/Udp4_3_Parser.h"
+
+using namespace dw::plugins::lidar;
+using namespace dw::plugins::lidar::tools;
+
+namespace
+{
+const size_t MAX_PACKET_POINTS = MAX_LASER_NUM * MAX_BLOCK_NUM;
+// jobs in flight of the decode pool, as 'decode_threads' of the plugin
+const uint32_t POOL_QUEUE_SIZE = 64;
+
+enum Field
+{
+    FIELD_STATUS = 0,
+    FIELD_POINT_NUM,
+    FIELD_MAX_POINTS,
+    FIELD_SCAN_COMPLETE,
+    FIELD_SENSOR_TIME,
+    FIELD_DURATION,
+    FIELD_PACKET_ANGLE,
+    FIELD_XYZ,
+    FIELD_INTENSITY,
+    FIELD_RADIUS,
+    FIELD_THETA_PHI,
+    FIELD_POINT_TIME,
+    FIELD_NUM
+};
+
+const char* const FIELD_NAMES[FIELD_NUM] = {"status",    "nPoints", "maxPoints", "scanComplete", "sensorTimestamp",
+                                            "duration",  "min/max angle", "xyz", "intensity", "radius",
+                                            "theta/phi", "point time"};
+
+struct Options
+{
+    std::vector<LidarType> types;
+    std::string pcap;
+    int port = 0;
+    // synthetic packets per stream, 0 for two spins
+    uint32_t packets = 0;
+    // 0 for 'ParserOnePacket', else the decode pool with this many workers
+    uint32_t threads = 0;
+    bool deskew      = false;
+    // the pool side is given the time buffer of the points, as the plugin with point_time=1
+    bool pointTime   = true;
+    std::string share = HESAI_SHARE_DIR;
+    double tolerance[FIELD_NUM] = {0, 0, 0, 0, 0, 0, 1e-5, 1e-4, 0, 1e-4, 1e-5, 1};
+};
+
+// One packet stream of one lidar
+struct Stream
+{
+    std::string name;
+    LidarType type;
+    std::vector<std::vector<uint8_t>> packets;
+};
+
+struct Report
+{
+    double maxError[FIELD_NUM] = {};
+    // first packet of the max error
+    uint64_t packet[FIELD_NUM] = {};
+    uint64_t packetNum         = 0;
+    uint64_t pointNum          = 0;
+    uint64_t frameNum          = 0;
+
+    void add(Field field, double error, uint64_t index)
+    {
+        if (error > maxError[field]) {
+            maxError[field] = error;
+            packet[field]   = index;
+        }
+    }
+};
+
+// Decoded packet, the points are copied as the buffers are reused
+struct Decoded
+{
+    dwStatus status = DW_FAILURE;
+    dwLidarDecodedPacket output;
+    std::vector<dwLidarPointXYZI> pointXYZI = std::vector<dwLidarPointXYZI>(MAX_PACKET_POINTS);
+    std::vector<dwLidarPointRTHI> pointRTHI = std::vector<dwLidarPointRTHI>(MAX_PACKET_POINTS);
+    std::vector<dwTime_t> pointTime         = std::vector<dwTime_t>(MAX_PACKET_POINTS);
+};
+
+void usage(const char* name)
+{
+    printf("Usage: %s [options]\n"
+           "  --lidar <type>          P128, QT128 or AT128, may be repeated. All three by default\n"
+           "  --pcap <file>           the point cloud packets of a capture instead of synthetic ones\n"
+           "  --port <port>           only the datagrams of the capture sent to this port\n"
+           "  --packets <n>           synthetic packets per stream, two spins by default\n"
+           "  --threads <n>           decode the current side with the decode pool of n workers\n"
+           "  --deskew                with ego motion compensation on both sides\n"
+           "  --no-point-time         no time buffer for the decode pool, its jobs time the points for the deskew\n"
+           "  --share <dir>           folder of the correction and firetime files, default %s\n"
+           "  --tol-time <us>         sensor timestamp and duration, default 0\n"
+           "  --tol-point-time <us>   per-point timestamp, default 1\n"
+           "  --tol-xyz <m>           default 1e-4\n"
+           "  --tol-radius <m>        default 1e-4\n"
+           "  --tol-angle <rad>       theta, phi and the min/max angles of the packet, default 1e-5\n"
+           "  --tol-intensity <n>     default 0\n",
+           name, HESAI_SHARE_DIR);
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    static const struct option longOptions[] = {
+        {"lidar", required_argument, nullptr, 'l'},         {"pcap", required_argument, nullptr, 'f'},
+        {"port", required_argument, nullptr, 'p'},          {"packets", required_argument, nullptr, 'n'},
+        {"threads", required_argument, nullptr, 'j'},       {"deskew", no_argument, nullptr, 'k'},
+        {"share", required_argument, nullptr, 'd'},         {"tol-time", required_argument, nullptr, 'T'},
+        {"tol-point-time", required_argument, nullptr, 'P'}, {"tol-xyz", required_argument, nullptr, 'X'},
+        {"tol-radius", required_argument, nullptr, 'R'},    {"tol-angle", required_argument, nullptr, 'A'},
+        {"tol-intensity", required_argument, nullptr, 'I'}, {"no-point-time", no_argument, nullptr, 'N'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}};
+    int c;
+    while ((c = getopt_long(argc, argv, "h", longOptions, nullptr)) != -1) {
+        switch (c) {
+        case 'l': {
+            LidarType type;
+            if (!ParseLidarType(optarg, type)) {
+                printf("unknown lidar type %s\n", optarg);
+                return false;
+            }
+            options.types.push_back(type);
+            break;
+        }
+        case 'f': options.pcap = optarg; break;
+        case 'p': options.port = atoi(optarg); break;
+        case 'n': options.packets = static_cast<uint32_t>(strtoul(optarg, nullptr, 10)); break;
+        case 'j': options.threads = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'k': options.deskew = true; break;
+        case 'N': options.pointTime = false; break;
+        case 'd': options.share = optarg; break;
+        case 'T': options.tolerance[FIELD_SENSOR_TIME] = options.tolerance[FIELD_DURATION] = atof(optarg); break;
+        case 'P': options.tolerance[FIELD_POINT_TIME] = atof(optarg); break;
+        case 'X': options.tolerance[FIELD_XYZ] = atof(optarg); break;
+        case 'R': options.tolerance[FIELD_RADIUS] = atof(optarg); break;
+        case 'A': options.tolerance[FIELD_THETA_PHI] = options.tolerance[FIELD_PACKET_ANGLE] = atof(optarg); break;
+        case 'I': options.tolerance[FIELD_INTENSITY] = atof(optarg); break;
+        default: return false;
+        }
+    }
+    if (options.types.empty()) {
+        options.types = {LidarType::P128, LidarType::QT128, LidarType::AT128};
+    }
+    return true;
+}
+
+// Parser with the shipped calibration, the same files for the reference and the current one
+template <typename Base, typename MeV4, typename QtV2, typename StV3>
+std::unique_ptr<Base> createParser(LidarType type, const std::string& share)
+{
+    std::unique_ptr<Base> parser;
+    std::string correction;
+    std::string firetimes;
+    switch (type) {
+    case LidarType::P128:
+        parser.reset(new MeV4());
+        correction = share + "/correction_p128.dat";
+        firetimes  = share + "/firetime_correction_Pandar128.csv";
+        break;
+    case LidarType::QT128:
+        parser.reset(new QtV2());
+        correction = share + "/correction_qt128.dat";
+        firetimes  = share + "/firetime_qt128.dat";
+        break;
+    case LidarType::AT128:
+        parser.reset(new StV3());
+        correction = share + "/correction_at128.dat";
+        break;
+    }
+    if (parser->LoadCorrectionFile(correction) != 0) {
+        printf("%s: load %s Error\n", LidarTypeName(type), correction.c_str());
+        return nullptr;
+    }
+    if (!firetimes.empty()) {
+        parser->LoadFiretimesFile(firetimes);
+    }
+    return parser;
+}
+
+// A car turning at 10 m/s, enough to move the points by a few cm within a spin
+template <typename Parser, typename Motion>
+void setDeskew(Parser& parser)
+{
+    Motion motion;
+    motion.linearVelocity[0]  = 10;
+    motion.linearVelocity[1]  = 0.5f;
+    motion.linearVelocity[2]  = 0;
+    motion.angularVelocity[0] = 0;
+    motion.angularVelocity[1] = 0;
+    motion.angularVelocity[2] = 0.3f;
+    motion.referenceTime      = 0;
+    parser.SetDeskewMotion(motion);
+}
+
+// Synthetic streams of each lidar, the packet parts and return modes the parsers branch on
+void generateStreams(const Options& options, std::vector<Stream>& streams)
+{
+    for (LidarType type : options.types) {
+        struct Variant
+        {
+            const char* name;
+            ReturnMode returnMode;
+            Scene scene;
+            bool funcSafety;
+            bool seqNum;
+        };
+        const Variant variants[] = {
+            {"strongest", ReturnMode::STRONGEST, Scene::HALL, true, true},
+            {"dual", ReturnMode::DUAL, Scene::HALL, true, true},
+            {"last, bare", ReturnMode::LAST, Scene::RANDOM, false, false},
+        };
+        for (const Variant& variant : variants) {
+            GeneratorConfig config;
+            config.type       = type;
+            config.returnMode = variant.returnMode;
+            config.scene      = variant.scene;
+            config.funcSafety = variant.funcSafety;
+            config.seqNum     = variant.seqNum;
+            PacketGenerator generator(config);
+            Stream stream;
+            stream.name = std::string(LidarTypeName(type)) + " " + variant.name;
+            stream.type = type;
+            uint32_t count = options.packets != 0 ? options.packets : generator.packetsPerSpin() * 2;
+            stream.packets.resize(count, std::vector<uint8_t>(generator.packetSize()));
+            for (auto& packet : stream.packets) {
+                packet.resize(generator.next(packet.data()));
+            }
+            streams.push_back(std::move(stream));
+        }
+    }
+}
+
+void loadCapture(const Options& options, std::vector<Stream>& streams)
+{
+    PcapFile pcap;
+    if (!pcap.open(options.pcap)) {
+        return;
+    }
+    std::vector<Stream> byType(3);
+    UdpDatagram datagram;
+    while (pcap.next(datagram)) {
+        LidarType type;
+        if ((options.port != 0 && datagram.dstPort != options.port) ||
+            !DetectLidarType(datagram.payload, datagram.length, type) ||
+            std::find(options.types.begin(), options.types.end(), type) == options.types.end()) {
+            continue;
+        }
+        Stream& stream = byType[static_cast<int>(type)];
+        stream.name    = std::string(LidarTypeName(type)) + " capture";
+        stream.type    = type;
+        stream.packets.emplace_back(datagram.payload, datagram.payload + datagram.length);
+    }
+    for (Stream& stream : byType) {
+        if (!stream.packets.empty()) {
+            streams.push_back(std::move(stream));
+        }
+    }
+}
+
+void compare(const Decoded& reference, const Decoded& current, bool withTime, uint64_t index, Report& report)
+{
+    const dwLidarDecodedPacket& a = reference.output;
+    const dwLidarDecodedPacket& b = current.output;
+    report.add(FIELD_STATUS, reference.status != current.status, index);
+    if (reference.status != DW_SUCCESS || current.status != DW_SUCCESS) {
+        return;
+    }
+    report.add(FIELD_POINT_NUM, fabs(static_cast<double>(a.nPoints) - b.nPoints), index);
+    report.add(FIELD_MAX_POINTS, fabs(static_cast<double>(a.maxPoints) - b.maxPoints), index);
+    report.add(FIELD_SCAN_COMPLETE, a.scanComplete != b.scanComplete, index);
+    report.add(FIELD_SENSOR_TIME, fabs(static_cast<double>(a.sensorTimestamp - b.sensorTimestamp)), index);
+    report.add(FIELD_DURATION, fabs(static_cast<double>(a.duration - b.duration)), index);
+    double angle = std::max(std::max(fabs(a.minHorizontalAngleRad - b.minHorizontalAngleRad),
+                                     fabs(a.maxHorizontalAngleRad - b.maxHorizontalAngleRad)),
+                            std::max(fabs(a.minVerticalAngleRad - b.minVerticalAngleRad),
+                                     fabs(a.maxVerticalAngleRad - b.maxVerticalAngleRad)));
+    report.add(FIELD_PACKET_ANGLE, angle, index);
+    uint32_t pointNum = std::min(a.nPoints, b.nPoints);
+    for (uint32_t i = 0; i < pointNum; i++) {
+        const dwLidarPointXYZI& p = reference.pointXYZI[i];
+        const dwLidarPointXYZI& q = current.pointXYZI[i];
+        report.add(FIELD_XYZ, std::max(std::max(fabs(p.x - q.x), fabs(p.y - q.y)), fabs(p.z - q.z)), index);
+        const dwLidarPointRTHI& r = reference.pointRTHI[i];
+        const dwLidarPointRTHI& s = current.pointRTHI[i];
+        report.add(FIELD_INTENSITY, std::max(fabs(p.intensity - q.intensity), fabs(r.intensity - s.intensity)), index);
+        report.add(FIELD_RADIUS, fabs(r.radius - s.radius), index);
+        report.add(FIELD_THETA_PHI, std::max(fabs(r.theta - s.theta), fabs(r.phi - s.phi)), index);
+        if (withTime) {
+            report.add(FIELD_POINT_TIME, fabs(static_cast<double>(reference.pointTime[i] - current.pointTime[i])),
+                       index);
+        }
+    }
+    report.packetNum++;
+    report.pointNum += a.nPoints;
+    report.frameNum += a.scanComplete;
+}
+
+// The reference side, always 'ParserOnePacket' as the plugin did when it was frozen
+void decodeReference(golden_ref::GeneralParser& parser, const std::vector<uint8_t>& packet, Decoded& decoded)
+{
+    memset(&decoded.output, 0, sizeof(decoded.output));
+    golden_ref::PointExtraOutput extra;
+    extra.pointTimestamp = decoded.pointTime.data();
+    decoded.status = parser.ParserOnePacket(&decoded.output, packet.data(), packet.size(), decoded.pointXYZI.data(),
+                                            decoded.pointRTHI.data(), &extra);
+}
+
+void decodeCurrent(GeneralParser& parser, const std::vector<uint8_t>& packet, Decoded& decoded)
+{
+    memset(&decoded.output, 0, sizeof(decoded.output));
+    PointExtraOutput extra;
+    extra.pointTimestamp = decoded.pointTime.data();
+    decoded.status = parser.ParserOnePacket(&decoded.output, packet.data(), packet.size(), decoded.pointXYZI.data(),
+                                            decoded.pointRTHI.data(), &extra);
+}
+
+// Sequence a job of the pool as 'parseData' of the plugin does, the points are copied out of the ring
+void collectJob(GeneralParser& parser, DecodeJob& job, Decoded& decoded)
+{
+    decoded.status = job.status;
+    decoded.output = job.output;
+    if (job.status == DW_SUCCESS) {
+        parser.DeskewPoints(job.pointXYZI, job.extra.pointTimestamp, job.output.nPoints, job.output.sensorTimestamp);
+    }
+    parser.SequencePacket(&decoded.output, job.info);
+    size_t pointNum = std::min<size_t>(decoded.output.nPoints, MAX_PACKET_POINTS);
+    std::copy(job.pointXYZI, job.pointXYZI + pointNum, decoded.pointXYZI.begin());
+    std::copy(job.pointRTHI, job.pointRTHI + pointNum, decoded.pointRTHI.begin());
+    std::copy(job.extra.pointTimestamp, job.extra.pointTimestamp + pointNum, decoded.pointTime.begin());
+}
+
+bool checkStream(const Stream& stream, const Options& options)
+{
+    auto reference = createParser<golden_ref::GeneralParser, golden_ref::Udp1_4_Parser, golden_ref::Udp3_2_Parser,
+                                  golden_ref::Udp4_3_Parser>(stream.type, options.share);
+    auto current = createParser<GeneralParser, Udp1_4_Parser, Udp3_2_Parser, Udp4_3_Parser>(stream.type, options.share);
+    if (reference == nullptr || current == nullptr) {
+        return false;
+    }
+    if (options.deskew) {
+        setDeskew<golden_ref::GeneralParser, golden_ref::DeskewMotion>(*reference);
+        setDeskew<GeneralParser, DeskewMotion>(*current);
+    }
+
+    Report report;
+    Decoded expected;
+    Decoded actual;
+    if (options.threads == 0) {
+        for (size_t i = 0; i < stream.packets.size(); i++) {
+            decodeReference(*reference, stream.packets[i], expected);
+            decodeCurrent(*current, stream.packets[i], actual);
+            compare(expected, actual, true, i, report);
+        }
+    } else {
+        // one point slot per job in flight, as the packet slots of the plugin
+        std::vector<dwLidarPointXYZI> pointXYZI(POOL_QUEUE_SIZE * MAX_PACKET_POINTS);
+        std::vector<dwLidarPointRTHI> pointRTHI(POOL_QUEUE_SIZE * MAX_PACKET_POINTS);
+        std::vector<dwTime_t> pointTime(POOL_QUEUE_SIZE * MAX_PACKET_POINTS);
+        DecodePool pool(current.get(), options.threads, POOL_QUEUE_SIZE, MAX_PACKET_POINTS);
+        size_t submitted = 0;
+        for (size_t collected = 0; collected < stream.packets.size(); collected++) {
+            while (submitted < stream.packets.size() && submitted - collected < POOL_QUEUE_SIZE) {
+                const std::vector<uint8_t>& packet = stream.packets[submitted];
+                UdpPacket udp;
+                udp.m_i16Len = static_cast<int16_t>(std::min(packet.size(), sizeof(udp.m_u8Buf)));
+                memcpy(udp.m_u8Buf, packet.data(), udp.m_i16Len);
+                size_t slot = (submitted % POOL_QUEUE_SIZE) * MAX_PACKET_POINTS;
+                PointExtraOutput extra;
+                if (options.pointTime) {
+                    extra.pointTimestamp = pointTime.data() + slot;
+                }
+                if (!pool.submit(udp, pointXYZI.data() + slot, pointRTHI.data() + slot, extra)) {
+                    break;
+                }
+                submitted++;
+            }
+            DecodeJob* job = pool.collect();
+            if (job == nullptr) {
+                break;
+            }
+            collectJob(*current, *job, actual);
+            pool.release();
+            decodeReference(*reference, stream.packets[collected], expected);
+            compare(expected, actual, true, collected, report);
+        }
+    }
+
+    bool passed = true;
+    printf("%s: %lu packets, %lu points, %lu frames\n", stream.name.c_str(),
+           static_cast<unsigned long>(report.packetNum), static_cast<unsigned long>(report.pointNum),
+           static_cast<unsigned long>(report.frameNum));
+    for (int field = 0; field < FIELD_NUM; field++) {
+        bool ok = report.maxError[field] <= options.tolerance[field];
+        passed  = passed && ok;
+        printf("  %-16s max error %-12.6g tolerance %-10.6g %s", FIELD_NAMES[field], report.maxError[field],
+               options.tolerance[field], ok ? "ok" : "FAIL");
+        if (!ok) {
+            printf(" first at packet %lu", static_cast<unsigned long>(report.packet[field]));
+        }
+        printf("\n");
+    }
+    return passed && report.packetNum > 0;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+    std::vector<Stream> streams;
+    if (!options.pcap.empty()) {
+        loadCapture(options, streams);
+    } else {
+        generateStreams(options, streams);
+    }
+    if (streams.empty()) {
+        printf("no packet to check\n");
+        return 2;
+    }
+    printf("reference ParserOnePacket against current %s%s\n",
+           options.threads == 0 ? "ParserOnePacket" : "DecodePool", options.deskew ? ", deskew" : "");
+    int failed = 0;
+    for (const Stream& stream : streams) {
+        failed += !checkStream(stream, options);
+    }
+    printf("%d of %zu streams %s\n", failed != 0 ? failed : static_cast<int>(streams.size()), streams.size(),
+           failed != 0 ? "failed" : "passed");
+    return failed != 0 ? 1 : 0;
+}
@@ -0,0 +1,348 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd] 
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Frozen reference copy of UdpParser/src/GeneralParser.cpp for the golden harness, see tools/golden/golden_check.cpp.
+// Copied at commit 669ad15, the one adding the harness, so it holds the decoder changes made before it and not the
+// parser of the first release. Only the namespace and the include guard differ from the original of 669ad15.
+// Do not optimise it, the optimised decoders are compared against it
+
+#include "GeneralParser.h"
+#include "TextScanner.h"
+
+namespace golden_ref {
+
+const std::string GeneralParser::kLidarIPAddr("192.168.1.201");
+
+GeneralParser::GeneralParser()
+    : m_fCosAllAngle(CIRCLE), m_fSinAllAngle(CIRCLE) {
+  for(int i = 0; i < CIRCLE; ++i) {
+      m_fSinAllAngle[i] = std::sin(2 * M_PI * i / CIRCLE);
+      m_fCosAllAngle[i] = std::cos(2 * M_PI * i / CIRCLE);
+  }
+}
+
+GeneralParser::~GeneralParser() {
+  // printf("release general Parser\n");
+}
+
+int GeneralParser::LoadCorrectionFile(std::string correction_path) {
+  // printf("GeneralParser: load correction file, path=%s \n", correction_path.c_str());
+  std::vector<char> buffer;
+  if (!ReadTextFile(correction_path, buffer)) {
+    printf("Open correction file Error, path=%s\n", correction_path.c_str());
+    return -1;
+  }
+
+  int ret = ParseCorrectionString(buffer.data());
+  if (ret != 0) {
+    printf("Parse local correction file Error\n");
+  } 
+
+  return ret;
+}
+
+bool GeneralParser::ReadTextFile(const std::string& path, std::vector<char>& buffer) {
+  FILE* fp = fopen(path.c_str(), "rb");
+  if (fp == nullptr) {
+    return false;
+  }
+  bool ok = fseek(fp, 0, SEEK_END) == 0;
+  long length = ok ? ftell(fp) : -1;
+  ok = length >= 0 && fseek(fp, 0, SEEK_SET) == 0;
+  if (ok) {
+    buffer.resize(length + 1);
+    ok = fread(buffer.data(), 1, length, fp) == static_cast<size_t>(length);
+    // the parsers take zero terminated strings
+    buffer[length] = '\0';
+  }
+  fclose(fp);
+  return ok;
+}
+
+int GeneralParser::ParseCorrectionString(char* correction_content) {
+  // printf("ParseCorrectionString: parsing calibration content\n %s \n", correction_content);
+  return ParseCorrectionCsv(correction_content, strlen(correction_content));
+}
+
+int GeneralParser::ParseCorrectionCsv(const char* data, size_t size) {
+  TextScanner scanner(data, size);
+  TextSpan line;
+  TextSpan field;
+
+  // skip first line "Laser id,Elevation,Azimuth" or "eeff"
+  if (!scanner.NextLine(line)) {
+    printf("ParseCorrectionString: empty correction Error\n");
+    return -1;
+  }
+  FieldScanner firstLine(line);
+  firstLine.Next(field);
+  if (field.EqualsNoCase("eeff")) {
+    // skip second line
+    scanner.NextLine(line);
+  }
+
+  int32_t elevationList[MAX_LASER_NUM], azimuthList[MAX_LASER_NUM];
+  int lineCount = 0;
+  while (scanner.NextLine(line)) {
+    FieldScanner fields(line);
+    if (fields.Count() < 3) { // skip error line or hash value line 
+      continue;
+    }
+    lineCount++;
+    int laserId = 0;
+    float elevation = 0, azimuth = 0;
+    fields.Next(field);
+    ParseInt(field, laserId);
+    if (laserId != lineCount || laserId >= MAX_LASER_NUM) {
+      printf("ParseCorrectionString: laser id Error. laser Id=%d, line=%d\n", laserId, lineCount);
+      return -1;
+    }
+    fields.Next(field);
+    bool ok = ParseFloat(field, elevation);
+    fields.Next(field);
+    ok = ParseFloat(field, azimuth) && ok;
+    if (!ok) {
+      printf("ParseCorrectionString: angle Error. laser Id=%d\n", laserId);
+      return -1;
+    }
+    elevationList[laserId - 1] = static_cast<int32_t> (round(elevation * m_iAziCorrUnit));
+    azimuthList[laserId - 1] = static_cast<int32_t> (round(azimuth * m_iAziCorrUnit));
+  }
+  auto correction = std::make_shared<LaserCorrection>();
+  correction->elevation.assign(elevationList, elevationList + lineCount);
+  correction->azimuth.assign(azimuthList, azimuthList + lineCount);
+  PublishCalibration(m_pLaserCorrection, std::shared_ptr<const LaserCorrection>(correction));
+
+  m_bGetCorrectionFile = true;
+  return 0;
+}
+
+int GeneralParser::LoadFiretimesString(const char *firetimes) {
+  printf("GeneralParser::LoadFiretimesString, no load\n");
+  (void) firetimes;
+
+  return -1;
+}
+
+void GeneralParser::LoadFiretimesFile(std::string firetimes_path) {
+  std::vector<char> buffer;
+  if (!ReadTextFile(firetimes_path, buffer)) {
+    printf("LoadFiretimesFile: Open firetimes file Error, path=%s\n", firetimes_path.c_str());
+    return;
+  }
+
+  int ret = LoadFiretimesString(buffer.data());
+  if (ret != 0) {
+    printf("LoadFiretimesFile: Parse local firetimes file Error\n");
+  }
+}
+
+void GeneralParser::SetDeskewMotion(const DeskewMotion& motion) {
+  std::lock_guard<std::mutex> lock(m_deskewMutex);
+  m_deskewMotion = motion;
+  m_bDeskew = true;
+}
+
+void GeneralParser::DisableDeskew() {
+  std::lock_guard<std::mutex> lock(m_deskewMutex);
+  m_bDeskew = false;
+}
+
+bool GeneralParser::GetDeskewMotion(DeskewMotion& motion) {
+  std::lock_guard<std::mutex> lock(m_deskewMutex);
+  if (!m_bDeskew) return false;
+  motion = m_deskewMotion;
+  if (motion.referenceTime == 0) {
+    motion.referenceTime = m_i64ScanStartTime;
+  }
+  return true;
+}
+
+dwStatus GeneralParser::ParserOnePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length,
+                                        dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI,
+                                        PointExtraOutput* extra) {
+  // single thread, the deskew is fused in the decode loop
+  DeskewMotion motion;
+  PacketDecodeInfo info;
+  dwStatus ret = DecodePacket(output, buffer, length, pointXYZI, pointRTHI, extra,
+                              GetDeskewMotion(motion) ? &motion : nullptr, info);
+  if (ret != DW_SUCCESS) info.splitAzimuthNum = 0;
+  SequencePacket(output, info);
+  return ret;
+}
+
+void GeneralParser::SequencePacket(dwLidarDecodedPacket *output, const PacketDecodeInfo& info) {
+  if (info.hasTail) {
+    m_u16SpinSpeed = info.spinSpeed;
+    m_bIsDualReturn = info.isDualReturn;
+  }
+  if (info.splitAzimuthNum == 0) return;
+
+  if (m_i64ScanStartTime == 0) {
+    m_i64ScanStartTime = output->sensorTimestamp;
+  }
+  for (int i = 0; i < info.splitAzimuthNum; i++) {
+    if (IsNeedFrameSplit(info.splitAzimuth[i])) {
+      output->scanComplete = true;
+    }
+    m_u16LastAzimuth = info.splitAzimuth[i];
+  }
+  // the next packet starts a new scan
+  if (output->scanComplete) m_i64ScanStartTime = 0;
+}
+
+void GeneralParser::DeskewPoints(dwLidarPointXYZI* pointXYZI, const dwTime_t* pointTimestamp, uint32_t pointNum,
+                                 int64_t packetTime, CompactPoint* compactPoint) {
+  DeskewMotion motion;
+  if (pointTimestamp == nullptr || !GetDeskewMotion(motion)) return;
+  if (motion.referenceTime == 0) motion.referenceTime = packetTime;
+  for (uint32_t i = 0; i < pointNum; i++) {
+    FinishPoint(pointXYZI[i], nullptr, pointTimestamp[i], &motion);
+    if (compactPoint != nullptr) {
+      PackCompactPoint(compactPoint[i], pointXYZI[i], compactPoint[i].laserId);
+    }
+  }
+}
+
+int GeneralParser::BindNumaNode(int node) {
+  int ret = m_fCosAllAngle.BindNode(node);
+  ret |= m_fSinAllAngle.BindNode(node);
+  return ret;
+}
+
+bool GeneralParser::ParseTailStatus(const uint8_t *buffer, size_t length, TailStatus& status) {
+  return false;
+}
+
+bool GeneralParser::ParsePacketId(const uint8_t *buffer, size_t length, uint32_t& sequence, uint16_t& azimuth) {
+  return false;
+}
+
+RangeImageLayout GeneralParser::GetRangeImageLayout() const {
+  RangeImageLayout layout;
+  layout.rows = 128;
+  layout.cols = 3600;
+  layout.returns = 2;
+  layout.azimuthStart = 0;
+  layout.azimuthStep = 100;
+  layout.unitsPerRev = CIRCLE;
+  return layout;
+}
+
+int GeneralParser::LoadChannelConfigString(const char *channelconfig) {
+  printf("GeneralParser::LoadChannelConfigString, no load\n");
+  (void) channelconfig;
+
+  return -1;
+}
+
+void GeneralParser::LoadChannelConfigFile(std::string channel_config_path) {
+  printf("GeneralParser::LoadChannelConfigFile, no load\n");
+  (void) channel_config_path;
+
+  return;
+}
+
+int16_t GeneralParser::GetVecticalAngle(int channel) {
+  std::shared_ptr<const LaserCorrection> correction = GetLaserCorrection();
+  if (correction == nullptr || channel < 0 || static_cast<size_t>(channel) >= correction->elevation.size()) {
+    return -1;
+  }
+  return correction->elevation[channel];
+}
+
+bool GeneralParser::IsNeedFrameSplit(uint16_t azimuth) {
+  if (abs(azimuth - m_u16LastAzimuth) > kAzimuthTolerance &&
+        m_u16LastAzimuth != 0 ) {
+      return true;
+    }
+  return false;
+}
+
+int64_t GeneralParser::GetMicroLidarTimeU64(const uint8_t* utc, int size, uint32_t timestamp) const {
+  if (size != 6) {
+    printf("GetMicroLidarTimeU64: array utc size is not 6 Error\n");
+    return -1;
+  }
+
+  if (utc[0] != 0) {
+    struct tm t = {0};
+    t.tm_year = utc[0];
+    if (t.tm_year >= 200) {
+      t.tm_year -= 100;
+    }
+    t.tm_mon = utc[1] - 1;
+    t.tm_mday = utc[2];
+    t.tm_hour = utc[3];
+    t.tm_min = utc[4];
+    t.tm_sec = utc[5];
+    t.tm_isdst = 0;
+    return (mktime(&t)) * 1000000 + timestamp;
+  }
+  else {
+    uint32_t utc_time_big = *(uint32_t*)(&utc[0] + 2);
+    int unix_second = ((utc_time_big >> 24) & 0xff) |
+            ((utc_time_big >> 8) & 0xff00) |
+            ((utc_time_big << 8) & 0xff0000) |
+            ((utc_time_big << 24));
+    return unix_second * 1000000 + timestamp;
+  }
+}
+
+dwStatus GeneralParser::ComputeDwPoint(dwLidarPointXYZI& pointXYZI, dwLidarPointRTHI& pointRTHI, double radius, int32_t elevation, int32_t azimuth, uint8_t intensity) {
+  // only 0 - 360 00
+  double xyDistance = radius * this->m_fCosAllAngle[elevation];
+  pointXYZI.x = xyDistance * this->m_fSinAllAngle[azimuth];
+  pointXYZI.y = xyDistance * this->m_fCosAllAngle[azimuth];
+  pointXYZI.z = radius * this->m_fSinAllAngle[elevation];
+  pointXYZI.intensity = intensity;  // float type 0-1 /255.0f
+
+  pointRTHI.radius = radius;
+  // 100 is the unit!!
+  pointRTHI.theta = azimuth / m_iAziCorrUnit / 180 * M_PI;
+  pointRTHI.phi = elevation / m_iAziCorrUnit / 180 * M_PI;
+  pointRTHI.intensity = intensity;
+
+  return DW_SUCCESS;
+}
+
+int32_t GeneralParser::CalibrateAzimuth(int32_t azimuth, unsigned int laserID, const LaserCorrection& correction) {
+  // azimuth from UDP packet has unit 100, but correction file is 1000
+  int32_t result = azimuth * 10 + correction.azimuth[laserID];
+  result = (CIRCLE + result) % CIRCLE;
+  // printf("azimuth=%d \n", result);
+  
+  return result;
+}
+
+void GeneralParser::PrintDwPoint(const dwLidarPointXYZI* point) {
+  printf("x:%f, y:%f, z:%f, intensity:%f \n", point->x, point->y, point->z, point->intensity);
+}
+
+void GeneralParser::PrintDwPoint(const dwLidarPointRTHI* point) {
+  printf("theta:%f, phi:%f, radius:%f, intensity:%f \n", point->theta, point->phi, point->radius, point->intensity);
+}
+
+void GeneralParser::PrintDwPacket(const dwLidarDecodedPacket *packet) {
+  printf("hostTimestamp=%ld, sensorTimestamp=%ld, duration=%ld, maxPoints=%d, nPoints=%d \n",
+          packet->hostTimestamp, packet->sensorTimestamp, packet->duration, packet->maxPoints, packet->nPoints);
+  printf("minHorizontalAngleRad=%f, maxHorizontalAngleRad=%f, minVerticalAngleRad=%f, maxVerticalAngleRad=%f \n",
+          packet->minHorizontalAngleRad, packet->maxHorizontalAngleRad, packet->minVerticalAngleRad, packet->maxVerticalAngleRad); 
+}
+
+}  // namespace golden_ref
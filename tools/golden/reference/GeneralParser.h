@@ -0,0 +1,412 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd] 
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Frozen reference copy of UdpParser/include/GeneralParser.h for the golden harness, see tools/golden/golden_check.cpp.
+// Copied at commit 669ad15, the one adding the harness, so it holds the decoder changes made before it and not the
+// parser of the first release. Only the namespace and the include guard differ from the original of 669ad15.
+// Do not optimise it, the optimised decoders are compared against it
+
+#ifndef GOLDEN_REF_GENERAL_PARSER_H_
+#define GOLDEN_REF_GENERAL_PARSER_H_
+
+// correction file has 3 digits, plus 1000
+#define CIRCLE (360000)
+#define MAX_LASER_NUM (512)
+#define MAX_BLOCK_NUM (16)
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+
+#include <dw/sensors/plugins/lidar/LidarDecoder.h>
+#include <dw/sensors/plugins/lidar/LidarPlugin.h>
+
+#include "RangeImage.h"
+#include "CompactPoint.h"
+#include "HugePageAllocator.h"
+
+namespace golden_ref {
+
+// Constant-velocity ego motion of the sensor used to deskew a scan, all in the sensor frame
+struct DeskewMotion {
+  // m/s
+  float linearVelocity[3];
+  // rad/s
+  float angularVelocity[3];
+  // sensor time (us) the points are compensated to, 0 means the start of the current scan
+  int64_t referenceTime;
+};
+
+// Optional outputs filled in the same pass as the xyzi/rthi points, leave a pointer null to skip it
+struct PointExtraOutput {
+  // sensor time of each point in us, same index as pointXYZI
+  dwTime_t* pointTimestamp = nullptr;
+  // organized grid of the scan, allocated with the layout from GetRangeImageLayout
+  RangeImage* rangeImage = nullptr;
+  // 8 byte quantized points, same index as pointXYZI
+  CompactPoint* compactPoint = nullptr;
+};
+
+// Stream state read from one packet by 'DecodePacket', applied in packet order by 'SequencePacket'
+struct PacketDecodeInfo {
+  // true once the tail is read, the fields below are valid
+  bool hasTail = false;
+  bool isDualReturn = false;
+  uint16_t spinSpeed = 0;
+  uint16_t laserNum = 0;
+  uint16_t blockNum = 0;
+  // azimuth of each block checked for the frame split, in block order
+  uint16_t splitAzimuth[MAX_BLOCK_NUM];
+  int splitAzimuthNum = 0;
+
+  inline void AddSplitAzimuth(uint16_t azimuth) {
+    if (splitAzimuthNum < MAX_BLOCK_NUM) splitAzimuth[splitAzimuthNum++] = azimuth;
+  }
+};
+
+// Status fields of a packet tail, read by 'ParseTailStatus'
+struct TailStatus {
+  // id and value of the status fields that rotate through the lidar status, e.g. a board temperature
+  uint8_t statusNum = 0;
+  uint8_t statusId[3] = {0};
+  uint16_t statusData[3] = {0};
+  uint16_t motorSpeed = 0;
+  uint8_t returnMode = 0;
+  bool shutdown = false;
+  // functional safety of Pandar128, if the packet has it
+  bool hasFuncSafety = false;
+  uint8_t lidarState = 0;
+  bool currentFault = false;
+  bool historyFault = false;
+  uint8_t faultNum = 0;
+  uint8_t faultId = 0;
+  uint16_t faultCode = 0;
+};
+
+// Angle correction of each laser from the correction file, unit 1/1000 degree. Immutable once published
+struct LaserCorrection {
+  std::vector<int32_t> elevation;
+  std::vector<int32_t> azimuth;
+};
+
+class GeneralParser {
+ public:
+  GeneralParser();
+  virtual ~GeneralParser();
+
+  /**
+   * @brief Introduce characteristic parameters of each lidar to Driveworks, e.g. speed
+   * @param[out] constants return struct stored the params
+   */
+  virtual dwStatus GetDecoderConstants(_dwSensorLidarDecoder_constants* constants) = 0;
+
+  /**
+   * @brief Decode the data buffer to a single packet
+   * 
+   * @param[out] output packet format ruled by driveworks
+   * @param[in] buffer data buffer of UDP
+   * @param[in] length length of data byte
+   * @param[out] pointXYZI return xyzi coordinate
+   * @param[out] pointRTHI return rthi coordinate
+   * @param[out] extra optional per-point outputs, e.g. timestamps
+   */
+  virtual dwStatus ParserOnePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length, \
+                                   dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI,
+                                   PointExtraOutput* extra = nullptr);
+
+  /**
+   * @brief Decode one packet without touching the stream state, so packets can be decoded by several threads.
+   * The output is complete except 'scanComplete', which is left false for 'SequencePacket'
+   *
+   * @param[in] motion deskew motion, nullptr to skip. Reference time 0 means the time of this packet
+   * @param[out] info stream state of the packet to be handed to 'SequencePacket'
+   */
+  virtual dwStatus DecodePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length,
+                                dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI, PointExtraOutput* extra,
+                                const DeskewMotion* motion, PacketDecodeInfo& info) = 0;
+
+  /**
+   * @brief Apply the stream state of a decoded packet, e.g. frame split. Must be called in packet order
+   */
+  virtual void SequencePacket(dwLidarDecodedPacket *output, const PacketDecodeInfo& info);
+
+  /**
+   * @brief Deskew the points of a packet decoded without motion, called in packet order before 'SequencePacket'
+   * as the reference time depends on the scan. The compact points are packed again if given
+   */
+  void DeskewPoints(dwLidarPointXYZI* pointXYZI, const dwTime_t* pointTimestamp, uint32_t pointNum,
+                    int64_t packetTime, CompactPoint* compactPoint = nullptr);
+  
+  /**
+   * @brief Use correction file to calibrate the azimuth of each laser channel
+   * @param correction snapshot taken by the decoder for the packet
+   * @return int32_t unit is 1000 360 000
+  */
+  virtual int32_t CalibrateAzimuth(int32_t azimuth, unsigned int laserID, const LaserCorrection& correction);
+
+  /**
+   * @brief Caculate the coordinates
+   * @param[out] pointXYZI Decoded coordinates of points
+   * @param[out] pointRTHI Decoded coordinates of points
+  */
+  virtual dwStatus ComputeDwPoint(dwLidarPointXYZI& pointXYZI, dwLidarPointRTHI& pointRTHI, double radius, int32_t elevation, int32_t azimuth, uint8_t intensity);
+
+  /**
+   * @brief Decode the correction bytes that controls the sequence of laser emitting, Only for QT128 
+   */
+  virtual int LoadFiretimesString(const char *firetimes);
+
+  /**
+   * @brief Load and decode the firetime file to correct lidar. For QT128 it displays normally even without.
+   * In the Web 192.168.1.201 you can check if the firetime of QT128 exist or not
+   * The file content is handed to 'LoadFiretimesString' of the derived class
+   */
+  virtual void LoadFiretimesFile(std::string firetimes_path);
+  
+  virtual int LoadChannelConfigString(const char *channelconfig);
+  virtual void LoadChannelConfigFile(std::string channel_config_path);
+
+  /**
+   * @brief Load the correction file from a local path, then call 'LoadCorrectionString' that might be overrided
+   */
+  virtual int LoadCorrectionFile(std::string correction_path);
+
+  /**
+   * @brief Parse the correction byte into typical data structure used in the derived class
+   * Global flag m_bGetCorrectionFile is set to true when it decodes succussfully
+   * Used in function 'LoadCorrectionFile', need to be override in the derived class
+   * QT128 P128 are the same. Can be called while decoding, the new correction is used from the next packet
+   */
+  virtual int ParseCorrectionString(char *correction_string);
+
+  /**
+   * @brief Correction in use, nullptr until one is parsed. The decoders take it once per packet
+   */
+  std::shared_ptr<const LaserCorrection> GetLaserCorrection() const { return std::atomic_load(&m_pLaserCorrection); }
+
+  /**
+   * @brief Get the vertical angle from the decoded correction file, specify which vertical angle of the laser channel
+   * @param channel 128 channel for P128 QT128
+   * @return int16_t return the vertical angle of the channel
+   */
+  virtual int16_t GetVecticalAngle(int channel);
+
+  /**
+   * @brief Compare to the latest azimuth, decide whether a complete frame is obtained or not. e.g. 359 00 - 0 00
+   * 
+   * @param azimuth normally from the UDP packet, unit 100, pAzimuth->GetAzimuth(), 355 * 100
+   * @return true A complete frame data is acquired 360 degree
+   * @return false Current azimuth belongs to the last scan, uncomplete scan
+   */
+  bool IsNeedFrameSplit(uint16_t azimuth);
+
+  // Set true if the correction file is sucessfully decoded
+  std::atomic<bool> m_bGetCorrectionFile{false};
+  // Return two points of each laser channel if the flag is set true, default dual return for P128
+  bool m_bIsDualReturn;
+  // Speed of lidar rotating spin
+  uint16_t m_u16SpinSpeed;
+  // Set true if the firetimes are sucessfully decoded
+  std::atomic<bool> m_bGetFiretimes{false};
+
+  /**
+   * @brief Motion compensate every decoded xyz point to the reference time of the motion, in the decode loop.
+   * Thread safe, can be updated by another thread while decoding, e.g. from the odometry
+   */
+  void SetDeskewMotion(const DeskewMotion& motion);
+  void DisableDeskew();
+
+  /**
+   * @brief Layout of the range image at the native horizontal resolution, in the azimuth unit of the parser.
+   * Default 0.1 degree over 360 degree, 1/1000 degree unit
+   */
+  virtual RangeImageLayout GetRangeImageLayout() const;
+
+  /**
+   * @brief Read the status fields of the tail of one packet. Stateless like 'DecodePacket', meant for
+   * a packet sampled now and then off the decode thread
+   * @return false if the packet is not valid or shorter than its tail
+   */
+  virtual bool ParseTailStatus(const uint8_t *buffer, size_t length, TailStatus& status);
+
+  /**
+   * @brief Read the sequence number and the azimuth of the first block of one packet, for the trace probes.
+   * Stateless like 'ParseTailStatus'
+   * @param[out] sequence 0 if the packet has no sequence number
+   * @return false if the packet is not valid
+   */
+  virtual bool ParsePacketId(const uint8_t *buffer, size_t length, uint32_t& sequence, uint16_t& azimuth);
+
+  /**
+   * @brief Move the lookup tables to a NUMA node, e.g. the node of the decode thread
+   * @return 0 on success
+   */
+  virtual int BindNumaNode(int node);
+
+  // For debugging
+  void PrintDwPoint(const dwLidarPointXYZI* point);
+  void PrintDwPoint(const dwLidarPointRTHI* point);
+  
+ protected:
+
+  /**
+   * @brief Combine the utc and timestamps of lidar to get timestamps (us)
+   * 
+   * @param utc contains six parameters of utc time
+   * @return int64_t return -1 if the size of utc is not six
+   */
+  int64_t GetMicroLidarTimeU64(const uint8_t* utc, int size, uint32_t timestamp) const;
+  
+  /**
+   * @brief Take a copy of the deskew motion once per packet, the reference time is resolved to the scan start,
+   * which is still 0 for the first packet of a scan
+   * @return false if deskew is disabled
+   */
+  bool GetDeskewMotion(DeskewMotion& motion);
+
+  /**
+   * @brief Resolve the reference time left 0 to the time of this packet, the first one of its scan
+   * @return nullptr if no motion
+   */
+  inline const DeskewMotion* ResolveDeskewMotion(const DeskewMotion* motion, DeskewMotion& resolved,
+                                                 int64_t packetTime) const {
+    if (motion == nullptr) return nullptr;
+    resolved = *motion;
+    if (resolved.referenceTime == 0) resolved.referenceTime = packetTime;
+    return &resolved;
+  }
+
+  /**
+   * @brief Time in us for the spin to sweep azimuth delta, delta is wrapped into one revolution
+   * @param unitsPerRev azimuth units of one revolution, e.g. 36000
+   * @param revPerUs revolutions per us, e.g. rpm / 60e6
+   */
+  inline float AzimuthDeltaToUs(int32_t delta, int32_t unitsPerRev, float revPerUs) const {
+    if (revPerUs <= 0) return 0;
+    delta = (delta % unitsPerRev + unitsPerRev) % unitsPerRev;
+    return static_cast<float>(delta) / unitsPerRev / revPerUs;
+  }
+
+  /**
+   * @brief Fill the time of one point and compensate the ego motion, 'pointXYZI' is updated in place
+   * p' = p + (w * dt) x p + v * dt, first order is enough for the 100 ms of one spin
+   */
+  inline void FinishPoint(dwLidarPointXYZI& pointXYZI, dwTime_t* pointTimestamp, int64_t pointTime,
+                          const DeskewMotion* motion) const {
+    if (pointTimestamp != nullptr) *pointTimestamp = pointTime;
+    if (motion != nullptr) {
+      float dt = (pointTime - motion->referenceTime) * 1e-6f;
+      float rx = motion->angularVelocity[0] * dt;
+      float ry = motion->angularVelocity[1] * dt;
+      float rz = motion->angularVelocity[2] * dt;
+      float x = pointXYZI.x, y = pointXYZI.y, z = pointXYZI.z;
+      pointXYZI.x = x + ry * z - rz * y + motion->linearVelocity[0] * dt;
+      pointXYZI.y = y + rz * x - rx * z + motion->linearVelocity[1] * dt;
+      pointXYZI.z = z + rx * y - ry * x + motion->linearVelocity[2] * dt;
+    }
+  }
+
+  /**
+   * @brief print all necessary messages except for the point clouds, e.g. timestamp
+   */
+  void PrintDwPacket(const dwLidarDecodedPacket *packet);
+
+  /**
+   * @brief Read a whole file, a zero is appended so the content can be given to the string parsers
+   *
+   * @return false if the file can not be read
+   */
+  static bool ReadTextFile(const std::string& path, std::vector<char>& buffer);
+
+  /**
+   * @brief Parse the csv correction, "laser id,elevation,azimuth" lines, in a single pass over the buffer
+   * without allocation. Used by 'ParseCorrectionString' of QT128 and P128
+   */
+  int ParseCorrectionCsv(const char* data, size_t size);
+
+  /**
+   * @brief Replace a calibration snapshot, RCU style. The new one is complete before it is published with one
+   * pointer swap, decoders take a snapshot once per packet so a packet never sees two calibrations.
+   * The caller waits for the decoders to drop the old one and frees it, not the decode path
+   */
+  template <typename T>
+  static void PublishCalibration(std::shared_ptr<const T>& slot, std::shared_ptr<const T> next) {
+    std::shared_ptr<const T> old = std::atomic_exchange(&slot, std::move(next));
+    // no new reference can be taken, the decoders hold it for one packet at most
+    for (int i = 0; old != nullptr && old.use_count() > 1 && i < kCalibrationGraceMs * 10; i++) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  inline float64_t deg2Rad(float64_t deg)
+  {
+      return deg * 0.01745329251994329575;
+  }
+
+  inline float64_t rad2Deg(float64_t rad)
+  {
+      return rad * 57.29577951308232087721;
+  }
+  
+  // store the value of sin/cos to speed up the computing, in huge pages as they are looked up randomly
+  HugePageArray<float> m_fCosAllAngle;
+  HugePageArray<float> m_fSinAllAngle;
+  // unit of aziumth/elevation from correction file
+  int m_iAziCorrUnit = 1000;
+  // Correction angle from the file has three digits, e.g. 1.234 degree is converted to 1 234
+  // Must be initilized by func 'LoadCorrectionString', replaced with 'PublishCalibration'
+  std::shared_ptr<const LaserCorrection> m_pLaserCorrection;
+  // max wait of 'PublishCalibration' for the decoders to drop the old calibration
+  static const int kCalibrationGraceMs = 100;
+
+  int m_iReturnMode = 0;
+  int m_iMotorSpeed = 0;
+
+  static const std::string kLidarIPAddr;
+  static const uint16_t kTcpPort = 9347;
+  static const uint16_t kUdpPort = 2368;
+
+  // default udp packet buffer size, 1s recv 18000 packets at most
+  static const uint32_t kMaxListSize = 18000;
+  // 1sec = 1000000000nsec
+  static const long kNSecToSec = 1000000000;
+
+  // firing time offset of each laser inside its block in us, for lidars without firetimes
+  float m_fNoFiretime[MAX_LASER_NUM] = {0};
+  // sensor time of the first block of the current scan, 0 if the next packet starts a new scan
+  int64_t m_i64ScanStartTime = 0;
+  bool m_bDeskew = false;
+  DeskewMotion m_deskewMotion;
+  std::mutex m_deskewMutex;
+
+  // to record the last azimuth to decide split frame or not
+  uint16_t m_u16LastAzimuth = 0;
+  // to judge if a complete frame data is collected, 
+  // curAzimuth - m_u16LastAzimuth > kAzimuthTolerance 360-0, 10 degree, unit 100
+  static const uint16_t kAzimuthTolerance = 1000;
+};
+
+}  // namespace golden_ref
+
+#endif  // GOLDEN_REF_GENERAL_PARSER_H_
@@ -0,0 +1,384 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd] 
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Frozen reference copy of UdpParser/src/Udp1_4_Parser.cpp for the golden harness, see tools/golden/golden_check.cpp.
+// Copied at commit 669ad15, the one adding the harness, so it holds the decoder changes made before it and not the
+// parser of the first release. Besides the namespace and the include guard it differs from the original of 669ad15 by
+// the output fixes ported since:
+// - 6b93219, the Pandar128 firetime row is bounded by the laser id
+// Do not optimise it, the optimised decoders are compared against it
+
+#include <iostream>
+#include "Udp1_4_Parser.h"
+#include "TextScanner.h"
+
+namespace golden_ref {
+
+Udp1_4_Parser::Udp1_4_Parser() {}
+
+Udp1_4_Parser::~Udp1_4_Parser() { 
+  // printf("release general parser\n"); 
+}
+
+dwStatus Udp1_4_Parser::GetDecoderConstants(_dwSensorLidarDecoder_constants* constants) {
+    // printf("GetDecoderConstants: \n");
+    // Each packet contains 893 bytes for each Pandar128 UDP, some sort of Pandar serial can be 1409
+    constants->maxPayloadSize = 1500;
+    // Packet nums per second, send one packet per 0.1 degree for Pandar128. 360/0.1*10 = 36000, it takes 0.1s
+    // Dual return means two block in one packet have the same timestamp
+    // !std::bad_alloc happens if value is too small, narrow memory 900000 450000 ok, but 90000 fails? 
+    // !Fault parameter to avoid dw printing packet dropping 12, real value = 36000
+    constants->properties.packetsPerSecond = 12 / (m_bIsDualReturn ? 1 : 2);
+    // !Influence the display of point cloud, 36000 * 128 * 2 = 9216000
+    // Error occurs if normal size, DW_OUT_OF_BOUNDS: RenderEngine::Buffer too small for requested layout
+    constants->properties.pointsPerSecond = 9216000 / (m_bIsDualReturn ? 1 : 2);
+    // 10Hz 10 circle per second, 20Hz the numbers of packets halve
+    constants->properties.spinFrequency = m_u16SpinSpeed / 60.0f;
+    // Will be override by dw, depends on the packets received in practice
+    // constants->properties.packetsPerSpin = 900;
+    // constants->properties.pointsPerSpin = 230400;
+    // 256 = blockNum * laserNum = 2 * 256
+    constants->properties.pointsPerPacket = 256;
+    
+    constants->properties.pointStride = 8;
+    constants->properties.horizontalFOVStart = deg2Rad(0);
+    constants->properties.horizontalFOVEnd = deg2Rad(360);
+    constants->properties.numberOfRows = m_nLaserNum;
+    // From Pandar128 manual or correction file to take the first and last value
+    constants->properties.verticalFOVStart = deg2Rad(-14);
+    constants->properties.verticalFOVEnd = deg2Rad(26);
+    std::shared_ptr<const LaserCorrection> correction = GetLaserCorrection();
+    for (int i = 0; i < m_nLaserNum; i++) {
+        if(correction != nullptr && static_cast<size_t>(i) < correction->elevation.size()) {
+            constants->properties.verticalAngles[i] = deg2Rad(correction->elevation[i] / m_iAziCorrUnit);
+            // printf("verticalAngles: %f \n", constants->properties.verticalAngles[i]);
+        }
+    }
+
+    // printLidarProperty(&constants->properties);
+    return DW_SUCCESS;
+}
+
+bool Udp1_4_Parser::ParseTailStatus(const uint8_t *buffer, size_t length, TailStatus& status) {
+  if (length < sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_ME_V4) || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+    return false;
+  }
+  const HS_LIDAR_HEADER_ME_V4 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_ME_V4 *>(&(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  size_t bodyEnd = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_ME_V4) + GetDataBodySize(pHeader) +
+                   sizeof(HS_LIDAR_BODY_CRC_ME_V4);
+  size_t tailOffset = bodyEnd + (pHeader->HasFuncSafety() ? sizeof(HS_LIDAR_FUNC_SAFETY_ME_V4) : 0);
+  if (tailOffset + sizeof(HS_LIDAR_TAIL_ME_V4) > length) {
+    return false;
+  }
+  const auto *pTail = reinterpret_cast<const HS_LIDAR_TAIL_ME_V4 *>(buffer + tailOffset);
+  status.statusNum = 3;
+  status.statusId[0] = pTail->GetStsID0();
+  status.statusData[0] = pTail->GetData0();
+  status.statusId[1] = pTail->GetStsID1();
+  status.statusData[1] = pTail->GetData1();
+  status.statusId[2] = pTail->GetStsID2();
+  status.statusData[2] = pTail->GetData2();
+  status.motorSpeed = pTail->GetMotorSpeed();
+  status.returnMode = pTail->GetReturnMode();
+  status.shutdown = pTail->HasShutdown();
+  status.hasFuncSafety = pHeader->HasFuncSafety();
+  if (status.hasFuncSafety) {
+    const auto *pSafety = reinterpret_cast<const HS_LIDAR_FUNC_SAFETY_ME_V4 *>(buffer + bodyEnd);
+    status.lidarState = pSafety->GetLidarState();
+    status.currentFault = pSafety->IsCurrentFault();
+    status.historyFault = pSafety->IsHistoryFault();
+    status.faultNum = pSafety->GetFaultNum();
+    status.faultId = pSafety->GetFaultID();
+    status.faultCode = pSafety->GetFaultCode();
+  }
+  return true;
+}
+
+bool Udp1_4_Parser::ParsePacketId(const uint8_t *buffer, size_t length, uint32_t& sequence, uint16_t& azimuth) {
+  size_t bodyOffset = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_ME_V4);
+  if (length < bodyOffset + sizeof(HS_LIDAR_BODY_AZIMUTH_ME_V4) || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+    return false;
+  }
+  const HS_LIDAR_HEADER_ME_V4 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_ME_V4 *>(&(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  azimuth = reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_ME_V4 *>(buffer + bodyOffset)->GetAzimuth();
+  // the sequence number follows the tail
+  size_t seqOffset = bodyOffset + GetDataBodySize(pHeader) + sizeof(HS_LIDAR_BODY_CRC_ME_V4) +
+                     (pHeader->HasFuncSafety() ? sizeof(HS_LIDAR_FUNC_SAFETY_ME_V4) : 0) + sizeof(HS_LIDAR_TAIL_ME_V4);
+  sequence = 0;
+  if (pHeader->HasSeqNum() && seqOffset + sizeof(HS_LIDAR_TAIL_SEQ_NUM_ME_V4) <= length) {
+    sequence = reinterpret_cast<const HS_LIDAR_TAIL_SEQ_NUM_ME_V4 *>(buffer + seqOffset)->GetSeqNum();
+  }
+  return true;
+}
+
+dwStatus Udp1_4_Parser::DecodePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length,
+                                     dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI, PointExtraOutput* extra,
+                                     const DeskewMotion* motion, PacketDecodeInfo& info) {
+  if (buffer[0] != 0xEE || buffer[1] != 0xFF || length < 0) {
+    printf("Udp1_4_Parser: ParserOnePacket, invalid packet %x %x\n", buffer[0], buffer[1]);
+    return DW_FAILURE;
+  }
+  const HS_LIDAR_HEADER_ME_V4 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_ME_V4 *>(
+          &(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  // pHeader->Print();
+  // point to azimuth of udp start block
+  const HS_LIDAR_BODY_AZIMUTH_ME_V4 *pAzimuth =
+      reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_ME_V4 *>(
+          (const unsigned char *)pHeader + sizeof(HS_LIDAR_HEADER_ME_V4));
+  int32_t azimuth = pAzimuth->GetAzimuth();
+  // packets may differ from the member defaults, which are only updated in 'SequencePacket'
+  const int blockNum = pHeader->GetBlockNum();
+  const int laserNum = pHeader->GetLaserNum();
+  // pAzimuth->Print();
+  
+  const auto *pTail = reinterpret_cast<const HS_LIDAR_TAIL_ME_V4 *>(
+      (const unsigned char *)pHeader + sizeof(HS_LIDAR_HEADER_ME_V4) +
+      GetDataBodySize(pHeader) + sizeof(HS_LIDAR_BODY_CRC_ME_V4) + 
+      (pHeader->HasFuncSafety() ? sizeof(HS_LIDAR_FUNC_SAFETY_ME_V4) : 0));
+  // pTail->Print();
+  info.hasTail = true;
+  info.spinSpeed = pTail->m_u16MotorSpeed;
+  info.isDualReturn = pTail->IsDualReturn();
+  info.laserNum = laserNum;
+  info.blockNum = blockNum;
+  output->duration =  pTail->GetMicroLidarTimeU64() - 100000;
+  output->hostTimestamp = 0;
+  output->maxPoints = blockNum * laserNum;
+  // the calibration of the whole packet is taken once, a reload is used from the next packet
+  std::shared_ptr<const LaserCorrection> pCorrection = GetLaserCorrection();
+  if (pCorrection == nullptr || pCorrection->elevation.size() < static_cast<size_t>(laserNum)) {
+    // printf("Udp1_4_Parser: ParserOnePacket, no calibration string loaded Error \n");
+    return DW_FAILURE;
+  }
+  std::shared_ptr<const P128Firetimes> pFiretimes = std::atomic_load(&m_pFiretimes);
+  output->maxVerticalAngleRad = pCorrection->elevation[laserNum - 1] / 1000 / 180 * M_PI;
+  output->minVerticalAngleRad = pCorrection->elevation[0] / 1000 / 180 * M_PI;
+  output->nPoints = blockNum * laserNum;
+  // scanComplete must be filled or it cracks
+  output->scanComplete = false;
+  // output->sensorTimestamp = GetMicroLidarTimeU64(pTail->m_u8UTC, 6, pTail->GetTimestamp());
+  output->sensorTimestamp = this->GetMicroLidarTimeU64(pTail->m_u8UTC, 6, pTail->GetTimestamp());
+
+  std::shared_ptr<const P128FiretimeAziCorr> pFiretimeCorr =
+      pFiretimes != nullptr ? GetFiretimesAziCorr(*pFiretimes, pTail->GetMotorSpeed()) : nullptr;
+  // the tail timestamp belongs to the first block, the others follow the spin
+  const int32_t firstAzimuth = azimuth;
+  const float revPerUs = pTail->GetMotorSpeed() / 60e6f;
+  dwTime_t* pointTimestamp = extra != nullptr ? extra->pointTimestamp : nullptr;
+  DeskewMotion packetMotion;
+  const DeskewMotion* pMotion = ResolveDeskewMotion(motion, packetMotion, output->sensorTimestamp);
+  const bool bPointTime = pointTimestamp != nullptr || pMotion != nullptr;
+  RangeImage* pImage = extra != nullptr ? extra->rangeImage : nullptr;
+  if (pImage != nullptr && pImage->timestamp == 0) pImage->timestamp = output->sensorTimestamp;
+  CompactPoint* pCompact = extra != nullptr ? extra->compactPoint : nullptr;
+
+  int index = 0;
+  float minAzimuth = -361;
+  float maxAzimuth = 361;
+  for (int blockID = 0; blockID < blockNum; blockID++) {
+    // point to channel unit addr
+    if (pHeader->HasConfidenceLevel()) {
+      printf("Not supported! HasConfidenceLevel");
+    } else {
+      const HS_LIDAR_BODY_CHN_UNIT_NO_CONF_ME_V4 *pChnUnitNoConf =
+          reinterpret_cast<const HS_LIDAR_BODY_CHN_UNIT_NO_CONF_ME_V4 *>(
+              (const unsigned char *)pAzimuth + sizeof(HS_LIDAR_BODY_AZIMUTH_ME_V4));
+      // pAzimuth->Print();
+      azimuth = pAzimuth->GetAzimuth();
+      // point to next block azimuth addr
+      pAzimuth = reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_ME_V4 *>(
+          (const unsigned char *)pAzimuth +
+          sizeof(HS_LIDAR_BODY_AZIMUTH_ME_V4) +
+          sizeof(HS_LIDAR_BODY_CHN_UNIT_NO_CONF_ME_V4) * laserNum);
+      const int64_t blockTime = output->sensorTimestamp +
+          static_cast<int64_t>(AzimuthDeltaToUs(azimuth - firstAzimuth, 36000, revPerUs));
+      int firetimeColumn = pFiretimeCorr != nullptr ?
+          GetFiretimeColumn(*pFiretimes, pTail->GetOperationMode(), pTail->GetAngleState(blockID)) : -1;
+      const float* pFiretime = firetimeColumn >= 0 ? pFiretimes->firetime[firetimeColumn] : m_fNoFiretime;
+      // dual return means two blocks of the same azimuth
+      const uint32_t returnIndex = info.isDualReturn ? blockID % 2 : 0;
+      for (int laserID = 0; laserID < laserNum; laserID++) {
+        int32_t elevation = pCorrection->elevation[laserID];
+        elevation = (360000 + elevation) % 360000;  //TODO No need
+        int32_t aziCorr = this->CalibrateAzimuth(azimuth, laserID, *pCorrection);
+        if (firetimeColumn >= 0 && laserID < HS_LIDAR_P128_LASER_NUM) {
+          aziCorr = (aziCorr + pFiretimeCorr->corr[firetimeColumn][laserID] + CIRCLE) % CIRCLE;
+        }
+
+        double distance = static_cast<double>(pChnUnitNoConf->GetDistance()) * pHeader->GetDistUnit();
+        uint8_t intensity = pChnUnitNoConf->GetReflectivity();
+        this->ComputeDwPoint(pointXYZI[index], pointRTHI[index], distance, elevation, aziCorr, intensity);
+        if (bPointTime) {
+          FinishPoint(pointXYZI[index], pointTimestamp != nullptr ? &pointTimestamp[index] : nullptr,
+                      blockTime + static_cast<int64_t>(laserID < HS_LIDAR_P128_LASER_NUM ? pFiretime[laserID] : 0),
+                      pMotion);
+        }
+        if (pImage != nullptr) {
+          pImage->Write(laserID, aziCorr, returnIndex, distance, intensity,
+                        pointXYZI[index].x, pointXYZI[index].y, pointXYZI[index].z);
+        }
+        if (pCompact != nullptr) {
+          PackCompactPoint(pCompact[index], pointXYZI[index], static_cast<uint8_t>(laserID));
+        }
+        // PrintDwPoint(&pointXYZI[index]);
+        ++ index;
+        pChnUnitNoConf = pChnUnitNoConf + 1;
+        // pChnUnitNoConf->Print();
+      }  // iterate laserId
+
+      info.AddSplitAzimuth(azimuth);
+      if (blockID == 0) minAzimuth = azimuth;
+      else maxAzimuth = azimuth;
+
+    } // noconf situation
+  }  // iterate block
+  
+  output->maxHorizontalAngleRad = this->deg2Rad(maxAzimuth / m_nAziUnitUDP);
+  output->minHorizontalAngleRad = this->deg2Rad(minAzimuth / m_nAziUnitUDP);
+  output->pointsRTHI = pointRTHI;
+  output->pointsXYZI = pointXYZI;
+  // PrintDwPoint(&pointXYZI[index-2]);
+
+  return DW_SUCCESS;
+}
+
+int16_t Udp1_4_Parser::GetVecticalAngle(int channel) {
+  if (channel < 0 || channel >= HS_LIDAR_P128_LASER_NUM) {
+    printf("GetVecticalAngle: channel id not in range 0-%d \n", HS_LIDAR_P128_LASER_NUM-1);
+    return -1;
+  }
+  return GeneralParser::GetVecticalAngle(channel);
+}
+
+int Udp1_4_Parser::LoadFiretimesString(const char *firetimes) {
+  TextScanner scanner(firetimes, strlen(firetimes));
+  TextSpan line;
+  TextSpan field;
+  // first line describes the distance of each column
+  if (!scanner.NextLine(line)) {
+    printf("LoadFiretimesString: empty firetimes Error\n");
+    return -1;
+  }
+  // built aside, the decoders keep the former firetimes until it is published
+  auto table = std::make_shared<P128Firetimes>();
+  // operation mode and angle state of each column
+  uint8_t* rowTable[2] = {table->mode, table->state};
+  for (int row = 0; row < 2; row++) {
+    if (!scanner.NextLine(line)) line = TextSpan();
+    FieldScanner fields(line);
+    if (fields.Count() < HS_LIDAR_P128_FIRETIME_COLUMN_NUM + 1) {
+      printf("LoadFiretimesString: mode or angle state line Error\n");
+      return -1;
+    }
+    // the first field is the name of the row
+    fields.Next(field);
+    for (int col = 0; col < HS_LIDAR_P128_FIRETIME_COLUMN_NUM; col++) {
+      fields.Next(field);
+      rowTable[row][col] = 0;
+      ParseInt(field, rowTable[row][col]);
+    }
+  }
+
+  auto& firetimeTable = table->firetime;
+  int lineCount = 0;
+  while (scanner.NextLine(line)) {
+    FieldScanner fields(line);
+    if (fields.Count() < HS_LIDAR_P128_FIRETIME_COLUMN_NUM + 1) continue;
+    int laserId = 0;
+    fields.Next(field);
+    ParseInt(field, laserId);
+    laserId -= 1;
+    if (laserId < 0 || laserId >= HS_LIDAR_P128_LASER_NUM) {
+      printf("LoadFiretimesString: laser id Error, laserId=%d\n", laserId + 1);
+      return -1;
+    }
+    for (int col = 0; col < HS_LIDAR_P128_FIRETIME_COLUMN_NUM; col++) {
+      fields.Next(field);
+      if (!ParseFloat(field, firetimeTable[col][laserId])) {
+        printf("LoadFiretimesString: firetime Error, laserId=%d\n", laserId + 1);
+        return -1;
+      }
+    }
+    lineCount++;
+  }
+  if (lineCount != HS_LIDAR_P128_LASER_NUM) {
+    printf("LoadFiretimesString: %d laser lines found, expected %d\n", lineCount, HS_LIDAR_P128_LASER_NUM);
+    return -1;
+  }
+  // the azimuth correction at the current speed is built here, not by the first packet after the swap
+  std::shared_ptr<const P128Firetimes> former = std::atomic_load(&m_pFiretimes);
+  std::shared_ptr<const P128FiretimeAziCorr> formerCorr = former != nullptr ? std::atomic_load(&former->aziCorr) : nullptr;
+  former.reset();
+  if (formerCorr != nullptr) {
+    GetFiretimesAziCorr(*table, formerCorr->speed);
+  }
+  PublishCalibration(m_pFiretimes, std::shared_ptr<const P128Firetimes>(table));
+  m_bGetFiretimes = true;
+  return 0;
+}
+
+int Udp1_4_Parser::GetFiretimeColumn(const P128Firetimes& firetimes, uint8_t operationMode, uint8_t angleState) {
+  // even columns are distance >= A1
+  for (int col = 0; col < HS_LIDAR_P128_FIRETIME_COLUMN_NUM; col += 2) {
+    if (firetimes.mode[col] == operationMode && firetimes.state[col] == angleState) {
+      return col;
+    }
+  }
+  return -1;
+}
+
+std::shared_ptr<const P128FiretimeAziCorr> Udp1_4_Parser::GetFiretimesAziCorr(const P128Firetimes& firetimes,
+                                                                           uint16_t speed) const {
+  std::shared_ptr<const P128FiretimeAziCorr> current = std::atomic_load(&firetimes.aziCorr);
+  if (current != nullptr && current->speed == speed) {
+    return current;
+  }
+  // us * rpm * 6e-6 is degree, then to the unit of correction file 1/1000
+  auto table = std::make_shared<P128FiretimeAziCorr>();
+  table->speed = speed;
+  for (int col = 0; col < HS_LIDAR_P128_FIRETIME_COLUMN_NUM; col++) {
+    for (int laserId = 0; laserId < HS_LIDAR_P128_LASER_NUM; laserId++) {
+      table->corr[col][laserId] = static_cast<int32_t>(
+          round(firetimes.firetime[col][laserId] * speed * 6E-6 * m_iAziCorrUnit));
+    }
+  }
+  // several threads may build it at the same time, they build the same table
+  std::atomic_store(&firetimes.aziCorr, std::shared_ptr<const P128FiretimeAziCorr>(table));
+  return table;
+}
+
+void Udp1_4_Parser::SequencePacket(dwLidarDecodedPacket *output, const PacketDecodeInfo& info) {
+  if (info.hasTail) {
+    m_nLaserNum = info.laserNum;
+    m_nBlockNum = info.blockNum;
+  }
+  GeneralParser::SequencePacket(output, info);
+}
+
+unsigned long Udp1_4_Parser::GetDataBodySize(const HS_LIDAR_HEADER_ME_V4 *pHeader) {
+  unsigned long bodySize = (sizeof(HS_LIDAR_BODY_AZIMUTH_ME_V4) +
+       (pHeader->HasConfidenceLevel() ? sizeof(HS_LIDAR_BODY_CHN_UNIT_ME_V4)
+                                      : sizeof(HS_LIDAR_BODY_CHN_UNIT_NO_CONF_ME_V4)) *
+        pHeader->GetLaserNum()) * pHeader->GetBlockNum();
+  return bodySize;
+}
+
+}  // namespace golden_ref
@@ -0,0 +1,114 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd] 
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Frozen reference copy of UdpParser/include/Udp1_4_Parser.h for the golden harness, see tools/golden/golden_check.cpp.
+// Copied at commit 669ad15, the one adding the harness, so it holds the decoder changes made before it and not the
+// parser of the first release. Only the namespace and the include guard differ from the original of 669ad15.
+// Do not optimise it, the optimised decoders are compared against it
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: Lidar Sensor UDP Parser</b>
+ *
+ * @b Description: This file defines the udp parser for Pandar128.
+ */
+
+#ifndef GOLDEN_REF_UDP1_4_PARSER_H_
+#define GOLDEN_REF_UDP1_4_PARSER_H_
+
+// Unit of azimuth in UDP packet 1/100
+#define HS_LIDAR_P128_AZIMUTH_UNIT_UDP (100)
+#define HS_LIDAR_P128_LASER_NUM (128)
+// Columns of firetime_correction_Pandar128.csv, distance >= A1 and < A1 for each operation mode and angle state
+#define HS_LIDAR_P128_FIRETIME_COLUMN_NUM (16)
+
+#include <memory>
+#include "GeneralParser.h"
+#include "HsLidarMeV4.h"
+
+namespace golden_ref {
+
+// For Pandar128
+// Azimuth correction caused by the firetime at one spin speed, unit 1/1000 degree. Immutable once built
+struct P128FiretimeAziCorr {
+  uint16_t speed = 0;
+  int32_t corr[HS_LIDAR_P128_FIRETIME_COLUMN_NUM][HS_LIDAR_P128_LASER_NUM];
+};
+
+// firetime_correction_Pandar128.csv. Immutable once published, except the cache of its azimuth correction
+struct P128Firetimes {
+  // operation mode and angle state of each column
+  uint8_t mode[HS_LIDAR_P128_FIRETIME_COLUMN_NUM] = {0};
+  uint8_t state[HS_LIDAR_P128_FIRETIME_COLUMN_NUM] = {0};
+  // firing time in us
+  float firetime[HS_LIDAR_P128_FIRETIME_COLUMN_NUM][HS_LIDAR_P128_LASER_NUM] = {{0}};
+  // azimuth correction for the last spin speed, replaced by 'GetFiretimesAziCorr'
+  mutable std::shared_ptr<const P128FiretimeAziCorr> aziCorr;
+};
+
+class Udp1_4_Parser : public GeneralParser {
+ public:
+  Udp1_4_Parser();
+  virtual ~Udp1_4_Parser();
+
+  dwStatus GetDecoderConstants(_dwSensorLidarDecoder_constants* constants) override;
+  
+  virtual dwStatus DecodePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length,
+                                dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI, PointExtraOutput* extra,
+                                const DeskewMotion* motion, PacketDecodeInfo& info) override;
+
+  bool ParseTailStatus(const uint8_t *buffer, size_t length, TailStatus& status) override;
+
+  bool ParsePacketId(const uint8_t *buffer, size_t length, uint32_t& sequence, uint16_t& azimuth) override;
+
+  void SequencePacket(dwLidarDecodedPacket *output, const PacketDecodeInfo& info) override;
+
+  int16_t GetVecticalAngle(int channel) override;
+
+  /**
+   * @brief Decode firetime_correction_Pandar128.csv, the firing time of each laser in us
+   * for each operation mode and angle state. Can be called while decoding, used from the next packet
+   */
+  virtual int LoadFiretimesString(const char *firetimes) override;
+
+ private:
+  // to be updated by the UDP packet
+  int m_nLaserNum = HS_LIDAR_P128_LASER_NUM;
+  // block number in a UDP packet
+  int m_nBlockNum = 2;
+  // unit of azimth angle from UDP packet
+  const int m_nAziUnitUDP = HS_LIDAR_P128_AZIMUTH_UNIT_UDP;
+
+  unsigned long GetDataBodySize(const HS_LIDAR_HEADER_ME_V4 *pHeader);
+
+  /**
+   * @brief Column of the firetime table for the operation mode and angle state, -1 if not listed.
+   * The A1 distance threshold is not part of the file, so the column of distance >= A1 is used
+   */
+  static int GetFiretimeColumn(const P128Firetimes& firetimes, uint8_t operationMode, uint8_t angleState);
+
+  // Azimuth correction of the firetimes, only computed again when the speed changes. Safe for several decode threads
+  std::shared_ptr<const P128FiretimeAziCorr> GetFiretimesAziCorr(const P128Firetimes& firetimes, uint16_t speed) const;
+
+  // To be initialized by func 'LoadFiretimesString', replaced with 'PublishCalibration'
+  std::shared_ptr<const P128Firetimes> m_pFiretimes;
+};
+
+}  // namespace golden_ref
+
+#endif  // GOLDEN_REF_UDP1_4_PARSER_H_
@@ -0,0 +1,460 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd] 
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Frozen reference copy of UdpParser/src/Udp3_2_Parser.cpp for the golden harness, see tools/golden/golden_check.cpp.
+// Copied at commit 669ad15, the one adding the harness, so it holds the decoder changes made before it and not the
+// parser of the first release. Besides the namespace and the include guard it differs from the original of 669ad15 by
+// the output fixes ported since:
+// - 6b93219, a laser id of the channel config out of the QT128 lasers gives a zero point
+// Do not optimise it, the optimised decoders are compared against it
+
+#include "Udp3_2_Parser.h"
+#include "TextScanner.h"
+
+namespace golden_ref {
+
+Udp3_2_Parser::Udp3_2_Parser() {}
+
+Udp3_2_Parser::~Udp3_2_Parser() { 
+  // printf("release Udp3_2_Parser\n"); 
+}
+
+bool Udp3_2_Parser::ParseTailStatus(const uint8_t *buffer, size_t length, TailStatus& status) {
+  if (length < sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_QT_V2) || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+    return false;
+  }
+  const HS_LIDAR_HEADER_QT_V2 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_QT_V2 *>(&(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  size_t tailOffset = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_QT_V2) +
+                      (sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2) + sizeof(HS_LIDAR_BODY_CHN_UNIT_QT_V2) * pHeader->GetLaserNum()) *
+                      pHeader->GetBlockNum() + sizeof(HS_LIDAR_BODY_CRC_QT_V2) +
+                      (pHeader->HasFunctionSafety() ? sizeof(HS_LIDAR_FUNCTION_SAFETY) : 0);
+  if (tailOffset + sizeof(HS_LIDAR_TAIL_QT_V2) > length) {
+    return false;
+  }
+  const HS_LIDAR_TAIL_QT_V2 *pTail = reinterpret_cast<const HS_LIDAR_TAIL_QT_V2 *>(buffer + tailOffset);
+  status.statusNum = 2;
+  status.statusId[0] = pTail->GetStsID1();
+  status.statusData[0] = pTail->GetData1();
+  status.statusId[1] = pTail->GetStsID3();
+  status.statusData[1] = pTail->GetData3();
+  status.motorSpeed = pTail->GetMotorSpeed();
+  status.returnMode = pTail->GetReturnMode();
+  status.shutdown = pTail->m_u8WorkingMode & HS_LIDAR_TAIL_QT_V2::kShutdown;
+  return true;
+}
+
+bool Udp3_2_Parser::ParsePacketId(const uint8_t *buffer, size_t length, uint32_t& sequence, uint16_t& azimuth) {
+  size_t bodyOffset = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_QT_V2);
+  if (length < bodyOffset + sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2) || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+    return false;
+  }
+  const HS_LIDAR_HEADER_QT_V2 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_QT_V2 *>(&(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  azimuth = reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_QT_V2 *>(buffer + bodyOffset)->GetAzimuth();
+  // the sequence number follows the tail
+  size_t seqOffset = bodyOffset +
+                     (sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2) + sizeof(HS_LIDAR_BODY_CHN_UNIT_QT_V2) * pHeader->GetLaserNum()) *
+                     pHeader->GetBlockNum() + sizeof(HS_LIDAR_BODY_CRC_QT_V2) +
+                     (pHeader->HasFunctionSafety() ? sizeof(HS_LIDAR_FUNCTION_SAFETY) : 0) + sizeof(HS_LIDAR_TAIL_QT_V2);
+  sequence = 0;
+  if (pHeader->HasSeqNum() && seqOffset + sizeof(HS_LIDAR_TAIL_SEQ_NUM_QT_V2) <= length) {
+    sequence = reinterpret_cast<const HS_LIDAR_TAIL_SEQ_NUM_QT_V2 *>(buffer + seqOffset)->GetSeqNum();
+  }
+  return true;
+}
+
+dwStatus Udp3_2_Parser::DecodePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length,
+                                     dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI, PointExtraOutput* extra,
+                                     const DeskewMotion* motion, PacketDecodeInfo& info)
+{
+  // printf("Udp3_2_Parser:ParserOnePacket, lens=%lu \n", length);
+  // printf(" %x yes %x \n", buffer[0], buffer[1]);
+  if (length < 0 || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+    printf("Udp3_2_Parser: ParserOnePacket, invalid packet %x %x\n", buffer[0], buffer[1]);
+    return DW_FAILURE;
+  }
+  const HS_LIDAR_HEADER_QT_V2 *pHeader = reinterpret_cast<const HS_LIDAR_HEADER_QT_V2 *>(
+                                         &(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  // pHeader->Print();
+  const HS_LIDAR_TAIL_QT_V2 *pTail = reinterpret_cast<const HS_LIDAR_TAIL_QT_V2 *>(
+                          (const unsigned char *)pHeader + sizeof(HS_LIDAR_HEADER_QT_V2) +
+                          (sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2) + sizeof(HS_LIDAR_BODY_CHN_UNIT_QT_V2) * pHeader->GetLaserNum()) *
+                          pHeader->GetBlockNum() + sizeof(HS_LIDAR_BODY_CRC_QT_V2) +
+                          (pHeader->HasFunctionSafety() ? sizeof(HS_LIDAR_FUNCTION_SAFETY) : 0));
+  // pTail->Print();
+  info.hasTail = true;
+  info.spinSpeed = pTail->m_u16MotorSpeed;
+  // dual return won't affect decoding, just the azimuth of two blocks are the same, more points
+  info.isDualReturn = pTail->IsDualReturn();
+  info.laserNum = pHeader->GetLaserNum();
+  info.blockNum = pHeader->GetBlockNum();
+  output->duration = pTail->GetTimestamp() - 100000;
+  // from outside this func
+  output->hostTimestamp = 0; 
+  output->maxPoints = pHeader->GetBlockNum() * pHeader->GetLaserNum();
+  // !Attention the correction must be initialized by func LoadCorrectionString
+  // the calibration of the whole packet is taken once, a reload is used from the next packet
+  std::shared_ptr<const LaserCorrection> pCorrection = GetLaserCorrection();
+  if (pCorrection == nullptr || pCorrection->elevation.size() < pHeader->GetLaserNum()) {
+    // printf("Udp3_2_Parser: ParserOnePacket, no calibration string loaded Error \n");
+    return DW_FAILURE;
+  }
+  const std::vector<int32_t>& eleCorrection = pCorrection->elevation;
+  const std::vector<int32_t>& aziCorrection = pCorrection->azimuth;
+  std::shared_ptr<const QT128Firetimes> pFiretimes = std::atomic_load(&m_pFiretimes);
+  std::shared_ptr<const PandarQTChannelConfig> pChannelConfig =
+      pHeader->HasSelfDefine() ? std::atomic_load(&m_pChannelConfig) : nullptr;
+  output->maxVerticalAngleRad = eleCorrection[pHeader->GetLaserNum() - 1] / 1000 / 180 * M_PI;
+  output->minVerticalAngleRad = eleCorrection[0] / 1000 / 180 * M_PI;
+  // vital parameter to assign memory
+  output->nPoints = pHeader->GetBlockNum() * pHeader->GetLaserNum();
+  // scanComplete must set false, then true when one scan is completed
+  output->scanComplete = false;
+  // output->sensorTimestamp = GetMicroLidarTimeU64(pTail->m_u8UTC, 6, pTail->GetTimestamp());
+  // output->sensorTimestamp = pTail->GetTimestamp();
+  output->sensorTimestamp = this->GetMicroLidarTimeU64(pTail->m_u8UTC, 6, pTail->GetTimestamp());
+
+  const HS_LIDAR_BODY_AZIMUTH_QT_V2 *pAzimuth = reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_QT_V2 *>(
+          (const unsigned char *)pHeader + sizeof(HS_LIDAR_HEADER_QT_V2));
+  // pAzimuth->Print();
+  std::shared_ptr<const QT128FiretimeAziCorr> pFiretimeCorr =
+      pFiretimes != nullptr ? GetFiretimesAziCorr(*pFiretimes, pTail->GetMotorSpeed()) : nullptr;
+  // the tail timestamp belongs to the first block, the others follow the spin
+  const uint32_t firstAzimuth = pAzimuth->GetAzimuth();
+  const float revPerUs = pTail->GetMotorSpeed() / 60e6f;
+  dwTime_t* pointTimestamp = extra != nullptr ? extra->pointTimestamp : nullptr;
+  DeskewMotion packetMotion;
+  const DeskewMotion* pMotion = ResolveDeskewMotion(motion, packetMotion, output->sensorTimestamp);
+  const bool bPointTime = pointTimestamp != nullptr || pMotion != nullptr;
+  RangeImage* pImage = extra != nullptr ? extra->rangeImage : nullptr;
+  if (pImage != nullptr && pImage->timestamp == 0) pImage->timestamp = output->sensorTimestamp;
+  CompactPoint* pCompact = extra != nullptr ? extra->compactPoint : nullptr;
+  const HS_LIDAR_BODY_CHN_UNIT_QT_V2 *pChnUnit = reinterpret_cast<const HS_LIDAR_BODY_CHN_UNIT_QT_V2 *>(
+          (const unsigned char *)pAzimuth + sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2));
+  // pChnUnit->Print();
+
+  // index of the packet, from block count * laser nums, 2*128
+  int index = 0;
+  float minAzimuth = -361;
+  float maxAzimuth = 361;
+  unsigned int blocknum = pHeader->GetBlockNum();
+  for (unsigned int i = 0; i < blocknum; i++) {
+    uint32_t azimuth = pAzimuth->GetAzimuth();
+    // azimuth corresponds to a block
+    pChnUnit = reinterpret_cast<const HS_LIDAR_BODY_CHN_UNIT_QT_V2 *>(
+               (const unsigned char *)pAzimuth + sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2));
+    // then pAzimuth points to next azimuth
+    pAzimuth = reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_QT_V2 *>(
+        (const unsigned char *)pAzimuth +
+        sizeof(HS_LIDAR_BODY_AZIMUTH_QT_V2) +
+        sizeof(HS_LIDAR_BODY_CHN_UNIT_QT_V2) * pHeader->GetLaserNum());
+    int loopIndex = (pTail->GetModeFlag() + (i / ((pTail->GetReturnMode() < 0x39) ? 1 : 2)) + 1) % 2;
+    const int64_t blockTime = output->sensorTimestamp +
+        static_cast<int64_t>(AzimuthDeltaToUs(azimuth - firstAzimuth, 36000, revPerUs));
+    const float* pFiretime = pFiretimes != nullptr ? pFiretimes->firetime[loopIndex].data() : m_fNoFiretime;
+    const std::vector<int>* pChannelTable =
+        pChannelConfig != nullptr && static_cast<size_t>(loopIndex) < pChannelConfig->m_vChannelConfigTable.size() ?
+        &pChannelConfig->m_vChannelConfigTable[loopIndex] : nullptr;
+    // two blocks of the same loop are the two returns
+    const uint32_t returnIndex = (pTail->GetReturnMode() < 0x39) ? 0 : i % 2;
+
+    for (unsigned int j = 0; j < pHeader->GetLaserNum(); j++) {
+      uint16_t u16Distance = pChnUnit->GetDistance();
+      uint8_t u8Intensity = pChnUnit->GetReflectivity();
+      // uint8_t u8Confidence = pChnUnit->GetConfidenceLevel();
+      double distance = static_cast<double>(u16Distance) * pHeader->GetDistUnit();
+      uint32_t azimuthCorr = 0;
+      uint32_t elevationCorr = 0;
+      pChnUnit = pChnUnit + 1;
+      int laserId = j;
+
+      if (pChannelTable != nullptr && j < pChannelTable->size()) {
+        laserId = (*pChannelTable)[j] - 1;
+      }
+      // a channel config entry out of the lasers, or a header with more lasers, gives a zero point, its
+      // extras are not written
+      if (laserId < 0 || laserId >= HS_LIDAR_QT128_LASER_NUM) {
+        this->ComputeDwPoint(pointXYZI[index], pointRTHI[index], 0, 0, 0, 0);
+        ++ index;
+        continue;
+      }
+      if (static_cast<size_t>(laserId) < eleCorrection.size()) {
+        elevationCorr = eleCorrection[laserId];
+        // azimuth unit from UDP packet is 100, e.g. 1.23 = 123.
+        // however, azimuth unit from correction file is 1000, e.g. 1.234 = 1234
+        azimuthCorr = azimuth * 10 + aziCorrection[laserId];
+        if (pFiretimeCorr != nullptr) {
+          azimuthCorr += pFiretimeCorr->corr[loopIndex][laserId];
+        }
+      }
+      elevationCorr = (HS_LIDAR_QT128_AZIMUTH_SIZE + elevationCorr) % HS_LIDAR_QT128_AZIMUTH_SIZE;
+      azimuthCorr = (HS_LIDAR_QT128_AZIMUTH_SIZE + azimuthCorr) % HS_LIDAR_QT128_AZIMUTH_SIZE;
+      // printf("azimuthCorr: %d, elevationCorr: %d \n", azimuthCorr, elevationCorr);
+      this->ComputeDwPoint(pointXYZI[index], pointRTHI[index], distance, elevationCorr, azimuthCorr, u8Intensity);
+      if (bPointTime) {
+        FinishPoint(pointXYZI[index], pointTimestamp != nullptr ? &pointTimestamp[index] : nullptr,
+                    blockTime + static_cast<int64_t>(pFiretime[laserId]), pMotion);
+      }
+      if (pImage != nullptr) {
+        pImage->Write(laserId, azimuthCorr, returnIndex, distance, u8Intensity,
+                      pointXYZI[index].x, pointXYZI[index].y, pointXYZI[index].z);
+      }
+      if (pCompact != nullptr) {
+        PackCompactPoint(pCompact[index], pointXYZI[index], static_cast<uint8_t>(laserId));
+      }
+      ++ index;
+      // PrintDwPoint(&pointRTHI[index]);
+      // PrintDwPoint(&pointXYZI[index]);
+    } // cycle laser channel
+    
+    info.AddSplitAzimuth(azimuth);
+    // As only two block exist, the primary one is minimum
+    if (i == 0) minAzimuth = azimuth;
+    else maxAzimuth = azimuth;
+  } // cycle block
+  // PrintDwPoint(&pointXYZI[index-2]);
+
+  output->maxHorizontalAngleRad = ((maxAzimuth) / 100.0f) / 180 * M_PI;
+  output->minHorizontalAngleRad = ((minAzimuth) / 100.0f) / 180 * M_PI;
+  // !the display only rely on xyzi
+  output->pointsRTHI = pointRTHI;
+  output->pointsXYZI = pointXYZI;
+  // PrintDwPacket(output);
+
+  return DW_SUCCESS;
+}
+
+RangeImageLayout Udp3_2_Parser::GetRangeImageLayout() const {
+  // 0.4 degree at 10Hz, 900 columns
+  RangeImageLayout layout;
+  layout.rows = HS_LIDAR_QT128_LASER_NUM;
+  layout.cols = 900;
+  layout.returns = 2;
+  layout.azimuthStart = 0;
+  layout.azimuthStep = 400;
+  layout.unitsPerRev = HS_LIDAR_QT128_AZIMUTH_SIZE;
+  return layout;
+}
+
+dwStatus Udp3_2_Parser::GetDecoderConstants(_dwSensorLidarDecoder_constants* constants) {
+  // printf("GetDecoderConstants: \n");
+  // Each packet contains 1127 bytes for QT128, use 1500
+  constants->maxPayloadSize = 1500;
+  // Packet nums per scan，360/0.4 = 900, 900*10=9000 per second 10Hz
+  // Vital - param to detect a gap in sensor timestamp, No need to use 12 to avoid incorrect warning
+  constants->properties.packetsPerSecond = 9000 / (m_bIsDualReturn ? 1 : 2);
+  // Vital - affect the display of live sensor, point nums per second: 9000 * 128 * 2 = 230400
+  constants->properties.pointsPerSecond = 2304000 / (m_bIsDualReturn ? 1 : 2);
+  constants->properties.spinFrequency = m_u16SpinSpeed / 60.0f;
+
+  // constants->properties.packetsPerSpin = 900;
+  // constants->properties.pointsPerSpin = 230400;
+  constants->properties.pointsPerPacket = 256;
+  constants->properties.pointStride = 8;
+  // TODO support qt lidar closes some laser channel, namely dynamic FOV
+  constants->properties.horizontalFOVStart = deg2Rad(0);
+  constants->properties.horizontalFOVEnd = deg2Rad(360);
+  // TODO QT can use customized channels 40 128 64
+  constants->properties.numberOfRows = 128;
+  // From the correction file, the first and last
+  constants->properties.verticalFOVStart = deg2Rad(-52.6);
+  constants->properties.verticalFOVEnd = deg2Rad(52.6);
+  std::shared_ptr<const LaserCorrection> correction = GetLaserCorrection();
+  for (int i = 0; i < 128; i++) {
+      if(correction != nullptr && static_cast<size_t>(i) < correction->elevation.size()) {
+          constants->properties.verticalAngles[i] = deg2Rad(correction->elevation[i] / HS_LIDAR_QT128_AZIMUTH_UNIT);
+          // printf("verticalAngles: %f \n", constants->properties.verticalAngles[i]);
+      }
+  }
+
+  // printLidarProperty(&constants->properties);
+  return DW_SUCCESS;
+}
+
+int16_t Udp3_2_Parser::GetVecticalAngle(int channel) {
+  if (channel < 0 || channel >= HS_LIDAR_QT128_LASER_NUM) {
+    printf("GetVecticalAngle: channel id not in range 0-%d \n", HS_LIDAR_QT128_LASER_NUM-1);
+    return -1;
+  }
+
+  return GeneralParser::GetVecticalAngle(channel);
+}
+
+int Udp3_2_Parser::LoadFiretimesString(const char *firetimes) {
+  // printf("LoadFiretimesString: %s\n",firetimes);
+  TextScanner scanner(firetimes, strlen(firetimes));
+  TextSpan line;
+  TextSpan field;
+  scanner.NextLine(line);
+  FieldScanner firstLine(line);
+  firstLine.Next(field);
+  if (!field.EqualsNoCase("eeff")) {
+    printf("firetime file delimiter is wrong\n");
+    return -1;
+  }
+  // built aside, the decoders keep the former firetimes until it is published
+  auto table = std::make_shared<QT128Firetimes>();
+  auto& firetimeTable = table->firetime;
+  for (auto& loop : firetimeTable) loop.fill(0);
+  // the loop number is the 4th field of the second line
+  unsigned int loopNum = 0;
+  scanner.NextLine(line);
+  FieldScanner loopNumLine(line);
+  for (int i = 0; i < 4 && loopNumLine.Next(field); i++) {}
+  ParseInt(field, loopNum);
+  // header of the channel lines
+  scanner.NextLine(line);
+  for (int i = 0; i < HS_LIDAR_QT128_LASER_NUM; i++) {
+    if (!scanner.NextLine(line)) line = TextSpan();
+    FieldScanner channelLine(line);
+    if (loopNum > 0 && channelLine.Count() != loopNum * 2) {
+      printf("loop num is not equal to the first channel line\n");
+      return -1;
+    }
+    // files may describe more loops than the lidar fires, only the first loops are used
+    for (unsigned int j = 0; j < loopNum && j < HS_LIDAR_QT128_LOOP_NUM; j++) {
+      int laserId = 0;
+      float firetime = 0;
+      channelLine.Next(field);
+      ParseInt(field, laserId);
+      laserId -= 1;
+      if (laserId < 0 || laserId >= HS_LIDAR_QT128_LASER_NUM) {
+        printf("LoadFiretimesString: laser id Error, laserId=%d\n", laserId);
+        return -1;
+      }
+      channelLine.Next(field);
+      if (!ParseFloat(field, firetime)) {
+        printf("LoadFiretimesString: firetime Error, laserId=%d\n", laserId);
+        return -1;
+      }
+      firetimeTable[j][laserId] = std::isfinite(firetime) ? firetime : 0;
+      // printf("loop num=%d, laserId =%d, firetime = %f\n", j, laserId, firetimeTable[j][laserId]);
+    }
+  }
+  // the azimuth correction at the current speed is built here, not by the first packet after the swap
+  std::shared_ptr<const QT128Firetimes> former = std::atomic_load(&m_pFiretimes);
+  std::shared_ptr<const QT128FiretimeAziCorr> formerCorr = former != nullptr ? std::atomic_load(&former->aziCorr) : nullptr;
+  former.reset();
+  if (formerCorr != nullptr) {
+    GetFiretimesAziCorr(*table, formerCorr->speed);
+  }
+  PublishCalibration(m_pFiretimes, std::shared_ptr<const QT128Firetimes>(table));
+  m_bGetFiretimes = true;
+  return 0;
+}
+
+int Udp3_2_Parser::LoadChannelConfigString(const char *channelconfig) {
+  // printf("LoadChannelConfigString: \n");
+  // printf("%s\n",channelconfig);
+  // built aside, the decoders keep the former config until it is published
+  auto config = std::make_shared<PandarQTChannelConfig>();
+  TextScanner scanner(channelconfig, strlen(channelconfig));
+  TextSpan line;
+  TextSpan field;
+
+  scanner.NextLine(line);
+  FieldScanner versionLine(line);
+  versionLine.Next(field);
+  if (!field.EqualsNoCase("eeff")) {
+    printf("channel config file delimiter is wrong\n");
+    return -1;
+  }
+  versionLine.Next(field);
+  bool ok = ParseInt(field, config->m_u8MajorVersion);
+  versionLine.Next(field);
+  ok = ParseInt(field, config->m_u8MinVersion) && ok;
+  // laser num is the 2nd field and block num the 4th
+  scanner.NextLine(line);
+  FieldScanner channelNumLine(line);
+  channelNumLine.Next(field);
+  channelNumLine.Next(field);
+  ok = ParseInt(field, config->m_u8LaserNum) && ok;
+  channelNumLine.Next(field);
+  channelNumLine.Next(field);
+  ok = ParseInt(field, config->m_u8BlockNum) && ok;
+  if (!ok || config->m_u8LaserNum <= 0 ||
+      config->m_u8BlockNum <= 0) {
+    printf("LaserNum:%d, BlockNum:%d\n", config->m_u8LaserNum, config->m_u8BlockNum);
+    return -1;
+  }
+  scanner.NextLine(line);
+  unsigned int loop_num = FieldScanner(line).Count();
+  config->m_vChannelConfigTable.resize(loop_num);
+
+  for (unsigned int i = 0; i < loop_num; i++) {
+    config->m_vChannelConfigTable[i].resize(
+        config->m_u8LaserNum);
+  }
+  for (int i = 0; i < config->m_u8LaserNum; i++) {
+    if (!scanner.NextLine(line)) line = TextSpan();
+    FieldScanner channelLine(line);
+    if (channelLine.Count() != loop_num) {
+      printf("loop num is not equal to the first channel line\n");
+      return -1;
+    }
+    for (unsigned int j = 0; j < loop_num; j++) {
+      channelLine.Next(field);
+      if (!ParseInt(field, config->m_vChannelConfigTable[j][i])) {
+        printf("LoadChannelConfigString: channel Error, line=%d\n", i);
+        return -1;
+      }
+    }
+  }
+  if (!scanner.NextLine(line)) line = TextSpan();
+  config->m_sHashValue.assign(line.begin, line.size());
+  config->m_bIsChannelConfigObtained = true;
+  PublishCalibration(m_pChannelConfig, std::shared_ptr<const PandarQTChannelConfig>(config));
+
+  return 0;
+}
+
+void Udp3_2_Parser::LoadChannelConfigFile(std::string channel_config_path) {
+  std::vector<char> buffer;
+  if (!ReadTextFile(channel_config_path, buffer)) {
+    printf("Open channel congfig file failed\n");
+    return;
+  }
+  int ret = LoadChannelConfigString(buffer.data());
+  if (ret != 0) {
+    printf("Parse local channel congfig file Error\n");
+  }
+}
+
+std::shared_ptr<const QT128FiretimeAziCorr> Udp3_2_Parser::GetFiretimesAziCorr(const QT128Firetimes& firetimes,
+                                                                             uint16_t speed) {
+  std::shared_ptr<const QT128FiretimeAziCorr> current = std::atomic_load(&firetimes.aziCorr);
+  if (current != nullptr && current->speed == speed) {
+    return current;
+  }
+  // degree to the unit of correction file 1/1000
+  auto table = std::make_shared<QT128FiretimeAziCorr>();
+  table->speed = speed;
+  for (int loop = 0; loop < HS_LIDAR_QT128_LOOP_NUM; loop++) {
+    for (int laserId = 0; laserId < HS_LIDAR_QT128_LASER_NUM; laserId++) {
+      // us * rpm * 6e-6 is degree
+      table->corr[loop][laserId] = static_cast<int32_t>(
+          round(firetimes.firetime[loop][laserId] * speed * 6E-6 * HS_LIDAR_QT128_AZIMUTH_UNIT));
+    }
+  }
+  // several threads may build it at the same time, they build the same table
+  std::atomic_store(&firetimes.aziCorr, std::shared_ptr<const QT128FiretimeAziCorr>(table));
+  return table;
+}
+
+}  // namespace golden_ref
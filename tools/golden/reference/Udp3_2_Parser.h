@@ -0,0 +1,130 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd] 
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Frozen reference copy of UdpParser/include/Udp3_2_Parser.h for the golden harness, see tools/golden/golden_check.cpp.
+// Copied at commit 669ad15, the one adding the harness, so it holds the decoder changes made before it and not the
+// parser of the first release. Only the namespace and the include guard differ from the original of 669ad15.
+// Do not optimise it, the optimised decoders are compared against it
+
+/**
+ * @file
+ * <b>HESAI Plugin for DriveWorks: Lidar Sensor UDP Parser</b>
+ *
+ * @b Description: This file defines the udp parser for QT128.
+ */
+
+#ifndef GOLDEN_REF_UDP3_2_PARSER_H_
+#define GOLDEN_REF_UDP3_2_PARSER_H_
+
+// Angle unit = 1/1000 360000/1000 = 360, the same as unit in correction file
+#define HS_LIDAR_QT128_AZIMUTH_SIZE (360000)
+#define HS_LIDAR_QT128_AZIMUTH_UNIT (1000)
+#define HS_LIDAR_QT128_LASER_NUM (128)
+#define HS_LIDAR_QT128_LOOP_NUM (4)
+#define HS_LIDAR_QT128_COORDINATE_CORRECTION_ODOG (0.0354)
+#define HS_LIDAR_QT128_COORDINATE_CORRECTION_OGOT (-0.0072)
+
+#include <array>
+#include <memory>
+#include "GeneralParser.h"
+#include "HsLidarQTV2.h"
+
+namespace golden_ref {
+
+// Default channel config is the common use of QT128, using all 128 channels. Immutable once published
+struct PandarQTChannelConfig {
+ public:
+  uint16_t m_u16Sob = 0;
+  uint8_t m_u8MajorVersion = 0;
+  uint8_t m_u8MinVersion = 0;
+  uint8_t m_u8LaserNum = 0;
+  uint8_t m_u8BlockNum = 0;
+  std::vector<std::vector<int>> m_vChannelConfigTable;
+  std::string m_sHashValue;
+  bool m_bIsChannelConfigObtained = false;
+};
+
+// Azimuth correction caused by the firetime at one spin speed, unit 1/1000 degree. Immutable once built
+struct QT128FiretimeAziCorr {
+  uint16_t speed = 0;
+  std::array<std::array<int32_t, HS_LIDAR_QT128_LASER_NUM>, HS_LIDAR_QT128_LOOP_NUM> corr;
+};
+
+// Firing time of each laser for every loop in us. Immutable once published, except the cache of its azimuth correction
+struct QT128Firetimes {
+  std::array<std::array<float, HS_LIDAR_QT128_LASER_NUM>, HS_LIDAR_QT128_LOOP_NUM> firetime;
+  // azimuth correction for the last spin speed, replaced by 'GetFiretimesAziCorr'
+  mutable std::shared_ptr<const QT128FiretimeAziCorr> aziCorr;
+};
+
+class Udp3_2_Parser : public GeneralParser {
+ public:
+  Udp3_2_Parser();
+  virtual ~Udp3_2_Parser();
+
+  dwStatus GetDecoderConstants(_dwSensorLidarDecoder_constants* constants) override;
+
+  virtual dwStatus DecodePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length,
+                                dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI, PointExtraOutput* extra,
+                                const DeskewMotion* motion, PacketDecodeInfo& info) override;
+
+  bool ParseTailStatus(const uint8_t *buffer, size_t length, TailStatus& status) override;
+
+  bool ParsePacketId(const uint8_t *buffer, size_t length, uint32_t& sequence, uint16_t& azimuth) override;
+
+  RangeImageLayout GetRangeImageLayout() const override;
+
+  /**
+   * @brief Get vertical angle of each laser channel
+   * 
+   * @param channel 0-127 each laser channel, QT128 has 128
+   * @return int16_t 1.223 degree will return 1223，unit = 1/1000
+   */
+  int16_t GetVecticalAngle(int channel) override;
+
+  /**
+   * @brief Decode the firetime of each laser for every loop, only the first HS_LIDAR_QT128_LOOP_NUM loops are used.
+   * Can be called while decoding, the new firetimes are used from the next packet
+   */
+  virtual int LoadFiretimesString(const char *firetimes) override;
+  
+  /**
+   * @brief Initialize the m_pChannelConfig, specialized for QT. Can be called while decoding
+   */
+  virtual int LoadChannelConfigString(const char *channelconfig) override;
+  virtual void LoadChannelConfigFile(std::string channel_config_path) override;
+
+ private:
+  /**
+   * @brief Azimuth correction of each laser and loop caused by the firetime, only computed again when the speed changes.
+   * Safe to be called by several decode threads
+   */
+  static std::shared_ptr<const QT128FiretimeAziCorr> GetFiretimesAziCorr(const QT128Firetimes& firetimes, uint16_t speed);
+
+  // To be initialized by func 'LoadFiretimesString', replaced with 'PublishCalibration'
+  std::shared_ptr<const QT128Firetimes> m_pFiretimes;
+  // To be initialized by func 'LoadChannelConfigString', replaced with 'PublishCalibration'
+  std::shared_ptr<const PandarQTChannelConfig> m_pChannelConfig;
+  
+  // Only for QT128 and etc，not for AT128
+  std::vector<double> m_vFiretimeCorrection;
+};
+
+}  // namespace golden_ref
+
+#endif  // GOLDEN_REF_UDP3_2_PARSER_H_
@@ -0,0 +1,448 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd] 
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Frozen reference copy of UdpParser/src/Udp4_3_Parser.cpp for the golden harness, see tools/golden/golden_check.cpp.
+// Copied at commit 669ad15, the one adding the harness, so it holds the decoder changes made before it and not the
+// parser of the first release. Besides the namespace and the include guard it differs from the original of 669ad15 by
+// the output fixes ported since:
+// - 8054895, the motor speed of the AT128 tail is read in 0.1 rpm for the point times
+// Do not optimise it, the optimised decoders are compared against it
+
+#include <fstream>
+#include "Udp4_3_Parser.h"
+#include "HsLidarStV3.h"
+#include "LidarProtocolHeader.h"
+
+namespace golden_ref {
+
+Udp4_3_Parser::Udp4_3_Parser() : m_fSinMap(MAX_AZI_LEN), m_fCosMap(MAX_AZI_LEN) {
+  // printf("Udp4_3_Parser: creating parser for lidar AT128 \n");
+  for (int i = 0; i < MAX_AZI_LEN; ++i) {
+    m_fSinMap[i] = std::sin(2 * i * M_PI / MAX_AZI_LEN);
+    m_fCosMap[i] = std::cos(2 * i * M_PI / MAX_AZI_LEN);
+  }
+  m_bGetCorrectionFile = false;
+  m_bIsDualReturn = true;
+  m_u16SpinSpeed = 2000;
+}
+
+Udp4_3_Parser::~Udp4_3_Parser() { 
+  // printf("release Udp4_3_Parser\n"); 
+}
+
+int Udp4_3_Parser::ParseCorrectionString(char *correction_string) {
+  // printf("ParseCorrectionString: parsing calibration file\n");
+  try {
+    char *p = correction_string;
+    PandarATCorrectionsHeader header = *(PandarATCorrectionsHeader *)p;
+    if (header.frame_number > 8 || header.channel_number > AT128_LASER_NUM) {
+      return -1;
+    }
+    // built aside, the decoders keep the former corrections until it is published
+    auto corrections = std::make_shared<PandarATCorrections>();
+    if (0xee == header.delimiter[0] && 0xff == header.delimiter[1]) {
+      switch (header.version[1]) {
+        case 3: {
+          corrections->header = header;
+          auto frame_num = corrections->header.frame_number;
+          auto channel_num = corrections->header.channel_number;
+          p += sizeof(PandarATCorrectionsHeader);
+          memcpy((void *)&corrections->start_frame, p,
+                 sizeof(uint16_t) * frame_num);
+          p += sizeof(uint16_t) * frame_num;
+          memcpy((void *)&corrections->end_frame, p,
+                 sizeof(uint16_t) * frame_num);
+          p += sizeof(uint16_t) * frame_num;
+          // printf("frame_num: %d\n", frame_num);
+          // printf("start_frame, end_frame: \n");
+          for (int i = 0; i < frame_num; ++i)
+            // printf("%lf,   %lf\n",
+            //        corrections->start_frame[i] / 100.f,
+            //        corrections->end_frame[i] / 100.f);
+          memcpy((void *)&corrections->azimuth, p,
+                 sizeof(int16_t) * channel_num);
+          p += sizeof(int16_t) * channel_num;
+          memcpy((void *)&corrections->elevation, p,
+                 sizeof(int16_t) * channel_num);
+          p += sizeof(int16_t) * channel_num;
+          memcpy((void *)&corrections->azimuth_offset, p,
+                 sizeof(int8_t) * CIRCLE_ANGLE);
+          p += sizeof(int8_t) * CIRCLE_ANGLE;
+          memcpy((void *)&corrections->elevation_offset, p,
+                 sizeof(int8_t) * CIRCLE_ANGLE);
+          p += sizeof(int8_t) * CIRCLE_ANGLE;
+          memcpy((void *)&corrections->SHA256, p,
+                 sizeof(uint8_t) * 32);
+          p += sizeof(uint8_t) * 32;
+          PublishCalibration(m_pCorrections, std::shared_ptr<const PandarATCorrections>(corrections));
+          m_bGetCorrectionFile = true;
+          return 0;
+        } break;
+        case 5: {
+          corrections->header = header;
+          auto frame_num = corrections->header.frame_number;
+          auto channel_num = corrections->header.channel_number;
+          p += sizeof(PandarATCorrectionsHeader);
+          memcpy((void *)&corrections->l.start_frame, p,
+                 sizeof(uint32_t) * frame_num);
+          p += sizeof(uint32_t) * frame_num;
+          memcpy((void *)&corrections->l.end_frame, p,
+                 sizeof(uint32_t) * frame_num);
+          p += sizeof(uint32_t) * frame_num;
+          // printf("frame_num: %d\n", frame_num);
+          // printf("start_frame, end_frame: \n");
+          // for (int i = 0; i < frame_num; ++i)
+          //   printf("%lf,   %lf\n",
+          //          corrections->l.start_frame[i] /
+          //              (FINE_AZIMUTH_UNIT * 100.f),
+          //          corrections->l.end_frame[i] /
+          //              (FINE_AZIMUTH_UNIT * 100.f));
+          memcpy((void *)&corrections->l.azimuth, p,
+                 sizeof(int32_t) * channel_num);
+          p += sizeof(int32_t) * channel_num;
+          memcpy((void *)&corrections->l.elevation, p,
+                 sizeof(int32_t) * channel_num);
+          p += sizeof(int32_t) * channel_num;
+          auto adjust_length = channel_num * CORRECTION_AZIMUTH_NUM;
+          memcpy((void *)&corrections->azimuth_offset, p,
+                 sizeof(int8_t) * adjust_length);
+          p += sizeof(int8_t) * adjust_length;
+          memcpy((void *)&corrections->elevation_offset, p,
+                 sizeof(int8_t) * adjust_length);
+          p += sizeof(int8_t) * adjust_length;
+          memcpy((void *)&corrections->SHA256, p,
+                 sizeof(uint8_t) * 32);
+          p += sizeof(uint8_t) * 32;
+          // printf("frame_num: %d\n", frame_num);
+          // printf("start_frame, end_frame: \n");
+          for (int i = 0; i < frame_num; ++i) {
+            corrections->l.start_frame[i] = corrections->l.start_frame[i] * corrections->header.resolution;
+            corrections->l.end_frame[i] = corrections->l.end_frame[i] * corrections->header.resolution;
+            // printf("%lf,   %lf\n", corrections->l.start_frame[i] / AZIMUTH_UNIT, corrections->l.end_frame[i] / AZIMUTH_UNIT);
+          }
+          for (int i = 0; i < AT128_LASER_NUM; i++) {
+            corrections->l.azimuth[i] = corrections->l.azimuth[i] * corrections->header.resolution;
+            corrections->l.elevation[i] = corrections->l.elevation[i] * corrections->header.resolution;
+          }
+          for (int i = 0; i < adjust_length; i++) {
+            corrections->azimuth_offset[i] = corrections->azimuth_offset[i] * corrections->header.resolution;
+            corrections->elevation_offset[i] = corrections->elevation_offset[i] * corrections->header.resolution;
+          }
+
+          PublishCalibration(m_pCorrections, std::shared_ptr<const PandarATCorrections>(corrections));
+          m_bGetCorrectionFile = true;
+          return 0;
+        } break;
+        default:
+          break;
+      }
+    }
+
+    return -1;
+  } catch (const std::exception &e) {
+    return -1;
+  }
+
+  return -1;
+}
+
+dwStatus Udp4_3_Parser::GetDecoderConstants(_dwSensorLidarDecoder_constants* constants) {
+  // Vital - crackdown if too small (10), memory mass consumption if too large.
+  // For AT128 1118 byte for each packet
+  constants->maxPayloadSize = 1500;
+  // Vital - virtual sensor mode will enter blackscreen, loading
+  // Too large causes accidental terminate (+0000) or dislocation on displaying (+00)
+  // !Fault parameter to avoid dw printing packet dropping
+  constants->properties.packetsPerSecond = 12 / (m_bIsDualReturn ? 1 : 2);
+  // Vital - exception occurs or ui stucks, if too large
+  constants->properties.pointsPerSecond = 3200000 / (m_bIsDualReturn ? 1 : 2);
+  // No effect
+  constants->properties.packetsPerSpin = 1250 * m_u16SpinSpeed / 2000.0f / (m_bIsDualReturn ? 1 : 2);
+  // No effect
+  constants->properties.pointsPerSpin = 320000 * m_u16SpinSpeed / 2000.0f / (m_bIsDualReturn ? 1 : 2);
+  constants->properties.pointsPerPacket = 256;
+  constants->properties.pointStride = 4;
+  // Vital - or no display
+  constants->properties.spinFrequency = m_u16SpinSpeed / 200.0f;
+  // No effect - Vectical FOV
+  constants->properties.horizontalFOVEnd = 2.8;
+  constants->properties.horizontalFOVStart = 0.5;
+  constants->properties.numberOfRows = 128;
+  constants->properties.verticalFOVEnd = 0.224673;
+  constants->properties.verticalFOVStart = -0.216697;
+  // No effect if no assignment
+  // printLidarProperty(&constants->properties);
+  std::shared_ptr<const PandarATCorrections> corrections = std::atomic_load(&m_pCorrections);
+  for (int i = 0; i < 128; i++) {
+      if(corrections != nullptr)
+          constants->properties.verticalAngles[i] = deg2Rad(corrections->elevation[i] / 25600.0f);
+  }
+
+  return DW_SUCCESS;
+}
+
+int Udp4_3_Parser::BindNumaNode(int node) {
+  int ret = GeneralParser::BindNumaNode(node);
+  ret |= m_fSinMap.BindNode(node);
+  ret |= m_fCosMap.BindNode(node);
+  return ret;
+}
+
+RangeImageLayout Udp4_3_Parser::GetRangeImageLayout() const {
+  // 0.1 degree over the 120 degree FOV, from 30 to 150 degree
+  RangeImageLayout layout;
+  layout.rows = AT128_LASER_NUM;
+  layout.cols = 1200;
+  layout.returns = 2;
+  layout.azimuthStart = 30 * 25600;
+  layout.azimuthStep = 2560;
+  layout.unitsPerRev = MAX_AZI_LEN;
+  return layout;
+}
+
+bool Udp4_3_Parser::ParseTailStatus(const uint8_t *buffer, size_t length, TailStatus& status) {
+  if (length < sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_ST_V3) || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+    return false;
+  }
+  const HS_LIDAR_HEADER_ST_V3 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_ST_V3 *>(&(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  size_t tailOffset = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_ST_V3) +
+                      (sizeof(HS_LIDAR_BODY_AZIMUTH_ST_V3) + sizeof(HS_LIDAR_BODY_FINE_AZIMUTH_ST_V3) +
+                       sizeof(HS_LIDAR_BODY_CHN_NNIT_ST_V3) * pHeader->GetLaserNum()) * pHeader->GetBlockNum() +
+                      sizeof(HS_LIDAR_BODY_CRC_ST_V3);
+  if (tailOffset + sizeof(HS_LIDAR_TAIL_ST_V3) > length) {
+    return false;
+  }
+  const HS_LIDAR_TAIL_ST_V3 *pTail = reinterpret_cast<const HS_LIDAR_TAIL_ST_V3 *>(buffer + tailOffset);
+  status.statusNum = 3;
+  status.statusId[0] = pTail->GetStsID0();
+  status.statusData[0] = pTail->GetData0();
+  status.statusId[1] = pTail->GetStsID1();
+  status.statusData[1] = pTail->GetData1();
+  status.statusId[2] = pTail->GetStsID2();
+  status.statusData[2] = pTail->GetData2();
+  status.motorSpeed = pTail->GetMotorSpeed();
+  status.returnMode = pTail->GetReturnMode();
+  status.shutdown = pTail->HasShutdown();
+  return true;
+}
+
+bool Udp4_3_Parser::ParsePacketId(const uint8_t *buffer, size_t length, uint32_t& sequence, uint16_t& azimuth) {
+  size_t bodyOffset = sizeof(HS_LIDAR_PRE_HEADER) + sizeof(HS_LIDAR_HEADER_ST_V3);
+  if (length < bodyOffset + sizeof(HS_LIDAR_BODY_AZIMUTH_ST_V3) || buffer[0] != 0xEE || buffer[1] != 0xFF) {
+    return false;
+  }
+  const HS_LIDAR_HEADER_ST_V3 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_ST_V3 *>(&(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+  azimuth = reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_ST_V3 *>(buffer + bodyOffset)->GetAzimuth();
+  // the sequence number follows the tail
+  size_t seqOffset = bodyOffset +
+                     (sizeof(HS_LIDAR_BODY_AZIMUTH_ST_V3) + sizeof(HS_LIDAR_BODY_FINE_AZIMUTH_ST_V3) +
+                      sizeof(HS_LIDAR_BODY_CHN_NNIT_ST_V3) * pHeader->GetLaserNum()) * pHeader->GetBlockNum() +
+                     sizeof(HS_LIDAR_BODY_CRC_ST_V3) + sizeof(HS_LIDAR_TAIL_ST_V3);
+  sequence = 0;
+  if (pHeader->HasSeqNum() && seqOffset + sizeof(HS_LIDAR_TAIL_SEQ_NUM_ST_V3) <= length) {
+    sequence = reinterpret_cast<const HS_LIDAR_TAIL_SEQ_NUM_ST_V3 *>(buffer + seqOffset)->GetSeqNum();
+  }
+  return true;
+}
+
+dwStatus Udp4_3_Parser::DecodePacket(dwLidarDecodedPacket *output, const uint8_t *buffer, const size_t length,
+                                     dwLidarPointXYZI* pointXYZI, dwLidarPointRTHI* pointRTHI, PointExtraOutput* extra,
+                                     const DeskewMotion* motion, PacketDecodeInfo& info){
+  if (buffer[0] != 0xEE || buffer[1] != 0xFF || length < 0) {
+    // printf("Udp4_3_Parser: ParserOnePacket, invalid packet %x %x\n", buffer[0], buffer[1]);
+    return DW_FAILURE;
+  }
+  const HS_LIDAR_HEADER_ST_V3 *pHeader =
+      reinterpret_cast<const HS_LIDAR_HEADER_ST_V3 *>(
+          &(buffer[0]) + sizeof(HS_LIDAR_PRE_HEADER));
+
+  const HS_LIDAR_TAIL_ST_V3 *pTail =
+      reinterpret_cast<const HS_LIDAR_TAIL_ST_V3 *>(
+          (const unsigned char *)pHeader + sizeof(HS_LIDAR_HEADER_ST_V3) +
+          (sizeof(HS_LIDAR_BODY_AZIMUTH_ST_V3) +
+           sizeof(HS_LIDAR_BODY_FINE_AZIMUTH_ST_V3) +
+           sizeof(HS_LIDAR_BODY_CHN_NNIT_ST_V3) * pHeader->GetLaserNum()) *
+              pHeader->GetBlockNum() +
+          sizeof(HS_LIDAR_BODY_CRC_ST_V3));
+  info.hasTail = true;
+  info.spinSpeed = pTail->m_i16MotorSpeed;
+  info.isDualReturn = pTail->IsDualReturn();
+  info.laserNum = pHeader->GetLaserNum();
+  info.blockNum = pHeader->GetBlockNum();
+  // seem have no effect on the display
+  output->duration = pTail->GetMicroLidarTimeU64() - 100000; 
+  // fill value outside this function
+  output->hostTimestamp = 0;
+  // seem have no effect on the display
+  output->maxPoints = pHeader->GetBlockNum() * pHeader->GetLaserNum();
+  // the calibration of the whole packet is taken once, a reload is used from the next packet
+  std::shared_ptr<const PandarATCorrections> pCorrections = std::atomic_load(&m_pCorrections);
+  if (pHeader->GetLaserNum() > AT128_LASER_NUM) {
+    return DW_FAILURE;
+  }
+  if (pCorrections != nullptr) {
+    output->maxVerticalAngleRad = pCorrections->l.elevation[pHeader->GetLaserNum() - 1] /180 * M_PI/ 25600.0f;
+    output->minVerticalAngleRad = pCorrections->l.elevation[0] /180 * M_PI/ 25600.0f;
+  } else {
+    output->maxVerticalAngleRad = 0;
+    output->minVerticalAngleRad = 0;
+  }
+  // vital parameter to assign memory for dw, no point exsits if equals to zero, program crack if no assignment
+  output->nPoints = pHeader->GetBlockNum() * pHeader->GetLaserNum();
+  // vital parameter showing one frame
+  output->scanComplete = false;
+  // the sensorTimestamp will be show in the replay tool UI, prove to be correct
+  // It is normal if sensorTimestamp differs from timestamp of PC, because some lidar timestamp needs to be corrected manauly by PTP
+  output->sensorTimestamp = this->GetMicroLidarTimeU64(pTail->m_u8UTC, 6, pTail->GetTimestamp());
+  // the tail timestamp belongs to the first block, the others follow the rotor, no firetimes for AT128
+  int32_t firstAzimuth = -1;
+  // the motor speed of the tail is in 0.1 rpm, as m_u16SpinSpeed
+  const float revPerUs = pTail->GetMotorSpeed() / 600e6f;
+  dwTime_t* pointTimestamp = extra != nullptr ? extra->pointTimestamp : nullptr;
+  DeskewMotion packetMotion;
+  const DeskewMotion* pMotion = ResolveDeskewMotion(motion, packetMotion, output->sensorTimestamp);
+  const bool bPointTime = pointTimestamp != nullptr || pMotion != nullptr;
+  RangeImage* pImage = extra != nullptr ? extra->rangeImage : nullptr;
+  if (pImage != nullptr && pImage->timestamp == 0) pImage->timestamp = output->sensorTimestamp;
+  CompactPoint* pCompact = extra != nullptr ? extra->compactPoint : nullptr;
+  int index = 0;
+  float minAzimuth = 0;
+  float maxAzimuth = 0;
+  
+  const HS_LIDAR_BODY_AZIMUTH_ST_V3 *pAzimuth =
+      reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_ST_V3 *>(
+          (const unsigned char *)pHeader + sizeof(HS_LIDAR_HEADER_ST_V3));
+  const HS_LIDAR_BODY_FINE_AZIMUTH_ST_V3 *pFineAzimuth =
+      reinterpret_cast<const HS_LIDAR_BODY_FINE_AZIMUTH_ST_V3 *>(
+          (const unsigned char *)pAzimuth +
+          sizeof(HS_LIDAR_BODY_AZIMUTH_ST_V3));
+
+  const HS_LIDAR_BODY_CHN_NNIT_ST_V3 *pChnUnit =
+      reinterpret_cast<const HS_LIDAR_BODY_CHN_NNIT_ST_V3 *>(
+          (const unsigned char *)pAzimuth +
+          sizeof(HS_LIDAR_BODY_FINE_AZIMUTH_ST_V3) +
+          sizeof(HS_LIDAR_BODY_AZIMUTH_ST_V3));
+  for (int blockid = 0; blockid < pHeader->GetBlockNum(); blockid++) {
+    uint16_t u16Azimuth = pAzimuth->GetAzimuth();
+    uint8_t u8FineAzimuth = pFineAzimuth->GetFineAzimuth();
+    pChnUnit = reinterpret_cast<const HS_LIDAR_BODY_CHN_NNIT_ST_V3 *>(
+        (const unsigned char *)pAzimuth + sizeof(HS_LIDAR_BODY_AZIMUTH_ST_V3) +
+        sizeof(HS_LIDAR_BODY_FINE_AZIMUTH_ST_V3));
+
+    // point to next block azimuth addr
+    pAzimuth = reinterpret_cast<const HS_LIDAR_BODY_AZIMUTH_ST_V3 *>(
+        (const unsigned char *)pAzimuth + sizeof(HS_LIDAR_BODY_AZIMUTH_ST_V3) +
+        sizeof(HS_LIDAR_BODY_FINE_AZIMUTH_ST_V3) +
+        sizeof(HS_LIDAR_BODY_CHN_NNIT_ST_V3) * pHeader->GetLaserNum());
+    // point to next block fine azimuth addr
+    pFineAzimuth = reinterpret_cast<const HS_LIDAR_BODY_FINE_AZIMUTH_ST_V3 *>(
+        (const unsigned char *)pAzimuth + sizeof(HS_LIDAR_BODY_AZIMUTH_ST_V3));
+
+    int Azimuth = u16Azimuth * FINE_AZIMUTH_UNIT + u8FineAzimuth;
+    if (firstAzimuth < 0) firstAzimuth = Azimuth;
+    const int64_t blockTime = output->sensorTimestamp +
+        static_cast<int64_t>(AzimuthDeltaToUs(Azimuth - firstAzimuth, MAX_AZI_LEN, revPerUs));
+    // dual return means two blocks of the same azimuth
+    const uint32_t returnIndex = info.isDualReturn ? blockid % 2 : 0;
+    int count = 0, field = 0;
+    if (pCorrections != nullptr) {
+      while (count < pCorrections->header.frame_number &&
+             (((Azimuth + MAX_AZI_LEN - pCorrections->l.start_frame[field]) % MAX_AZI_LEN +
+             (pCorrections->l.end_frame[field] + MAX_AZI_LEN - Azimuth) % MAX_AZI_LEN) !=
+             (pCorrections->l.end_frame[field] + MAX_AZI_LEN -
+             pCorrections->l.start_frame[field]) % MAX_AZI_LEN)) {
+        field = (field + 1) % pCorrections->header.frame_number;
+        count++;
+      }
+      if (count >= pCorrections->header.frame_number) continue;
+    }
+    auto elevation =0;
+    auto azimuth = Azimuth;
+    for (int i = 0; i < pHeader->GetLaserNum(); i++) {
+      /* for all the units in a block */
+      uint16_t u16Distance = pChnUnit->GetDistance();
+      uint8_t u8Intensity = pChnUnit->GetReflectivity();
+      // uint8_t u8Confidence = pChnUnit->GetConfidenceLevel();
+      float distance = static_cast<float>(u16Distance) * pHeader->GetDistUnit();
+      pChnUnit = pChnUnit + 1;
+      
+      if (pCorrections != nullptr) {
+        elevation = (pCorrections->l.elevation[i] +
+                   pCorrections->getElevationAdjustV3(i, Azimuth) *
+                       FINE_AZIMUTH_UNIT );
+        elevation = (MAX_AZI_LEN + elevation) % MAX_AZI_LEN;
+        azimuth = ((Azimuth + MAX_AZI_LEN - pCorrections->l.start_frame[field]) * 2 -
+                         pCorrections->l.azimuth[i] +
+                         pCorrections->getAzimuthAdjustV3(i, Azimuth) * FINE_AZIMUTH_UNIT);
+        azimuth = (MAX_AZI_LEN + azimuth) % MAX_AZI_LEN;
+      }      
+      float xyDistance = distance * m_fCosMap[(elevation)];
+
+      pointXYZI[index].x = xyDistance * m_fSinMap[(azimuth)];
+      pointXYZI[index].y = xyDistance * m_fCosMap[(azimuth)];
+      pointXYZI[index].z = distance * m_fSinMap[(elevation)];
+      pointXYZI[index].intensity = u8Intensity;  // divide 255.0f if 0-1
+      pointRTHI[index].radius = distance;
+      pointRTHI[index].theta = azimuth / AZIMUTH_UNIT / 180 * M_PI;
+      pointRTHI[index].phi = elevation / AZIMUTH_UNIT / 180 * M_PI;
+      pointRTHI[index].intensity = u8Intensity;  // divide 255.0f if 0-1
+      if (bPointTime) {
+        FinishPoint(pointXYZI[index], pointTimestamp != nullptr ? &pointTimestamp[index] : nullptr,
+                    blockTime, pMotion);
+      }
+      if (pImage != nullptr) {
+        pImage->Write(i, azimuth, returnIndex, distance, u8Intensity,
+                      pointXYZI[index].x, pointXYZI[index].y, pointXYZI[index].z);
+      }
+      if (pCompact != nullptr) {
+        PackCompactPoint(pCompact[index], pointXYZI[index], static_cast<uint8_t>(i));
+      }
+      index++;
+      // PrintDwPoint(&pointRTHI[index]);
+      // PrintDwPoint(&pointXYZI[index]);
+    }
+    // ! Error crack the window and show loading if scanComplete never is never set true
+    info.AddSplitAzimuth(u16Azimuth);
+    if(blockid  == 0 ) minAzimuth =  azimuth;
+    else maxAzimuth = azimuth;
+    
+  }
+
+  // No influence on the display
+  output->maxHorizontalAngleRad = (maxAzimuth / 25600.0f) / 180 * M_PI;
+  output->minHorizontalAngleRad = (minAzimuth / 25600.0f) / 180 * M_PI;
+  // Display program show black screen if no incoming points
+  output->pointsRTHI = pointRTHI;
+  output->pointsXYZI = pointXYZI;
+
+  return DW_SUCCESS;
+}
+
+int16_t Udp4_3_Parser::GetVecticalAngle(int channel) {
+  std::shared_ptr<const PandarATCorrections> corrections = std::atomic_load(&m_pCorrections);
+  if (corrections == nullptr || channel < 0 || channel >= AT128_LASER_NUM) {
+    printf ("GetVecticalAngle: no correction file get, Error");
+    return -1;
+  }
+
+  return corrections->elevation[channel];
+}
+
+}  // namespace golden_ref
@@ -0,0 +1,222 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Index the frames of a recording, a pcap or pcapng capture or a DriveWorks .bin recording of the plugin. The
+// recording is read once, the packets of one lidar are split into frames like the plugin does, and the offset,
+// times and packet count of each frame are written next to it, so the replay and batch tools can go to frame N
+// at once or hand the frames to several threads
+
+#include <getopt.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "FrameIndex.h"
+#include "ParserFactory.h"
+#include "RecordReader.h"
+
+using namespace dw::plugins::lidar;
+using namespace dw::plugins::lidar::tools;
+
+namespace
+{
+struct Options
+{
+    std::string recording;
+    std::string output;
+    bool hasType = false;
+    LidarType type = LidarType::P128;
+    uint16_t port  = 0;
+    std::string share = HESAI_SHARE_DIR;
+    std::string correction;
+    bool print = false;
+    // check the frames by reading them back through the index, -1 for none
+    long check = -1;
+};
+
+void usage(const char* name)
+{
+    printf("Usage: %s [options] <recording>\n"
+           "  The recording is a pcap or pcapng capture or a DriveWorks .bin recording of the plugin\n"
+           "  --lidar <type>        P128, QT128 or AT128, the type of the first point cloud packet by default\n"
+           "  --port <port>         only the datagrams of a capture sent to this port\n"
+           "  --output <file>       index file, <recording>.frames by default\n"
+           "  --share <dir>         folder of the correction files, default %s\n"
+           "  --correction <file>   correction file of the recorded lidar, AT128 needs the right one to\n"
+           "                        split its frames\n"
+           "  --print               list the frames\n"
+           "  --check <n>           read frame n back by its offset, or all the frames if n is 'all'\n",
+           name, HESAI_SHARE_DIR);
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    static const struct option longOptions[] = {
+        {"lidar", required_argument, nullptr, 'l'},      {"port", required_argument, nullptr, 'p'},
+        {"output", required_argument, nullptr, 'o'},     {"share", required_argument, nullptr, 'd'},
+        {"correction", required_argument, nullptr, 'c'}, {"print", no_argument, nullptr, 'P'},
+        {"check", required_argument, nullptr, 'k'},      {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}};
+    int c;
+    while ((c = getopt_long(argc, argv, "h", longOptions, nullptr)) != -1) {
+        switch (c) {
+        case 'l':
+            if (!ParseLidarType(optarg, options.type)) {
+                printf("unknown lidar type %s\n", optarg);
+                return false;
+            }
+            options.hasType = true;
+            break;
+        case 'p': options.port = static_cast<uint16_t>(atoi(optarg)); break;
+        case 'o': options.output = optarg; break;
+        case 'd': options.share = optarg; break;
+        case 'c': options.correction = optarg; break;
+        case 'P': options.print = true; break;
+        case 'k': options.check = strcmp(optarg, "all") == 0 ? LONG_MAX : atol(optarg); break;
+        default: return false;
+        }
+    }
+    if (optind + 1 != argc) {
+        printf("one recording is needed\n");
+        return false;
+    }
+    options.recording = argv[optind];
+    if (options.output.empty()) {
+        options.output = FrameIndex::DefaultPath(options.recording);
+    }
+    return true;
+}
+
+// Type of the first point cloud packet of the recording
+bool detectType(RecordReader& reader, LidarType& type)
+{
+    RecordPacket packet;
+    bool found = false;
+    while (!found && reader.next(packet)) {
+        found = DetectLidarType(packet.data, packet.length, type);
+    }
+    reader.rewind();
+    return found;
+}
+
+// Read a frame back by its offset, its first packet must be the indexed one and the packets must be there
+bool checkFrame(const FrameIndex& index, RecordReader& reader, size_t frame)
+{
+    const FrameEntry& entry = index.frame(frame);
+    if (!index.seekFrame(reader, frame)) {
+        printf("frame %zu: seek to %llu failed\n", frame, static_cast<unsigned long long>(entry.offset));
+        return false;
+    }
+    RecordPacket packet;
+    uint32_t packets = 0;
+    while (packets < entry.packetNum && reader.next(packet)) {
+        LidarType type;
+        if (!DetectLidarType(packet.data, packet.length, type) || type != index.lidarType()) {
+            continue;
+        }
+        if (packets == 0 && (packet.offset != entry.offset || packet.captureTime != entry.captureTime)) {
+            printf("frame %zu: first packet at %llu, indexed at %llu\n", frame,
+                   static_cast<unsigned long long>(packet.offset), static_cast<unsigned long long>(entry.offset));
+            return false;
+        }
+        packets++;
+    }
+    if (packets != entry.packetNum) {
+        printf("frame %zu: %u packets read, %u indexed\n", frame, packets, entry.packetNum);
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+    RecordReader reader;
+    if (!reader.open(options.recording, options.port)) {
+        return 1;
+    }
+    if (!options.hasType && !detectType(reader, options.type)) {
+        printf("no point cloud packet in %s\n", options.recording.c_str());
+        return 1;
+    }
+    std::unique_ptr<GeneralParser> parser = CreateParser(options.type, options.share, options.correction);
+    if (parser == nullptr) {
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    FrameIndex index;
+    if (!index.build(reader, options.type, options.port, *parser)) {
+        printf("no %s packet in %s\n", LidarTypeName(options.type), options.recording.c_str());
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (!index.write(options.output)) {
+        return 1;
+    }
+    size_t complete = 0;
+    for (size_t i = 0; i < index.frameNum(); i++) {
+        complete += (index.frame(i).flags & FRAME_COMPLETE) != 0;
+    }
+    printf("%s: %s %s, %llu packets, %zu frames (%zu complete) in %.3f s, index %s\n", options.recording.c_str(),
+           RecordFormatName(reader.format()), LidarTypeName(options.type),
+           static_cast<unsigned long long>(index.packetNum()), index.frameNum(), complete, seconds,
+           options.output.c_str());
+
+    if (options.print) {
+        printf("%8s %14s %18s %20s %8s %s\n", "frame", "offset", "sensor_time_us", "capture_time_ns", "packets",
+               "complete");
+        for (size_t i = 0; i < index.frameNum(); i++) {
+            const FrameEntry& entry = index.frame(i);
+            printf("%8zu %14llu %18lld %20lld %8u %s\n", i, static_cast<unsigned long long>(entry.offset),
+                   static_cast<long long>(entry.sensorTime), static_cast<long long>(entry.captureTime),
+                   entry.packetNum, (entry.flags & FRAME_COMPLETE) != 0 ? "yes" : "no");
+        }
+    }
+
+    if (options.check >= 0) {
+        // through the written file, as a replay tool would
+        FrameIndex loaded;
+        if (!loaded.load(options.output) || loaded.frameNum() != index.frameNum()) {
+            return 1;
+        }
+        size_t first = options.check == LONG_MAX ? 0 : static_cast<size_t>(options.check);
+        size_t last  = options.check == LONG_MAX ? loaded.frameNum() : first + 1;
+        if (first >= loaded.frameNum()) {
+            printf("frame %zu out of %zu\n", first, loaded.frameNum());
+            return 1;
+        }
+        // backwards, each seek is a jump
+        for (size_t i = last; i-- > first;) {
+            if (!checkFrame(loaded, reader, i)) {
+                return 1;
+            }
+        }
+        printf("%zu frames read back\n", last - first);
+    }
+    return 0;
+}
@@ -0,0 +1,341 @@
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright [2022] [Hesai Technology Co., Ltd]
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+//
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Replay the udp datagrams of pcap or pcapng captures to the plugin, with the inter-packet timing of the capture,
+// faster or slower, or as fast as possible. Several captures are merged in time order onto their own port or
+// source address, e.g. to play the recordings of two lidars at once. Reports the achieved rate and how far the
+// sends are from the capture timing
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PcapFile.h"
+#include "StageStats.h"
+#include "UdpSender.h"
+
+using namespace dw::plugins::lidar;
+using namespace dw::plugins::lidar::tools;
+
+namespace
+{
+const uint16_t LIDAR_PORT = 2368;
+
+// One capture and where its datagrams go
+struct Input
+{
+    std::string path;
+    // destination port, 0 for the base port plus the index of the input
+    uint16_t dstPort = 0;
+    uint32_t srcAddr = 0;
+    uint16_t srcPort = 0;
+    // only the datagrams sent to this port in the capture, 0 for all
+    uint16_t filterPort = 0;
+
+    PcapFile pcap;
+    std::unique_ptr<UdpSender> sender;
+    UdpDatagram next;
+    bool hasNext = false;
+    // capture time of the first datagram and of the last one read
+    int64_t firstTime = -1;
+    int64_t lastTime  = 0;
+    // added to the due time of each datagram, grows by the length of the capture at each loop
+    int64_t loopOffset   = 0;
+    uint32_t loop        = 0;
+    uint64_t loopPackets = 0;
+    // due time of the last datagram sent, and when it was sent
+    int64_t lastDue  = -1;
+    int64_t lastSent = 0;
+    uint64_t bytes   = 0;
+    LatencyHistogram lag;
+    LatencyHistogram gapError;
+};
+
+struct Options
+{
+    std::vector<std::unique_ptr<Input>> inputs;
+    uint32_t dstAddr   = 0x7f000001;
+    uint16_t basePort  = LIDAR_PORT;
+    double speed       = 1;
+    bool maxRate       = false;
+    // 0 for ever
+    uint32_t loops     = 1;
+    bool keepOffsets   = false;
+    size_t batch       = 32;
+    double statsPeriod = 0;
+};
+
+volatile sig_atomic_t g_stop = 0;
+
+void onSignal(int)
+{
+    g_stop = 1;
+}
+
+void usage(const char* name)
+{
+    printf("Usage: %s [options] <capture>[,port=<n>][,src=<ip[:port]>][,filter=<port>] ...\n"
+           "  Captures are pcap or pcapng files, merged in time order. Each one goes to its own port,\n"
+           "  the base port plus its index unless 'port' is given, from the 'src' address if given.\n"
+           "  'filter' keeps the datagrams sent to this port in the capture, e.g. the point cloud of a lidar\n"
+           "  --dest <ip>          destination address, default 127.0.0.1\n"
+           "  --port <n>           base destination port, default 2368\n"
+           "  --speed <x>          replay x times faster than captured, default 1\n"
+           "  --max-rate           send as fast as possible\n"
+           "  --loop <n>           play each capture n times, 0 for ever, default 1\n"
+           "  --keep-offsets       keep the time offsets between the captures, they all start at once otherwise\n"
+           "  --batch <n>          max datagrams per sendmmsg, of the ones already due, default 32\n"
+           "  --stats <s>          print the rate every s seconds\n",
+           name);
+}
+
+bool parseInput(const char* text, Input& input)
+{
+    std::string spec = text;
+    size_t comma     = spec.find(',');
+    input.path       = spec.substr(0, comma);
+    while (comma != std::string::npos) {
+        size_t end        = spec.find(',', comma + 1);
+        std::string field = spec.substr(comma + 1, end == std::string::npos ? std::string::npos : end - comma - 1);
+        comma             = end;
+        size_t equal      = field.find('=');
+        std::string key   = field.substr(0, equal);
+        std::string value = equal == std::string::npos ? "" : field.substr(equal + 1);
+        uint32_t addr;
+        uint16_t port;
+        if (key == "port") {
+            input.dstPort = static_cast<uint16_t>(atoi(value.c_str()));
+        } else if (key == "filter") {
+            input.filterPort = static_cast<uint16_t>(atoi(value.c_str()));
+        } else if (key == "src" && ParseEndpoint(value.find(':') == std::string::npos ? value + ":0" : value, addr, port)) {
+            input.srcAddr = addr;
+            input.srcPort = port;
+        } else {
+            printf("wrong capture option %s\n", field.c_str());
+            return false;
+        }
+    }
+    return !input.path.empty();
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    static const struct option longOptions[] = {
+        {"dest", required_argument, nullptr, 'd'},  {"port", required_argument, nullptr, 'p'},
+        {"speed", required_argument, nullptr, 'x'}, {"max-rate", no_argument, nullptr, 'm'},
+        {"loop", required_argument, nullptr, 'l'},  {"keep-offsets", no_argument, nullptr, 'k'},
+        {"batch", required_argument, nullptr, 'b'}, {"stats", required_argument, nullptr, 's'},
+        {"help", no_argument, nullptr, 'h'},        {nullptr, 0, nullptr, 0}};
+    int c;
+    uint16_t port;
+    while ((c = getopt_long(argc, argv, "h", longOptions, nullptr)) != -1) {
+        switch (c) {
+        case 'd':
+            if (!ParseEndpoint(std::string(optarg) + ":0", options.dstAddr, port)) {
+                printf("wrong address %s\n", optarg);
+                return false;
+            }
+            break;
+        case 'p': options.basePort = static_cast<uint16_t>(atoi(optarg)); break;
+        case 'x': options.speed = atof(optarg); break;
+        case 'm': options.maxRate = true; break;
+        case 'l': options.loops = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'k': options.keepOffsets = true; break;
+        case 'b': options.batch = static_cast<size_t>(atoi(optarg)); break;
+        case 's': options.statsPeriod = atof(optarg); break;
+        default: return false;
+        }
+    }
+    for (int i = optind; i < argc; i++) {
+        std::unique_ptr<Input> input(new Input());
+        if (!parseInput(argv[i], *input)) {
+            return false;
+        }
+        options.inputs.push_back(std::move(input));
+    }
+    if (options.inputs.empty() || options.speed <= 0 || options.batch == 0 || options.batch > 1024) {
+        printf("at least one capture, a positive speed and a batch of 1 to 1024 are needed\n");
+        return false;
+    }
+    return true;
+}
+
+// Read the next datagram of the input, rewound at the end while loops are left
+bool advance(Input& input, const Options& options)
+{
+    while (true) {
+        while (input.pcap.next(input.next)) {
+            if (input.filterPort != 0 && input.next.dstPort != input.filterPort) {
+                continue;
+            }
+            if (input.firstTime < 0) {
+                input.firstTime = input.next.timestamp;
+            }
+            input.lastTime = input.next.timestamp;
+            input.hasNext  = true;
+            input.loopPackets++;
+            return true;
+        }
+        input.hasNext = false;
+        if (input.firstTime < 0 || (options.loops != 0 && input.loop + 1 >= options.loops)) {
+            return false;
+        }
+        // the next loop starts one mean packet interval after the last packet
+        input.loop++;
+        int64_t length = input.lastTime - input.firstTime;
+        input.loopOffset += length + (input.loopPackets > 1 ? length / static_cast<int64_t>(input.loopPackets - 1) : 0);
+        input.loopPackets = 0;
+        input.pcap.rewind();
+    }
+}
+
+// When the next datagram of the input is due, ns since the start of the replay
+int64_t dueTime(const Input& input, int64_t origin, const Options& options)
+{
+    if (options.maxRate) {
+        return 0;
+    }
+    return static_cast<int64_t>((input.next.timestamp - origin + input.loopOffset) / options.speed);
+}
+
+void printSummary(const char* name, const LatencyHistogram& histogram)
+{
+    LatencyHistogram::Summary summary = histogram.summarize();
+    printf("  %-10s mean %8.1f us  p50 %8.1f us  p99 %8.1f us  p99.9 %8.1f us  max %8.1f us\n", name,
+           summary.meanNs / 1e3, summary.p50Ns / 1e3, summary.p99Ns / 1e3, summary.p999Ns / 1e3,
+           summary.maxNs / 1e3);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    int64_t earliest = INT64_MAX;
+    for (size_t i = 0; i < options.inputs.size(); i++) {
+        Input& input = *options.inputs[i];
+        if (input.dstPort == 0) {
+            input.dstPort = static_cast<uint16_t>(options.basePort + i);
+        }
+        input.sender.reset(new UdpSender(options.batch));
+        if (!input.pcap.open(input.path) ||
+            !input.sender->open(options.dstAddr, input.dstPort, input.srcAddr, input.srcPort)) {
+            return 1;
+        }
+        if (!advance(input, options)) {
+            printf("%s: no udp datagram to replay\n", input.path.c_str());
+            return 1;
+        }
+        earliest = std::min(earliest, input.firstTime);
+        printf("%s %s -> port %u\n", input.path.c_str(), input.pcap.isPcapng() ? "pcapng" : "pcap", input.dstPort);
+    }
+
+    RatePacer pacer;
+    pacer.start();
+    uint64_t sent          = 0;
+    uint64_t reportedSent  = 0;
+    int64_t reportedTime   = 0;
+    std::vector<int64_t> dueTimes;
+    while (g_stop == 0) {
+        // the input with the earliest datagram
+        Input* first     = nullptr;
+        int64_t firstDue = 0;
+        for (auto& input : options.inputs) {
+            if (!input->hasNext) continue;
+            int64_t due = dueTime(*input, options.keepOffsets ? earliest : input->firstTime, options);
+            if (first == nullptr || due < firstDue) {
+                first    = input.get();
+                firstDue = due;
+            }
+        }
+        if (first == nullptr) {
+            break;
+        }
+        if (!options.maxRate) {
+            pacer.waitUntil(firstDue);
+        }
+        int64_t now = pacer.elapsed();
+        // everything due by now goes out in one sendmmsg per input, the payloads stay in the mappings
+        for (auto& input : options.inputs) {
+            int64_t origin = options.keepOffsets ? earliest : input->firstTime;
+            dueTimes.clear();
+            while (input->hasNext && dueTimes.size() < input->sender->batchNum()) {
+                int64_t due = dueTime(*input, origin, options);
+                if (due > now) break;
+                input->sender->add(input->next.payload, input->next.length);
+                input->bytes += input->next.length;
+                dueTimes.push_back(due);
+                advance(*input, options);
+            }
+            if (dueTimes.empty()) continue;
+            input->sender->flush();
+            int64_t sentTime = pacer.elapsed();
+            for (int64_t due : dueTimes) {
+                if (!options.maxRate) {
+                    input->lag.record(static_cast<uint64_t>(sentTime - due));
+                    // how much the gap to the previous datagram differs from the capture
+                    if (input->lastDue >= 0) {
+                        int64_t error = (sentTime - input->lastSent) - (due - input->lastDue);
+                        input->gapError.record(static_cast<uint64_t>(error < 0 ? -error : error));
+                    }
+                }
+                input->lastDue  = due;
+                input->lastSent = sentTime;
+            }
+            sent += dueTimes.size();
+        }
+        if (options.statsPeriod > 0 && now - reportedTime >= options.statsPeriod * 1e9) {
+            printf("%8.3f s %10.0f packets/s\n", now / 1e9, (sent - reportedSent) * 1e9 / (now - reportedTime));
+            reportedSent = sent;
+            reportedTime = now;
+        }
+    }
+
+    double seconds = pacer.elapsed() / 1e9;
+    int ret        = 0;
+    printf("sent %lu packets in %.3f s, %.0f packets/s\n", static_cast<unsigned long>(sent), seconds,
+           seconds > 0 ? sent / seconds : 0);
+    for (auto& input : options.inputs) {
+        const UdpSender& sender = *input->sender;
+        printf("%s: %lu packets, %.1f MB, %.0f packets/s, %lu errors, %u loops\n", input->path.c_str(),
+               static_cast<unsigned long>(sender.sentNum()), input->bytes / 1e6,
+               seconds > 0 ? sender.sentNum() / seconds : 0, static_cast<unsigned long>(sender.errorNum()),
+               input->loop + 1);
+        if (!options.maxRate) {
+            // lag behind the capture timing, and jitter of the gap between two datagrams
+            printSummary("lag", input->lag);
+            printSummary("gap error", input->gapError);
+        }
+        if (sender.errorNum() != 0) {
+            ret = 2;
+        }
+    }
+    return ret;
+}